@@ -0,0 +1,156 @@
+/**
+ * @file
+ * Austauschbare Beschleunigungsstruktur ueber die Instanzen der Szene.
+ * Jedes Backend stellt seine Funktionen ueber eine Tabelle bereit, die Logik schneidet
+ * Strahlen nur ueber diese Schnittstelle. Die Normalen und Materialien der Treffer
+ * werden weiterhin ueber die Instanzen bestimmt, die Backends liefern nur Instanz und Dreieck.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <GL/glut.h>
+#include "accelerator.h"
+
+/** Funktionen eines Backends */
+typedef struct acceleratorBackend {
+    const char *name;
+    void (*build)(accelerator *accel);
+    GLint (*intersectClosest)(const accelerator *accel, bvhOptions opts, GLuint skipMask, Ray ray, GLfloat *dist,
+                              GLint *tri);
+    GLboolean (*intersectAny)(const accelerator *accel, bvhOptions opts, Ray ray, GLfloat maxDist);
+    /** NULL, wenn das Backend keine Pakete unterstuetzt */
+    void (*intersectPacket)(const accelerator *accel, bvhOptions opts, bvhRayPacket *packet,
+                            const GLuint *skipMasks, GLfloat *dists, GLint *instances, GLint *tris);
+    size_t (*memoryFootprint)(const accelerator *accel);
+    void (*free)(accelerator *accel);
+} acceleratorBackend;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/* ---- BVH: zweistufige BVH aus bvhTopLevel ---- */
+
+static void accelerator_bvhBuild(accelerator *accel) {
+    bvhTopLevel_build(accel->tlas);
+}
+
+static GLint accelerator_bvhIntersectClosest(const accelerator *accel, bvhOptions opts, GLuint skipMask, Ray ray,
+                                             GLfloat *dist, GLint *tri) {
+    return bvhTopLevel_intersectClosest(accel->tlas, opts, skipMask, ray, dist, tri);
+}
+
+static GLboolean accelerator_bvhIntersectAny(const accelerator *accel, bvhOptions opts, Ray ray, GLfloat maxDist) {
+    return bvhTopLevel_intersectAny(accel->tlas, opts, ray, maxDist);
+}
+
+static void accelerator_bvhIntersectPacket(const accelerator *accel, bvhOptions opts, bvhRayPacket *packet,
+                                           const GLuint *skipMasks, GLfloat *dists, GLint *instances, GLint *tris) {
+    bvhTopLevel_intersectPacket(accel->tlas, opts, packet, skipMasks, dists, instances, tris);
+}
+
+static size_t accelerator_bvhMemoryFootprint(const accelerator *accel) {
+    const topLevel *tlas = accel->tlas;
+    size_t result = tlas->instanceCount * sizeof(objectInstance) +
+                    bvh_memoryFootprint(&tlas->bvh, tlas->instanceCount) +
+                    bvh_memoryFootprint(&tlas->shadowBvh, tlas->instanceCount) +
+                    2 * tlas->instanceCount * sizeof(GLint);
+
+    //Jedes Mesh nur einmal zaehlen, auch wenn es mehrere Instanzen hat
+    for (int i = 0; i < tlas->instanceCount; ++i) {
+        const object *mesh = tlas->instances[i].mesh;
+        GLboolean counted = GL_FALSE;
+        for (int j = 0; j < i && !counted; ++j) {
+            counted = tlas->instances[j].mesh == mesh;
+        }
+        if (!counted) {
+            result += bvh_memoryFootprint(&mesh->bvh, mesh->faceCount);
+        }
+    }
+    return result;
+}
+
+static void accelerator_bvhFree(accelerator *accel) {
+    //Die BVH ueber die Instanzen wird mit den Instanzen in bvhTopLevel_free freigegeben
+    (void) accel;
+}
+
+/* ---- Gleichmaessiges Gitter ---- */
+
+static void accelerator_gridBuild(accelerator *accel) {
+    grid_build(&accel->grid, accel->tlas);
+}
+
+static GLint accelerator_gridIntersectClosest(const accelerator *accel, bvhOptions opts, GLuint skipMask, Ray ray,
+                                              GLfloat *dist, GLint *tri) {
+    (void) opts;
+    return grid_intersectClosest(&accel->grid, skipMask, ray, dist, tri);
+}
+
+static GLboolean accelerator_gridIntersectAny(const accelerator *accel, bvhOptions opts, Ray ray, GLfloat maxDist) {
+    (void) opts;
+    return grid_intersectAny(&accel->grid, ray, maxDist);
+}
+
+static size_t accelerator_gridMemoryFootprint(const accelerator *accel) {
+    return grid_memoryFootprint(&accel->grid);
+}
+
+static void accelerator_gridFree(accelerator *accel) {
+    grid_free(&accel->grid);
+}
+
+/** Backends, indiziert ueber acceleratorType */
+static const acceleratorBackend BACKENDS[] = {
+        [accelBvh] = {"BVH", accelerator_bvhBuild, accelerator_bvhIntersectClosest, accelerator_bvhIntersectAny,
+                      accelerator_bvhIntersectPacket, accelerator_bvhMemoryFootprint, accelerator_bvhFree},
+        [accelGrid] = {"Grid", accelerator_gridBuild, accelerator_gridIntersectClosest, accelerator_gridIntersectAny,
+                       NULL, accelerator_gridMemoryFootprint, accelerator_gridFree}
+};
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+void accelerator_build(accelerator *accel, topLevel *tlas) {
+    accel->tlas = tlas;
+    int startTime = glutGet(GLUT_ELAPSED_TIME);
+    BACKENDS[accel->type].build(accel);
+    accel->buildTime = glutGet(GLUT_ELAPSED_TIME) - startTime;
+}
+
+void accelerator_setType(accelerator *accel, acceleratorType type) {
+    accelerator_free(accel);
+    accel->type = type;
+    accelerator_build(accel, accel->tlas);
+}
+
+GLint accelerator_intersectClosest(const accelerator *accel, bvhOptions opts, GLuint skipMask, Ray ray,
+                                   GLfloat *dist, GLint *tri) {
+    return BACKENDS[accel->type].intersectClosest(accel, opts, skipMask, ray, dist, tri);
+}
+
+GLboolean accelerator_intersectAny(const accelerator *accel, bvhOptions opts, Ray ray, GLfloat maxDist) {
+    return BACKENDS[accel->type].intersectAny(accel, opts, ray, maxDist);
+}
+
+GLboolean accelerator_supportsPackets(const accelerator *accel) {
+    return BACKENDS[accel->type].intersectPacket != NULL;
+}
+
+void accelerator_intersectPacket(const accelerator *accel, bvhOptions opts, bvhRayPacket *packet,
+                                 const GLuint *skipMasks, GLfloat *dists, GLint *instances, GLint *tris) {
+    BACKENDS[accel->type].intersectPacket(accel, opts, packet, skipMasks, dists, instances, tris);
+}
+
+size_t accelerator_memoryFootprint(const accelerator *accel) {
+    return BACKENDS[accel->type].memoryFootprint(accel);
+}
+
+GLint accelerator_buildTime(const accelerator *accel) {
+    return accel->buildTime;
+}
+
+const char *accelerator_name(acceleratorType type) {
+    return BACKENDS[type].name;
+}
+
+void accelerator_free(accelerator *accel) {
+    BACKENDS[accel->type].free(accel);
+}
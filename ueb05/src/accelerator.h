@@ -0,0 +1,91 @@
+#ifndef RAYTRACER_ACCELERATOR_H
+#define RAYTRACER_ACCELERATOR_H
+#include "bvhTopLevel.h"
+#include "grid.h"
+
+/**
+ * Baut die eingestellte Beschleunigungsstruktur ueber die Instanzen (neu) auf
+ * @param accel Beschleunigungsstruktur, accel->type bestimmt das Backend
+ * @param tlas Instanzen der Szene, muessen so lange gueltig bleiben wie die Struktur
+ */
+void accelerator_build(accelerator *accel, topLevel *tlas);
+
+/**
+ * Wechselt das Backend, gibt das bisherige frei und baut das neue ueber dieselben Instanzen auf
+ * @param accel aufgebaute Beschleunigungsstruktur
+ * @param type neues Backend
+ */
+void accelerator_setType(accelerator *accel, acceleratorType type);
+
+/**
+ * Sucht den naehesten Schnittpunkt eines Strahls mit allen Instanzen
+ * @param accel Beschleunigungsstruktur
+ * @param opts Einstellungen der BVHs (vom Gitter ignoriert)
+ * @param skipMask Modelle, die uebersprungen werden (BVH_TOP_LEVEL_SKIP)
+ * @param ray Strahl im Weltraum
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @param tri Ausgabe, Index des getroffenen Dreiecks im Mesh der Instanz
+ * @return Index der getroffenen Instanz, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint accelerator_intersectClosest(const accelerator *accel, bvhOptions opts, GLuint skipMask, Ray ray,
+                                   GLfloat *dist, GLint *tri);
+
+/**
+ * Prueft, ob ein Schattenstrahl irgendeine schattenwerfende Instanz innerhalb einer Distanz trifft
+ * @param accel Beschleunigungsstruktur
+ * @param opts Einstellungen der BVHs (vom Gitter ignoriert)
+ * @param ray Strahl im Weltraum
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE beim ersten Treffer dichter als maxDist
+ */
+GLboolean accelerator_intersectAny(const accelerator *accel, bvhOptions opts, Ray ray, GLfloat maxDist);
+
+/**
+ * Prueft, ob das Backend koharente Pakete gemeinsam traversieren kann
+ * @param accel Beschleunigungsstruktur
+ * @return GL_TRUE, wenn accelerator_intersectPacket verwendet werden kann
+ */
+GLboolean accelerator_supportsPackets(const accelerator *accel);
+
+/**
+ * Sucht fuer alle Strahlen eines koharenten Pakets den naehesten Schnittpunkt,
+ * nur fuer Backends mit accelerator_supportsPackets
+ * @param accel Beschleunigungsstruktur
+ * @param opts Einstellungen der BVHs
+ * @param packet ueber bvhPacket_init vorbereitetes Paket im Weltraum
+ * @param skipMasks uebersprungene Modelle je Strahl (BVH_TOP_LEVEL_SKIP)
+ * @param dists Ein: maximale Distanz je Strahl, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @param instances Ausgabe, Index der getroffenen Instanz je Strahl, -1 wenn nichts getroffen wurde
+ * @param tris Ausgabe, Index des getroffenen Dreiecks im Mesh der Instanz je Strahl
+ */
+void accelerator_intersectPacket(const accelerator *accel, bvhOptions opts, bvhRayPacket *packet,
+                                 const GLuint *skipMasks, GLfloat *dists, GLint *instances, GLint *tris);
+
+/**
+ * Speicherbedarf der Beschleunigungsstruktur (ohne die Dreiecke der Meshes)
+ * @param accel Beschleunigungsstruktur
+ * @return Bytes
+ */
+size_t accelerator_memoryFootprint(const accelerator *accel);
+
+/**
+ * Aufbauzeit der Beschleunigungsstruktur
+ * @param accel Beschleunigungsstruktur
+ * @return Millisekunden
+ */
+GLint accelerator_buildTime(const accelerator *accel);
+
+/**
+ * Liefert den Namen eines Backends fuer Ausgaben
+ * @param type Backend
+ * @return Name des Backends
+ */
+const char *accelerator_name(acceleratorType type);
+
+/**
+ * Gibt den Speicher des Backends frei, die Instanzen bleiben erhalten
+ * @param accel Beschleunigungsstruktur
+ */
+void accelerator_free(accelerator *accel);
+
+#endif //RAYTRACER_ACCELERATOR_H
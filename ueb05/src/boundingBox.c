@@ -1,208 +1,207 @@
 /**
  * @file
  * Erstellt Axis Aligned Bounding Boxes und Object Oriented Bounding Boxes von Objekten
+ * und testet Strahlen gegen sie
  *
  * @author Christopher Ploog, Mario da Graca
  */
 #include "boundingBox.h"
 
+/** Schrittweite der Winkelsuche fuer die OBB in Grad */
+#define BOUNDING_BOX_ANGLE_STEP (5)
 
-boundingBox boundingBox_calculateAABB(object currObj, corners* corner) {
-    boundingBox result;
-    //Initialwert zum verlgeichen
-    result.cube.cornerX.min = FLT_MAX;
-    result.cube.cornerX.max = -FLT_MAX;
-    result.cube.cornerY.min = FLT_MAX;
-    result.cube.cornerY.max = -FLT_MAX;
-    result.cube.cornerZ.min = FLT_MAX;
-    result.cube.cornerZ.max = -FLT_MAX;
-
-    //Ueber alle Vertizes iterieren
-    for (int i = 0; i < currObj.vertexCount; ++i) {
-        vec3 currVert;
-        glm_vec3_copy(currObj.vertices[i], currVert);
-
-        //x Min und Max
-        result.cube.cornerX.min = fminf(currVert[0], result.cube.cornerX.min);
-        result.cube.cornerX.max = fmaxf(currVert[0], result.cube.cornerX.max);
-
-        //y Min und Max
-        result.cube.cornerY.min = fminf(currVert[1], result.cube.cornerY.min);
-        result.cube.cornerY.max = fmaxf(currVert[1], result.cube.cornerY.max);
-
-        //z Min und Max
-        result.cube.cornerZ.min = fminf(currVert[2], result.cube.cornerZ.min);
-        result.cube.cornerZ.max = fmaxf(currVert[2], result.cube.cornerZ.max);
-    }
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
 
-    //Dimensionen
-    result.width = result.cube.cornerX.max - result.cube.cornerX.min;
-    result.height = result.cube.cornerY.max - result.cube.cornerY.min;
-    result.depth = result.cube.cornerZ.max - result.cube.cornerZ.min;
-
-    //Alle 8 Ecken eines Würfels aus den min und max Werten erstellen
-    glm_vec3_copy((vec3){result.cube.cornerX.min, result.cube.cornerY.max, result.cube.cornerZ.max}, corner->topFrontLeft);
-    glm_vec3_copy((vec3){result.cube.cornerX.max, result.cube.cornerY.max, result.cube.cornerZ.max}, corner->topFrontRight);
-    glm_vec3_copy((vec3){result.cube.cornerX.min, result.cube.cornerY.min, result.cube.cornerZ.max}, corner->bottomFrontLeft);
-    glm_vec3_copy((vec3){result.cube.cornerX.max, result.cube.cornerY.min, result.cube.cornerZ.max}, corner->bottomFrontRight);
-    glm_vec3_copy((vec3){result.cube.cornerX.min, result.cube.cornerY.max, result.cube.cornerZ.min}, corner->topBackLeft);
-    glm_vec3_copy((vec3){result.cube.cornerX.max, result.cube.cornerY.max, result.cube.cornerZ.min}, corner->topBackRight);
-    glm_vec3_copy((vec3){result.cube.cornerX.min, result.cube.cornerY.min, result.cube.cornerZ.min}, corner->bottomBackLeft);
-    glm_vec3_copy((vec3){result.cube.cornerX.max, result.cube.cornerY.min, result.cube.cornerZ.min}, corner->bottomBackRight);
-    
-    return result;
+/**
+ * Volumen der OBB
+ */
+static GLfloat boundingBox_obbVolume(const boundingVolume *bv) {
+    return 8.0f * bv->halfSize[0] * bv->halfSize[1] * bv->halfSize[2];
 }
 
-object boundingBox_createObjectFromBoundingBox(corners corner) {
-    object result;
-
-    //Rechteck aus 12 Dreiecken erstellen
-    result.vertexCount = 8;
-    result.vertices = (vec3 *) calloc(result.vertexCount, sizeof(vec3));
-    glm_vec3_copy(corner.bottomFrontLeft, result.vertices[0]);
-    glm_vec3_copy(corner.bottomFrontRight, result.vertices[1]);
-    glm_vec3_copy(corner.topFrontLeft, result.vertices[2]);
-    glm_vec3_copy(corner.topFrontRight, result.vertices[3]);
-    glm_vec3_copy(corner.topBackLeft, result.vertices[4]);
-    glm_vec3_copy(corner.topBackRight, result.vertices[5]);
-    glm_vec3_copy(corner.bottomBackLeft, result.vertices[6]);
-    glm_vec3_copy(corner.bottomBackRight, result.vertices[7]);
-
-    //Indizes
-    result.faceCount = 12;
-    result.facesTM = (triangleTM *) calloc(result.faceCount, sizeof(triangleTM));
-    faces indices[] = {{0, 1, 2},
-                       {2, 1, 3},
-                       {2, 3, 4},
-                       {4, 3, 5},
-                       {4, 5, 6},
-                       {6, 5, 7},
-                       {6, 7, 0},
-                       {0, 7, 1},
-                       {1, 7, 3},
-                       {3, 7, 5},
-                       {6, 0, 4},
-                       {4, 0, 2}};
-
-    for (int i = 0; i < result.faceCount; ++i) {
-        glm_vec3_copy(result.vertices[indices[i].index1], result.facesTM[i].vertices.a);
-        glm_vec3_copy(result.vertices[indices[i].index2], result.facesTM[i].vertices.b);
-        glm_vec3_copy(result.vertices[indices[i].index3], result.facesTM[i].vertices.c);
-        utils_calcTwoEdgesTM(&result.facesTM[i]);
-        utils_calcNormal(&result.facesTM[i]);
-    }
+/**
+ * Volumen der AABB
+ */
+static GLfloat boundingBox_aabbVolume(const boundingVolume *bv) {
+    return (bv->max[0] - bv->min[0]) * (bv->max[1] - bv->min[1]) * (bv->max[2] - bv->min[2]);
+}
 
-    return result;
+/**
+ * Transformiert einen Strahl in das Koordinatensystem der OBB (Mittelpunkt im Ursprung).
+ * Die Achsen sind orthonormal, die Distanzen entlang des Strahls bleiben also gleich.
+ */
+static void boundingBox_toObbSpace(const boundingVolume *bv, const Ray *ray, vec3 start, vec3 dir) {
+    vec3 offset;
+    glm_vec3_sub((float *) ray->start, (float *) bv->center, offset);
+    for (int axis = 0; axis < 3; ++axis) {
+        start[axis] = glm_vec3_dot(offset, (float *) bv->axes[axis]);
+        dir[axis] = glm_vec3_dot((float *) ray->dir, (float *) bv->axes[axis]);
+    }
 }
 
-void boundingBox_createOOBFromAABB(boundingBox aabb, object obj, corners *corner, vec3 bunnyTranslation) {
-    vec3 center= {0.0f, 0.0f, 0.0f};
+/**---------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
 
-    //OOBB um den Mittelpunkt erstellen
-    vec3 bunnyAtCenter[obj.vertexCount];
+void boundingBox_calculateBounds(object *obj) {
+    boundingVolume *bv = &obj->bounds;
 
-    //Komponentenweise Mittelung der Vertizes, um den Mittelpunkt des Hasen zu bestimmen
-    for (int i = 0; i < obj.vertexCount; ++i) {
-        glm_vec3_copy(obj.vertices[i], bunnyAtCenter[i]);
-        glm_vec3_sub(bunnyAtCenter[i], bunnyTranslation, bunnyAtCenter[i]);
+    //AABB ueber alle Vertizes
+    glm_vec3_copy((vec3) {FLT_MAX, FLT_MAX, FLT_MAX}, bv->min);
+    glm_vec3_copy((vec3) {-FLT_MAX, -FLT_MAX, -FLT_MAX}, bv->max);
+    for (int i = 0; i < obj->vertexCount; ++i) {
+        glm_vec3_minv(bv->min, obj->vertices[i], bv->min);
+        glm_vec3_maxv(bv->max, obj->vertices[i], bv->max);
+    }
 
-        center[0] += bunnyAtCenter[i][0];
-        center[1] += bunnyAtCenter[i][1];
-        center[2] += bunnyAtCenter[i][2];
+    //OBB: Die Achsen in der xz-Ebene um y drehen und den Winkel mit der kleinsten Grundflaeche suchen
+    GLfloat minArea = FLT_MAX;
+    vec3 bestAxisX = {1.0f, 0.0f, 0.0f};
+    vec3 bestAxisZ = {0.0f, 0.0f, 1.0f};
+    GLfloat bestX[2] = {0.0f, 0.0f};
+    GLfloat bestZ[2] = {0.0f, 0.0f};
+
+    for (int angle = 0; angle < 180; angle += BOUNDING_BOX_ANGLE_STEP) {
+        vec3 axisX = {1.0f, 0.0f, 0.0f};
+        vec3 axisZ = {0.0f, 0.0f, 1.0f};
+        glm_vec3_rotate(axisX, glm_rad((float) angle), (vec3) {0.0f, 1.0f, 0.0f});
+        glm_vec3_rotate(axisZ, glm_rad((float) angle), (vec3) {0.0f, 1.0f, 0.0f});
+
+        //Ausdehnung der Vertizes entlang der gedrehten Achsen
+        GLfloat x[2] = {FLT_MAX, -FLT_MAX};
+        GLfloat z[2] = {FLT_MAX, -FLT_MAX};
+        for (int i = 0; i < obj->vertexCount; ++i) {
+            GLfloat distX = glm_vec3_dot(axisX, obj->vertices[i]);
+            GLfloat distZ = glm_vec3_dot(axisZ, obj->vertices[i]);
+            x[0] = fminf(x[0], distX);
+            x[1] = fmaxf(x[1], distX);
+            z[0] = fminf(z[0], distZ);
+            z[1] = fmaxf(z[1], distZ);
+        }
+
+        //Kleinster Flaecheninhalt bestimmt die optimale OBB
+        GLfloat area = (x[1] - x[0]) * (z[1] - z[0]);
+        if (area < minArea) {
+            minArea = area;
+            glm_vec3_copy(axisX, bestAxisX);
+            glm_vec3_copy(axisZ, bestAxisZ);
+            bestX[0] = x[0];
+            bestX[1] = x[1];
+            bestZ[0] = z[0];
+            bestZ[1] = z[1];
+        }
     }
 
-    center[0] /= (float) obj.vertexCount;
-    center[1] /= (float) obj.vertexCount;
-    center[2] /= (float) obj.vertexCount;
+    glm_vec3_copy(bestAxisX, bv->axes[0]);
+    glm_vec3_copy((vec3) {0.0f, 1.0f, 0.0f}, bv->axes[1]);
+    glm_vec3_copy(bestAxisZ, bv->axes[2]);
+    bv->halfSize[0] = 0.5f * (bestX[1] - bestX[0]);
+    bv->halfSize[1] = 0.5f * (bv->max[1] - bv->min[1]);
+    bv->halfSize[2] = 0.5f * (bestZ[1] - bestZ[0]);
 
+    //Mittelpunkt aus den Mitten entlang der drei Achsen
+    glm_vec3_scale(bv->axes[0], 0.5f * (bestX[0] + bestX[1]), bv->center);
+    glm_vec3_muladds(bv->axes[1], 0.5f * (bv->min[1] + bv->max[1]), bv->center);
+    glm_vec3_muladds(bv->axes[2], 0.5f * (bestZ[0] + bestZ[1]), bv->center);
 
-    GLfloat minXDist = FLT_MAX, maxXDist = -FLT_MAX;
-    GLfloat minZDist = FLT_MAX, maxZDist = -FLT_MAX;
-    GLfloat minArea = FLT_MAX;
-    GLfloat angle = 0.0f;
+    bv->useObb = boundingBox_obbVolume(bv) < boundingBox_aabbVolume(bv);
+}
 
-    for (int i = 0; i <= 175; i += 5) {
-        //Geraden in x und z Richtung
-        vec3 vecX = {1.0f, 0.0f, 0.0f};
-        vec3 vecZ = {0.0f, 0.0f, 1.0f};
+void boundingBox_transformBounds(const object *obj, mat4 toWorld, boundingVolume *world) {
+    const boundingVolume *local = &obj->bounds;
 
-        //Geraden rotieren
-        glm_vec3_rotate(vecX, glm_rad((float) i), (vec3){0.0f, 1.0f, 0.0f});
-        glm_vec3_rotate(vecZ, glm_rad((float) i), (vec3){0.0f, 1.0f, 0.0f});
+    //OBB: Mittelpunkt transformieren, Achsen drehen und die Skalierung in die halben Kantenlaengen uebernehmen
+    glm_mat4_mulv3(toWorld, (float *) local->center, 1.0f, world->center);
+    for (int axis = 0; axis < 3; ++axis) {
+        glm_mat4_mulv3(toWorld, (float *) local->axes[axis], 0.0f, world->axes[axis]);
+        GLfloat length = glm_vec3_norm(world->axes[axis]);
+        glm_vec3_scale(world->axes[axis], 1.0f / length, world->axes[axis]);
+        world->halfSize[axis] = local->halfSize[axis] * length;
+    }
 
-        //An Center Position des Bunnys translatieren und normieren
-        glm_vec3_add(vecX, center, vecX);
-        glm_vec3_normalize(vecX);
+    //AABB ueber die transformierten Vertizes, damit sie auch bei rotierten Objekten eng anliegt
+    glm_vec3_copy((vec3) {FLT_MAX, FLT_MAX, FLT_MAX}, world->min);
+    glm_vec3_copy((vec3) {-FLT_MAX, -FLT_MAX, -FLT_MAX}, world->max);
+    for (int i = 0; i < obj->vertexCount; ++i) {
+        vec3 vertex;
+        glm_mat4_mulv3(toWorld, obj->vertices[i], 1.0f, vertex);
+        glm_vec3_minv(world->min, vertex, world->min);
+        glm_vec3_maxv(world->max, vertex, world->max);
+    }
 
-        glm_vec3_add(vecZ, center, vecZ);
-        glm_vec3_normalize(vecZ);
+    world->useObb = boundingBox_obbVolume(world) < boundingBox_aabbVolume(world);
+}
 
-        GLfloat minXDistTemp = FLT_MAX, maxXDistTemp = -FLT_MAX;
-        GLfloat minZDistTemp = FLT_MAX, maxZDistTemp = -FLT_MAX;
+GLfloat boundingBox_intersect(const boundingVolume *bv, boundingBoxState mode, const Ray *ray, const vec3 invDir,
+                              GLfloat maxDist) {
+    if (mode == none) {
+        return 0.0f;
+    }
+    if (mode == aabb || !bv->useObb) {
+        return boundingBox_intersectSlab(bv->min, bv->max, ray->start, invDir, maxDist);
+    }
 
-        for (int k = 0; k < obj.vertexCount; ++k) {
-            vec3 PM;
-            glm_vec3_sub(bunnyAtCenter[k], center, PM);
+    //Slab Test im Koordinatensystem der OBB gegen [-halfSize, halfSize]
+    vec3 start, dir, localInvDir, negHalfSize;
+    boundingBox_toObbSpace(bv, ray, start, dir);
+    localInvDir[0] = 1.0f / dir[0];
+    localInvDir[1] = 1.0f / dir[1];
+    localInvDir[2] = 1.0f / dir[2];
+    glm_vec3_negate_to((float *) bv->halfSize, negHalfSize);
+    return boundingBox_intersectSlab(negHalfSize, bv->halfSize, start, localInvDir, maxDist);
+}
 
-            //Min Max Distanz auf der x-Achse
-            GLfloat distX = glm_vec3_dot(vecX, PM);
-            minXDistTemp = fminf(distX, minXDistTemp);
-            maxXDistTemp = fmaxf(distX, maxXDistTemp);
+GLboolean boundingBox_intersectSurface(const boundingVolume *bv, boundingBoxState mode, Ray ray, GLfloat *dist,
+                                       vec3 normal) {
+    if (mode == none) {
+        return GL_FALSE;
+    }
 
-            //Min Max Distanz auf der z-Achse
-            GLfloat distZ = glm_vec3_dot(vecZ, PM);
-            minZDistTemp = fminf(distZ, minZDistTemp);
-            maxZDistTemp = fmaxf(distZ, maxZDistTemp);
+    //Strahl und Box in ein gemeinsames System bringen, in dem die Box achsenparallel um den Ursprung liegt
+    GLboolean obb = mode == oobb && bv->useObb;
+    vec3 start, dir, halfSize;
+    if (obb) {
+        boundingBox_toObbSpace(bv, &ray, start, dir);
+        glm_vec3_copy((float *) bv->halfSize, halfSize);
+    } else {
+        for (int axis = 0; axis < 3; ++axis) {
+            GLfloat center = 0.5f * (bv->min[axis] + bv->max[axis]);
+            start[axis] = ray.start[axis] - center;
+            dir[axis] = ray.dir[axis];
+            halfSize[axis] = 0.5f * (bv->max[axis] - bv->min[axis]);
         }
+    }
 
-        //Flaecheninhalt bestimmen
-        GLfloat minAreaTemp = (fabsf(maxZDistTemp) + fabsf(minZDistTemp)) * (fabsf(maxXDistTemp) + fabsf(minXDistTemp));
-
-        //Kleiner Flaecheninhalt bestimmt die optimale OOBB
-        if(minAreaTemp < minArea){
-            minXDist = minXDistTemp;
-            minZDist = minZDistTemp;
-            maxXDist = maxXDistTemp;
-            maxZDist = maxZDistTemp;
-            minArea = minAreaTemp;
-            angle = (float) i;
+    //Wie der Slab Test, aber mit der Achse, ueber die ein- und ausgetreten wird
+    GLfloat tMin = -FLT_MAX, tMax = FLT_MAX;
+    GLint axisMin = 0, axisMax = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat invDir = 1.0f / dir[axis];
+        GLfloat t1 = (-halfSize[axis] - start[axis]) * invDir;
+        GLfloat t2 = (halfSize[axis] - start[axis]) * invDir;
+        if (fminf(t1, t2) > tMin) {
+            tMin = fminf(t1, t2);
+            axisMin = axis;
+        }
+        if (fmaxf(t1, t2) < tMax) {
+            tMax = fmaxf(t1, t2);
+            axisMax = axis;
         }
-
+    }
+    //Wie bei den Dreiecken zaehlen nur Treffer mit einer Distanz groesser EPSILON
+    if (tMax < tMin || tMax <= EPSILON) {
+        return GL_FALSE;
     }
 
-    vec3 min = {minXDist, aabb.cube.cornerY.min, minZDist};
-    vec3 max = {maxXDist, aabb.cube.cornerY.max, maxZDist};
-
-    //Dimensionen der Bounding Box
-    glm_vec3_copy((vec3){min[0], min[1], max[2]}, corner->bottomFrontLeft);
-    glm_vec3_copy((vec3){max[0], min[1], max[2]}, corner->bottomFrontRight);
-    glm_vec3_copy((vec3){min[0], min[1], min[2]}, corner->bottomBackLeft);
-    glm_vec3_copy((vec3){max[0], min[1], min[2]}, corner->bottomBackRight);
-
-    glm_vec3_copy((vec3){min[0], max[1], max[2]}, corner->topFrontLeft);
-    glm_vec3_copy((vec3){max[0], max[1], max[2]}, corner->topFrontRight);
-    glm_vec3_copy((vec3){min[0], max[1], min[2]}, corner->topBackLeft);
-    glm_vec3_copy((vec3){max[0], max[1], min[2]}, corner->topBackRight);
-
-    //Um den Winkel rotieren, der den kleinsten Flaecheninhalt liefert
-    glm_vec3_rotate(corner->bottomFrontLeft, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-    glm_vec3_rotate(corner->bottomFrontRight, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-    glm_vec3_rotate(corner->bottomBackLeft, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-    glm_vec3_rotate(corner->bottomBackRight, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-
-    glm_vec3_rotate(corner->topFrontLeft, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-    glm_vec3_rotate(corner->topFrontRight, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-    glm_vec3_rotate(corner->topBackLeft, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-    glm_vec3_rotate(corner->topBackRight, glm_rad(angle), (vec3){0.0f, 1.0f, 0.0f});
-
-    //An Position des Hasen translatieren und Bounding Box in der Szene positioniern
-    glm_vec3_add(corner->bottomFrontLeft, (vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->bottomFrontLeft);
-    glm_vec3_add(corner->bottomFrontRight,(vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->bottomFrontRight);
-    glm_vec3_add(corner->bottomBackLeft,  (vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->bottomBackLeft);
-    glm_vec3_add(corner->bottomBackRight, (vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->bottomBackRight);
-
-    glm_vec3_add(   corner->topFrontLeft, (vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->topFrontLeft);
-    glm_vec3_add(   corner->topFrontRight,(vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->topFrontRight);
-    glm_vec3_add(   corner->topBackLeft,  (vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->topBackLeft);
-    glm_vec3_add(   corner->topBackRight, (vec3){center[0] + bunnyTranslation[0], 0.0f, center[2] + bunnyTranslation[2]}, corner->topBackRight);
-}
\ No newline at end of file
+    //Startet der Strahl in der Box (oder auf ihr), wird die Austrittsseite getroffen
+    GLboolean inside = tMin <= EPSILON;
+    GLint axis = inside ? axisMax : axisMin;
+    *dist = inside ? tMax : tMin;
+    //Die Eintrittsseite zeigt dem Strahl entgegen, die Austrittsseite in Strahlrichtung
+    GLfloat sign = (dir[axis] < 0.0f) != inside ? 1.0f : -1.0f;
+    if (obb) {
+        glm_vec3_scale((float *) bv->axes[axis], sign, normal);
+    } else {
+        glm_vec3_zero(normal);
+        normal[axis] = sign;
+    }
+    return GL_TRUE;
+}
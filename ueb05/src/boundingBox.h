@@ -1,27 +1,79 @@
 #ifndef RAYTRACER_BOUNDINGBOX_H
 #define RAYTRACER_BOUNDINGBOX_H
+#include <float.h>
 #include "utils.h"
 
 /**
- * Erstellt aus einer Bounding ein Objekt, welches in der Szene gerendert werden kann
- * @param bBox Bounding Box (AABB / OOBB)
- * @return Objekt fuer die Szene
+ * Slab Test eines Strahls mit einer achsenparallelen Box, ohne Verzweigungen ueber fminf/fmaxf.
+ * Steht im Header, damit die Traversierungen der BVHs den Test inlinen koennen.
+ * @param min minimale Ecke der Box
+ * @param max maximale Ecke der Box
+ * @param start Startpunkt des Strahls
+ * @param invDir komponentenweise inverse Richtung des Strahls
+ * @param maxDist maximale Distanz
+ * @return Eintrittsdistanz (negativ, wenn der Strahl in der Box startet),
+ *         FLT_MAX wenn die Box nicht (dichter als maxDist) getroffen wird
  */
-object boundingBox_createObjectFromBoundingBox(corners corner);
+static inline GLfloat boundingBox_intersectSlab(const vec3 min, const vec3 max, const vec3 start, const vec3 invDir,
+                                                GLfloat maxDist) {
+    GLfloat tx1 = (min[0] - start[0]) * invDir[0];
+    GLfloat tx2 = (max[0] - start[0]) * invDir[0];
+    GLfloat tMin = fminf(tx1, tx2);
+    GLfloat tMax = fmaxf(tx1, tx2);
+
+    GLfloat ty1 = (min[1] - start[1]) * invDir[1];
+    GLfloat ty2 = (max[1] - start[1]) * invDir[1];
+    tMin = fmaxf(tMin, fminf(ty1, ty2));
+    tMax = fminf(tMax, fmaxf(ty1, ty2));
+
+    GLfloat tz1 = (min[2] - start[2]) * invDir[2];
+    GLfloat tz2 = (max[2] - start[2]) * invDir[2];
+    tMin = fmaxf(tMin, fminf(tz1, tz2));
+    tMax = fminf(tMax, fmaxf(tz1, tz2));
+
+    return (tMax >= tMin && tMax > 0.0f && tMin < maxDist) ? tMin : FLT_MAX;
+}
+
+/**
+ * Berechnet die AABB und die OBB eines Objektes im Objektraum.
+ * Die OBB wird wie bisher nur um die y-Achse gedreht (in 5 Grad Schritten) gesucht.
+ * @param obj Objekt, dessen Vertizes bereits geladen wurden
+ */
+void boundingBox_calculateBounds(object *obj);
+
+/**
+ * Transformiert die Bounding Volumes eines Objektes in den Weltraum. Die OBB wird mitgedreht,
+ * die AABB wird ueber die transformierten Vertizes neu bestimmt. Danach wird erneut entschieden,
+ * ob die OBB enger ist.
+ * @param obj Objekt mit berechneten Bounding Volumes im Objektraum
+ * @param toWorld Transformation (Rotation, Translation und uniforme Skalierung)
+ * @param world Ausgabe, Bounding Volumes im Weltraum
+ */
+void boundingBox_transformBounds(const object *obj, mat4 toWorld, boundingVolume *world);
 
 /**
- * Erstellt fuer ein Objekt aus der Szene eine AABB
- * @param currObj Objekt aus der Szene
- * @return AABB fuer dieses Objekt
+ * Testet einen Strahl gegen das eingestellte Bounding Volume eines Objektes
+ * @param bv Bounding Volumes
+ * @param mode aabb, oobb (nur wenn enger als die AABB, sonst die AABB) oder none
+ * @param ray Strahl
+ * @param invDir komponentenweise inverse Richtung des Strahls
+ * @param maxDist maximale Distanz
+ * @return Eintrittsdistanz, FLT_MAX wenn das Volume verfehlt wird, 0 bei none
  */
-boundingBox boundingBox_calculateAABB(object currObj, corners* corner);
+GLfloat boundingBox_intersect(const boundingVolume *bv, boundingBoxState mode, const Ray *ray, const vec3 invDir,
+                              GLfloat maxDist);
 
 /**
- * Erstellt eine OOBB fuer ein Objekt aus der Szene
- * @param aabb AABB des Objektes
- * @param obj Objekt aus der Szene
- * @return OOBB fuer dieses Objekt
+ * Sucht den Schnittpunkt mit der Oberflaeche des eingestellten Bounding Volumes, um es anzuzeigen.
+ * Startet der Strahl in der Box, wird die Austrittsseite getroffen.
+ * @param bv Bounding Volumes
+ * @param mode aabb oder oobb
+ * @param ray Strahl
+ * @param dist Ausgabe, Distanz zur getroffenen Seite
+ * @param normal Ausgabe, nach aussen zeigende Normale der getroffenen Seite
+ * @return GL_TRUE, wenn eine Seite vor dem Strahl liegt
  */
-void boundingBox_createOOBFromAABB(boundingBox aabb, object obj, corners *corner, vec3 bunnyTranslation);
+GLboolean boundingBox_intersectSurface(const boundingVolume *bv, boundingBoxState mode, Ray ray, GLfloat *dist,
+                                       vec3 normal);
 
-#endif //RAYTRACER_BOUNDINGBOX_H
\ No newline at end of file
+#endif //RAYTRACER_BOUNDINGBOX_H
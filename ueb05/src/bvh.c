@@ -0,0 +1,982 @@
+/**
+ * @file
+ * Bounding Volume Hierarchy ueber die Dreiecke eines Objektes.
+ * Aufbau ueber die Surface Area Heuristic mit Binning, die oberen Ebenen werden seriell
+ * aufgeteilt und die entstehenden Teilbaeume parallel aufgebaut,
+ * Traversierung fuer den naehesten Schnittpunkt und fuer beliebige Schnittpunkte.
+ * Die Dreiecke der Blaetter liegen wahlweise als triangleTM oder als SoA Bloecke vor.
+ * Fuer grosse Meshes kann auch nur die komprimierte BVH ueber die indizierten Dreiecke aufgebaut werden.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include <string.h>
+#include <GL/glut.h>
+#include "bvh.h"
+#include "trumboreMoeller.h"
+#include "bvhWide.h"
+#include "bvhCompressed.h"
+#include "multiThreading.h"
+
+/** Groesse des Traversierungsstacks (muss groesser als BVH_MAX_DEPTH sein) */
+#define BVH_STACK_SIZE (64)
+/** Kosten einer Knotentraversierung relativ zu einem Dreieckstest */
+#define BVH_COST_TRAVERSAL (1.0f)
+/** Kosten eines Dreieckstests */
+#define BVH_COST_INTERSECTION (1.0f)
+
+/** Anzahl der Bins je Achse beim SAH Aufbau */
+#define BVH_BIN_COUNT (32)
+/** Ziel fuer die Anzahl der Teilbaeume, die parallel aufgebaut werden */
+#define BVH_BUILD_TASKS (64)
+/** Teilbaeume mit hoechstens so vielen Primitiven werden nicht weiter fuer die Parallelisierung aufgeteilt */
+#define BVH_BUILD_MIN_TASK_SIZE (1024)
+
+/** Ein Bin beim SAH Aufbau */
+typedef struct bvhBin {
+    vec3 box[2];
+    GLint count;
+} bvhBin;
+
+/** Zustand waehrend des Aufbaus, jeder parallel aufgebaute Teilbaum hat einen eigenen Builder */
+typedef struct bvhBuilder {
+    vec3 (*bounds)[2];
+    vec3 *centroids;
+    GLint *order;
+    bvhNode *nodes;
+    GLint nodeCount;
+    GLint capacity;
+} bvhBuilder;
+
+/** Teilbaum, der nach dem seriellen Aufteilen der oberen Ebenen eigenstaendig aufgebaut wird */
+typedef struct bvhBuildTask {
+    /** Index des Wurzelknotens im gemeinsamen Knotenarray */
+    GLint nodeIdx;
+    GLint first;
+    GLint count;
+    GLint depth;
+    /** Lokaler Builder, Knoten 0 ist die Wurzel des Teilbaums */
+    bvhBuilder local;
+} bvhBuildTask;
+
+/** Liste der Teilbaeume und Kontext fuer die parallelen Aufbau Jobs */
+typedef struct bvhBuildContext {
+    const bvhBuilder *shared;
+    bvhBuildTask *tasks;
+    GLint taskCount;
+    GLint taskCapacity;
+    /** Teilbaeume mit hoechstens so vielen Primitiven werden zu Aufgaben */
+    GLint taskSize;
+} bvhBuildContext;
+
+/** Eintrag auf dem Traversierungsstack */
+typedef struct bvhStackEntry {
+    GLint node;
+    GLfloat tEntry;
+} bvhStackEntry;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/**
+ * Oberflaeche einer AABB
+ */
+static GLfloat bvh_surfaceArea(vec3 min, vec3 max) {
+    GLfloat dx = max[0] - min[0];
+    GLfloat dy = max[1] - min[1];
+    GLfloat dz = max[2] - min[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+/**
+ * Reserviert zwei aufeinanderfolgende Kindknoten
+ * @return Index des linken Kindes
+ */
+static GLint bvh_allocChildren(bvhBuilder *builder) {
+    if (builder->nodeCount + 2 > builder->capacity) {
+        builder->capacity *= 2;
+        builder->nodes = realloc(builder->nodes, builder->capacity * sizeof(bvhNode));
+        if (builder->nodes == NULL) {
+            printf("Error allocating BVH!\n");
+            exit(1);
+        }
+    }
+    GLint result = builder->nodeCount;
+    builder->nodeCount += 2;
+    return result;
+}
+
+/**
+ * Bin eines Schwerpunktes entlang einer Achse
+ */
+static GLint bvh_binIndex(GLfloat centroid, GLfloat cMin, GLfloat scale) {
+    GLint result = (GLint) ((centroid - cMin) * scale);
+    return result < BVH_BIN_COUNT ? (result < 0 ? 0 : result) : BVH_BIN_COUNT - 1;
+}
+
+/**
+ * Bestimmt die Bounds des Knotens an nodeIdx und teilt ihn ueber die binned SAH auf,
+ * wenn sich das lohnt. Die Kinder werden angelegt, aber noch nicht aufgebaut.
+ * @return GL_TRUE, wenn der Knoten aufgeteilt wurde (Kinder ab node->leftFirst, Split nach *splitCount Primitiven)
+ */
+static GLboolean bvh_splitNode(bvhBuilder *builder, GLint nodeIdx, GLint first, GLint count, GLint depth,
+                               GLint *splitCount) {
+    bvhNode *node = &builder->nodes[nodeIdx];
+
+    //Bounds des Knotens und seiner Schwerpunkte aus allen Primitiven bestimmen
+    vec3 nodeBox[2];
+    vec3 centroidBox[2];
+    glm_aabb_invalidate(nodeBox);
+    glm_aabb_invalidate(centroidBox);
+    for (int i = first; i < first + count; ++i) {
+        GLint prim = builder->order[i];
+        glm_aabb_merge(nodeBox, builder->bounds[prim], nodeBox);
+        glm_vec3_minv(centroidBox[0], builder->centroids[prim], centroidBox[0]);
+        glm_vec3_maxv(centroidBox[1], builder->centroids[prim], centroidBox[1]);
+    }
+    glm_vec3_copy(nodeBox[0], node->min);
+    glm_vec3_copy(nodeBox[1], node->max);
+    node->leftFirst = first;
+    node->count = count;
+
+    if (count <= 1 || depth >= BVH_MAX_DEPTH) {
+        return GL_FALSE;
+    }
+
+    //Besten Split ueber alle Achsen und Bingrenzen suchen
+    GLfloat bestCost = FLT_MAX;
+    GLint bestAxis = -1;
+    GLint bestBin = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat extent = centroidBox[1][axis] - centroidBox[0][axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+        GLfloat scale = (GLfloat) BVH_BIN_COUNT / extent;
+
+        bvhBin bins[BVH_BIN_COUNT];
+        for (int b = 0; b < BVH_BIN_COUNT; ++b) {
+            glm_aabb_invalidate(bins[b].box);
+            bins[b].count = 0;
+        }
+        for (int i = first; i < first + count; ++i) {
+            GLint prim = builder->order[i];
+            bvhBin *bin = &bins[bvh_binIndex(builder->centroids[prim][axis], centroidBox[0][axis], scale)];
+            glm_aabb_merge(bin->box, builder->bounds[prim], bin->box);
+            bin->count++;
+        }
+
+        //Von rechts nach links Flaechen und Anzahlen aller rechten Teilmengen vorberechnen
+        GLfloat rightAreas[BVH_BIN_COUNT];
+        GLint rightCounts[BVH_BIN_COUNT];
+        vec3 box[2];
+        glm_aabb_invalidate(box);
+        GLint rightCount = 0;
+        for (int b = BVH_BIN_COUNT - 1; b > 0; --b) {
+            if (bins[b].count > 0) {
+                glm_aabb_merge(box, bins[b].box, box);
+            }
+            rightCount += bins[b].count;
+            rightAreas[b] = bvh_surfaceArea(box[0], box[1]);
+            rightCounts[b] = rightCount;
+        }
+
+        //Von links nach rechts die Kosten jeder Bingrenze bestimmen
+        glm_aabb_invalidate(box);
+        GLint leftCount = 0;
+        for (int b = 1; b < BVH_BIN_COUNT; ++b) {
+            if (bins[b - 1].count > 0) {
+                glm_aabb_merge(box, bins[b - 1].box, box);
+            }
+            leftCount += bins[b - 1].count;
+            if (leftCount == 0 || rightCounts[b] == 0) {
+                continue;
+            }
+            GLfloat cost = bvh_surfaceArea(box[0], box[1]) * (GLfloat) leftCount +
+                           rightAreas[b] * (GLfloat) rightCounts[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    //SAH: Kosten des Splits mit den Kosten eines Blattes vergleichen
+    GLfloat nodeArea = bvh_surfaceArea(node->min, node->max);
+    GLfloat splitCost = BVH_COST_TRAVERSAL * nodeArea + BVH_COST_INTERSECTION * bestCost;
+    GLfloat leafCost = BVH_COST_INTERSECTION * nodeArea * (GLfloat) count;
+    if (bestAxis >= 0 && leafCost <= splitCost && count <= BVH_MAX_LEAF_SIZE) {
+        return GL_FALSE;
+    }
+
+    GLint split;
+    if (bestAxis >= 0) {
+        //Primitive anhand ihres Bins in-place aufteilen
+        GLfloat scale = (GLfloat) BVH_BIN_COUNT / (centroidBox[1][bestAxis] - centroidBox[0][bestAxis]);
+        GLint i = first;
+        GLint j = first + count - 1;
+        while (i <= j) {
+            GLint prim = builder->order[i];
+            if (bvh_binIndex(builder->centroids[prim][bestAxis], centroidBox[0][bestAxis], scale) < bestBin) {
+                i++;
+            } else {
+                builder->order[i] = builder->order[j];
+                builder->order[j--] = prim;
+            }
+        }
+        split = i - first;
+    } else if (count > BVH_MAX_LEAF_SIZE) {
+        //Alle Schwerpunkte liegen aufeinander, zu grosses Blatt trotzdem in der Mitte teilen
+        split = count / 2;
+    } else {
+        return GL_FALSE;
+    }
+
+    //Kinder liegen immer direkt hintereinander (node kann durch realloc ungueltig werden)
+    GLint left = bvh_allocChildren(builder);
+    builder->nodes[nodeIdx].leftFirst = left;
+    builder->nodes[nodeIdx].count = 0;
+    *splitCount = split;
+    return GL_TRUE;
+}
+
+/**
+ * Baut rekursiv den Knoten an nodeIdx fuer die Primitive order[first, first + count) auf
+ */
+static void bvh_buildNode(bvhBuilder *builder, GLint nodeIdx, GLint first, GLint count, GLint depth) {
+    GLint split;
+    if (!bvh_splitNode(builder, nodeIdx, first, count, depth, &split)) {
+        return;
+    }
+    GLint left = builder->nodes[nodeIdx].leftFirst;
+    bvh_buildNode(builder, left, first, split, depth + 1);
+    bvh_buildNode(builder, left + 1, first + split, count - split, depth + 1);
+}
+
+/**
+ * Teilt die oberen Ebenen seriell auf, bis die Teilbaeume klein genug sind,
+ * und merkt sich diese als Aufgaben fuer den parallelen Aufbau
+ */
+static void bvh_buildTop(bvhBuilder *builder, GLint nodeIdx, GLint first, GLint count, GLint depth,
+                         bvhBuildContext *context) {
+    if (count <= context->taskSize) {
+        if (context->taskCount == context->taskCapacity) {
+            context->taskCapacity *= 2;
+            context->tasks = realloc(context->tasks, context->taskCapacity * sizeof(bvhBuildTask));
+            if (context->tasks == NULL) {
+                printf("Error allocating BVH!\n");
+                exit(1);
+            }
+        }
+        bvhBuildTask *task = &context->tasks[context->taskCount++];
+        task->nodeIdx = nodeIdx;
+        task->first = first;
+        task->count = count;
+        task->depth = depth;
+        return;
+    }
+
+    GLint split;
+    if (!bvh_splitNode(builder, nodeIdx, first, count, depth, &split)) {
+        return;
+    }
+    GLint left = builder->nodes[nodeIdx].leftFirst;
+    bvh_buildTop(builder, left, first, split, depth + 1, context);
+    bvh_buildTop(builder, left + 1, first + split, count - split, depth + 1, context);
+}
+
+/**
+ * Job: baut einen Teilbaum in einem eigenen Knotenarray auf
+ */
+static void bvh_buildTaskJob(GLint idx, void *ctx) {
+    bvhBuildContext *context = (bvhBuildContext *) ctx;
+    bvhBuildTask *task = &context->tasks[idx];
+
+    task->local = *context->shared;
+    task->local.capacity = 2 * task->count;
+    task->local.nodes = malloc(task->local.capacity * sizeof(bvhNode));
+    task->local.nodeCount = 1;
+    if (task->local.nodes == NULL) {
+        printf("Error allocating BVH!\n");
+        exit(1);
+    }
+
+    bvh_buildNode(&task->local, 0, task->first, task->count, task->depth);
+}
+
+/**
+ * Haengt einen parallel aufgebauten Teilbaum an das gemeinsame Knotenarray an
+ */
+static void bvh_mergeTask(bvhBuilder *builder, const bvhBuildTask *task) {
+    //Lokale Indizes ab 1 landen ab dem aktuellen Ende des gemeinsamen Arrays
+    GLint offset = builder->nodeCount - 1;
+    for (int i = 0; i < task->local.nodeCount; ++i) {
+        bvhNode node = task->local.nodes[i];
+        if (node.count == 0) {
+            node.leftFirst += offset;
+        }
+        builder->nodes[i == 0 ? task->nodeIdx : i + offset] = node;
+    }
+    builder->nodeCount += task->local.nodeCount - 1;
+}
+
+/**
+ * Bestimmt Tiefe, Blattanzahl und SAH Kosten eines fertigen Baums
+ */
+static void bvh_computeStats(bvh *tree) {
+    tree->stats.depth = 0;
+    tree->stats.leafCount = 0;
+    tree->stats.sahCost = 0.0f;
+
+    GLfloat rootArea = bvh_surfaceArea(tree->nodes[0].min, tree->nodes[0].max);
+    GLint stack[BVH_STACK_SIZE];
+    GLint depths[BVH_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize] = 0;
+    depths[stackSize++] = 1;
+
+    GLfloat cost = 0.0f;
+    while (stackSize > 0) {
+        --stackSize;
+        const bvhNode *node = &tree->nodes[stack[stackSize]];
+        GLint depth = depths[stackSize];
+        GLfloat area = bvh_surfaceArea((float *) node->min, (float *) node->max);
+        if (depth > tree->stats.depth) {
+            tree->stats.depth = depth;
+        }
+
+        if (node->count > 0) {
+            tree->stats.leafCount++;
+            cost += BVH_COST_INTERSECTION * area * (GLfloat) node->count;
+        } else {
+            cost += BVH_COST_TRAVERSAL * area;
+            stack[stackSize] = node->leftFirst;
+            depths[stackSize++] = depth + 1;
+            stack[stackSize] = node->leftFirst + 1;
+            depths[stackSize++] = depth + 1;
+        }
+    }
+    //Kosten relativ zur Wurzel, also erwartete Anzahl Tests je Strahl, der die Wurzel trifft
+    tree->stats.sahCost = rootArea > 0.0f ? cost / rootArea : 0.0f;
+}
+
+/**
+ * Berechnet die inverse Strahlrichtung fuer die Slab Tests
+ */
+static void bvh_inverseDir(const vec3 dir, vec3 invDir) {
+    invDir[0] = 1.0f / dir[0];
+    invDir[1] = 1.0f / dir[1];
+    invDir[2] = 1.0f / dir[2];
+}
+
+/**
+ * Berechnet die triangleTM Records (Kanten und Normale) aller Dreiecke aus den Indizes und Vertizes
+ * @param obj Objekt mit Indizes in Blattreihenfolge
+ * @return Dreiecke in derselben Reihenfolge wie die Indizes
+ */
+static triangleTM *bvh_buildTriangles(const object *obj) {
+    triangleTM *result = calloc(obj->faceCount, sizeof(triangleTM));
+    if (result == NULL) {
+        printf("Error allocating triangles!\n");
+        exit(1);
+    }
+    for (int i = 0; i < obj->faceCount; ++i) {
+        bvh_getTriangle(obj, i, &result[i]);
+    }
+    return result;
+}
+
+/**
+ * Behaelt vom binaeren Baum nur die Wurzel, deren Box die komprimierte BVH als Ausgangspunkt braucht.
+ * Die weiten Baeume und die SoA Bloecke werden dann gar nicht erst aufgebaut.
+ * @param tree BVH mit aufgebauter komprimierter BVH
+ */
+static void bvh_keepRootOnly(bvh *tree) {
+    bvhNode *root = realloc(tree->nodes, sizeof(bvhNode));
+    if (root != NULL) {
+        tree->nodes = root;
+    }
+    tree->nodeCount = 1;
+    tree->nodes4 = NULL;
+    tree->nodeCount4 = 0;
+    tree->nodes8 = NULL;
+    tree->nodeCount8 = 0;
+    tree->blocks4 = NULL;
+    tree->blockCount4 = 0;
+    tree->leafBlock4 = NULL;
+    tree->blocks8 = NULL;
+    tree->blockCount8 = 0;
+    tree->leafBlock8 = NULL;
+    tree->compressedOnly = GL_TRUE;
+}
+
+/**
+ * Packt die Dreiecke aller Blaetter in SoA Bloecke der Breite width.
+ * Jedes Blatt beginnt mit einem eigenen Block, damit Blaetter ueber ihren
+ * ersten Dreiecksindex auf ihre Bloecke zugreifen koennen.
+ * @param obj Objekt mit aufgebautem binaeren Baum
+ * @param width 4 oder 8
+ * @param blocks Ausgabe, triangleBlock4 bzw. triangleBlock8 Array
+ * @param leafBlock Ausgabe, erster Block je Blatt (indiziert ueber das erste Dreieck)
+ * @return Anzahl der Bloecke
+ */
+static GLint bvh_buildTriangleBlocks(object *obj, GLint width, void **blocks, GLint **leafBlock) {
+    size_t blockSize = width == 4 ? sizeof(triangleBlock4) : sizeof(triangleBlock8);
+
+    //Anzahl der Bloecke bestimmen
+    GLint blockCount = 0;
+    for (int n = 0; n < obj->bvh.nodeCount; ++n) {
+        if (obj->bvh.nodes[n].count > 0) {
+            blockCount += (obj->bvh.nodes[n].count + width - 1) / width;
+        }
+    }
+
+    //calloc -> leere Plaetze haben Kanten der Laenge 0
+    *blocks = calloc(blockCount, blockSize);
+    *leafBlock = calloc(obj->faceCount, sizeof(GLint));
+    if (*blocks == NULL || *leafBlock == NULL) {
+        printf("Error allocating triangle blocks!\n");
+        exit(1);
+    }
+
+    GLint nextBlock = 0;
+    for (int n = 0; n < obj->bvh.nodeCount; ++n) {
+        const bvhNode *node = &obj->bvh.nodes[n];
+        if (node->count == 0) {
+            continue;
+        }
+        (*leafBlock)[node->leftFirst] = nextBlock;
+        for (int i = 0; i < node->count; ++i) {
+            GLint lane = i % width;
+            GLint blockIdx = nextBlock + i / width;
+            GLfloat *vertex, *edge1, *edge2;
+            GLint *idx;
+            if (width == 4) {
+                triangleBlock4 *block = &((triangleBlock4 *) *blocks)[blockIdx];
+                vertex = &block->vertex[0][0];
+                edge1 = &block->edge1[0][0];
+                edge2 = &block->edge2[0][0];
+                idx = block->idx;
+            } else {
+                triangleBlock8 *block = &((triangleBlock8 *) *blocks)[blockIdx];
+                vertex = &block->vertex[0][0];
+                edge1 = &block->edge1[0][0];
+                edge2 = &block->edge2[0][0];
+                idx = block->idx;
+            }
+
+            //Leere Plaetze am Ende des Blocks markieren
+            if (lane == 0) {
+                for (int k = 0; k < width; ++k) {
+                    idx[k] = -1;
+                }
+            }
+
+            const triangleTM *tri = &obj->facesTM[node->leftFirst + i];
+            for (int axis = 0; axis < 3; ++axis) {
+                vertex[axis * width + lane] = tri->vertices.a[axis];
+                edge1[axis * width + lane] = tri->edge1[axis];
+                edge2[axis * width + lane] = tri->edge2[axis];
+            }
+            idx[lane] = node->leftFirst + i;
+        }
+        nextBlock += (node->count + width - 1) / width;
+    }
+
+    return blockCount;
+}
+
+/**
+ * Prueft, ob ueber die komprimierte BVH traversiert werden kann (auch wenn die Wurzel ein Blatt ist)
+ */
+static GLboolean bvh_hasCompressed(const object *obj) {
+    return obj->indices != NULL && (obj->bvh.nodesQ != NULL || obj->bvh.nodes[0].count > 0);
+}
+
+/**
+ * Sucht den naehesten Schnittpunkt ueber den binaeren Baum
+ */
+static GLint bvh_intersectClosestBinary(const bvhLeafQuery *query, GLfloat *dist) {
+    GLint result = -1;
+    const object *obj = query->obj;
+
+    vec3 invDir;
+    bvh_inverseDir(query->ray.dir, invDir);
+
+    bvhStackEntry stack[BVH_STACK_SIZE];
+    GLint stackSize = 0;
+
+    GLfloat tRoot = bvh_intersectNode(&obj->bvh.nodes[0], query->ray.start, invDir, *dist);
+    if (tRoot == FLT_MAX) {
+        return result;
+    }
+    stack[stackSize].node = 0;
+    stack[stackSize++].tEntry = tRoot;
+
+    while (stackSize > 0) {
+        bvhStackEntry entry = stack[--stackSize];
+        //Knoten liegt hinter dem bisher naehesten Treffer
+        if (entry.tEntry >= *dist) {
+            continue;
+        }
+
+        const bvhNode *node = &obj->bvh.nodes[entry.node];
+        if (node->count > 0) {
+            //Blatt: alle Dreiecke testen
+            GLint idxTri = bvh_intersectLeafClosest(query, node->leftFirst, node->count, dist);
+            if (idxTri >= 0) {
+                result = idxTri;
+            }
+        } else {
+            //Innerer Knoten: naeheres Kind zuletzt auf den Stack, damit es zuerst besucht wird
+            GLint left = node->leftFirst;
+            GLint right = left + 1;
+            GLfloat tLeft = bvh_intersectNode(&obj->bvh.nodes[left], query->ray.start, invDir, *dist);
+            GLfloat tRight = bvh_intersectNode(&obj->bvh.nodes[right], query->ray.start, invDir, *dist);
+
+            if (tLeft > tRight) {
+                GLint tmpNode = left;
+                left = right;
+                right = tmpNode;
+                GLfloat tmpT = tLeft;
+                tLeft = tRight;
+                tRight = tmpT;
+            }
+            if (tRight != FLT_MAX) {
+                stack[stackSize].node = right;
+                stack[stackSize++].tEntry = tRight;
+            }
+            if (tLeft != FLT_MAX) {
+                stack[stackSize].node = left;
+                stack[stackSize++].tEntry = tLeft;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Prueft ueber den binaeren Baum, ob irgendein Dreieck dichter als maxDist getroffen wird.
+ * Die Kinder werden nicht nach Eintrittsdistanz sortiert, sondern entlang der Hauptachse
+ * des Strahls von vorne nach hinten besucht (ohne zusaetzliche Slab Tests).
+ */
+static GLboolean bvh_intersectAnyBinary(const bvhLeafQuery *query, GLfloat maxDist) {
+    const object *obj = query->obj;
+    vec3 invDir;
+    bvh_inverseDir(query->ray.dir, invDir);
+
+    //Hauptachse des Strahls bestimmen
+    GLint axis = 0;
+    for (int i = 1; i < 3; ++i) {
+        if (fabsf(query->ray.dir[i]) > fabsf(query->ray.dir[axis])) {
+            axis = i;
+        }
+    }
+    GLboolean positive = query->ray.dir[axis] > 0.0f;
+
+    GLint stack[BVH_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const bvhNode *node = &obj->bvh.nodes[stack[--stackSize]];
+        if (bvh_intersectNode(node, query->ray.start, invDir, maxDist) == FLT_MAX) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            //Erster Treffer vor maxDist reicht aus
+            if (bvh_intersectLeafAny(query, node->leftFirst, node->count, maxDist)) {
+                return GL_TRUE;
+            }
+        } else {
+            GLint near = node->leftFirst;
+            GLint far = node->leftFirst + 1;
+            const bvhNode *left = &obj->bvh.nodes[near];
+            const bvhNode *right = &obj->bvh.nodes[far];
+            if (positive ? (right->min[axis] < left->min[axis]) : (right->max[axis] > left->max[axis])) {
+                near = far;
+                far = node->leftFirst;
+            }
+            stack[stackSize++] = far;
+            stack[stackSize++] = near;
+        }
+    }
+
+    return GL_FALSE;
+}
+
+/**---------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+bvh bvh_buildFromBounds(vec3 (*primBounds)[2], GLint primCount, GLint *order) {
+    //Alle Layouts und Kennzahlen leer initialisieren
+    bvh result;
+    memset(&result, 0, sizeof(bvh));
+
+    if (primCount <= 0) {
+        return result;
+    }
+
+    //Nicht ueber GLUT, Meshes werden auch in Arbeitsthreads aufgebaut
+    double startTime = multiThreading_seconds();
+
+    bvhBuilder builder;
+    builder.bounds = primBounds;
+    builder.order = order;
+    builder.centroids = calloc(primCount, sizeof(vec3));
+    //Binaerer Baum mit n Blaettern hat hoechstens 2n - 1 Knoten
+    builder.capacity = 2 * primCount;
+    builder.nodes = calloc(builder.capacity, sizeof(bvhNode));
+    builder.nodeCount = 1;
+
+    bvhBuildContext context;
+    context.shared = &builder;
+    context.taskCount = 0;
+    context.taskCapacity = BVH_BUILD_TASKS;
+    context.taskSize = primCount / BVH_BUILD_TASKS;
+    if (context.taskSize < BVH_BUILD_MIN_TASK_SIZE) {
+        context.taskSize = BVH_BUILD_MIN_TASK_SIZE;
+    }
+    context.tasks = calloc(context.taskCapacity, sizeof(bvhBuildTask));
+
+    if (builder.centroids == NULL || builder.nodes == NULL || context.tasks == NULL) {
+        printf("Error allocating BVH!\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < primCount; ++i) {
+        order[i] = i;
+        glm_aabb_center(primBounds[i], builder.centroids[i]);
+    }
+
+    //Obere Ebenen seriell aufteilen, Teilbaeume parallel aufbauen und wieder zusammenfuegen
+    //Die Aufteilung haengt nicht von der Threadanzahl ab, der Baum ist also immer identisch
+    bvh_buildTop(&builder, 0, 0, primCount, 0, &context);
+    multiThreading_runJobs(context.taskCount, multiThreading_cpuCount(), bvh_buildTaskJob, &context);
+
+    for (int i = 0; i < context.taskCount; ++i) {
+        bvh_mergeTask(&builder, &context.tasks[i]);
+        free(context.tasks[i].local.nodes);
+    }
+
+    free(context.tasks);
+    free(builder.centroids);
+
+    //Ungenutzten Speicher zurueckgeben
+    result.nodes = realloc(builder.nodes, builder.nodeCount * sizeof(bvhNode));
+    if (result.nodes == NULL) {
+        result.nodes = builder.nodes;
+    }
+    result.nodeCount = builder.nodeCount;
+
+    bvh_computeStats(&result);
+    result.stats.buildTime = (GLint) ((multiThreading_seconds() - startTime) * 1000.0);
+    return result;
+}
+
+void bvh_buildObject(object *obj, GLboolean compressedOnly) {
+    if (obj->faceCount <= 0) {
+        obj->bvh = bvh_buildFromBounds(NULL, 0, NULL);
+        bvhWide_collapse(&obj->bvh);
+        obj->bvh.blocks4 = NULL;
+        obj->bvh.blockCount4 = 0;
+        obj->bvh.leafBlock4 = NULL;
+        obj->bvh.blocks8 = NULL;
+        obj->bvh.blockCount8 = 0;
+        obj->bvh.leafBlock8 = NULL;
+        return;
+    }
+
+    vec3 (*bounds)[2] = calloc(obj->faceCount, sizeof(*bounds));
+    GLint *order = calloc(obj->faceCount, sizeof(GLint));
+    faces *sortedIndices = calloc(obj->faceCount, sizeof(faces));
+    if (bounds == NULL || order == NULL || sortedIndices == NULL) {
+        printf("Error allocating BVH!\n");
+        exit(1);
+    }
+
+    //AABB jedes Dreiecks
+    for (int i = 0; i < obj->faceCount; ++i) {
+        const faces *tri = &obj->indices[i];
+        glm_vec3_minv(obj->vertices[tri->index1], obj->vertices[tri->index2], bounds[i][0]);
+        glm_vec3_minv(bounds[i][0], obj->vertices[tri->index3], bounds[i][0]);
+        glm_vec3_maxv(obj->vertices[tri->index1], obj->vertices[tri->index2], bounds[i][1]);
+        glm_vec3_maxv(bounds[i][1], obj->vertices[tri->index3], bounds[i][1]);
+    }
+
+    obj->bvh = bvh_buildFromBounds(bounds, obj->faceCount, order);
+
+    //Dreiecke in Blattreihenfolge bringen, damit Blaetter zusammenhaengende Bereiche referenzieren
+    for (int i = 0; i < obj->faceCount; ++i) {
+        sortedIndices[i] = obj->indices[order[i]];
+    }
+    free(obj->indices);
+    obj->indices = sortedIndices;
+    free(bounds);
+    free(order);
+
+    //Quantisierte Knoten ueber die indizierten Dreiecke
+    bvhCompressed_build(obj);
+
+    //Nur die komprimierte BVH behalten, alle anderen Layouts werden nicht aufgebaut
+    if (compressedOnly && bvh_hasCompressed(obj)) {
+        bvh_keepRootOnly(&obj->bvh);
+        return;
+    }
+
+    //Kanten und Normalen vorberechnen -> spart Rechenleistung beim Schnitttest und beim Rendern
+    obj->facesTM = bvh_buildTriangles(obj);
+
+    //Weite Layouts aus dem binaeren Baum erzeugen
+    bvhWide_collapse(&obj->bvh);
+
+    //Dreiecke der Blaetter zusaetzlich als SoA Bloecke ablegen
+    void *blocks;
+    obj->bvh.blockCount4 = bvh_buildTriangleBlocks(obj, 4, &blocks, &obj->bvh.leafBlock4);
+    obj->bvh.blocks4 = (triangleBlock4 *) blocks;
+    obj->bvh.blockCount8 = bvh_buildTriangleBlocks(obj, 8, &blocks, &obj->bvh.leafBlock8);
+    obj->bvh.blocks8 = (triangleBlock8 *) blocks;
+}
+
+GLint bvh_intersectClosest(const object *obj, bvhOptions opts, Ray ray, GLfloat *dist) {
+    if (obj->bvh.nodeCount == 0) {
+        return -1;
+    }
+
+    bvhLeafQuery query;
+    bvh_initLeafQuery(obj, opts.triLayout, ray, &query);
+
+    switch (bvh_objectLayout(obj, opts.layout)) {
+        case bvh4:
+        case bvh8:
+            return bvhWide_intersectClosest(&query, opts.layout, dist);
+        case bvhQuantized:
+            if (bvh_hasCompressed(obj)) {
+                return bvhCompressed_intersectClosest(&query, dist);
+            }
+            return bvh_intersectClosestBinary(&query, dist);
+        case bvh2:
+        default:
+            return bvh_intersectClosestBinary(&query, dist);
+    }
+}
+
+GLboolean bvh_intersectAny(const object *obj, bvhOptions opts, Ray ray, GLfloat maxDist) {
+    if (obj->bvh.nodeCount == 0) {
+        return GL_FALSE;
+    }
+
+    bvhLeafQuery query;
+    bvh_initLeafQuery(obj, opts.triLayout, ray, &query);
+
+    switch (bvh_objectLayout(obj, opts.layout)) {
+        case bvh4:
+        case bvh8:
+            return bvhWide_intersectAny(&query, opts.layout, maxDist);
+        case bvhQuantized:
+            if (bvh_hasCompressed(obj)) {
+                return bvhCompressed_intersectAny(&query, maxDist);
+            }
+            return bvh_intersectAnyBinary(&query, maxDist);
+        case bvh2:
+        default:
+            return bvh_intersectAnyBinary(&query, maxDist);
+    }
+}
+
+void bvh_initLeafQuery(const object *obj, triangleLayout triLayout, Ray ray, bvhLeafQuery *query) {
+    query->obj = obj;
+    query->triLayout = triLayout;
+    query->ray = ray;
+    if (triLayout != trisAoS) {
+        trumboreMoeller_initBlockRay(&ray, &query->blockRay);
+    }
+}
+
+GLint bvh_intersectLeafClosest(const bvhLeafQuery *query, GLint first, GLint count, GLfloat *dist) {
+    GLint result = -1;
+    const bvh *tree = &query->obj->bvh;
+    GLfloat u, v;
+
+    switch (query->triLayout) {
+        case trisSoA4: {
+            const triangleBlock4 *blocks = &tree->blocks4[tree->leafBlock4[first]];
+            for (int b = 0; b < (count + 3) / 4; ++b) {
+                GLint lane = trumboreMoeller_intersectBlock4(&query->blockRay, &blocks[b], dist, &u, &v);
+                if (lane >= 0) {
+                    result = blocks[b].idx[lane];
+                }
+            }
+            break;
+        }
+        case trisSoA8: {
+            const triangleBlock8 *blocks = &tree->blocks8[tree->leafBlock8[first]];
+            for (int b = 0; b < (count + 7) / 8; ++b) {
+                GLint lane = trumboreMoeller_intersectBlock8(&query->blockRay, &blocks[b], dist, &u, &v);
+                if (lane >= 0) {
+                    result = blocks[b].idx[lane];
+                }
+            }
+            break;
+        }
+        case trisAoS:
+        default:
+            for (int i = first; i < first + count; ++i) {
+                Hit temp = trumboreMoeller_rayTriangleIntersection(query->ray, query->obj->facesTM[i]);
+                if (!temp.defaultHit && temp.dist < *dist) {
+                    *dist = temp.dist;
+                    result = i;
+                }
+            }
+            break;
+    }
+
+    return result;
+}
+
+GLboolean bvh_intersectLeafAny(const bvhLeafQuery *query, GLint first, GLint count, GLfloat maxDist) {
+    const bvh *tree = &query->obj->bvh;
+
+    //Nur die Frage nach irgendeinem Treffer, ohne naehesten Platz, Hit oder Position
+    switch (query->triLayout) {
+        case trisSoA4: {
+            const triangleBlock4 *blocks = &tree->blocks4[tree->leafBlock4[first]];
+            for (int b = 0; b < (count + 3) / 4; ++b) {
+                if (trumboreMoeller_occludesBlock4(&query->blockRay, &blocks[b], maxDist)) {
+                    return GL_TRUE;
+                }
+            }
+            break;
+        }
+        case trisSoA8: {
+            const triangleBlock8 *blocks = &tree->blocks8[tree->leafBlock8[first]];
+            for (int b = 0; b < (count + 7) / 8; ++b) {
+                if (trumboreMoeller_occludesBlock8(&query->blockRay, &blocks[b], maxDist)) {
+                    return GL_TRUE;
+                }
+            }
+            break;
+        }
+        case trisAoS:
+        default:
+            for (int i = first; i < first + count; ++i) {
+                if (trumboreMoeller_rayTriangleOccludes(&query->ray, &query->obj->facesTM[i], maxDist)) {
+                    return GL_TRUE;
+                }
+            }
+            break;
+    }
+    return GL_FALSE;
+}
+
+const char *bvh_layoutName(bvhLayout layout) {
+    switch (layout) {
+        case bvh4:
+            return "BVH4";
+        case bvh8:
+            return "BVH8";
+        case bvhQuantized:
+            return "BVH2 Quantized";
+        case bvh2:
+        default:
+            return "BVH2";
+    }
+}
+
+const char *bvh_triangleLayoutName(triangleLayout triLayout) {
+    switch (triLayout) {
+        case trisSoA4:
+            return "SoA4";
+        case trisSoA8:
+            return "SoA8";
+        case trisAoS:
+        default:
+            return "AoS";
+    }
+}
+
+void bvh_getTriangle(const object *obj, GLint tri, triangleTM *result) {
+    if (obj->facesTM != NULL) {
+        *result = obj->facesTM[tri];
+        return;
+    }
+    //Ohne triangleTM Records wie beim Aufbau aus den Vertizes berechnen, damit die Normalen gleich sind
+    const faces *idx = &obj->indices[tri];
+    glm_vec3_copy(obj->vertices[idx->index1], result->vertices.a);
+    glm_vec3_copy(obj->vertices[idx->index2], result->vertices.b);
+    glm_vec3_copy(obj->vertices[idx->index3], result->vertices.c);
+    utils_calcTwoEdgesTM(result);
+    utils_calcNormal(result);
+}
+
+GLfloat bvh_bytesPerTriangle(const object *obj) {
+    if (obj->faceCount <= 0) {
+        return 0.0f;
+    }
+
+    //Alles, was vom Mesh im Speicher liegt, unabhaengig vom gerade eingestellten Layout
+    size_t bytes = obj->vertexCount * sizeof(vec3) + bvh_memoryFootprint(&obj->bvh, obj->faceCount);
+    if (obj->facesTM != NULL) {
+        bytes += obj->faceCount * sizeof(triangleTM);
+    }
+    if (obj->indices != NULL) {
+        bytes += obj->faceCount * sizeof(faces);
+    }
+    return (GLfloat) bytes / (GLfloat) obj->faceCount;
+}
+
+size_t bvh_memoryFootprint(const bvh *tree, GLint primCount) {
+    size_t result = tree->nodeCount * sizeof(bvhNode) + tree->nodeCount4 * sizeof(bvh4Node) +
+                    tree->nodeCount8 * sizeof(bvh8Node) + tree->blockCount4 * sizeof(triangleBlock4) +
+                    tree->blockCount8 * sizeof(triangleBlock8) + tree->nodeCountQ * sizeof(bvhQuantNode);
+    //Erster Block je Blatt, indiziert ueber das erste Dreieck
+    if (tree->leafBlock4 != NULL) {
+        result += primCount * sizeof(GLint);
+    }
+    if (tree->leafBlock8 != NULL) {
+        result += primCount * sizeof(GLint);
+    }
+    return result;
+}
+
+void bvh_free(bvh *tree) {
+    if (tree->nodes != NULL) {
+        free(tree->nodes);
+    }
+    if (tree->nodes4 != NULL) {
+        free(tree->nodes4);
+    }
+    if (tree->nodes8 != NULL) {
+        free(tree->nodes8);
+    }
+    if (tree->blocks4 != NULL) {
+        free(tree->blocks4);
+        free(tree->leafBlock4);
+    }
+    if (tree->blocks8 != NULL) {
+        free(tree->blocks8);
+        free(tree->leafBlock8);
+    }
+    if (tree->nodesQ != NULL) {
+        free(tree->nodesQ);
+    }
+    tree->nodes = NULL;
+    tree->nodeCount = 0;
+    tree->nodes4 = NULL;
+    tree->nodeCount4 = 0;
+    tree->nodes8 = NULL;
+    tree->nodeCount8 = 0;
+    tree->blocks4 = NULL;
+    tree->blockCount4 = 0;
+    tree->leafBlock4 = NULL;
+    tree->blocks8 = NULL;
+    tree->blockCount8 = 0;
+    tree->leafBlock8 = NULL;
+    tree->nodesQ = NULL;
+    tree->nodeCountQ = 0;
+    tree->compressedOnly = GL_FALSE;
+}
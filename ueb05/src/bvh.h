@@ -0,0 +1,157 @@
+#ifndef RAYTRACER_BVH_H
+#define RAYTRACER_BVH_H
+#include "types.h"
+#include "boundingBox.h"
+#include "trumboreMoeller.h"
+
+/** Strahl und Einstellungen fuer die Dreieckstests in den Blaettern einer BVH */
+typedef struct bvhLeafQuery {
+    const object *obj;
+    triangleLayout triLayout;
+    Ray ray;
+    /** Nur fuer die SoA Layouts vorbereitet */
+    triangleBlockRay blockRay;
+} bvhLeafQuery;
+
+/**
+ * Baut eine BVH ueber beliebige Primitive anhand ihrer Bounding Boxes auf.
+ * Die Splits werden ueber die Surface Area Heuristic (SAH) bestimmt.
+ * @param primBounds AABB jedes Primitivs (min, max)
+ * @param primCount Anzahl der Primitive
+ * @param order Ausgabe, Reihenfolge in der die Primitive in den Blaettern liegen (primCount Eintraege)
+ * @return BVH, leer wenn keine Primitive uebergeben wurden
+ */
+bvh bvh_buildFromBounds(vec3 (*primBounds)[2], GLint primCount, GLint *order);
+
+/**
+ * Baut die BVH eines Objektes auf und sortiert die Dreiecke des Objektes
+ * in die Reihenfolge der Blaetter um. Neben dem binaeren Baum werden die triangleTM Records,
+ * die 4-fach und 8-fach Layouts, die SoA Dreiecksbloecke und die komprimierte BVH erzeugt.
+ * Mit compressedOnly bleiben nur die komprimierte BVH, die Wurzel des binaeren Baums, die Indizes
+ * und die Vertizes uebrig (bvh.compressedOnly). Laesst sich die komprimierte BVH nicht aufbauen,
+ * werden doch alle Layouts erzeugt.
+ * @param obj Objekt mit Vertizes und Indizes
+ * @param compressedOnly GL_TRUE, wenn nur die komprimierte BVH aufgebaut werden soll
+ */
+void bvh_buildObject(object *obj, GLboolean compressedOnly);
+
+/**
+ * Sucht den naehesten Schnittpunkt eines Strahls mit den Dreiecken eines Objektes
+ * @param obj Objekt mit aufgebauter BVH
+ * @param opts Knoten- und Dreieckslayout, mit dem traversiert wird
+ * @param ray Strahl
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @return Index des getroffenen Dreiecks, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint bvh_intersectClosest(const object *obj, bvhOptions opts, Ray ray, GLfloat *dist);
+
+/**
+ * Prueft, ob ein Strahl irgendein Dreieck eines Objektes innerhalb einer Distanz trifft.
+ * Reiner Verdeckungstest fuer Schattenstrahlen: bricht beim ersten Treffer ab
+ * und berechnet keine Trefferattribute.
+ * @param obj Objekt mit aufgebauter BVH
+ * @param opts Knoten- und Dreieckslayout, mit dem traversiert wird
+ * @param ray Strahl
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE, sobald ein Dreieck dichter als maxDist getroffen wurde
+ */
+GLboolean bvh_intersectAny(const object *obj, bvhOptions opts, Ray ray, GLfloat maxDist);
+
+/**
+ * Knotenlayout, mit dem ein Objekt traversiert wird. Objekte, von denen nur die komprimierte BVH
+ * aufgebaut wurde, werden unabhaengig vom eingestellten Layout quantisiert traversiert.
+ * @param obj Objekt mit aufgebauter BVH
+ * @param layout eingestelltes Knotenlayout
+ * @return Knotenlayout, das das Objekt besitzt
+ */
+static inline bvhLayout bvh_objectLayout(const object *obj, bvhLayout layout) {
+    return obj->bvh.compressedOnly ? bvhQuantized : layout;
+}
+
+/**
+ * Slab Test eines Strahls mit der AABB eines binaeren Knotens.
+ * Steht im Header, damit auch die Traversierungen in bvhPacket und bvhTopLevel den Test inlinen koennen.
+ * @param node Knoten
+ * @param start Startpunkt des Strahls
+ * @param invDir komponentenweise inverse Richtung des Strahls
+ * @param maxDist maximale Distanz
+ * @return Eintrittsdistanz, FLT_MAX wenn die Box nicht (dichter als maxDist) getroffen wird
+ */
+static inline GLfloat bvh_intersectNode(const bvhNode *node, const vec3 start, const vec3 invDir, GLfloat maxDist) {
+    return boundingBox_intersectSlab(node->min, node->max, start, invDir, maxDist);
+}
+
+/**
+ * Bereitet einen Strahl fuer die Dreieckstests in den Blaettern vor
+ * @param obj Objekt, dessen Dreiecke getestet werden
+ * @param triLayout Dreieckslayout der Blaetter
+ * @param ray Strahl
+ * @param query Ausgabe
+ */
+void bvh_initLeafQuery(const object *obj, triangleLayout triLayout, Ray ray, bvhLeafQuery *query);
+
+/**
+ * Sucht den naehesten Treffer unter den Dreiecken eines Blattes
+ * @param query vorbereiteter Strahl
+ * @param first erstes Dreieck des Blattes
+ * @param count Anzahl der Dreiecke des Blattes
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Treffer (nur wenn getroffen)
+ * @return Index des getroffenen Dreiecks, -1 wenn keins dichter als dist getroffen wurde
+ */
+GLint bvh_intersectLeafClosest(const bvhLeafQuery *query, GLint first, GLint count, GLfloat *dist);
+
+/**
+ * Prueft, ob irgendein Dreieck eines Blattes dichter als maxDist getroffen wird (ohne Trefferattribute)
+ * @param query vorbereiteter Strahl
+ * @param first erstes Dreieck des Blattes
+ * @param count Anzahl der Dreiecke des Blattes
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE beim ersten Treffer
+ */
+GLboolean bvh_intersectLeafAny(const bvhLeafQuery *query, GLint first, GLint count, GLfloat maxDist);
+
+/**
+ * Liefert den Namen eines Knotenlayouts fuer Ausgaben
+ * @param layout Knotenlayout
+ * @return Name des Layouts
+ */
+const char *bvh_layoutName(bvhLayout layout);
+
+/**
+ * Liefert den Namen eines Dreieckslayouts fuer Ausgaben
+ * @param triLayout Dreieckslayout
+ * @return Name des Layouts
+ */
+const char *bvh_triangleLayoutName(triangleLayout triLayout);
+
+/**
+ * Liefert ein Dreieck mit Kanten und Normale, aus facesTM oder ohne triangleTM Records aus den Indizes berechnet
+ * @param obj Objekt mit aufgebauter BVH
+ * @param tri Index des Dreiecks (Blattreihenfolge)
+ * @param result Ausgabe
+ */
+void bvh_getTriangle(const object *obj, GLint tri, triangleTM *result);
+
+/**
+ * Bytes je Dreieck, die das Mesh tatsaechlich im Speicher belegt (Vertizes, Indizes, triangleTM Records
+ * und alle aufgebauten Layouts der BVH)
+ * @param obj Objekt mit aufgebauter BVH
+ * @return Bytes je Dreieck, 0 bei Objekten ohne Dreiecke
+ */
+GLfloat bvh_bytesPerTriangle(const object *obj);
+
+/**
+ * Speicherbedarf aller Knoten- und Dreieckslayouts einer BVH (ohne die triangleTM Records)
+ * @param tree BVH
+ * @param primCount Anzahl der Primitive, ueber die die BVH aufgebaut wurde
+ * @return Bytes
+ */
+size_t bvh_memoryFootprint(const bvh *tree, GLint primCount);
+
+/**
+ * Gibt den Speicher der BVH frei
+ * @param tree BVH
+ */
+void bvh_free(bvh *tree);
+
+#endif //RAYTRACER_BVH_H
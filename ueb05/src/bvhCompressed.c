@@ -0,0 +1,275 @@
+/**
+ * @file
+ * Komprimierte binaere BVH fuer grosse Meshes. Jeder innere Knoten speichert die Boxen seiner beiden
+ * Kinder mit BVH_QUANT_BITS je Koordinate relativ zu seiner eigenen Box; die Box wird beim Traversieren
+ * von der Wurzel (volle Genauigkeit) aus mitgefuehrt. Beim Quantisieren wird nach aussen gerundet,
+ * die dekodierten Boxen sind also etwas groesser, aber nie kleiner als die exakten.
+ * Die Blaetter testen indizierte Dreiecke direkt gegen die Vertizes des Objektes.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include "bvhCompressed.h"
+
+/** Groesster quantisierter Wert */
+#define BVH_COMPRESSED_QUANT_MAX ((1 << BVH_QUANT_BITS) - 1)
+/** Groesste Dreiecksanzahl eines Blattes, die im Knoten gespeichert werden kann */
+#define BVH_COMPRESSED_MAX_LEAF_COUNT (255)
+/** Groesse des Traversierungsstacks */
+#define BVH_COMPRESSED_STACK_SIZE (64)
+
+/** Eintrag auf dem Traversierungsstack, innere Knoten bringen ihre dekodierte Box mit */
+typedef struct bvhCompressedStackEntry {
+    /** Innerer Knoten: Index in nodesQ, Blatt: erstes Dreieck */
+    GLint child;
+    /** Anzahl der Dreiecke bei Blaettern, sonst 0 */
+    GLint count;
+    GLfloat tEntry;
+    vec3 min;
+    vec3 max;
+} bvhCompressedStackEntry;
+
+/** Zustand beim Erzeugen der komprimierten BVH */
+typedef struct bvhCompressedBuilder {
+    const bvh *tree;
+    bvhQuantNode *nodes;
+    GLint nodeCount;
+    GLboolean valid;
+} bvhCompressedBuilder;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/**
+ * Abstand zweier quantisierter Werte entlang einer Achse der Box
+ */
+static inline GLfloat bvhCompressed_step(GLfloat boxMin, GLfloat boxMax) {
+    return (boxMax - boxMin) * (1.0f / BVH_COMPRESSED_QUANT_MAX);
+}
+
+/**
+ * Dekodiert eine untere Ecke, 0 liefert exakt die untere Ecke der Box
+ */
+static inline GLfloat bvhCompressed_decodeMin(GLfloat boxMin, GLfloat step, GLint q) {
+    return boxMin + (GLfloat) q * step;
+}
+
+/**
+ * Dekodiert eine obere Ecke von oben, BVH_COMPRESSED_QUANT_MAX liefert exakt die obere Ecke der Box
+ */
+static inline GLfloat bvhCompressed_decodeMax(GLfloat boxMax, GLfloat step, GLint q) {
+    return boxMax - (GLfloat) (BVH_COMPRESSED_QUANT_MAX - q) * step;
+}
+
+/**
+ * Dekodiert die Box eines Kindes. Build und Traversierung verwenden dieselbe Rechnung,
+ * damit die Boxen, auf die sich die Enkel beziehen, bitgenau uebereinstimmen.
+ */
+static void bvhCompressed_decodeChild(const bvhQuantNode *node, GLint c, const vec3 boxMin, const vec3 boxMax,
+                                      vec3 childMin, vec3 childMax) {
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat step = bvhCompressed_step(boxMin[axis], boxMax[axis]);
+        childMin[axis] = bvhCompressed_decodeMin(boxMin[axis], step, node->qMin[c][axis]);
+        childMax[axis] = bvhCompressed_decodeMax(boxMax[axis], step, node->qMax[c][axis]);
+    }
+}
+
+/**
+ * Quantisiert die Box eines Kindes relativ zur dekodierten Box des Elternknotens (nach aussen gerundet)
+ */
+static void bvhCompressed_quantize(const vec3 boxMin, const vec3 boxMax, const bvhNode *child, bvhQuantNode *node,
+                                   GLint c) {
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat step = bvhCompressed_step(boxMin[axis], boxMax[axis]);
+        GLint lo = 0;
+        GLint hi = BVH_COMPRESSED_QUANT_MAX;
+        if (step > 0.0f) {
+            lo = (GLint) floorf((child->min[axis] - boxMin[axis]) / step);
+            hi = BVH_COMPRESSED_QUANT_MAX - (GLint) floorf((boxMax[axis] - child->max[axis]) / step);
+            lo = lo < 0 ? 0 : (lo > BVH_COMPRESSED_QUANT_MAX ? BVH_COMPRESSED_QUANT_MAX : lo);
+            hi = hi < 0 ? 0 : (hi > BVH_COMPRESSED_QUANT_MAX ? BVH_COMPRESSED_QUANT_MAX : hi);
+        }
+
+        //Rundungsfehler ausgleichen, die dekodierte Box muss das Kind vollstaendig enthalten
+        while (lo > 0 && bvhCompressed_decodeMin(boxMin[axis], step, lo) > child->min[axis]) {
+            lo--;
+        }
+        while (hi < BVH_COMPRESSED_QUANT_MAX && bvhCompressed_decodeMax(boxMax[axis], step, hi) < child->max[axis]) {
+            hi++;
+        }
+        node->qMin[c][axis] = (bvhQuant) lo;
+        node->qMax[c][axis] = (bvhQuant) hi;
+    }
+}
+
+/**
+ * Erzeugt rekursiv den komprimierten Knoten zu einem inneren Knoten des binaeren Baums
+ * @param binary Index des inneren Knotens im binaeren Baum
+ * @param boxMin dekodierte Box des Knotens
+ * @param boxMax dekodierte Box des Knotens
+ * @return Index des komprimierten Knotens
+ */
+static GLint bvhCompressed_buildNode(bvhCompressedBuilder *builder, GLint binary, const vec3 boxMin,
+                                     const vec3 boxMax) {
+    GLint idx = builder->nodeCount++;
+    const bvhNode *node = &builder->tree->nodes[binary];
+
+    for (int c = 0; c < 2; ++c) {
+        const bvhNode *child = &builder->tree->nodes[node->leftFirst + c];
+        bvhCompressed_quantize(boxMin, boxMax, child, &builder->nodes[idx], c);
+
+        if (child->count > 0) {
+            if (child->count > BVH_COMPRESSED_MAX_LEAF_COUNT) {
+                builder->valid = GL_FALSE;
+            }
+            builder->nodes[idx].child[c] = child->leftFirst;
+            builder->nodes[idx].count[c] = (GLubyte) child->count;
+        } else {
+            vec3 childMin, childMax;
+            bvhCompressed_decodeChild(&builder->nodes[idx], c, boxMin, boxMax, childMin, childMax);
+            GLint childIdx = bvhCompressed_buildNode(builder, node->leftFirst + c, childMin, childMax);
+            builder->nodes[idx].child[c] = childIdx;
+            builder->nodes[idx].count[c] = 0;
+        }
+    }
+    return idx;
+}
+
+/**
+ * Testet die indizierten Dreiecke eines Blattes
+ * @param anyHit GL_TRUE, wenn beim ersten Treffer abgebrochen werden kann
+ * @return Index des naehesten (bzw. ersten) getroffenen Dreiecks, -1 wenn keins dichter als dist getroffen wurde
+ */
+static GLint bvhCompressed_intersectLeaf(const bvhLeafQuery *query, GLint first, GLint count, GLfloat *dist,
+                                         GLboolean anyHit) {
+    const object *obj = query->obj;
+    GLint result = -1;
+    for (int i = first; i < first + count; ++i) {
+        const faces *tri = &obj->indices[i];
+        GLfloat t;
+        if (trumboreMoeller_rayVertexIntersection(&query->ray, obj->vertices[tri->index1],
+                                                  obj->vertices[tri->index2], obj->vertices[tri->index3], *dist,
+                                                  &t)) {
+            *dist = t;
+            result = i;
+            if (anyHit) {
+                return result;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Traversiert die komprimierte BVH von vorne nach hinten
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Treffer (nur wenn getroffen)
+ * @param anyHit GL_TRUE, wenn beim ersten Treffer abgebrochen werden kann
+ * @return Index des getroffenen Dreiecks, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+static GLint bvhCompressed_traverse(const bvhLeafQuery *query, GLfloat *dist, GLboolean anyHit) {
+    GLint result = -1;
+    const bvh *tree = &query->obj->bvh;
+    const GLfloat *start = query->ray.start;
+    vec3 invDir = {1.0f / query->ray.dir[0], 1.0f / query->ray.dir[1], 1.0f / query->ray.dir[2]};
+
+    //Die Wurzel liegt in voller Genauigkeit vor und kann selbst ein Blatt sein
+    const bvhNode *root = &tree->nodes[0];
+    GLfloat tRoot = bvh_intersectNode(root, start, invDir, *dist);
+    if (tRoot == FLT_MAX) {
+        return result;
+    }
+    if (root->count > 0) {
+        return bvhCompressed_intersectLeaf(query, root->leftFirst, root->count, dist, anyHit);
+    }
+
+    bvhCompressedStackEntry stack[BVH_COMPRESSED_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize].child = 0;
+    stack[stackSize].count = 0;
+    stack[stackSize].tEntry = tRoot;
+    glm_vec3_copy((float *) root->min, stack[stackSize].min);
+    glm_vec3_copy((float *) root->max, stack[stackSize++].max);
+
+    while (stackSize > 0) {
+        bvhCompressedStackEntry entry = stack[--stackSize];
+        //Knoten liegt hinter dem bisher naehesten Treffer
+        if (entry.tEntry >= *dist) {
+            continue;
+        }
+
+        if (entry.count > 0) {
+            GLint idxTri = bvhCompressed_intersectLeaf(query, entry.child, entry.count, dist, anyHit);
+            if (idxTri >= 0) {
+                result = idxTri;
+                if (anyHit) {
+                    return result;
+                }
+            }
+            continue;
+        }
+
+        //Boxen beider Kinder dekodieren und testen
+        const bvhQuantNode *node = &tree->nodesQ[entry.child];
+        bvhCompressedStackEntry children[2];
+        for (int c = 0; c < 2; ++c) {
+            bvhCompressed_decodeChild(node, c, entry.min, entry.max, children[c].min, children[c].max);
+            children[c].child = node->child[c];
+            children[c].count = node->count[c];
+            children[c].tEntry = boundingBox_intersectSlab(children[c].min, children[c].max, start, invDir, *dist);
+        }
+
+        //Naeheres Kind zuletzt auf den Stack, damit es zuerst besucht wird
+        GLint near = children[1].tEntry < children[0].tEntry ? 1 : 0;
+        GLint far = 1 - near;
+        if (children[far].tEntry != FLT_MAX) {
+            stack[stackSize++] = children[far];
+        }
+        if (children[near].tEntry != FLT_MAX) {
+            stack[stackSize++] = children[near];
+        }
+    }
+
+    return result;
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+void bvhCompressed_build(object *obj) {
+    bvh *tree = &obj->bvh;
+    tree->nodesQ = NULL;
+    tree->nodeCountQ = 0;
+    if (tree->nodeCount == 0 || tree->nodes[0].count > 0) {
+        return;
+    }
+
+    //Ein voller binaerer Baum mit n Knoten hat (n - 1) / 2 innere Knoten
+    bvhCompressedBuilder builder;
+    builder.tree = tree;
+    builder.nodes = calloc(tree->nodeCount / 2 + 1, sizeof(bvhQuantNode));
+    builder.nodeCount = 0;
+    builder.valid = GL_TRUE;
+    if (builder.nodes == NULL) {
+        printf("Error allocating compressed BVH!\n");
+        exit(1);
+    }
+
+    bvhCompressed_buildNode(&builder, 0, tree->nodes[0].min, tree->nodes[0].max);
+
+    if (!builder.valid) {
+        printf("Compressed BVH: leaf too large, falling back to BVH2\n");
+        free(builder.nodes);
+        return;
+    }
+    tree->nodesQ = builder.nodes;
+    tree->nodeCountQ = builder.nodeCount;
+}
+
+GLint bvhCompressed_intersectClosest(const bvhLeafQuery *query, GLfloat *dist) {
+    return bvhCompressed_traverse(query, dist, GL_FALSE);
+}
+
+GLboolean bvhCompressed_intersectAny(const bvhLeafQuery *query, GLfloat maxDist) {
+    return bvhCompressed_traverse(query, &maxDist, GL_TRUE) >= 0;
+}
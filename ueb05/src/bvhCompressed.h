@@ -0,0 +1,30 @@
+#ifndef RAYTRACER_BVHCOMPRESSED_H
+#define RAYTRACER_BVHCOMPRESSED_H
+#include "bvh.h"
+
+/**
+ * Erzeugt aus dem binaeren Baum eines Objektes die komprimierte BVH mit quantisierten Kindboxen.
+ * Die Blaetter referenzieren die indizierten Dreiecke des Objektes (gleiche Reihenfolge wie facesTM).
+ * Laesst sich ein Blatt nicht darstellen (mehr als 255 Dreiecke), bleibt die komprimierte BVH leer
+ * und es wird ueber den binaeren Baum traversiert.
+ * @param obj Objekt mit aufgebautem binaeren Baum und sortierten Indizes
+ */
+void bvhCompressed_build(object *obj);
+
+/**
+ * Sucht den naehesten Schnittpunkt ueber die komprimierte BVH eines Objektes
+ * @param query vorbereiteter Strahl und Objekt mit aufgebauter komprimierter BVH
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @return Index des getroffenen Dreiecks, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint bvhCompressed_intersectClosest(const bvhLeafQuery *query, GLfloat *dist);
+
+/**
+ * Prueft ueber die komprimierte BVH, ob ein Strahl irgendein Dreieck innerhalb einer Distanz trifft
+ * @param query vorbereiteter Strahl und Objekt mit aufgebauter komprimierter BVH
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE, sobald ein Dreieck dichter als maxDist getroffen wurde
+ */
+GLboolean bvhCompressed_intersectAny(const bvhLeafQuery *query, GLfloat maxDist);
+
+#endif //RAYTRACER_BVHCOMPRESSED_H
@@ -0,0 +1,325 @@
+/**
+ * @file
+ * Gemeinsame Traversierung der binaeren und der 4- bzw. 8-fach BVH fuer Pakete koharenter Primaerstrahlen.
+ * Fuer jeden Knoten wird zuerst ueber Intervallarithmetik (Startpunkte und inverse Richtungen
+ * des Pakets als Intervalle) geprueft, ob ueberhaupt ein Strahl des Pakets den Knoten treffen kann.
+ * Danach wird der erste aktive Strahl gesucht, der den Knoten tatsaechlich trifft; Strahlen davor
+ * werden im gesamten Teilbaum nicht mehr betrachtet.
+ * Die quantisierte BVH kennt nur die Box der Wurzel, ihre Strahlen werden einzeln verfolgt.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <float.h>
+#include "bvhPacket.h"
+
+/** Groesse des Traversierungsstacks, pro Ebene kommt hoechstens ein Eintrag dazu */
+#define BVH_PACKET_STACK_SIZE (64)
+/** Groesse des Traversierungsstacks der weiten BVHs, pro Ebene koennen bis zu 7 Eintraege dazukommen */
+#define BVH_PACKET_WIDE_STACK_SIZE (384)
+
+/** Eintrag auf dem Traversierungsstack */
+typedef struct bvhPacketStackEntry {
+    GLint node;
+    /** Erster Strahl, der fuer den Knoten noch betrachtet werden muss */
+    GLint firstActive;
+} bvhPacketStackEntry;
+
+/**
+ * Eintrag auf dem Traversierungsstack der weiten BVHs. Die Box des Kindes liegt nur im
+ * Elternknoten (SoA) und wird deshalb als binaerer Knoten mitgenommen.
+ */
+typedef struct bvhPacketWideEntry {
+    /** Box des Kindes, leftFirst: Index des weiten Knotens bzw. erstes Dreieck, count wie im binaeren Knoten */
+    bvhNode node;
+    /** Erster Strahl, der fuer den Knoten noch betrachtet werden muss */
+    GLint firstActive;
+    /** Eintrittsdistanz des ersten aktiven Strahls, bestimmt die Reihenfolge */
+    GLfloat tEntry;
+} bvhPacketWideEntry;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/**
+ * Produkt zweier Intervalle [a0, a1] * [b0, b1]
+ */
+static void bvhPacket_intervalMul(GLfloat a0, GLfloat a1, GLfloat b0, GLfloat b1, GLfloat *lo, GLfloat *hi) {
+    GLfloat p0 = a0 * b0;
+    GLfloat p1 = a0 * b1;
+    GLfloat p2 = a1 * b0;
+    GLfloat p3 = a1 * b1;
+    *lo = fminf(fminf(p0, p1), fminf(p2, p3));
+    *hi = fmaxf(fmaxf(p0, p1), fmaxf(p2, p3));
+}
+
+/**
+ * Groesste maximale Distanz ueber alle Strahlen des Pakets
+ */
+static GLfloat bvhPacket_maxDist(const GLfloat *dists, GLint rayCount) {
+    GLfloat result = -FLT_MAX;
+    for (int r = 0; r < rayCount; ++r) {
+        result = fmaxf(result, dists[r]);
+    }
+    return result;
+}
+
+/**
+ * Sucht ab firstActive den ersten Strahl, der die Box eines Knotens trifft
+ * @return Index des Strahls, rayCount wenn keiner trifft
+ */
+static GLint bvhPacket_firstHit(const bvhNode *node, const bvhRayPacket *packet, const GLfloat *dists,
+                                GLint firstActive) {
+    GLint first = firstActive;
+    while (first < packet->rayCount &&
+           bvh_intersectNode(node, packet->queries[first].ray.start, packet->invDir[first], dists[first]) == FLT_MAX) {
+        first++;
+    }
+    return first;
+}
+
+/**
+ * Testet die Dreiecke eines Blattes mit jedem Strahl ab first, der die Box des Blattes trifft
+ * @param node Blatt (leftFirst und count beschreiben die Dreiecke wie in der binaeren BVH)
+ * @param first erster Strahl, der das Blatt trifft
+ */
+static void bvhPacket_intersectLeaf(const bvhNode *node, GLint first, bvhRayPacket *packet, GLfloat *dists,
+                                    GLint *tris) {
+    for (int r = first; r < packet->rayCount; ++r) {
+        if (r != first && bvh_intersectNode(node, packet->queries[r].ray.start, packet->invDir[r],
+                                            dists[r]) == FLT_MAX) {
+            continue;
+        }
+        GLint idxTri = bvh_intersectLeafClosest(&packet->queries[r], node->leftFirst, node->count, &dists[r]);
+        if (idxTri >= 0) {
+            tris[r] = idxTri;
+        }
+    }
+}
+
+/**
+ * Gemeinsame Traversierung der binaeren BVH, siehe bvhPacket_intersectClosest
+ */
+static void bvhPacket_intersectBinary(const object *obj, bvhRayPacket *packet, GLfloat *dists, GLint *tris) {
+    GLint rayCount = packet->rayCount;
+    GLfloat maxDist = bvhPacket_maxDist(dists, rayCount);
+
+    bvhPacketStackEntry stack[BVH_PACKET_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize].node = 0;
+    stack[stackSize++].firstActive = 0;
+
+    while (stackSize > 0) {
+        bvhPacketStackEntry entry = stack[--stackSize];
+        const bvhNode *node = &obj->bvh.nodes[entry.node];
+
+        //Ganzes Paket verfehlt den Knoten
+        if (!bvhPacket_intersectBounds(node, &packet->bounds, maxDist)) {
+            continue;
+        }
+
+        //Ersten Strahl suchen, der den Knoten trifft
+        GLint first = bvhPacket_firstHit(node, packet, dists, entry.firstActive);
+        if (first == rayCount) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            //Blatt: jeder Strahl, der die Box trifft, testet die Dreiecke
+            bvhPacket_intersectLeaf(node, first, packet, dists, tris);
+            //Auf dem Stack liegen auch Knoten mit frueheren aktiven Strahlen, daher ueber alle Strahlen
+            maxDist = bvhPacket_maxDist(dists, rayCount);
+        } else {
+            //Reihenfolge der Kinder anhand des ersten aktiven Strahls bestimmen, naeheres Kind zuletzt
+            GLint left = node->leftFirst;
+            GLint right = node->leftFirst + 1;
+            const GLfloat *start = packet->queries[first].ray.start;
+            GLfloat tLeft = bvh_intersectNode(&obj->bvh.nodes[left], start, packet->invDir[first], dists[first]);
+            GLfloat tRight = bvh_intersectNode(&obj->bvh.nodes[right], start, packet->invDir[first], dists[first]);
+            if (tLeft > tRight) {
+                GLint tmp = left;
+                left = right;
+                right = tmp;
+            }
+            stack[stackSize].node = right;
+            stack[stackSize++].firstActive = first;
+            stack[stackSize].node = left;
+            stack[stackSize++].firstActive = first;
+        }
+    }
+}
+
+/**
+ * Gemeinsame Traversierung der 4- bzw. 8-fach BVH, siehe bvhPacket_intersectClosest.
+ * Die Kinder eines Knotens werden einzeln mit dem Intervall Test geprueft und nach der
+ * Eintrittsdistanz des ersten aktiven Strahls sortiert auf den Stack gelegt.
+ */
+static void bvhPacket_intersectWide(const object *obj, bvhLayout layout, bvhRayPacket *packet, GLfloat *dists,
+                                    GLint *tris) {
+    GLint rayCount = packet->rayCount;
+    GLfloat maxDist = bvhPacket_maxDist(dists, rayCount);
+
+    //Die Wurzel der weiten BVH ueberdeckt dieselben Dreiecke wie die binaere Wurzel
+    bvhPacketWideEntry stack[BVH_PACKET_WIDE_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize].node = obj->bvh.nodes[0];
+    stack[stackSize].node.leftFirst = 0;
+    stack[stackSize].node.count = 0;
+    stack[stackSize].firstActive = 0;
+    stack[stackSize++].tEntry = 0.0f;
+
+    while (stackSize > 0) {
+        bvhPacketWideEntry entry = stack[--stackSize];
+        const bvhNode *node = &entry.node;
+
+        //Ganzes Paket verfehlt den Knoten (maxDist kann seit dem Ablegen kleiner geworden sein)
+        if (!bvhPacket_intersectBounds(node, &packet->bounds, maxDist)) {
+            continue;
+        }
+        GLint first = bvhPacket_firstHit(node, packet, dists, entry.firstActive);
+        if (first == rayCount) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            bvhPacket_intersectLeaf(node, first, packet, dists, tris);
+            maxDist = bvhPacket_maxDist(dists, rayCount);
+            continue;
+        }
+
+        const GLfloat *bounds;
+        const GLint *child;
+        const GLint *count;
+        GLint width;
+        if (layout == bvh4) {
+            const bvh4Node *wide = &obj->bvh.nodes4[node->leftFirst];
+            bounds = &wide->bounds[0][0];
+            child = wide->child;
+            count = wide->count;
+            width = 4;
+        } else {
+            const bvh8Node *wide = &obj->bvh.nodes8[node->leftFirst];
+            bounds = &wide->bounds[0][0];
+            child = wide->child;
+            count = wide->count;
+            width = 8;
+        }
+
+        //Getroffene Kinder absteigend nach Distanz ablegen, damit das naeheste als erstes besucht wird
+        GLint firstSlot = stackSize;
+        for (int i = 0; i < width; ++i) {
+            //Leeres Kind
+            if (child[i] < 0) {
+                continue;
+            }
+            bvhPacketWideEntry newEntry;
+            for (int axis = 0; axis < 3; ++axis) {
+                newEntry.node.min[axis] = bounds[axis * width + i];
+                newEntry.node.max[axis] = bounds[(axis + 3) * width + i];
+            }
+            newEntry.node.leftFirst = child[i];
+            newEntry.node.count = count[i];
+            if (!bvhPacket_intersectBounds(&newEntry.node, &packet->bounds, maxDist)) {
+                continue;
+            }
+            newEntry.firstActive = first;
+            newEntry.tEntry = bvh_intersectNode(&newEntry.node, packet->queries[first].ray.start,
+                                                packet->invDir[first], dists[first]);
+
+            GLint pos = stackSize++;
+            while (pos > firstSlot && stack[pos - 1].tEntry < newEntry.tEntry) {
+                stack[pos] = stack[pos - 1];
+                pos--;
+            }
+            stack[pos] = newEntry;
+        }
+    }
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+GLboolean bvhPacket_intersectBounds(const bvhNode *node, const bvhPacketBounds *bounds, GLfloat maxDist) {
+    GLfloat nearLo = -FLT_MAX;
+    GLfloat farHi = FLT_MAX;
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat t0Lo, t0Hi, t1Lo, t1Hi;
+        bvhPacket_intervalMul(node->min[axis] - bounds->startMax[axis], node->min[axis] - bounds->startMin[axis],
+                              bounds->invDirMin[axis], bounds->invDirMax[axis], &t0Lo, &t0Hi);
+        bvhPacket_intervalMul(node->max[axis] - bounds->startMax[axis], node->max[axis] - bounds->startMin[axis],
+                              bounds->invDirMin[axis], bounds->invDirMax[axis], &t1Lo, &t1Hi);
+        //Bei positiver Richtung ist die min Ebene die Eintrittsebene
+        if (bounds->positive[axis]) {
+            nearLo = fmaxf(nearLo, t0Lo);
+            farHi = fminf(farHi, t1Hi);
+        } else {
+            nearLo = fmaxf(nearLo, t1Lo);
+            farHi = fminf(farHi, t0Hi);
+        }
+    }
+    return farHi >= nearLo && farHi > 0.0f && nearLo < maxDist;
+}
+
+GLboolean bvhPacket_init(const Ray *rays, GLint rayCount, triangleLayout triLayout, bvhRayPacket *packet) {
+    if (rayCount < 1) {
+        return GL_FALSE;
+    }
+
+    //Alle Richtungen muessen auf jeder Achse das gleiche Vorzeichen haben
+    for (int axis = 0; axis < 3; ++axis) {
+        GLboolean positive = rays[0].dir[axis] > 0.0f;
+        for (int r = 0; r < rayCount; ++r) {
+            if (rays[r].dir[axis] == 0.0f || (rays[r].dir[axis] > 0.0f) != positive) {
+                return GL_FALSE;
+            }
+        }
+        packet->bounds.positive[axis] = positive;
+        packet->bounds.startMin[axis] = FLT_MAX;
+        packet->bounds.startMax[axis] = -FLT_MAX;
+        packet->bounds.invDirMin[axis] = FLT_MAX;
+        packet->bounds.invDirMax[axis] = -FLT_MAX;
+    }
+
+    //Strahlen vorbereiten und Intervalle des Pakets bestimmen
+    packet->rayCount = rayCount;
+    for (int r = 0; r < rayCount; ++r) {
+        bvh_initLeafQuery(NULL, triLayout, rays[r], &packet->queries[r]);
+        for (int axis = 0; axis < 3; ++axis) {
+            packet->invDir[r][axis] = 1.0f / rays[r].dir[axis];
+            packet->bounds.startMin[axis] = fminf(packet->bounds.startMin[axis], rays[r].start[axis]);
+            packet->bounds.startMax[axis] = fmaxf(packet->bounds.startMax[axis], rays[r].start[axis]);
+            packet->bounds.invDirMin[axis] = fminf(packet->bounds.invDirMin[axis], packet->invDir[r][axis]);
+            packet->bounds.invDirMax[axis] = fmaxf(packet->bounds.invDirMax[axis], packet->invDir[r][axis]);
+        }
+    }
+    return GL_TRUE;
+}
+
+void bvhPacket_intersectClosest(const object *obj, bvhOptions opts, bvhRayPacket *packet, GLfloat *dists,
+                                GLint *tris) {
+    GLint rayCount = packet->rayCount;
+    for (int r = 0; r < rayCount; ++r) {
+        tris[r] = -1;
+        packet->queries[r].obj = obj;
+    }
+    if (obj->bvh.nodeCount == 0) {
+        return;
+    }
+
+    switch (bvh_objectLayout(obj, opts.layout)) {
+        case bvh4:
+        case bvh8:
+            bvhPacket_intersectWide(obj, opts.layout, packet, dists, tris);
+            break;
+        case bvhQuantized:
+            //Uebersprungene Strahlen (negative Distanz) koennen nichts treffen
+            for (int r = 0; r < rayCount; ++r) {
+                if (dists[r] > 0.0f) {
+                    tris[r] = bvh_intersectClosest(obj, opts, packet->queries[r].ray, &dists[r]);
+                }
+            }
+            break;
+        case bvh2:
+        default:
+            bvhPacket_intersectBinary(obj, packet, dists, tris);
+            break;
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef RAYTRACER_BVHPACKET_H
+#define RAYTRACER_BVHPACKET_H
+#include "bvh.h"
+
+/** Maximale Anzahl an Strahlen in einem Paket (8x8 Pixel) */
+#define BVH_PACKET_MAX_RAYS (64)
+
+/** Intervalle ueber alle Strahlen eines Pakets */
+typedef struct bvhPacketBounds {
+    vec3 startMin;
+    vec3 startMax;
+    vec3 invDirMin;
+    vec3 invDirMax;
+    /** GL_TRUE, wenn die Richtungen auf der Achse positiv sind */
+    GLboolean positive[3];
+} bvhPacketBounds;
+
+/** Vorbereitetes Strahlenpaket, wird fuer alle Objekte der Szene wiederverwendet */
+typedef struct bvhRayPacket {
+    GLint rayCount;
+    vec3 invDir[BVH_PACKET_MAX_RAYS];
+    bvhLeafQuery queries[BVH_PACKET_MAX_RAYS];
+    bvhPacketBounds bounds;
+} bvhRayPacket;
+
+/**
+ * Intervall Slab Test des ganzen Pakets mit der AABB eines Knotens.
+ * Die Schranken sind konservativ: wird der Knoten verworfen, trifft ihn auch kein einzelner Strahl
+ * (gleiche Rechenschritte wie bvh_intersectNode, Rundung ist monoton).
+ * @param node Knoten
+ * @param bounds Intervalle des Pakets
+ * @param maxDist groesste maximale Distanz ueber alle Strahlen
+ * @return GL_TRUE, wenn mindestens ein Strahl den Knoten treffen kann
+ */
+GLboolean bvhPacket_intersectBounds(const bvhNode *node, const bvhPacketBounds *bounds, GLfloat maxDist);
+
+/**
+ * Bereitet ein Strahlenpaket fuer die gemeinsame Traversierung vor.
+ * Dafuer muessen alle Richtungen auf jeder Achse das gleiche (von 0 verschiedene) Vorzeichen haben,
+ * sonst ist der Intervall Test des Pakets nicht aussagekraeftig und die Strahlen muessen einzeln verfolgt werden.
+ * @param rays Strahlen des Pakets
+ * @param rayCount Anzahl der Strahlen, maximal BVH_PACKET_MAX_RAYS
+ * @param triLayout Dreieckslayout, mit dem die Blaetter getestet werden
+ * @param packet Ausgabe
+ * @return GL_TRUE, wenn das Paket koharent ist und gemeinsam traversiert werden kann
+ */
+GLboolean bvhPacket_init(const Ray *rays, GLint rayCount, triangleLayout triLayout, bvhRayPacket *packet);
+
+/**
+ * Sucht fuer alle Strahlen eines koharenten Pakets den naehesten Schnittpunkt mit den Dreiecken eines Objektes.
+ * Die Strahlen traversieren die binaere bzw. 4- oder 8-fach BVH gemeinsam: ein Knoten wird ueber
+ * Intervallarithmetik fuer das ganze Paket verworfen, sonst wird ab dem ersten Strahl, der den Knoten trifft,
+ * weiter abgestiegen. Im quantisierten Layout werden die Strahlen einzeln verfolgt.
+ * @param obj Objekt mit aufgebauter BVH
+ * @param opts Knoten- und Dreieckslayout, mit dem traversiert wird
+ * @param packet ueber bvhPacket_init vorbereitetes, koharentes Paket
+ * @param dists Ein: maximale Distanz je Strahl, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @param tris Ausgabe, Index des getroffenen Dreiecks je Strahl, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+void bvhPacket_intersectClosest(const object *obj, bvhOptions opts, bvhRayPacket *packet, GLfloat *dists,
+                                GLint *tris);
+
+#endif //RAYTRACER_BVHPACKET_H
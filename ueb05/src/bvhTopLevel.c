@@ -0,0 +1,482 @@
+/**
+ * @file
+ * Zweistufige Beschleunigungsstruktur. Die Meshes liegen mit ihrer BVH nur einmal im Objektraum vor,
+ * die Instanzen verweisen mit einer eigenen Transformation auf sie. Ueber die AABBs der Instanzen
+ * im Weltraum wird eine weitere BVH aufgebaut. Beim Traversieren wird der Strahl in den Blaettern
+ * in den Objektraum der Instanz transformiert (ohne Normierung, damit die Distanzen gleich bleiben),
+ * vorher wird das eingestellte Bounding Volume (AABB oder OBB) der Instanz getestet.
+ * Wird eine Instanz bewegt, muss nur die BVH ueber die Instanzen neu aufgebaut werden.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include <string.h>
+#include "bvhTopLevel.h"
+
+/** Startgroesse des Instanzarrays */
+#define BVH_TOP_LEVEL_INITIAL_CAPACITY (16)
+/** Groesse des Traversierungsstacks */
+#define BVH_TOP_LEVEL_STACK_SIZE (64)
+
+/** Eintrag auf dem Traversierungsstack */
+typedef struct bvhTopLevelStackEntry {
+    GLint node;
+    GLfloat tEntry;
+} bvhTopLevelStackEntry;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/**
+ * Transformiert einen Strahl in den Objektraum einer Instanz
+ * @param inst Instanz
+ * @param ray Strahl im Weltraum
+ * @param local Ausgabe, Strahl im Objektraum (Richtung nicht normiert)
+ */
+static void bvhTopLevel_toObjectRay(const objectInstance *inst, const Ray *ray, Ray *local) {
+    for (int i = 0; i < 3; ++i) {
+        local->start[i] = inst->toObject[0][i] * ray->start[0] + inst->toObject[1][i] * ray->start[1] +
+                          inst->toObject[2][i] * ray->start[2] + inst->toObject[3][i];
+        local->dir[i] = inst->toObject[0][i] * ray->dir[0] + inst->toObject[1][i] * ray->dir[1] +
+                        inst->toObject[2][i] * ray->dir[2];
+    }
+    local->distance = ray->distance;
+}
+
+/**
+ * Erstellt einen Knoten aus der AABB einer Instanz, damit die Slab Tests der BVH verwendet werden koennen
+ */
+static void bvhTopLevel_instanceNode(const objectInstance *inst, bvhNode *node) {
+    glm_vec3_copy((float *) inst->bounds.min, node->min);
+    glm_vec3_copy((float *) inst->bounds.max, node->max);
+    node->leftFirst = 0;
+    node->count = 0;
+}
+
+/**
+ * Komponentenweise inverse Strahlrichtung
+ */
+static void bvhTopLevel_inverseDir(const vec3 dir, vec3 invDir) {
+    invDir[0] = 1.0f / dir[0];
+    invDir[1] = 1.0f / dir[1];
+    invDir[2] = 1.0f / dir[2];
+}
+
+/**
+ * Groesste maximale Distanz ueber alle Strahlen des Pakets
+ */
+static GLfloat bvhTopLevel_maxDist(const GLfloat *dists, GLint rayCount) {
+    GLfloat result = -FLT_MAX;
+    for (int r = 0; r < rayCount; ++r) {
+        result = fmaxf(result, dists[r]);
+    }
+    return result;
+}
+
+/**
+ * Sucht den naehesten Treffer eines Strahls mit einer Instanz
+ * @param invDir inverse Strahlrichtung im Weltraum
+ * @return Index des getroffenen Dreiecks, -1 wenn nichts dichter als dist getroffen wurde
+ */
+static GLint bvhTopLevel_intersectInstance(const objectInstance *inst, bvhOptions opts, const Ray *ray,
+                                           const vec3 invDir, GLfloat *dist) {
+    //Bounding Volume der Instanz vor der Transformation des Strahls pruefen
+    if (boundingBox_intersect(&inst->bounds, opts.bounds, ray, invDir, *dist) == FLT_MAX) {
+        return -1;
+    }
+
+    if (inst->identity) {
+        return bvh_intersectClosest(inst->mesh, opts, *ray, dist);
+    }
+    Ray local;
+    bvhTopLevel_toObjectRay(inst, ray, &local);
+    return bvh_intersectClosest(inst->mesh, opts, local, dist);
+}
+
+/**
+ * Testet ein Paket gegen eine Instanz und uebernimmt alle Treffer, die dichter als die bisherigen sind
+ * @param idx Index der Instanz
+ */
+static void bvhTopLevel_intersectInstancePacket(const objectInstance *inst, GLint idx, bvhOptions opts,
+                                                bvhRayPacket *packet, const GLuint *skipMasks, GLfloat *dists,
+                                                GLint *instances, GLint *tris) {
+    GLint rayCount = packet->rayCount;
+    GLfloat instDists[BVH_PACKET_MAX_RAYS];
+    GLint instTris[BVH_PACKET_MAX_RAYS];
+
+    //Uebersprungene Strahlen bekommen eine negative maximale Distanz und treffen dadurch nichts
+    for (int r = 0; r < rayCount; ++r) {
+        instDists[r] = (skipMasks[r] & BVH_TOP_LEVEL_SKIP(inst->model)) ? -FLT_MAX : dists[r];
+    }
+
+    //Paket verfehlt die Instanz, dann muss auch nichts transformiert werden
+    if (opts.bounds != none) {
+        bvhNode instNode;
+        bvhTopLevel_instanceNode(inst, &instNode);
+        if (!bvhPacket_intersectBounds(&instNode, &packet->bounds, bvhTopLevel_maxDist(instDists, rayCount))) {
+            return;
+        }
+    }
+
+    //Die OBB wird je Strahl getestet, Strahlen die sie verfehlen werden wie uebersprungene behandelt
+    if (opts.bounds == oobb && inst->bounds.useObb) {
+        for (int r = 0; r < rayCount; ++r) {
+            if (boundingBox_intersect(&inst->bounds, opts.bounds, &packet->queries[r].ray, packet->invDir[r],
+                                      instDists[r]) == FLT_MAX) {
+                instDists[r] = -FLT_MAX;
+            }
+        }
+        if (bvhTopLevel_maxDist(instDists, rayCount) < 0.0f) {
+            return;
+        }
+    }
+
+    if (inst->identity) {
+        bvhPacket_intersectClosest(inst->mesh, opts, packet, instDists, instTris);
+    } else {
+        Ray local[BVH_PACKET_MAX_RAYS];
+        for (int r = 0; r < rayCount; ++r) {
+            bvhTopLevel_toObjectRay(inst, &packet->queries[r].ray, &local[r]);
+        }
+
+        //Die Transformation kann die Vorzeichen der Richtungen aendern,
+        //dann werden die Strahlen fuer diese Instanz einzeln verfolgt
+        bvhRayPacket localPacket;
+        if (bvhPacket_init(local, rayCount, opts.triLayout, &localPacket)) {
+            bvhPacket_intersectClosest(inst->mesh, opts, &localPacket, instDists, instTris);
+        } else {
+            for (int r = 0; r < rayCount; ++r) {
+                instTris[r] = bvh_intersectClosest(inst->mesh, opts, local[r], &instDists[r]);
+            }
+        }
+    }
+
+    for (int r = 0; r < rayCount; ++r) {
+        if (instTris[r] >= 0) {
+            dists[r] = instDists[r];
+            instances[r] = idx;
+            tris[r] = instTris[r];
+        }
+    }
+}
+
+/**
+ * Baut eine BVH ueber die AABBs der Instanzen (neu) auf
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param shadowOnly GL_TRUE, wenn nur schattenwerfende Instanzen aufgenommen werden
+ * @param tree Ausgabe, BVH (wird vorher freigegeben)
+ * @param order Ausgabe, Index der Instanzen in der Reihenfolge der Blaetter (wird vorher freigegeben)
+ */
+static void bvhTopLevel_buildTree(topLevel *tlas, GLboolean shadowOnly, bvh *tree, GLint **order) {
+    bvh_free(tree);
+    if (*order != NULL) {
+        free(*order);
+        *order = NULL;
+    }
+
+    vec3 (*bounds)[2] = calloc(tlas->instanceCount > 0 ? tlas->instanceCount : 1, sizeof(vec3[2]));
+    GLint *instances = calloc(tlas->instanceCount > 0 ? tlas->instanceCount : 1, sizeof(GLint));
+    if (bounds == NULL || instances == NULL) {
+        printf("Error allocating top level BVH!\n");
+        exit(1);
+    }
+
+    GLint count = 0;
+    for (int i = 0; i < tlas->instanceCount; ++i) {
+        if (!shadowOnly || tlas->instances[i].castsShadow) {
+            glm_vec3_copy(tlas->instances[i].bounds.min, bounds[count][0]);
+            glm_vec3_copy(tlas->instances[i].bounds.max, bounds[count][1]);
+            instances[count++] = i;
+        }
+    }
+
+    //Die BVH liefert die Reihenfolge der aufgenommenen Instanzen, diese auf die Indizes im Instanzarray abbilden
+    *order = calloc(count > 0 ? count : 1, sizeof(GLint));
+    if (*order == NULL) {
+        printf("Error allocating top level BVH!\n");
+        exit(1);
+    }
+    *tree = bvh_buildFromBounds(bounds, count, *order);
+    for (int i = 0; i < count; ++i) {
+        (*order)[i] = instances[(*order)[i]];
+    }
+
+    free(instances);
+    free(bounds);
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+GLint bvhTopLevel_addInstance(topLevel *tlas, const object *mesh, objectModels model, vec3 translation,
+                              vec3 rotation, GLfloat scale, GLboolean castsShadow) {
+    if (mesh->faceCount <= 0 || mesh->bvh.nodeCount == 0) {
+        return -1;
+    }
+
+    if (tlas->instanceCount == tlas->capacity) {
+        GLint capacity = tlas->capacity > 0 ? 2 * tlas->capacity : BVH_TOP_LEVEL_INITIAL_CAPACITY;
+        objectInstance *instances = realloc(tlas->instances, capacity * sizeof(objectInstance));
+        if (instances == NULL) {
+            printf("Error allocating instances!\n");
+            exit(1);
+        }
+        tlas->instances = instances;
+        tlas->capacity = capacity;
+    }
+
+    GLint idx = tlas->instanceCount++;
+    objectInstance *inst = &tlas->instances[idx];
+    inst->mesh = mesh;
+    inst->model = model;
+    inst->castsShadow = castsShadow;
+    bvhTopLevel_setTransform(tlas, idx, translation, rotation, scale);
+
+    return idx;
+}
+
+void bvhTopLevel_setTransform(topLevel *tlas, GLint idx, vec3 translation, vec3 rotation, GLfloat scale) {
+    objectInstance *inst = &tlas->instances[idx];
+
+    //Gleiche Reihenfolge wie utils_transformVertices: skalieren, um x, y, z rotieren, verschieben
+    mat4 toWorld;
+    glm_translate_make(toWorld, translation);
+    glm_rotate_z(toWorld, glm_rad(rotation[2]), toWorld);
+    glm_rotate_y(toWorld, glm_rad(rotation[1]), toWorld);
+    glm_rotate_x(toWorld, glm_rad(rotation[0]), toWorld);
+    glm_scale_uni(toWorld, scale);
+
+    mat4 toObject;
+    glm_mat4_inv(toWorld, toObject);
+    mat3 normalMatrix;
+    glm_mat4_pick3t(toObject, normalMatrix);
+
+    mat4 identity = GLM_MAT4_IDENTITY_INIT;
+    inst->identity = memcmp(toWorld, identity, sizeof(mat4)) == 0;
+    memcpy(inst->toWorld, toWorld, sizeof(inst->toWorld));
+    memcpy(inst->toObject, toObject, sizeof(inst->toObject));
+    memcpy(inst->normalMatrix, normalMatrix, sizeof(inst->normalMatrix));
+
+    //Bounding Volumes im Weltraum, die AABB geht in die BVH ueber die Instanzen ein
+    boundingBox_transformBounds(inst->mesh, toWorld, &inst->bounds);
+}
+
+void bvhTopLevel_build(topLevel *tlas) {
+    bvhTopLevel_buildTree(tlas, GL_FALSE, &tlas->bvh, &tlas->order);
+    bvhTopLevel_buildTree(tlas, GL_TRUE, &tlas->shadowBvh, &tlas->shadowOrder);
+}
+
+GLint bvhTopLevel_intersectClosest(const topLevel *tlas, bvhOptions opts, GLuint skipMask, Ray ray, GLfloat *dist,
+                                   GLint *tri) {
+    GLint result = -1;
+    if (tlas->bvh.nodeCount == 0) {
+        return result;
+    }
+
+    vec3 invDir;
+    bvhTopLevel_inverseDir(ray.dir, invDir);
+
+    bvhTopLevelStackEntry stack[BVH_TOP_LEVEL_STACK_SIZE];
+    GLint stackSize = 0;
+
+    GLfloat tRoot = bvh_intersectNode(&tlas->bvh.nodes[0], ray.start, invDir, *dist);
+    if (tRoot == FLT_MAX) {
+        return result;
+    }
+    stack[stackSize].node = 0;
+    stack[stackSize++].tEntry = tRoot;
+
+    while (stackSize > 0) {
+        bvhTopLevelStackEntry entry = stack[--stackSize];
+        //Knoten liegt hinter dem bisher naehesten Treffer
+        if (entry.tEntry >= *dist) {
+            continue;
+        }
+
+        const bvhNode *node = &tlas->bvh.nodes[entry.node];
+        if (node->count > 0) {
+            //Blatt: Strahl in den Objektraum jeder Instanz transformieren und deren BVH traversieren
+            for (int i = node->leftFirst; i < node->leftFirst + node->count; ++i) {
+                GLint idx = tlas->order[i];
+                const objectInstance *inst = &tlas->instances[idx];
+                if (skipMask & BVH_TOP_LEVEL_SKIP(inst->model)) {
+                    continue;
+                }
+                GLint idxTri = bvhTopLevel_intersectInstance(inst, opts, &ray, invDir, dist);
+                if (idxTri >= 0) {
+                    result = idx;
+                    *tri = idxTri;
+                }
+            }
+        } else {
+            //Naeheres Kind zuletzt auf den Stack, damit es zuerst besucht wird
+            GLint left = node->leftFirst;
+            GLint right = left + 1;
+            GLfloat tLeft = bvh_intersectNode(&tlas->bvh.nodes[left], ray.start, invDir, *dist);
+            GLfloat tRight = bvh_intersectNode(&tlas->bvh.nodes[right], ray.start, invDir, *dist);
+
+            if (tLeft > tRight) {
+                GLint tmpNode = left;
+                left = right;
+                right = tmpNode;
+                GLfloat tmpT = tLeft;
+                tLeft = tRight;
+                tRight = tmpT;
+            }
+            if (tRight != FLT_MAX) {
+                stack[stackSize].node = right;
+                stack[stackSize++].tEntry = tRight;
+            }
+            if (tLeft != FLT_MAX) {
+                stack[stackSize].node = left;
+                stack[stackSize++].tEntry = tLeft;
+            }
+        }
+    }
+
+    return result;
+}
+
+GLboolean bvhTopLevel_intersectAny(const topLevel *tlas, bvhOptions opts, Ray ray, GLfloat maxDist) {
+    if (tlas->shadowBvh.nodeCount == 0) {
+        return GL_FALSE;
+    }
+
+    vec3 invDir;
+    bvhTopLevel_inverseDir(ray.dir, invDir);
+
+    GLint stack[BVH_TOP_LEVEL_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const bvhNode *node = &tlas->shadowBvh.nodes[stack[--stackSize]];
+        if (bvh_intersectNode(node, ray.start, invDir, maxDist) == FLT_MAX) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (int i = node->leftFirst; i < node->leftFirst + node->count; ++i) {
+                const objectInstance *inst = &tlas->instances[tlas->shadowOrder[i]];
+                if (boundingBox_intersect(&inst->bounds, opts.bounds, &ray, invDir, maxDist) == FLT_MAX) {
+                    continue;
+                }
+                GLboolean occluded;
+                if (inst->identity) {
+                    occluded = bvh_intersectAny(inst->mesh, opts, ray, maxDist);
+                } else {
+                    Ray local;
+                    bvhTopLevel_toObjectRay(inst, &ray, &local);
+                    occluded = bvh_intersectAny(inst->mesh, opts, local, maxDist);
+                }
+                if (occluded) {
+                    return GL_TRUE;
+                }
+            }
+        } else {
+            stack[stackSize++] = node->leftFirst + 1;
+            stack[stackSize++] = node->leftFirst;
+        }
+    }
+
+    return GL_FALSE;
+}
+
+void bvhTopLevel_intersectPacket(const topLevel *tlas, bvhOptions opts, bvhRayPacket *packet,
+                                 const GLuint *skipMasks, GLfloat *dists, GLint *instances, GLint *tris) {
+    GLint rayCount = packet->rayCount;
+    for (int r = 0; r < rayCount; ++r) {
+        instances[r] = -1;
+        tris[r] = -1;
+    }
+    if (tlas->bvh.nodeCount == 0) {
+        return;
+    }
+
+    GLint stack[BVH_TOP_LEVEL_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const bvhNode *node = &tlas->bvh.nodes[stack[--stackSize]];
+        //Ganzes Paket verfehlt den Knoten
+        if (!bvhPacket_intersectBounds(node, &packet->bounds, bvhTopLevel_maxDist(dists, rayCount))) {
+            continue;
+        }
+
+        if (node->count > 0) {
+            for (int i = node->leftFirst; i < node->leftFirst + node->count; ++i) {
+                GLint idx = tlas->order[i];
+                bvhTopLevel_intersectInstancePacket(&tlas->instances[idx], idx, opts, packet, skipMasks, dists,
+                                                    instances, tris);
+            }
+        } else {
+            //Reihenfolge der Kinder anhand des ersten Strahls bestimmen, naeheres Kind zuletzt
+            GLint left = node->leftFirst;
+            GLint right = left + 1;
+            const GLfloat *start = packet->queries[0].ray.start;
+            GLfloat tLeft = bvh_intersectNode(&tlas->bvh.nodes[left], start, packet->invDir[0], FLT_MAX);
+            GLfloat tRight = bvh_intersectNode(&tlas->bvh.nodes[right], start, packet->invDir[0], FLT_MAX);
+            if (tLeft > tRight) {
+                GLint tmp = left;
+                left = right;
+                right = tmp;
+            }
+            stack[stackSize++] = right;
+            stack[stackSize++] = left;
+        }
+    }
+}
+
+GLint bvhTopLevel_intersectBounds(const topLevel *tlas, bvhOptions opts, objectModels model, Ray ray, GLfloat *dist,
+                                  vec3 normal) {
+    GLint result = -1;
+    for (int i = 0; i < tlas->instanceCount; ++i) {
+        GLfloat instDist;
+        vec3 instNormal;
+        if (tlas->instances[i].model == model &&
+            boundingBox_intersectSurface(&tlas->instances[i].bounds, opts.bounds, ray, &instDist, instNormal) &&
+            instDist < *dist) {
+            *dist = instDist;
+            glm_vec3_copy(instNormal, normal);
+            result = i;
+        }
+    }
+    return result;
+}
+
+void bvhTopLevel_hitNormal(const topLevel *tlas, GLint idx, GLint tri, vec3 normal) {
+    const objectInstance *inst = &tlas->instances[idx];
+    triangleTM triangle;
+    bvh_getTriangle(inst->mesh, tri, &triangle);
+    const GLfloat *local = triangle.normal;
+    if (inst->identity) {
+        glm_vec3_copy((float *) local, normal);
+        return;
+    }
+    for (int i = 0; i < 3; ++i) {
+        normal[i] = inst->normalMatrix[0][i] * local[0] + inst->normalMatrix[1][i] * local[1] +
+                    inst->normalMatrix[2][i] * local[2];
+    }
+    glm_vec3_normalize(normal);
+}
+
+void bvhTopLevel_free(topLevel *tlas) {
+    if (tlas->instances != NULL) {
+        free(tlas->instances);
+    }
+    if (tlas->order != NULL) {
+        free(tlas->order);
+    }
+    if (tlas->shadowOrder != NULL) {
+        free(tlas->shadowOrder);
+    }
+    bvh_free(&tlas->bvh);
+    bvh_free(&tlas->shadowBvh);
+    tlas->instances = NULL;
+    tlas->instanceCount = 0;
+    tlas->capacity = 0;
+    tlas->order = NULL;
+    tlas->shadowOrder = NULL;
+}
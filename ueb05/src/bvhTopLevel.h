@@ -0,0 +1,109 @@
+#ifndef RAYTRACER_BVHTOPLEVEL_H
+#define RAYTRACER_BVHTOPLEVEL_H
+#include "bvh.h"
+#include "bvhPacket.h"
+#include "boundingBox.h"
+
+/** Bitmaske eines Modells fuer die skipMask Parameter */
+#define BVH_TOP_LEVEL_SKIP(MODEL) (1u << (MODEL))
+
+/**
+ * Fuegt eine Instanz eines Meshes hinzu. Die BVH ueber die Instanzen wird erst ueber
+ * bvhTopLevel_build aktualisiert.
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param mesh Mesh im Objektraum mit aufgebauter BVH, muss so lange gueltig bleiben wie die Instanz
+ * @param model Modell der Instanz (Material und Sonderfaelle)
+ * @param translation Ort der Instanz in der Szene
+ * @param rotation Rotation in Grad um x, y und z (in dieser Reihenfolge)
+ * @param scale Skalierung
+ * @param castsShadow GL_TRUE, wenn die Instanz von Schattenstrahlen getestet werden soll
+ * @return Index der Instanz, -1 wenn das Mesh keine Dreiecke hat
+ */
+GLint bvhTopLevel_addInstance(topLevel *tlas, const object *mesh, objectModels model, vec3 translation,
+                              vec3 rotation, GLfloat scale, GLboolean castsShadow);
+
+/**
+ * Setzt die Transformation einer Instanz neu. Das Mesh bleibt unveraendert,
+ * danach muss nur die BVH ueber die Instanzen mit bvhTopLevel_build neu aufgebaut werden.
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param idx Index der Instanz
+ * @param translation Ort der Instanz in der Szene
+ * @param rotation Rotation in Grad um x, y und z (in dieser Reihenfolge)
+ * @param scale Skalierung
+ */
+void bvhTopLevel_setTransform(topLevel *tlas, GLint idx, vec3 translation, vec3 rotation, GLfloat scale);
+
+/**
+ * Baut die BVH ueber die AABBs der Instanzen (neu) auf
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ */
+void bvhTopLevel_build(topLevel *tlas);
+
+/**
+ * Sucht den naehesten Schnittpunkt eines Strahls mit allen Instanzen
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param opts Knoten- und Dreieckslayout, mit dem die Meshes traversiert werden
+ * @param skipMask Modelle, die uebersprungen werden (BVH_TOP_LEVEL_SKIP)
+ * @param ray Strahl im Weltraum
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @param tri Ausgabe, Index des getroffenen Dreiecks im Mesh der Instanz
+ * @return Index der getroffenen Instanz, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint bvhTopLevel_intersectClosest(const topLevel *tlas, bvhOptions opts, GLuint skipMask, Ray ray, GLfloat *dist,
+                                   GLint *tri);
+
+/**
+ * Prueft, ob ein Schattenstrahl irgendeine schattenwerfende Instanz innerhalb einer Distanz trifft
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param opts Knoten- und Dreieckslayout, mit dem die Meshes traversiert werden
+ * @param ray Strahl im Weltraum
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE beim ersten Treffer dichter als maxDist
+ */
+GLboolean bvhTopLevel_intersectAny(const topLevel *tlas, bvhOptions opts, Ray ray, GLfloat maxDist);
+
+/**
+ * Sucht fuer alle Strahlen eines koharenten Pakets den naehesten Schnittpunkt mit allen Instanzen.
+ * Instanzen ohne Transformation verwenden das Paket direkt, fuer alle anderen wird
+ * das Paket in den Objektraum transformiert (oder einzeln verfolgt, wenn es dort nicht koharent ist).
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param opts Knoten- und Dreieckslayout, mit dem die Meshes traversiert werden
+ * @param packet ueber bvhPacket_init vorbereitetes Paket im Weltraum
+ * @param skipMasks uebersprungene Modelle je Strahl (BVH_TOP_LEVEL_SKIP)
+ * @param dists Ein: maximale Distanz je Strahl, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @param instances Ausgabe, Index der getroffenen Instanz je Strahl, -1 wenn nichts getroffen wurde
+ * @param tris Ausgabe, Index des getroffenen Dreiecks im Mesh der Instanz je Strahl
+ */
+void bvhTopLevel_intersectPacket(const topLevel *tlas, bvhOptions opts, bvhRayPacket *packet,
+                                 const GLuint *skipMasks, GLfloat *dists, GLint *instances, GLint *tris);
+
+/**
+ * Sucht den naehesten Schnittpunkt mit den Oberflaechen der Bounding Volumes aller Instanzen
+ * eines Modells, um sie anzuzeigen. Es wird das in opts.bounds eingestellte Volume verwendet.
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param opts Einstellungen, opts.bounds bestimmt das Volume
+ * @param model Modell, dessen Bounding Volumes getestet werden
+ * @param ray Strahl im Weltraum
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum Schnittpunkt (nur wenn getroffen)
+ * @param normal Ausgabe, nach aussen zeigende Normale der getroffenen Seite
+ * @return Index der getroffenen Instanz, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint bvhTopLevel_intersectBounds(const topLevel *tlas, bvhOptions opts, objectModels model, Ray ray, GLfloat *dist,
+                                  vec3 normal);
+
+/**
+ * Liefert die normalisierte Normale eines getroffenen Dreiecks im Weltraum
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ * @param idx Index der Instanz
+ * @param tri Index des Dreiecks im Mesh der Instanz
+ * @param normal Ausgabe
+ */
+void bvhTopLevel_hitNormal(const topLevel *tlas, GLint idx, GLint tri, vec3 normal);
+
+/**
+ * Gibt die Instanzen und die BVH ueber die Instanzen frei (die Meshes bleiben erhalten)
+ * @param tlas Zweistufige Beschleunigungsstruktur
+ */
+void bvhTopLevel_free(topLevel *tlas);
+
+#endif //RAYTRACER_BVHTOPLEVEL_H
@@ -0,0 +1,426 @@
+/**
+ * @file
+ * 4-fach und 8-fach BVH, die aus der binaeren BVH zusammengefasst werden.
+ * Die Bounds der Kinder liegen als SoA vor, sodass ein SSE (4 Kinder) bzw.
+ * AVX (8 Kinder) Slab Test alle Kinder eines Knotens auf einmal prueft.
+ * Ohne SIMD Unterstuetzung wird auf einen skalaren Test zurueckgegriffen.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include "bvhWide.h"
+
+/** Maximale Breite eines Knotens */
+#define BVH_WIDE_MAX_WIDTH (8)
+/** Groesse des Traversierungsstacks, pro Ebene koennen bis zu 7 Eintraege dazukommen */
+#define BVH_WIDE_STACK_SIZE (384)
+
+/** Strahl mit vorberechneten Werten fuer die Slab Tests */
+typedef struct bvhWideRay {
+    vec3 start;
+    vec3 invDir;
+#ifdef CGLM_SSE_FP
+    __m128 start4[3];
+    __m128 invDir4[3];
+#endif
+#ifdef CGLM_AVX_FP
+    __m256 start8[3];
+    __m256 invDir8[3];
+#endif
+} bvhWideRay;
+
+/** Eintrag auf dem Traversierungsstack, Blaetter und innere Knoten werden gemeinsam sortiert */
+typedef struct bvhWideStackEntry {
+    GLint child;
+    GLint count;
+    GLfloat tEntry;
+} bvhWideStackEntry;
+
+/** Zustand beim Zusammenfassen des binaeren Baums */
+typedef struct bvhWideBuilder {
+    const bvh *tree;
+    GLint width;
+    void *nodes;
+    GLint nodeCount;
+    GLint capacity;
+} bvhWideBuilder;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/**
+ * Oberflaeche eines binaeren Knotens
+ */
+static GLfloat bvhWide_surfaceArea(const bvhNode *node) {
+    GLfloat dx = node->max[0] - node->min[0];
+    GLfloat dy = node->max[1] - node->min[1];
+    GLfloat dz = node->max[2] - node->min[2];
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+/**
+ * Liefert die Zeiger auf Bounds, Kinder und Dreiecksanzahlen eines weiten Knotens
+ */
+static void bvhWide_nodeArrays(void *nodes, GLint width, GLint idx, GLfloat **bounds, GLint **child, GLint **count) {
+    if (width == 4) {
+        bvh4Node *node = &((bvh4Node *) nodes)[idx];
+        *bounds = &node->bounds[0][0];
+        *child = node->child;
+        *count = node->count;
+    } else {
+        bvh8Node *node = &((bvh8Node *) nodes)[idx];
+        *bounds = &node->bounds[0][0];
+        *child = node->child;
+        *count = node->count;
+    }
+}
+
+/**
+ * Fasst rekursiv den binaeren Knoten binIdx (und so viele Nachfahren wie moeglich)
+ * zu einem weiten Knoten zusammen
+ * @return Index des weiten Knotens
+ */
+static GLint bvhWide_collapseNode(bvhWideBuilder *builder, GLint binIdx) {
+    size_t nodeSize = builder->width == 4 ? sizeof(bvh4Node) : sizeof(bvh8Node);
+    if (builder->nodeCount == builder->capacity) {
+        builder->capacity *= 2;
+        builder->nodes = realloc(builder->nodes, builder->capacity * nodeSize);
+        if (builder->nodes == NULL) {
+            printf("Error allocating wide BVH!\n");
+            exit(1);
+        }
+    }
+    GLint wideIdx = builder->nodeCount++;
+
+    //Startmenge: die beiden Kinder des binaeren Knotens (oder das Blatt selbst)
+    GLint slots[BVH_WIDE_MAX_WIDTH];
+    GLint slotCount = 0;
+    const bvhNode *binNode = &builder->tree->nodes[binIdx];
+    if (binNode->count > 0) {
+        slots[slotCount++] = binIdx;
+    } else {
+        slots[slotCount++] = binNode->leftFirst;
+        slots[slotCount++] = binNode->leftFirst + 1;
+    }
+
+    //Solange das innere Kind mit der groessten Oberflaeche durch seine Kinder ersetzen,
+    //bis der Knoten voll ist
+    while (slotCount < builder->width) {
+        GLint best = -1;
+        GLfloat bestArea = -1.0f;
+        for (int i = 0; i < slotCount; ++i) {
+            const bvhNode *candidate = &builder->tree->nodes[slots[i]];
+            if (candidate->count == 0 && bvhWide_surfaceArea(candidate) > bestArea) {
+                bestArea = bvhWide_surfaceArea(candidate);
+                best = i;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        GLint left = builder->tree->nodes[slots[best]].leftFirst;
+        slots[best] = left;
+        slots[slotCount++] = left + 1;
+    }
+
+    //Kinder rekursiv aufbauen, bevor die Zeiger geholt werden (realloc!)
+    GLint children[BVH_WIDE_MAX_WIDTH];
+    for (int i = 0; i < slotCount; ++i) {
+        const bvhNode *slotNode = &builder->tree->nodes[slots[i]];
+        children[i] = slotNode->count > 0 ? slotNode->leftFirst : bvhWide_collapseNode(builder, slots[i]);
+    }
+
+    GLfloat *bounds;
+    GLint *child;
+    GLint *count;
+    bvhWide_nodeArrays(builder->nodes, builder->width, wideIdx, &bounds, &child, &count);
+    for (int i = 0; i < builder->width; ++i) {
+        if (i < slotCount) {
+            const bvhNode *slotNode = &builder->tree->nodes[slots[i]];
+            for (int axis = 0; axis < 3; ++axis) {
+                bounds[axis * builder->width + i] = slotNode->min[axis];
+                bounds[(axis + 3) * builder->width + i] = slotNode->max[axis];
+            }
+            child[i] = children[i];
+            count[i] = slotNode->count;
+        } else {
+            //Leere Kinder werden durch NaN nie getroffen
+            for (int row = 0; row < 6; ++row) {
+                bounds[row * builder->width + i] = NAN;
+            }
+            child[i] = -1;
+            count[i] = 0;
+        }
+    }
+
+    return wideIdx;
+}
+
+/**
+ * Baut einen weiten Baum der angegebenen Breite aus dem binaeren Baum auf
+ */
+static void *bvhWide_collapseTree(const bvh *tree, GLint width, GLint *nodeCount) {
+    bvhWideBuilder builder;
+    size_t nodeSize = width == 4 ? sizeof(bvh4Node) : sizeof(bvh8Node);
+    builder.tree = tree;
+    builder.width = width;
+    builder.nodeCount = 0;
+    builder.capacity = tree->nodeCount / 2 + 1;
+    builder.nodes = malloc(builder.capacity * nodeSize);
+    if (builder.nodes == NULL) {
+        printf("Error allocating wide BVH!\n");
+        exit(1);
+    }
+
+    bvhWide_collapseNode(&builder, 0);
+
+    *nodeCount = builder.nodeCount;
+    void *result = realloc(builder.nodes, builder.nodeCount * nodeSize);
+    return result != NULL ? result : builder.nodes;
+}
+
+/**
+ * Bereitet den Strahl fuer die Slab Tests vor
+ */
+static void bvhWide_initRay(const Ray *ray, bvhWideRay *result) {
+    for (int axis = 0; axis < 3; ++axis) {
+        result->start[axis] = ray->start[axis];
+        result->invDir[axis] = 1.0f / ray->dir[axis];
+#ifdef CGLM_SSE_FP
+        result->start4[axis] = _mm_set1_ps(result->start[axis]);
+        result->invDir4[axis] = _mm_set1_ps(result->invDir[axis]);
+#endif
+#ifdef CGLM_AVX_FP
+        result->start8[axis] = _mm256_set1_ps(result->start[axis]);
+        result->invDir8[axis] = _mm256_set1_ps(result->invDir[axis]);
+#endif
+    }
+}
+
+/**
+ * Slab Test fuer 4 Kinder ab bounds (Reihenabstand stride)
+ * Minimum/Maximum sind so geschrieben, dass NaN im akkumulierten Wert erhalten bleibt
+ * (gleiches Verhalten wie minps/maxps), damit leere Kinder nie getroffen werden.
+ * @param tEntry Ausgabe, Eintrittsdistanzen der 4 Kinder
+ * @return Bitmaske der getroffenen Kinder
+ */
+static GLint bvhWide_slabTest4(const GLfloat *bounds, GLint stride, const bvhWideRay *ray, GLfloat maxDist,
+                               GLfloat *tEntry) {
+#ifdef CGLM_SSE_FP
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds), ray->start4[0]), ray->invDir4[0]);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds + 3 * stride), ray->start4[0]), ray->invDir4[0]);
+    __m128 tMin = _mm_min_ps(t1, t2);
+    __m128 tMax = _mm_max_ps(t1, t2);
+    for (int axis = 1; axis < 3; ++axis) {
+        t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds + axis * stride), ray->start4[axis]), ray->invDir4[axis]);
+        t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(bounds + (axis + 3) * stride), ray->start4[axis]),
+                        ray->invDir4[axis]);
+        tMin = _mm_max_ps(_mm_min_ps(t1, t2), tMin);
+        tMax = _mm_min_ps(_mm_max_ps(t1, t2), tMax);
+    }
+    __m128 mask = _mm_and_ps(_mm_cmpge_ps(tMax, tMin),
+                             _mm_and_ps(_mm_cmpgt_ps(tMax, _mm_setzero_ps()),
+                                        _mm_cmplt_ps(tMin, _mm_set1_ps(maxDist))));
+    _mm_storeu_ps(tEntry, tMin);
+    return _mm_movemask_ps(mask);
+#else
+    GLint result = 0;
+    for (int i = 0; i < 4; ++i) {
+        GLfloat t1 = (bounds[i] - ray->start[0]) * ray->invDir[0];
+        GLfloat t2 = (bounds[3 * stride + i] - ray->start[0]) * ray->invDir[0];
+        GLfloat tMin = t1 < t2 ? t1 : t2;
+        GLfloat tMax = t1 > t2 ? t1 : t2;
+        for (int axis = 1; axis < 3; ++axis) {
+            t1 = (bounds[axis * stride + i] - ray->start[axis]) * ray->invDir[axis];
+            t2 = (bounds[(axis + 3) * stride + i] - ray->start[axis]) * ray->invDir[axis];
+            GLfloat axisMin = t1 < t2 ? t1 : t2;
+            GLfloat axisMax = t1 > t2 ? t1 : t2;
+            tMin = axisMin > tMin ? axisMin : tMin;
+            tMax = axisMax < tMax ? axisMax : tMax;
+        }
+        tEntry[i] = tMin;
+        if (tMax >= tMin && tMax > 0.0f && tMin < maxDist) {
+            result |= 1 << i;
+        }
+    }
+    return result;
+#endif
+}
+
+/**
+ * Slab Test fuer alle Kinder eines weiten Knotens
+ * @param tEntry Ausgabe, Eintrittsdistanzen aller Kinder
+ * @return Bitmaske der getroffenen Kinder
+ */
+static GLint bvhWide_slabTest(const GLfloat *bounds, GLint width, const bvhWideRay *ray, GLfloat maxDist,
+                              GLfloat *tEntry) {
+#ifdef CGLM_AVX_FP
+    if (width == 8) {
+        __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds), ray->start8[0]), ray->invDir8[0]);
+        __m256 t2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds + 24), ray->start8[0]), ray->invDir8[0]);
+        __m256 tMin = _mm256_min_ps(t1, t2);
+        __m256 tMax = _mm256_max_ps(t1, t2);
+        for (int axis = 1; axis < 3; ++axis) {
+            t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds + axis * 8), ray->start8[axis]),
+                               ray->invDir8[axis]);
+            t2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(bounds + (axis + 3) * 8), ray->start8[axis]),
+                               ray->invDir8[axis]);
+            tMin = _mm256_max_ps(_mm256_min_ps(t1, t2), tMin);
+            tMax = _mm256_min_ps(_mm256_max_ps(t1, t2), tMax);
+        }
+        __m256 mask = _mm256_and_ps(_mm256_cmp_ps(tMax, tMin, _CMP_GE_OQ),
+                                    _mm256_and_ps(_mm256_cmp_ps(tMax, _mm256_setzero_ps(), _CMP_GT_OQ),
+                                                  _mm256_cmp_ps(tMin, _mm256_set1_ps(maxDist), _CMP_LT_OQ)));
+        _mm256_storeu_ps(tEntry, tMin);
+        return _mm256_movemask_ps(mask);
+    }
+#endif
+    GLint result = bvhWide_slabTest4(bounds, width, ray, maxDist, tEntry);
+    if (width == 8) {
+        result |= bvhWide_slabTest4(bounds + 4, width, ray, maxDist, tEntry + 4) << 4;
+    }
+    return result;
+}
+
+/**
+ * Liefert den Zeiger auf Bounds, Kinder und Dreiecksanzahlen eines Knotens des gewaehlten Layouts
+ */
+static GLint bvhWide_getNode(const bvh *tree, bvhLayout layout, GLint idx, const GLfloat **bounds,
+                             const GLint **child, const GLint **count) {
+    if (layout == bvh4) {
+        const bvh4Node *node = &tree->nodes4[idx];
+        *bounds = &node->bounds[0][0];
+        *child = node->child;
+        *count = node->count;
+        return 4;
+    } else {
+        const bvh8Node *node = &tree->nodes8[idx];
+        *bounds = &node->bounds[0][0];
+        *child = node->child;
+        *count = node->count;
+        return 8;
+    }
+}
+
+/**---------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+void bvhWide_collapse(bvh *tree) {
+    tree->nodes4 = NULL;
+    tree->nodeCount4 = 0;
+    tree->nodes8 = NULL;
+    tree->nodeCount8 = 0;
+    if (tree->nodeCount == 0) {
+        return;
+    }
+
+    tree->nodes4 = (bvh4Node *) bvhWide_collapseTree(tree, 4, &tree->nodeCount4);
+    tree->nodes8 = (bvh8Node *) bvhWide_collapseTree(tree, 8, &tree->nodeCount8);
+}
+
+GLint bvhWide_intersectClosest(const bvhLeafQuery *query, bvhLayout layout, GLfloat *dist) {
+    GLint result = -1;
+    const object *obj = query->obj;
+    if (obj->bvh.nodeCount == 0) {
+        return result;
+    }
+
+    bvhWideRay wideRay;
+    bvhWide_initRay(&query->ray, &wideRay);
+
+    bvhWideStackEntry stack[BVH_WIDE_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize].child = 0;
+    stack[stackSize].count = 0;
+    stack[stackSize++].tEntry = 0.0f;
+
+    while (stackSize > 0) {
+        bvhWideStackEntry entry = stack[--stackSize];
+        //Eintrag liegt hinter dem bisher naehesten Treffer
+        if (entry.tEntry >= *dist) {
+            continue;
+        }
+
+        if (entry.count > 0) {
+            //Blatt: alle Dreiecke testen
+            GLint idxTri = bvh_intersectLeafClosest(query, entry.child, entry.count, dist);
+            if (idxTri >= 0) {
+                result = idxTri;
+            }
+            continue;
+        }
+
+        const GLfloat *bounds;
+        const GLint *child;
+        const GLint *count;
+        GLint width = bvhWide_getNode(&obj->bvh, layout, entry.child, &bounds, &child, &count);
+
+        GLfloat tEntry[BVH_WIDE_MAX_WIDTH];
+        GLint mask = bvhWide_slabTest(bounds, width, &wideRay, *dist, tEntry);
+
+        //Getroffene Kinder absteigend nach Distanz auf den Stack legen,
+        //damit das naeheste Kind als erstes besucht wird
+        GLint first = stackSize;
+        for (int i = 0; i < width; ++i) {
+            if (mask & (1 << i)) {
+                bvhWideStackEntry newEntry;
+                newEntry.child = child[i];
+                newEntry.count = count[i];
+                newEntry.tEntry = tEntry[i];
+
+                GLint pos = stackSize++;
+                while (pos > first && stack[pos - 1].tEntry < newEntry.tEntry) {
+                    stack[pos] = stack[pos - 1];
+                    pos--;
+                }
+                stack[pos] = newEntry;
+            }
+        }
+    }
+
+    return result;
+}
+
+GLboolean bvhWide_intersectAny(const bvhLeafQuery *query, bvhLayout layout, GLfloat maxDist) {
+    const object *obj = query->obj;
+    if (obj->bvh.nodeCount == 0) {
+        return GL_FALSE;
+    }
+
+    bvhWideRay wideRay;
+    bvhWide_initRay(&query->ray, &wideRay);
+
+    bvhWideStackEntry stack[BVH_WIDE_STACK_SIZE];
+    GLint stackSize = 0;
+    stack[stackSize].child = 0;
+    stack[stackSize++].count = 0;
+
+    while (stackSize > 0) {
+        bvhWideStackEntry entry = stack[--stackSize];
+
+        if (entry.count > 0) {
+            //Erster Treffer vor maxDist reicht aus
+            if (bvh_intersectLeafAny(query, entry.child, entry.count, maxDist)) {
+                return GL_TRUE;
+            }
+            continue;
+        }
+
+        const GLfloat *bounds;
+        const GLint *child;
+        const GLint *count;
+        GLint width = bvhWide_getNode(&obj->bvh, layout, entry.child, &bounds, &child, &count);
+
+        GLfloat tEntry[BVH_WIDE_MAX_WIDTH];
+        GLint mask = bvhWide_slabTest(bounds, width, &wideRay, maxDist, tEntry);
+        for (int i = 0; i < width; ++i) {
+            if (mask & (1 << i)) {
+                stack[stackSize].child = child[i];
+                stack[stackSize++].count = count[i];
+            }
+        }
+    }
+
+    return GL_FALSE;
+}
@@ -0,0 +1,32 @@
+#ifndef RAYTRACER_BVHWIDE_H
+#define RAYTRACER_BVHWIDE_H
+#include "bvh.h"
+
+/**
+ * Fasst die binaere BVH eines Objektes zu einer 4-fach und einer 8-fach BVH zusammen.
+ * Die Blaetter referenzieren weiterhin die Dreiecksbereiche der binaeren BVH.
+ * @param tree BVH mit aufgebautem binaeren Baum
+ */
+void bvhWide_collapse(bvh *tree);
+
+/**
+ * Sucht den naehesten Schnittpunkt eines Strahls ueber die 4- bzw. 8-fach BVH eines Objektes.
+ * Die Kinder eines Knotens werden mit einem SIMD Slab Test gleichzeitig geprueft
+ * und von vorne nach hinten besucht.
+ * @param query vorbereiteter Strahl und Objekt mit aufgebauter BVH
+ * @param layout bvh4 oder bvh8
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @return Index des getroffenen Dreiecks, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint bvhWide_intersectClosest(const bvhLeafQuery *query, bvhLayout layout, GLfloat *dist);
+
+/**
+ * Prueft ueber die 4- bzw. 8-fach BVH, ob ein Strahl irgendein Dreieck innerhalb einer Distanz trifft
+ * @param query vorbereiteter Strahl und Objekt mit aufgebauter BVH
+ * @param layout bvh4 oder bvh8
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE, sobald ein Dreieck dichter als maxDist getroffen wurde
+ */
+GLboolean bvhWide_intersectAny(const bvhLeafQuery *query, bvhLayout layout, GLfloat maxDist);
+
+#endif //RAYTRACER_BVHWIDE_H
@@ -0,0 +1,666 @@
+/**
+ * @file
+ * Verteiltes Rendern ueber mehrere Prozesse. Ein Koordinator (das Programm mit Fenster) teilt das Bild
+ * in Baender und schickt sie ueber Unix Domain oder TCP Sockets an Render-Prozesse, die die Szene einmal
+ * laden und dauerhaft laufen. Ein Auftrag enthaelt nur die Einstellungen des Frames und das Band,
+ * zurueck kommen die Pixelfarben des Bandes. Alle Werte werden als 32 Bit Worte in Netzwerk-Bytereihenfolge
+ * uebertragen, so koennen Koordinator und Render-Prozesse auf verschiedenen Rechnern laufen.
+ * Unter Windows wird nur lokal gerendert.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#ifndef WIN32
+//Fuer getaddrinfo unter -std=c99
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef WIN32
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+#include "distributed.h"
+#include "progress.h"
+
+#ifndef WIN32
+
+/** Kennung am Anfang jeder Nachricht ("RTDR") */
+#define DISTRIBUTED_MAGIC (0x52544452u)
+/** Praefix fuer Adressen von Unix Domain Sockets */
+#define DISTRIBUTED_UNIX_PREFIX "unix:"
+/** Worte der Begruessung: Kennung, Breite und Hoehe des Bildes */
+#define DISTRIBUTED_HELLO_WORDS (3)
+/** Worte eines Auftrags: Kennung, Frame, Zeile, Hoehe und die Einstellungen */
+#define DISTRIBUTED_REQUEST_WORDS (12 + AMOUNT_LIGHTS)
+/** Worte vor den Pixeln einer Antwort: Kennung, Frame, Zeile, Hoehe */
+#define DISTRIBUTED_REPLY_WORDS (4)
+/** Worte der Pixel eines Bandes */
+#define DISTRIBUTED_BAND_WORDS (DISTRIBUTED_BAND_HEIGHT * DEFAULT_WINDOW_WIDTH * 3)
+/** Wartezeit auf Antworten, bevor erneut nach einem Abbruch gefragt wird, in Millisekunden */
+#define DISTRIBUTED_POLL_TIMEOUT (100)
+
+/** Baender eines Frames, die noch (erneut) verteilt werden muessen */
+typedef struct distributedQueue {
+    GLint *bands;
+    GLint capacity;
+    GLint first;
+    GLint count;
+} distributedQueue;
+
+/**---------------------------------------- LOCAL FUNCTION DECLARATION ----------------------------------------*/
+
+/**
+ * Schreibt alle Bytes in einen Socket
+ * @param fd Socket
+ * @param data Daten
+ * @param size Anzahl der Bytes
+ * @return GL_FALSE, wenn die Verbindung abgebrochen ist
+ */
+static GLboolean distributed_sendAll(int fd, const void *data, size_t size);
+
+/**
+ * Liest genau size Bytes aus einem Socket
+ * @param fd Socket
+ * @param data Ziel
+ * @param size Anzahl der Bytes
+ * @return GL_FALSE, wenn die Verbindung vorher geschlossen wurde oder abgebrochen ist
+ */
+static GLboolean distributed_recvAll(int fd, void *data, size_t size);
+
+/**
+ * Loest eine Adresse auf und oeffnet einen Socket, der verbunden ist oder lauscht
+ * @param address "unix:/pfad" oder "host:port" (beim Lauschen darf host leer sein)
+ * @param listening GL_TRUE: an die Adresse binden und lauschen, GL_FALSE: verbinden
+ * @return Socket, -1 bei einem Fehler
+ */
+static int distributed_openSocket(const char *address, GLboolean listening);
+
+/**
+ * Schaltet das Sammeln kleiner Pakete (Nagle) ab, damit Auftraege sofort verschickt werden.
+ * Fuer Unix Domain Sockets ohne Wirkung.
+ * @param fd Socket
+ */
+static void distributed_setNoDelay(int fd);
+
+/**
+ * Wandelt die Pixel eines Bandes in Worte in Netzwerk-Bytereihenfolge
+ * @param fb Framebuffer
+ * @param row erste Zeile
+ * @param height Anzahl der Zeilen
+ * @param words Ausgabe, height * DEFAULT_WINDOW_WIDTH * 3 Worte
+ */
+static void distributed_packPixels(const Color *fb, GLint row, GLint height, GLuint *words);
+
+/**
+ * Schreibt die Pixel eines Bandes aus Worten in Netzwerk-Bytereihenfolge in den Framebuffer
+ * @param words height * DEFAULT_WINDOW_WIDTH * 3 Worte
+ * @param row erste Zeile
+ * @param height Anzahl der Zeilen
+ * @param fb Framebuffer
+ */
+static void distributed_unpackPixels(const GLuint *words, GLint row, GLint height, Color *fb);
+
+/**
+ * Schickt einem Render-Prozess das Band am Anfang der Queue
+ * @param worker Render-Prozess mit freiem Platz
+ * @param frameId Nummer des Frames
+ * @param settings Einstellungen des Frames
+ * @param queue Baender, die noch verteilt werden muessen
+ * @return GL_FALSE, wenn die Verbindung abgebrochen ist
+ */
+static GLboolean distributed_sendBand(distributedWorker *worker, GLuint frameId, const distributedSettings *settings,
+                                      distributedQueue *queue);
+
+/**
+ * Liest die Antwort auf das aelteste Band eines Render-Prozesses und uebernimmt die Pixel in den Framebuffer
+ * @param worker Render-Prozess mit mindestens einem ausstehenden Band
+ * @param frameId Nummer des Frames
+ * @param pixels Puffer fuer DISTRIBUTED_BAND_WORDS Worte
+ * @param fb Framebuffer
+ * @param progress Fortschritt des Frames, das Band wird als fertiges Tile gemeldet
+ * @return GL_FALSE, wenn die Verbindung abgebrochen ist oder die Antwort nicht passt
+ */
+static GLboolean distributed_receiveBand(distributedWorker *worker, GLuint frameId, GLuint *pixels, Color *fb,
+                                         renderProgress *progress);
+
+/**
+ * Schliesst die Verbindung zu einem Render-Prozess und stellt seine ausstehenden Baender zurueck in die Queue
+ * @param worker Render-Prozess
+ * @param queue Baender, die noch verteilt werden muessen
+ */
+static void distributed_dropWorker(distributedWorker *worker, distributedQueue *queue);
+
+/**
+ * Liest die Einstellungen eines Auftrags. Jedes Wort wird vor der Umwandlung gegen den Wertebereich
+ * seines Typs geprueft, damit ein fremder Koordinator keine Tabellen oder Puffer ueberlaufen lassen kann.
+ * @param request Auftrag in Host-Bytereihenfolge (DISTRIBUTED_REQUEST_WORDS Worte)
+ * @param settings Ausgabe, Einstellungen des Frames
+ * @return GL_FALSE, wenn ein Wert ausserhalb seines Wertebereichs liegt
+ */
+static GLboolean distributed_parseSettings(const GLuint *request, distributedSettings *settings);
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+static GLboolean distributed_sendAll(int fd, const void *data, size_t size) {
+    const char *bytes = (const char *) data;
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, 0);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return GL_FALSE;
+        }
+        bytes += sent;
+        size -= (size_t) sent;
+    }
+    return GL_TRUE;
+}
+
+static GLboolean distributed_recvAll(int fd, void *data, size_t size) {
+    char *bytes = (char *) data;
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return GL_FALSE;
+        }
+        bytes += received;
+        size -= (size_t) received;
+    }
+    return GL_TRUE;
+}
+
+static int distributed_openSocket(const char *address, GLboolean listening) {
+    size_t prefixLength = strlen(DISTRIBUTED_UNIX_PREFIX);
+
+    if (strncmp(address, DISTRIBUTED_UNIX_PREFIX, prefixLength) == 0) {
+        struct sockaddr_un addr;
+        const char *path = address + prefixLength;
+        if (strlen(path) >= sizeof(addr.sun_path)) {
+            return -1;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, path);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (listening) {
+            //Socket eines vorherigen Render-Prozesses entfernen
+            unlink(path);
+            if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0 && listen(fd, 1) == 0) {
+                return fd;
+            }
+        } else if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        return -1;
+    }
+
+    //host:port, der Port steht hinter dem letzten Doppelpunkt
+    char host[128];
+    const char *colon = strrchr(address, ':');
+    if (colon == NULL || (size_t) (colon - address) >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, address, colon - address);
+    host[colon - address] = '\0';
+
+    struct addrinfo hints;
+    struct addrinfo *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = listening ? AI_PASSIVE : 0;
+    const char *node = host[0] != '\0' ? host : (listening ? NULL : "localhost");
+    if (getaddrinfo(node, colon + 1, &hints, &result) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *info = result; info != NULL && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (listening) {
+            int reuse = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            if (bind(fd, info->ai_addr, info->ai_addrlen) != 0 || listen(fd, 1) != 0) {
+                close(fd);
+                fd = -1;
+            }
+        } else if (connect(fd, info->ai_addr, info->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+static void distributed_setNoDelay(int fd) {
+    int noDelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+}
+
+static void distributed_packPixels(const Color *fb, GLint row, GLint height, GLuint *words) {
+    for (int j = row; j < row + height; ++j) {
+        for (int i = 0; i < DEFAULT_WINDOW_WIDTH; ++i) {
+            const Color *color = &fb[OFFSET2D(DEFAULT_WINDOW_HEIGHT, i, j)];
+            GLuint bits[3];
+            memcpy(&bits[0], &color->r, sizeof(GLuint));
+            memcpy(&bits[1], &color->g, sizeof(GLuint));
+            memcpy(&bits[2], &color->b, sizeof(GLuint));
+            *words++ = htonl(bits[0]);
+            *words++ = htonl(bits[1]);
+            *words++ = htonl(bits[2]);
+        }
+    }
+}
+
+static void distributed_unpackPixels(const GLuint *words, GLint row, GLint height, Color *fb) {
+    for (int j = row; j < row + height; ++j) {
+        for (int i = 0; i < DEFAULT_WINDOW_WIDTH; ++i) {
+            Color *color = &fb[OFFSET2D(DEFAULT_WINDOW_HEIGHT, i, j)];
+            GLuint bits[3] = {ntohl(words[0]), ntohl(words[1]), ntohl(words[2])};
+            memcpy(&color->r, &bits[0], sizeof(GLuint));
+            memcpy(&color->g, &bits[1], sizeof(GLuint));
+            memcpy(&color->b, &bits[2], sizeof(GLuint));
+            words += 3;
+        }
+    }
+}
+
+static GLboolean distributed_sendBand(distributedWorker *worker, GLuint frameId, const distributedSettings *settings,
+                                      distributedQueue *queue) {
+    GLint band = queue->bands[queue->first];
+    GLint row = band * DISTRIBUTED_BAND_HEIGHT;
+    GLint height = row + DISTRIBUTED_BAND_HEIGHT < DEFAULT_WINDOW_HEIGHT ? DISTRIBUTED_BAND_HEIGHT
+                                                                         : DEFAULT_WINDOW_HEIGHT - row;
+
+    GLuint request[DISTRIBUTED_REQUEST_WORDS];
+    GLint word = 0;
+    request[word++] = DISTRIBUTED_MAGIC;
+    request[word++] = frameId;
+    request[word++] = (GLuint) row;
+    request[word++] = (GLuint) height;
+    request[word++] = (GLuint) settings->viewMode;
+    for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
+        request[word++] = settings->lightsActive[i];
+    }
+    request[word++] = settings->showBB;
+    request[word++] = (GLuint) settings->bvhOpts.layout;
+    request[word++] = (GLuint) settings->bvhOpts.triLayout;
+    request[word++] = (GLuint) settings->bvhOpts.bounds;
+    request[word++] = (GLuint) settings->accelType;
+    request[word++] = (GLuint) settings->packetSize;
+    request[word++] = settings->wavefront;
+    for (int i = 0; i < word; ++i) {
+        request[i] = htonl(request[i]);
+    }
+
+    if (!distributed_sendAll(worker->socket, request, sizeof(request))) {
+        return GL_FALSE;
+    }
+    queue->first = (queue->first + 1) % queue->capacity;
+    queue->count--;
+    worker->bands[worker->inFlight++] = band;
+    return GL_TRUE;
+}
+
+static GLboolean distributed_receiveBand(distributedWorker *worker, GLuint frameId, GLuint *pixels, Color *fb,
+                                         renderProgress *progress) {
+    GLuint reply[DISTRIBUTED_REPLY_WORDS];
+    if (!distributed_recvAll(worker->socket, reply, sizeof(reply))) {
+        return GL_FALSE;
+    }
+    for (int i = 0; i < DISTRIBUTED_REPLY_WORDS; ++i) {
+        reply[i] = ntohl(reply[i]);
+    }
+
+    //Antworten kommen in der Reihenfolge der Auftraege
+    GLint row = worker->bands[0] * DISTRIBUTED_BAND_HEIGHT;
+    GLint height = row + DISTRIBUTED_BAND_HEIGHT < DEFAULT_WINDOW_HEIGHT ? DISTRIBUTED_BAND_HEIGHT
+                                                                         : DEFAULT_WINDOW_HEIGHT - row;
+    if (reply[0] != DISTRIBUTED_MAGIC || reply[1] != frameId || reply[2] != (GLuint) row ||
+        reply[3] != (GLuint) height) {
+        return GL_FALSE;
+    }
+    if (!distributed_recvAll(worker->socket, pixels, height * DEFAULT_WINDOW_WIDTH * 3 * sizeof(GLuint))) {
+        return GL_FALSE;
+    }
+    distributed_unpackPixels(pixels, row, height, fb);
+    progress_finishTile(progress, 0, row, DEFAULT_WINDOW_WIDTH, height);
+
+    worker->inFlight--;
+    memmove(&worker->bands[0], &worker->bands[1], worker->inFlight * sizeof(GLint));
+    return GL_TRUE;
+}
+
+static GLboolean distributed_parseSettings(const GLuint *request, distributedSettings *settings) {
+    GLint word = 4;
+    GLuint view = request[word++];
+    GLboolean valid = view <= RIGHT;
+    settings->viewMode = (viewMode) (valid ? view : FRONT);
+    for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
+        valid = valid && request[word] <= 1;
+        settings->lightsActive[i] = (GLboolean) request[word++];
+    }
+    valid = valid && request[word] <= 1;
+    settings->showBB = (GLboolean) request[word++];
+
+    GLuint layout = request[word++];
+    GLuint triLayout = request[word++];
+    GLuint bounds = request[word++];
+    GLuint accelType = request[word++];
+    GLuint size = request[word++];
+    valid = valid && layout <= bvhQuantized && triLayout <= trisSoA8 && bounds <= none && accelType <= accelGrid;
+    //Die Pakete muessen in die festen Puffer von packets8x8 passen
+    valid = valid && (size == packetsOff || size == packets2x2 || size == packets4x4 || size == packets8x8);
+    valid = valid && request[word] <= 1;
+    settings->wavefront = (GLboolean) request[word++];
+    if (!valid) {
+        return GL_FALSE;
+    }
+
+    settings->bvhOpts.layout = (bvhLayout) layout;
+    settings->bvhOpts.triLayout = (triangleLayout) triLayout;
+    settings->bvhOpts.bounds = (boundingBoxState) bounds;
+    settings->accelType = (acceleratorType) accelType;
+    settings->packetSize = (packetSize) size;
+    return GL_TRUE;
+}
+
+static void distributed_dropWorker(distributedWorker *worker, distributedQueue *queue) {
+    printf("Lost connection to render worker %s!\n", worker->address);
+    close(worker->socket);
+    worker->socket = -1;
+
+    for (int i = 0; i < worker->inFlight; ++i) {
+        queue->bands[(queue->first + queue->count) % queue->capacity] = worker->bands[i];
+        queue->count++;
+    }
+    worker->inFlight = 0;
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+GLint distributed_connect(distributedCluster *cluster, const char *addresses) {
+    //Ein abgebrochener Render-Prozess soll den Koordinator nicht beenden
+    signal(SIGPIPE, SIG_IGN);
+
+    char *list = (char *) malloc(strlen(addresses) + 1);
+    if (list == NULL) {
+        printf("Error allocating render workers!\n");
+        exit(1);
+    }
+    strcpy(list, addresses);
+
+    for (char *address = strtok(list, ","); address != NULL; address = strtok(NULL, ",")) {
+        int fd = distributed_openSocket(address, GL_FALSE);
+        if (fd < 0) {
+            printf("Could not connect to render worker %s!\n", address);
+            continue;
+        }
+        distributed_setNoDelay(fd);
+
+        //Der Render-Prozess muss mit derselben Aufloesung uebersetzt sein
+        GLuint hello[DISTRIBUTED_HELLO_WORDS];
+        if (!distributed_recvAll(fd, hello, sizeof(hello)) || ntohl(hello[0]) != DISTRIBUTED_MAGIC ||
+            ntohl(hello[1]) != DEFAULT_WINDOW_WIDTH || ntohl(hello[2]) != DEFAULT_WINDOW_HEIGHT) {
+            printf("Render worker %s does not match this build!\n", address);
+            close(fd);
+            continue;
+        }
+
+        distributedWorker *workers = (distributedWorker *) realloc(cluster->workers, (cluster->workerCount + 1) *
+                                                                                     sizeof(distributedWorker));
+        if (workers == NULL) {
+            printf("Error allocating render workers!\n");
+            exit(1);
+        }
+        cluster->workers = workers;
+        distributedWorker *worker = &cluster->workers[cluster->workerCount++];
+        memset(worker, 0, sizeof(*worker));
+        worker->socket = fd;
+        strncpy(worker->address, address, sizeof(worker->address) - 1);
+        printf("Connected to render worker %s\n", address);
+    }
+
+    free(list);
+    return distributed_workerCount(cluster);
+}
+
+GLboolean distributed_renderFrame(distributedCluster *cluster, const distributedSettings *settings, Color *fb,
+                                  renderProgress *progress, distributedLocalFunc local,
+                                  distributedCancelFunc cancelled, void *ctx) {
+    GLint bandCount = (DEFAULT_WINDOW_HEIGHT + DISTRIBUTED_BAND_HEIGHT - 1) / DISTRIBUTED_BAND_HEIGHT;
+    GLuint frameId = cluster->nextFrame++;
+
+    distributedQueue queue = {(GLint *) calloc(bandCount, sizeof(GLint)), bandCount, 0, bandCount};
+    GLuint *pixels = (GLuint *) malloc(DISTRIBUTED_BAND_WORDS * sizeof(GLuint));
+    struct pollfd *fds = (struct pollfd *) calloc(cluster->workerCount + 1, sizeof(struct pollfd));
+    GLint *polledWorkers = (GLint *) calloc(cluster->workerCount + 1, sizeof(GLint));
+    if (queue.bands == NULL || pixels == NULL || fds == NULL || polledWorkers == NULL) {
+        printf("Error allocating bands!\n");
+        exit(1);
+    }
+    for (int i = 0; i < bandCount; ++i) {
+        queue.bands[i] = i;
+    }
+    progress_beginPass(progress, bandCount);
+
+    GLint finished = 0;
+    GLboolean stop = GL_FALSE;
+    while (finished < bandCount) {
+        stop = stop || cancelled();
+
+        //Jedem Render-Prozess bis zu DISTRIBUTED_MAX_IN_FLIGHT Baender zuteilen
+        for (int i = 0; i < cluster->workerCount && !stop; ++i) {
+            distributedWorker *worker = &cluster->workers[i];
+            while (worker->socket >= 0 && worker->inFlight < DISTRIBUTED_MAX_IN_FLIGHT && queue.count > 0) {
+                if (!distributed_sendBand(worker, frameId, settings, &queue)) {
+                    distributed_dropWorker(worker, &queue);
+                }
+            }
+        }
+
+        GLint polled = 0;
+        for (int i = 0; i < cluster->workerCount; ++i) {
+            if (cluster->workers[i].socket >= 0 && cluster->workers[i].inFlight > 0) {
+                fds[polled].fd = cluster->workers[i].socket;
+                fds[polled].events = POLLIN;
+                fds[polled].revents = 0;
+                polledWorkers[polled++] = i;
+            }
+        }
+
+        if (polled == 0) {
+            if (stop) {
+                break;
+            }
+            //Kein Render-Prozess mehr erreichbar, die restlichen Baender selbst rendern
+            while (queue.count > 0 && !stop) {
+                GLint row = queue.bands[queue.first] * DISTRIBUTED_BAND_HEIGHT;
+                GLint height = row + DISTRIBUTED_BAND_HEIGHT < DEFAULT_WINDOW_HEIGHT ? DISTRIBUTED_BAND_HEIGHT
+                                                                                     : DEFAULT_WINDOW_HEIGHT - row;
+                local(row, height, ctx);
+                progress_finishTile(progress, 0, row, DEFAULT_WINDOW_WIDTH, height);
+                queue.first = (queue.first + 1) % queue.capacity;
+                queue.count--;
+                finished++;
+                stop = cancelled();
+            }
+            continue;
+        }
+
+        if (poll(fds, polled, DISTRIBUTED_POLL_TIMEOUT) < 0 && errno != EINTR) {
+            printf("Error waiting for render workers!\n");
+            exit(1);
+        }
+        for (int k = 0; k < polled; ++k) {
+            if (fds[k].revents == 0) {
+                continue;
+            }
+            distributedWorker *worker = &cluster->workers[polledWorkers[k]];
+            if (distributed_receiveBand(worker, frameId, pixels, fb, progress)) {
+                finished++;
+            } else {
+                distributed_dropWorker(worker, &queue);
+            }
+        }
+    }
+
+    free(polledWorkers);
+    free(fds);
+    free(pixels);
+    free(queue.bands);
+    return finished == bandCount;
+}
+
+GLint distributed_workerCount(const distributedCluster *cluster) {
+    GLint result = 0;
+    for (int i = 0; i < cluster->workerCount; ++i) {
+        if (cluster->workers[i].socket >= 0) {
+            result++;
+        }
+    }
+    return result;
+}
+
+void distributed_disconnect(distributedCluster *cluster) {
+    for (int i = 0; i < cluster->workerCount; ++i) {
+        if (cluster->workers[i].socket >= 0) {
+            close(cluster->workers[i].socket);
+        }
+    }
+    free(cluster->workers);
+    cluster->workers = NULL;
+    cluster->workerCount = 0;
+}
+
+int distributed_serve(const char *address, distributedServeFunc serve, Color *fb, void *ctx) {
+    //Ein abgebrochener Koordinator soll den Render-Prozess nicht beenden
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = distributed_openSocket(address, GL_TRUE);
+    if (listener < 0) {
+        printf("Could not listen on %s!\n", address);
+        return 1;
+    }
+    GLuint *pixels = (GLuint *) malloc((DISTRIBUTED_REPLY_WORDS + DISTRIBUTED_BAND_WORDS) * sizeof(GLuint));
+    if (pixels == NULL) {
+        printf("Error allocating bands!\n");
+        exit(1);
+    }
+    printf("Waiting for a coordinator on %s\n", address);
+
+    while (1) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        distributed_setNoDelay(fd);
+        printf("Coordinator connected\n");
+
+        GLuint hello[DISTRIBUTED_HELLO_WORDS] = {htonl(DISTRIBUTED_MAGIC), htonl(DEFAULT_WINDOW_WIDTH),
+                                                  htonl(DEFAULT_WINDOW_HEIGHT)};
+        GLuint request[DISTRIBUTED_REQUEST_WORDS];
+        GLboolean connected = distributed_sendAll(fd, hello, sizeof(hello));
+        while (connected && distributed_recvAll(fd, request, sizeof(request))) {
+            for (int i = 0; i < DISTRIBUTED_REQUEST_WORDS; ++i) {
+                request[i] = ntohl(request[i]);
+            }
+            GLint row = (GLint) request[2];
+            GLint height = (GLint) request[3];
+            distributedSettings settings;
+            if (request[0] != DISTRIBUTED_MAGIC || row < 0 || height <= 0 || height > DISTRIBUTED_BAND_HEIGHT ||
+                row + height > DEFAULT_WINDOW_HEIGHT || !distributed_parseSettings(request, &settings)) {
+                printf("Invalid request from coordinator!\n");
+                break;
+            }
+
+            serve(&settings, row, height, fb, ctx);
+
+            //Kopf und Pixel zusammen verschicken
+            pixels[0] = htonl(DISTRIBUTED_MAGIC);
+            pixels[1] = htonl(request[1]);
+            pixels[2] = htonl((GLuint) row);
+            pixels[3] = htonl((GLuint) height);
+            distributed_packPixels(fb, row, height, pixels + DISTRIBUTED_REPLY_WORDS);
+            connected = distributed_sendAll(fd, pixels, (DISTRIBUTED_REPLY_WORDS + height * DEFAULT_WINDOW_WIDTH * 3) *
+                                                        sizeof(GLuint));
+        }
+
+        close(fd);
+        printf("Coordinator disconnected\n");
+    }
+
+    free(pixels);
+    close(listener);
+    return 0;
+}
+
+#else
+
+GLint distributed_connect(distributedCluster *cluster, const char *addresses) {
+    (void) cluster;
+    printf("Distributed rendering is not supported on Windows, ignoring %s\n", addresses);
+    return 0;
+}
+
+GLboolean distributed_renderFrame(distributedCluster *cluster, const distributedSettings *settings, Color *fb,
+                                  renderProgress *progress, distributedLocalFunc local,
+                                  distributedCancelFunc cancelled, void *ctx) {
+    (void) cluster;
+    (void) settings;
+    (void) fb;
+    progress_beginPass(progress, (DEFAULT_WINDOW_HEIGHT + DISTRIBUTED_BAND_HEIGHT - 1) / DISTRIBUTED_BAND_HEIGHT);
+    for (int row = 0; row < DEFAULT_WINDOW_HEIGHT && !cancelled(); row += DISTRIBUTED_BAND_HEIGHT) {
+        GLint height = row + DISTRIBUTED_BAND_HEIGHT < DEFAULT_WINDOW_HEIGHT ? DISTRIBUTED_BAND_HEIGHT
+                                                                             : DEFAULT_WINDOW_HEIGHT - row;
+        local(row, height, ctx);
+        progress_finishTile(progress, 0, row, DEFAULT_WINDOW_WIDTH, height);
+    }
+    return !cancelled();
+}
+
+GLint distributed_workerCount(const distributedCluster *cluster) {
+    (void) cluster;
+    return 0;
+}
+
+void distributed_disconnect(distributedCluster *cluster) {
+    (void) cluster;
+}
+
+int distributed_serve(const char *address, distributedServeFunc serve, Color *fb, void *ctx) {
+    (void) serve;
+    (void) fb;
+    (void) ctx;
+    printf("Distributed rendering is not supported on Windows, cannot listen on %s\n", address);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef RAYTRACER_DISTRIBUTED_H
+#define RAYTRACER_DISTRIBUTED_H
+#include "types.h"
+
+/**
+ * Rendert die Zeilen [row, row + height) eines Frames im Prozess des Koordinators,
+ * wenn kein Render-Prozess mehr erreichbar ist
+ */
+typedef void (*distributedLocalFunc)(GLint row, GLint height, void *ctx);
+
+/**
+ * Rendert in einem Render-Prozess die Zeilen [row, row + height) mit den Einstellungen des Koordinators
+ * in einen Framebuffer (DEFAULT_WINDOW_WIDTH x DEFAULT_WINDOW_HEIGHT)
+ */
+typedef void (*distributedServeFunc)(const distributedSettings *settings, GLint row, GLint height, Color *fb,
+                                     void *ctx);
+
+/** Prueft, ob der laufende Frame abgebrochen werden soll */
+typedef GLboolean (*distributedCancelFunc)(void);
+
+/**
+ * Verbindet den Koordinator mit Render-Prozessen. Adressen werden durch Kommas getrennt,
+ * "unix:/pfad" fuer Unix Domain Sockets, sonst "host:port" fuer TCP.
+ * Nicht erreichbare Prozesse werden ausgelassen.
+ * @param cluster Cluster (zu Beginn mit 0 initialisiert), bereits verbundene Prozesse bleiben erhalten
+ * @param addresses Adressen der Render-Prozesse
+ * @return Anzahl der verbundenen Render-Prozesse
+ */
+GLint distributed_connect(distributedCluster *cluster, const char *addresses);
+
+/**
+ * Verteilt die Baender (DISTRIBUTED_BAND_HEIGHT Zeilen) eines Frames auf die Render-Prozesse und
+ * setzt die Ergebnisse im Framebuffer zusammen. Wer ein Band abliefert, bekommt das naechste.
+ * Bricht eine Verbindung ab, werden ihre Baender neu verteilt, ohne Render-Prozesse lokal gerendert.
+ * @param cluster verbundene Render-Prozesse
+ * @param settings Einstellungen des Frames
+ * @param fb Ziel der Pixelfarben
+ * @param progress Fortschritt des Frames, jedes fertige Band zaehlt als ein Tile
+ * @param local rendert Baender lokal, wenn kein Render-Prozess mehr erreichbar ist
+ * @param cancelled wird nach jedem Band abgefragt, ausstehende Baender werden dann noch abgewartet
+ * @param ctx Kontext fuer local
+ * @return GL_FALSE, wenn der Frame abgebrochen wurde
+ */
+GLboolean distributed_renderFrame(distributedCluster *cluster, const distributedSettings *settings, Color *fb,
+                                  renderProgress *progress, distributedLocalFunc local,
+                                  distributedCancelFunc cancelled, void *ctx);
+
+/**
+ * Anzahl der Render-Prozesse mit bestehender Verbindung
+ * @param cluster Cluster
+ * @return Anzahl
+ */
+GLint distributed_workerCount(const distributedCluster *cluster);
+
+/**
+ * Trennt alle Verbindungen zu Render-Prozessen und gibt den Cluster frei
+ * @param cluster Cluster
+ */
+void distributed_disconnect(distributedCluster *cluster);
+
+/**
+ * Arbeitsschleife eines Render-Prozesses: wartet an einer Adresse auf einen Koordinator und beantwortet
+ * dessen Auftraege, bis er die Verbindung schliesst. Danach wird auf den naechsten Koordinator gewartet.
+ * @param address "unix:/pfad" oder "[host]:port", auf der gelauscht wird
+ * @param serve rendert ein Band, die Szene wurde vorher einmal geladen
+ * @param fb Framebuffer, in den serve rendert
+ * @param ctx Kontext fuer serve
+ * @return ungleich 0, wenn nicht gelauscht werden konnte
+ */
+int distributed_serve(const char *address, distributedServeFunc serve, Color *fb, void *ctx);
+
+#endif //RAYTRACER_DISTRIBUTED_H
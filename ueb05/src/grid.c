@@ -0,0 +1,363 @@
+/**
+ * @file
+ * Gleichmaessiges Gitter als Beschleunigungsstruktur ohne Hierarchie.
+ * Die Dreiecke aller Instanzen werden in den Weltraum transformiert und in jede Zelle eingetragen,
+ * die ihre AABB ueberlappt. Traversiert wird mit 3D-DDA (Amanatides & Woo) von Zelle zu Zelle,
+ * bis ein Treffer in der aktuellen Zelle liegt. Dreiecke, die in mehreren Zellen liegen,
+ * werden ueber eine kleine Mailbox je Strahl nur einmal getestet (ohne gemeinsamen Zustand zwischen Threads).
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <float.h>
+#include "grid.h"
+
+/** Angestrebte Anzahl an Zellen je Dreieck */
+#define GRID_DENSITY (3.0f)
+/** Maximale Anzahl an Zellen je Achse */
+#define GRID_MAX_RES (128)
+/** Eintraege der Mailbox je Strahl (Zweierpotenz, Dreiecke werden ueber ihren Index verteilt) */
+#define GRID_MAILBOX_SIZE (64)
+
+/** Zustand der 3D-DDA Traversierung eines Strahls */
+typedef struct gridWalk {
+    /** Aktuelle Zelle */
+    GLint cell[3];
+    /** Schrittrichtung je Achse (-1, 0, 1) */
+    GLint step[3];
+    /** Zellindex je Achse, bei dem das Gitter verlassen wird */
+    GLint end[3];
+    /** Distanz, bei der die naechste Zellgrenze je Achse erreicht wird */
+    GLfloat tNext[3];
+    /** Distanz zwischen zwei Zellgrenzen je Achse */
+    GLfloat tDelta[3];
+} gridWalk;
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+/**
+ * Index einer Zelle im Gitter
+ */
+static GLint grid_cellIndex(const grid *g, const GLint *cell) {
+    return cell[0] + g->res[0] * (cell[1] + g->res[1] * cell[2]);
+}
+
+/**
+ * Zelle, in der eine Koordinate entlang einer Achse liegt (auf das Gitter begrenzt)
+ */
+static GLint grid_cellCoord(const grid *g, GLint axis, GLfloat pos) {
+    GLint cell = (GLint) ((pos - g->min[axis]) * g->invCellSize[axis]);
+    return cell < 0 ? 0 : (cell >= g->res[axis] ? g->res[axis] - 1 : cell);
+}
+
+/**
+ * Transformiert einen Punkt mit der Transformation einer Instanz in den Weltraum
+ */
+static void grid_toWorld(const objectInstance *inst, const vec3 local, vec3 world) {
+    for (int i = 0; i < 3; ++i) {
+        world[i] = inst->toWorld[0][i] * local[0] + inst->toWorld[1][i] * local[1] +
+                   inst->toWorld[2][i] * local[2] + inst->toWorld[3][i];
+    }
+}
+
+/**
+ * Zellbereich, den die AABB eines Dreiecks ueberlappt
+ * @param cellMin Ausgabe, erste Zelle je Achse
+ * @param cellMax Ausgabe, letzte Zelle je Achse
+ */
+static void grid_triangleCells(const grid *g, const triangleTM *tri, GLint *cellMin, GLint *cellMax) {
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat lo = fminf(tri->vertices.a[axis], fminf(tri->vertices.b[axis], tri->vertices.c[axis]));
+        GLfloat hi = fmaxf(tri->vertices.a[axis], fmaxf(tri->vertices.b[axis], tri->vertices.c[axis]));
+        cellMin[axis] = grid_cellCoord(g, axis, lo);
+        cellMax[axis] = grid_cellCoord(g, axis, hi);
+    }
+}
+
+/**
+ * Bestimmt die Zelle, in der ein Strahl das Gitter betritt, und bereitet die 3D-DDA vor
+ * @param maxDist maximale Distanz
+ * @return GL_FALSE, wenn der Strahl das Gitter nicht (dichter als maxDist) trifft
+ */
+static GLboolean grid_initWalk(const grid *g, const Ray *ray, GLfloat maxDist, gridWalk *walk) {
+    vec3 invDir = {1.0f / ray->dir[0], 1.0f / ray->dir[1], 1.0f / ray->dir[2]};
+    GLfloat tEnter = boundingBox_intersectSlab(g->min, g->max, ray->start, invDir, maxDist);
+    if (tEnter == FLT_MAX) {
+        return GL_FALSE;
+    }
+    //Startet der Strahl im Gitter, beginnt die Traversierung an seinem Startpunkt
+    tEnter = fmaxf(tEnter, 0.0f);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        walk->cell[axis] = grid_cellCoord(g, axis, ray->start[axis] + tEnter * ray->dir[axis]);
+        if (ray->dir[axis] > 0.0f) {
+            walk->step[axis] = 1;
+            walk->end[axis] = g->res[axis];
+            walk->tNext[axis] = (g->min[axis] + (GLfloat) (walk->cell[axis] + 1) * g->cellSize[axis] -
+                                 ray->start[axis]) * invDir[axis];
+            walk->tDelta[axis] = g->cellSize[axis] * invDir[axis];
+        } else if (ray->dir[axis] < 0.0f) {
+            walk->step[axis] = -1;
+            walk->end[axis] = -1;
+            walk->tNext[axis] = (g->min[axis] + (GLfloat) walk->cell[axis] * g->cellSize[axis] -
+                                 ray->start[axis]) * invDir[axis];
+            walk->tDelta[axis] = -g->cellSize[axis] * invDir[axis];
+        } else {
+            //Parallel zur Achse wird keine Zellgrenze dieser Achse erreicht
+            walk->step[axis] = 0;
+            walk->end[axis] = -1;
+            walk->tNext[axis] = FLT_MAX;
+            walk->tDelta[axis] = FLT_MAX;
+        }
+    }
+    return GL_TRUE;
+}
+
+/**
+ * Distanz, bei der der Strahl die aktuelle Zelle verlaesst
+ */
+static GLfloat grid_cellExit(const gridWalk *walk) {
+    return fminf(walk->tNext[0], fminf(walk->tNext[1], walk->tNext[2]));
+}
+
+/**
+ * Geht in die naechste Zelle entlang des Strahls
+ * @return GL_FALSE, wenn der Strahl das Gitter verlaesst
+ */
+static GLboolean grid_nextCell(gridWalk *walk) {
+    GLint axis = walk->tNext[0] < walk->tNext[1] ? (walk->tNext[0] < walk->tNext[2] ? 0 : 2)
+                                                 : (walk->tNext[1] < walk->tNext[2] ? 1 : 2);
+    walk->cell[axis] += walk->step[axis];
+    if (walk->cell[axis] == walk->end[axis] || walk->step[axis] == 0) {
+        return GL_FALSE;
+    }
+    walk->tNext[axis] += walk->tDelta[axis];
+    return GL_TRUE;
+}
+
+/**
+ * Prueft und setzt die Mailbox eines Strahls
+ * @return GL_TRUE, wenn das Dreieck bereits getestet wurde
+ */
+static GLboolean grid_mailboxTested(GLint *mailbox, GLint tri) {
+    GLint slot = tri & (GRID_MAILBOX_SIZE - 1);
+    if (mailbox[slot] == tri) {
+        return GL_TRUE;
+    }
+    mailbox[slot] = tri;
+    return GL_FALSE;
+}
+
+/**
+ * Leert die Mailbox eines Strahls
+ */
+static void grid_initMailbox(GLint *mailbox) {
+    for (int i = 0; i < GRID_MAILBOX_SIZE; ++i) {
+        mailbox[i] = -1;
+    }
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+void grid_build(grid *g, const topLevel *tlas) {
+    grid_free(g);
+
+    //Dreiecke aller Instanzen in den Weltraum transformieren
+    for (int i = 0; i < tlas->instanceCount; ++i) {
+        g->triCount += tlas->instances[i].mesh->faceCount;
+    }
+    g->tris = calloc(g->triCount > 0 ? g->triCount : 1, sizeof(gridTriangle));
+    if (g->tris == NULL) {
+        printf("Error allocating grid!\n");
+        exit(1);
+    }
+
+    glm_vec3_copy((vec3) {FLT_MAX, FLT_MAX, FLT_MAX}, g->min);
+    glm_vec3_copy((vec3) {-FLT_MAX, -FLT_MAX, -FLT_MAX}, g->max);
+    GLint count = 0;
+    for (int i = 0; i < tlas->instanceCount; ++i) {
+        const objectInstance *inst = &tlas->instances[i];
+        for (int t = 0; t < inst->mesh->faceCount; ++t) {
+            gridTriangle *gt = &g->tris[count++];
+            triangleTM local;
+            bvh_getTriangle(inst->mesh, t, &local);
+            grid_toWorld(inst, local.vertices.a, gt->tri.vertices.a);
+            grid_toWorld(inst, local.vertices.b, gt->tri.vertices.b);
+            grid_toWorld(inst, local.vertices.c, gt->tri.vertices.c);
+            utils_calcTwoEdgesTM(&gt->tri);
+            utils_calcNormal(&gt->tri);
+            gt->instance = i;
+            gt->idx = t;
+            gt->model = inst->model;
+            gt->castsShadow = inst->castsShadow;
+
+            glm_vec3_minv(g->min, gt->tri.vertices.a, g->min);
+            glm_vec3_minv(g->min, gt->tri.vertices.b, g->min);
+            glm_vec3_minv(g->min, gt->tri.vertices.c, g->min);
+            glm_vec3_maxv(g->max, gt->tri.vertices.a, g->max);
+            glm_vec3_maxv(g->max, gt->tri.vertices.b, g->max);
+            glm_vec3_maxv(g->max, gt->tri.vertices.c, g->max);
+        }
+    }
+    if (g->triCount == 0) {
+        glm_vec3_zero(g->min);
+        glm_vec3_zero(g->max);
+    }
+
+    //Gitter minimal vergroessern, damit flache Szenen (z.B. eine einzelne Wand) eine Ausdehnung haben
+    vec3 extent;
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat pad = EPSILON + 0.001f * (g->max[axis] - g->min[axis]);
+        g->min[axis] -= pad;
+        g->max[axis] += pad;
+        extent[axis] = g->max[axis] - g->min[axis];
+    }
+
+    //Aufloesung so waehlen, dass die Zellen etwa wuerfelfoermig sind und GRID_DENSITY Zellen je Dreieck entstehen
+    GLfloat volume = extent[0] * extent[1] * extent[2];
+    GLfloat cellsPerUnit = cbrtf(GRID_DENSITY * (GLfloat) (g->triCount > 0 ? g->triCount : 1) / volume);
+    GLint cellCount = 1;
+    for (int axis = 0; axis < 3; ++axis) {
+        GLint res = (GLint) (extent[axis] * cellsPerUnit);
+        g->res[axis] = res < 1 ? 1 : (res > GRID_MAX_RES ? GRID_MAX_RES : res);
+        g->cellSize[axis] = extent[axis] / (GLfloat) g->res[axis];
+        g->invCellSize[axis] = 1.0f / g->cellSize[axis];
+        cellCount *= g->res[axis];
+    }
+
+    //Erster Durchlauf: Dreiecke je Zelle zaehlen, danach Startindizes ueber die Praefixsumme
+    g->cellStart = calloc(cellCount + 1, sizeof(GLint));
+    if (g->cellStart == NULL) {
+        printf("Error allocating grid!\n");
+        exit(1);
+    }
+    GLint cellMin[3], cellMax[3], cell[3];
+    for (int t = 0; t < g->triCount; ++t) {
+        grid_triangleCells(g, &g->tris[t].tri, cellMin, cellMax);
+        for (cell[2] = cellMin[2]; cell[2] <= cellMax[2]; ++cell[2]) {
+            for (cell[1] = cellMin[1]; cell[1] <= cellMax[1]; ++cell[1]) {
+                for (cell[0] = cellMin[0]; cell[0] <= cellMax[0]; ++cell[0]) {
+                    g->cellStart[grid_cellIndex(g, cell) + 1]++;
+                }
+            }
+        }
+    }
+    for (int c = 0; c < cellCount; ++c) {
+        g->cellStart[c + 1] += g->cellStart[c];
+    }
+    g->refCount = g->cellStart[cellCount];
+
+    //Zweiter Durchlauf: Dreiecke eintragen
+    g->cellTris = calloc(g->refCount > 0 ? g->refCount : 1, sizeof(GLint));
+    GLint *fill = calloc(cellCount, sizeof(GLint));
+    if (g->cellTris == NULL || fill == NULL) {
+        printf("Error allocating grid!\n");
+        exit(1);
+    }
+    for (int t = 0; t < g->triCount; ++t) {
+        grid_triangleCells(g, &g->tris[t].tri, cellMin, cellMax);
+        for (cell[2] = cellMin[2]; cell[2] <= cellMax[2]; ++cell[2]) {
+            for (cell[1] = cellMin[1]; cell[1] <= cellMax[1]; ++cell[1]) {
+                for (cell[0] = cellMin[0]; cell[0] <= cellMax[0]; ++cell[0]) {
+                    GLint c = grid_cellIndex(g, cell);
+                    g->cellTris[g->cellStart[c] + fill[c]++] = t;
+                }
+            }
+        }
+    }
+    free(fill);
+}
+
+GLint grid_intersectClosest(const grid *g, GLuint skipMask, Ray ray, GLfloat *dist, GLint *tri) {
+    GLint result = -1;
+    gridWalk walk;
+    if (g->triCount == 0 || !grid_initWalk(g, &ray, *dist, &walk)) {
+        return result;
+    }
+
+    GLint mailbox[GRID_MAILBOX_SIZE];
+    grid_initMailbox(mailbox);
+
+    do {
+        GLint c = grid_cellIndex(g, walk.cell);
+        for (int i = g->cellStart[c]; i < g->cellStart[c + 1]; ++i) {
+            GLint t = g->cellTris[i];
+            const gridTriangle *gt = &g->tris[t];
+            if ((skipMask & BVH_TOP_LEVEL_SKIP(gt->model)) || grid_mailboxTested(mailbox, t)) {
+                continue;
+            }
+            Hit temp = trumboreMoeller_rayTriangleIntersection(ray, gt->tri);
+            if (!temp.defaultHit && temp.dist < *dist) {
+                *dist = temp.dist;
+                *tri = gt->idx;
+                result = gt->instance;
+            }
+        }
+        //Treffer liegt vor dem Ende der Zelle, in den folgenden Zellen kann nichts dichter liegen
+        if (*dist <= grid_cellExit(&walk)) {
+            break;
+        }
+    } while (grid_nextCell(&walk));
+
+    return result;
+}
+
+GLboolean grid_intersectAny(const grid *g, Ray ray, GLfloat maxDist) {
+    gridWalk walk;
+    if (g->triCount == 0 || !grid_initWalk(g, &ray, maxDist, &walk)) {
+        return GL_FALSE;
+    }
+
+    GLint mailbox[GRID_MAILBOX_SIZE];
+    grid_initMailbox(mailbox);
+
+    do {
+        GLint c = grid_cellIndex(g, walk.cell);
+        for (int i = g->cellStart[c]; i < g->cellStart[c + 1]; ++i) {
+            GLint t = g->cellTris[i];
+            const gridTriangle *gt = &g->tris[t];
+            if (!gt->castsShadow || grid_mailboxTested(mailbox, t)) {
+                continue;
+            }
+            if (trumboreMoeller_rayTriangleOccludes(&ray, &gt->tri, maxDist)) {
+                return GL_TRUE;
+            }
+        }
+        //Lichtquelle liegt in dieser Zelle
+        if (maxDist <= grid_cellExit(&walk)) {
+            break;
+        }
+    } while (grid_nextCell(&walk));
+
+    return GL_FALSE;
+}
+
+size_t grid_memoryFootprint(const grid *g) {
+    if (g->cellStart == NULL) {
+        return 0;
+    }
+    size_t cellCount = (size_t) g->res[0] * g->res[1] * g->res[2];
+    return g->triCount * sizeof(gridTriangle) + (cellCount + 1) * sizeof(GLint) + g->refCount * sizeof(GLint);
+}
+
+void grid_free(grid *g) {
+    if (g->tris != NULL) {
+        free(g->tris);
+    }
+    if (g->cellStart != NULL) {
+        free(g->cellStart);
+    }
+    if (g->cellTris != NULL) {
+        free(g->cellTris);
+    }
+    g->tris = NULL;
+    g->triCount = 0;
+    g->cellStart = NULL;
+    g->cellTris = NULL;
+    g->refCount = 0;
+    g->res[0] = 0;
+    g->res[1] = 0;
+    g->res[2] = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef RAYTRACER_GRID_H
+#define RAYTRACER_GRID_H
+#include "bvhTopLevel.h"
+
+/**
+ * Baut ein gleichmaessiges Gitter ueber die Dreiecke aller Instanzen im Weltraum auf.
+ * Die Aufloesung richtet sich nach der Anzahl der Dreiecke und dem Seitenverhaeltnis der Szene.
+ * @param g Ausgabe, Gitter (wird vorher freigegeben)
+ * @param tlas Instanzen der Szene
+ */
+void grid_build(grid *g, const topLevel *tlas);
+
+/**
+ * Sucht den naehesten Schnittpunkt eines Strahls, die Zellen werden ueber 3D-DDA von vorne
+ * nach hinten besucht. Dreiecke in mehreren Zellen werden je Strahl nur einmal getestet (Mailbox).
+ * @param g Gitter
+ * @param skipMask Modelle, die uebersprungen werden (BVH_TOP_LEVEL_SKIP)
+ * @param ray Strahl im Weltraum
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Schnittpunkt (nur wenn getroffen)
+ * @param tri Ausgabe, Index des getroffenen Dreiecks im Mesh der Instanz
+ * @return Index der getroffenen Instanz, -1 wenn nichts (dichter als dist) getroffen wurde
+ */
+GLint grid_intersectClosest(const grid *g, GLuint skipMask, Ray ray, GLfloat *dist, GLint *tri);
+
+/**
+ * Prueft, ob ein Schattenstrahl irgendein Dreieck einer schattenwerfenden Instanz innerhalb einer Distanz trifft
+ * @param g Gitter
+ * @param ray Strahl im Weltraum
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE beim ersten Treffer dichter als maxDist
+ */
+GLboolean grid_intersectAny(const grid *g, Ray ray, GLfloat maxDist);
+
+/**
+ * Speicherbedarf des Gitters
+ * @param g Gitter
+ * @return Bytes
+ */
+size_t grid_memoryFootprint(const grid *g);
+
+/**
+ * Gibt den Speicher des Gitters frei
+ * @param g Gitter
+ */
+void grid_free(grid *g);
+
+#endif //RAYTRACER_GRID_H
@@ -24,9 +24,13 @@
 #include "scene.h"
 #include "debugGL.h"
 #include "logic.h"
+#include "progress.h"
 
 /* ---- Konstanten ---- */
 
+/** Intervall in Millisekunden, in dem auf fertig gerenderte Frames geprueft wird */
+#define IO_FRAME_POLL_INTERVAL (30)
+
 static GLboolean g_startRender = GL_FALSE;
 
 /* ---- Funktionen ---- */
@@ -42,6 +46,9 @@ static void io_printHelp(void){
     printf("F3 :       4  Threads Rendering\n");
     printf("F4 :       2  Threads Rendering\n");
     printf("F5 :       1  Thread  Rendering\n");
+    printf("F6 :       1  Thread per CPU Core Rendering\n");
+    printf("c/C:          Toggle pinning Render Threads to CPU Cores\n");
+    printf("d/D:          Toggle between local and distributed Rendering (--workers)\n");
     printf("q/Q:          Exit the Program\n");
     printf("g/G:          Disable Pointlight 1\n");
     printf("f/F:          Disable Pointlight 2\n");
@@ -52,7 +59,14 @@ static void io_printHelp(void){
     printf("o/O:          View Scene from Above\n");
     printf("u/U:          View Scene from Below\n");
     printf("l/L:          View Scene from the Left\n");
-    printf("r/R:          View Scene from the Right\n\n");
+    printf("r/R:          View Scene from the Right\n");
+    printf("w/W:          Toggle between BVH2, BVH4, BVH8 and quantized BVH2 Nodes (--compressed: only quantized)\n");
+    printf("x/X:          Toggle between AoS, SoA4 and SoA8 Triangle Leaves\n");
+    printf("p/P:          Toggle between single Rays and 2x2, 4x4, 8x8 Ray Packets\n");
+    printf("a/A:          Toggle between BVH and Uniform Grid Accelerator\n");
+    printf("i/I:          Toggle progressive (coarse to fine) Preview\n");
+    printf("e/E:          Toggle between recursive and wavefront (queue based) Ray Tracing\n");
+    printf("m/M:          Benchmark all Accelerators on the current View\n\n");
 }
 
 /**
@@ -100,6 +114,10 @@ handleKeyboardEvent(int key, int status, GLboolean isSpecialKey, int x, int y) {
                 case GLUT_KEY_F5:
                     opt = noMultiThreading;
                     break;
+                    /* Render mit einem Thread pro CPU Kern */
+                case GLUT_KEY_F6:
+                    opt = threadsAuto;
+                    break;
 
             }
             logic_freeData();
@@ -114,6 +132,7 @@ handleKeyboardEvent(int key, int status, GLboolean isSpecialKey, int x, int y) {
                 case 'Q':
                 case ESC:
                     logic_freeData();
+                    logic_freeThreads();
                     exit(0);
                 case 'v':
                 case 'V':
@@ -165,6 +184,50 @@ handleKeyboardEvent(int key, int status, GLboolean isSpecialKey, int x, int y) {
                     if(g_startRender)
                         logic_togglePointLight2();
                     break;
+                case 'w':
+                case 'W':
+                    if(g_startRender)
+                        logic_toggleBvhLayout();
+                    break;
+                case 'x':
+                case 'X':
+                    if(g_startRender)
+                        logic_toggleTriangleLayout();
+                    break;
+                case 'p':
+                case 'P':
+                    if(g_startRender)
+                        logic_togglePacketSize();
+                    break;
+                case 'i':
+                case 'I':
+                    if(g_startRender)
+                        logic_toggleProgressive();
+                    break;
+                case 'e':
+                case 'E':
+                    if(g_startRender)
+                        logic_toggleWavefront();
+                    break;
+                case 'a':
+                case 'A':
+                    if(g_startRender)
+                        logic_toggleAccelerator();
+                    break;
+                case 'm':
+                case 'M':
+                    if(g_startRender)
+                        logic_benchmarkAccelerators();
+                    break;
+                case 'c':
+                case 'C':
+                    logic_toggleThreadPinning();
+                    break;
+                case 'd':
+                case 'D':
+                    if(g_startRender)
+                        logic_toggleDistributed();
+                    break;
                 case 't':
                 case 'T':
                     io_printHelp();
@@ -217,6 +280,20 @@ cbDisplay(void) {
     glutSwapBuffers(); /* fuer DoubleBuffering */
 }
 
+/**
+ * Timer-Callback.
+ * Zeichnet neu, sobald der Render-Thread einen Frame fertiggestellt hat oder
+ * solange ein Frame laeuft (Fortschrittsanzeige), und registriert sich danach erneut.
+ * @param value unbenutzt (In).
+ */
+static void
+cbTimer(int value) {
+    if (logic_takeFinishedFrame() || progress_running(logic_getProgress())) {
+        glutPostRedisplay();
+    }
+    glutTimerFunc(IO_FRAME_POLL_INTERVAL, cbTimer, value);
+}
+
 /**
  * Registrierung der GLUT-Callback-Routinen.
  */
@@ -235,6 +312,9 @@ registerCallbacks(void) {
      * Reshape-Callback) oder explizit (durch glutPostRedisplay) angestossen */
     glutDisplayFunc(cbDisplay);
 
+    /* Timer-Callback - prueft regelmaessig, ob im Hintergrund ein neuer Frame fertig geworden ist */
+    glutTimerFunc(IO_FRAME_POLL_INTERVAL, cbTimer, 0);
+
 }
 
 /**
@@ -1,119 +1,485 @@
 /**
  * @file
- * Schnittstelle, um .obj Dateien zu laden und Szenenobjekte daraus zu erstellen
+ * Schnittstelle, um .obj Dateien zu laden und Szenenobjekte daraus zu erstellen.
+ * Die Datei wird in den Speicher gemappt und in Abschnitte an Zeilengrenzen zerlegt. Ein erster paralleler
+ * Durchlauf zaehlt Vertizes, Dreiecke und Zeilen je Abschnitt, daraus ergeben sich die Groessen der Arrays und
+ * die Startindizes der Abschnitte. Ein zweiter paralleler Durchlauf liest die Zahlen ohne fscanf/strtof direkt
+ * an ihre Stelle. Die Arrays gehen danach ohne Kopie an das Mesh ueber.
+ * Die Kommentare mit der Anzahl der Vertizes werden nicht mehr benoetigt.
+ * Das fertige Mesh wird als Mesh-Datei abgelegt (meshCache), spaetere Starts mappen nur noch diese Datei.
  *
  * @author Christopher Ploog, Mario da Graca
  */
 
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include "loadObj.h"
 #include "stdio.h"
 #include "sceneObjects.h"
+#include "bvh.h"
+#include "multiThreading.h"
+#include "meshCache.h"
 
 /** Dateipfad zu den obj Dateien */
 static const char* FILE_PATH = "../res/model/";
 
-void loadObj_createObjectFromFile(vec3 *vertices, object *currObj, faces *indices, vec3 translation, vec3 rotation,
-                                  GLfloat scale) {
-    currObj->facesTM = calloc(currObj->faceCount, sizeof(struct triangleTM));
-    currObj->vertices = calloc(currObj->vertexCount, sizeof(vec3));
-
-    for (int j = 0; j < currObj->vertexCount; ++j) {
-        //Alle Vertizes transformieren
-        utils_transformVertices(vertices[j], translation, rotation, scale);
-        glm_vec3_copy(vertices[j], currObj->vertices[j]);
-    }
-
-    for (int i = 0; i < currObj->faceCount; ++i) {
-        //Dreieck aus 3 Vertizes erzeugen
-        glm_vec3_copy(currObj->vertices[indices[i].index1], currObj->facesTM[i].vertices.a);
-        glm_vec3_copy(currObj->vertices[indices[i].index2], currObj->facesTM[i].vertices.b);
-        glm_vec3_copy(currObj->vertices[indices[i].index3], currObj->facesTM[i].vertices.c);
-        //Zwei Seiten des Dreiecks vorberechnen
-        //-> spart Rechenleistung beim Schnittvergleich Strahl und Dreieck
-        utils_calcTwoEdgesTM(&currObj->facesTM[i]);
-        //Normale des Dreiecks vorberechnen
-        //-> spart Rechenleistung beim rendern der Szene selber
-        utils_calcNormal(&currObj->facesTM[i]);
+/** Mindestgroesse eines Abschnitts in Bytes, kleinere Dateien werden nicht aufgeteilt */
+#define LOAD_OBJ_MIN_CHUNK (1 << 16)
+/** Abschnitte pro CPU Kern, damit ungleich lange Abschnitte sich ausgleichen */
+#define LOAD_OBJ_CHUNKS_PER_CPU (4)
+
+/**---------------------------------------------- LOCAL TYPES ---------------------------------------------------*/
+
+/** Abschnitt der Datei, der von einem Thread gezaehlt und gelesen wird */
+typedef struct loadObjChunk {
+    /** Erstes Zeichen und Ende des Abschnitts, der Abschnitt endet nach einem Zeilenumbruch */
+    const char *begin;
+    const char *end;
+    /** Vertizes, Dreiecke und Zeilen im Abschnitt (erster Durchlauf) */
+    GLint vertexCount;
+    GLint faceCount;
+    GLint lineCount;
+    /** Index des ersten Vertex, Dreiecks und der ersten Zeile (ab 1) des Abschnitts in der Datei */
+    GLint firstVertex;
+    GLint firstFace;
+    GLint firstLine;
+    /** Zeile des ersten Fehlers im Abschnitt, 0 wenn keiner aufgetreten ist */
+    GLint errorLine;
+} loadObjChunk;
+
+/** Gemeinsamer Zustand der Jobs beim Lesen einer Datei */
+typedef struct loadObjFile {
+    loadObjChunk *chunks;
+    /** Ziel der Vertizes und Indizes, gross genug fuer alle Abschnitte */
+    vec3 *vertices;
+    faces *indices;
+    /** Vertizes der ganzen Datei */
+    GLint vertexCount;
+} loadObjFile;
+
+/**------------------------------------------ LOCAL FUNCTION DECLARATION ----------------------------------------*/
+
+/**
+ * Zaehlt Vertizes, Dreiecke und Zeilen eines Abschnitts, Job von multiThreading_runJobs
+ * @param idx Index des Abschnitts
+ * @param ctx loadObjFile
+ */
+static void loadObj_countChunk(GLint idx, void *ctx);
+
+/**
+ * Liest Vertizes und Dreiecke eines Abschnitts ab dessen Startindizes, Job von multiThreading_runJobs.
+ * Flaechen mit mehr als drei Vertizes werden als Faecher in Dreiecke zerlegt.
+ * @param idx Index des Abschnitts
+ * @param ctx loadObjFile
+ */
+static void loadObj_parseChunk(GLint idx, void *ctx);
+
+/**
+ * Prueft, ob eine Zeile mit dem Schluessel (z.B. "v" oder "f") gefolgt von einem Leerzeichen beginnt
+ * @param line Anfang der Zeile ohne fuehrende Leerzeichen
+ * @param end Ende der Zeile
+ * @param key Schluessel aus einem Zeichen
+ * @return GL_TRUE, wenn die Zeile den Schluessel hat
+ */
+static GLboolean loadObj_isKey(const char *line, const char *end, char key);
+
+/**
+ * Ueberspringt Leerzeichen und Tabs
+ * @param pos aktuelle Position
+ * @param end Ende der Zeile
+ * @return erstes anderes Zeichen oder end
+ */
+static const char *loadObj_skipSpaces(const char *pos, const char *end);
+
+/**
+ * Liest eine Gleitkommazahl (Vorzeichen, Nachkommastellen und Exponent optional)
+ * @param pos aktuelle Position, fuehrende Leerzeichen werden uebersprungen
+ * @param end Ende der Zeile
+ * @param value Ausgabe, gelesene Zahl
+ * @return Position hinter der Zahl, NULL wenn keine Zahl gelesen werden konnte
+ */
+static const char *loadObj_parseFloat(const char *pos, const char *end, GLfloat *value);
+
+/**
+ * Liest den Vertex Index eines Eintrags einer Flaeche ("v", "v/vt", "v//vn" oder "v/vt/vn"),
+ * Textur- und Normalenindizes werden uebersprungen
+ * @param pos aktuelle Position, fuehrende Leerzeichen werden uebersprungen
+ * @param end Ende der Zeile
+ * @param value Ausgabe, gelesener Index wie in der Datei (ab 1, negativ relativ zum letzten Vertex)
+ * @return Position hinter dem Eintrag, NULL wenn kein Index gelesen werden konnte
+ */
+static const char *loadObj_parseIndex(const char *pos, const char *end, GLint *value);
+
+/**
+ * Liest Vertizes und Dreiecke einer .obj Datei in zwei parallelen Durchlaeufen, Parser von loadObj_readCached
+ * @param fileName Dateiname fuer Meldungen
+ * @param path Pfad der Datei
+ * @param result Ausgabe, vertexCount und faceCount
+ * @param vertices Ausgabe, gelesene Vertizes
+ * @param indices Ausgabe, Vertexindizes der Dreiecke
+ * @return GL_FALSE bei einem Fehler in der Datei
+ */
+static GLboolean loadObj_parseFile(const char *fileName, const char *path, object *result, vec3 **vertices,
+                                   faces **indices);
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION ---------------------------------------*/
+
+static GLboolean loadObj_isKey(const char *line, const char *end, char key) {
+    return line + 1 < end && line[0] == key && (line[1] == ' ' || line[1] == '\t');
+}
+
+static const char *loadObj_skipSpaces(const char *pos, const char *end) {
+    while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+        pos++;
     }
+    return pos;
 }
 
-object loadObj_readFile(const char *fileName, vec3 translation, vec3 rotation, GLfloat scale) {
-    
-    object result = sceneObjects_initDefaultModel();
-    
-    //Aus dem Dateinamen und dem Pfad die Datei laden
-    char *path = utils_concatStrings(FILE_PATH, fileName);
-    FILE *file = fopen(path, "r");
+static void loadObj_countChunk(GLint idx, void *ctx) {
+    loadObjChunk *chunk = &((loadObjFile *) ctx)->chunks[idx];
+    chunk->vertexCount = 0;
+    chunk->faceCount = 0;
+    chunk->lineCount = 0;
 
-    if (file == NULL) {
-        printf("Couldn't open file!\n");
-        return result;
+    for (const char *line = chunk->begin; line < chunk->end;) {
+        const char *lineEnd = (const char *) memchr(line, '\n', chunk->end - line);
+        if (lineEnd == NULL) {
+            lineEnd = chunk->end;
+        }
+        chunk->lineCount++;
+
+        const char *pos = loadObj_skipSpaces(line, lineEnd);
+        if (loadObj_isKey(pos, lineEnd, 'v')) {
+            chunk->vertexCount++;
+        } else if (loadObj_isKey(pos, lineEnd, 'f')) {
+            //Eintraege zaehlen, eine Flaeche mit n Vertizes ergibt n - 2 Dreiecke
+            GLint entries = 0;
+            pos = loadObj_skipSpaces(pos + 1, lineEnd);
+            while (pos < lineEnd && *pos != '#') {
+                entries++;
+                //Ein Kommentar beginnt wie beim Lesen auch mitten in einem Eintrag
+                while (pos < lineEnd && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '#') {
+                    pos++;
+                }
+                pos = loadObj_skipSpaces(pos, lineEnd);
+            }
+            //Ungueltige Flaechen meldet erst der zweite Durchlauf
+            chunk->faceCount += entries > 2 ? entries - 2 : 0;
+        }
+        line = lineEnd + 1;
     }
+}
 
-    GLint vertexCount = 0;
-    GLint faceCount = 0;
-    faces *indices;
-    vec3 *vertices;
+static void loadObj_parseChunk(GLint idx, void *ctx) {
+    loadObjFile *file = (loadObjFile *) ctx;
+    loadObjChunk *chunk = &file->chunks[idx];
+    GLint vertex = chunk->firstVertex;
+    GLint face = chunk->firstFace;
+    GLint lineNumber = chunk->firstLine;
+    chunk->errorLine = 0;
 
-    //Kommentare auswerten
-    //Anzahl der Vertizes
-    if (fscanf(file, "# vertex count = %d\n", &result.vertexCount) != 1) {
-        printf("Vertex Count Syntax-Error in .obj-File comment!\n");
+    for (const char *line = chunk->begin; line < chunk->end && chunk->errorLine == 0; ++lineNumber) {
+        const char *lineEnd = (const char *) memchr(line, '\n', chunk->end - line);
+        if (lineEnd == NULL) {
+            lineEnd = chunk->end;
+        }
+
+        const char *pos = loadObj_skipSpaces(line, lineEnd);
+        if (loadObj_isKey(pos, lineEnd, 'v')) {
+            //Koordinaten des Vertexes auslesen, eine optionale vierte Koordinate wird ignoriert
+            pos++;
+            for (int i = 0; i < 3 && pos != NULL; ++i) {
+                pos = loadObj_parseFloat(pos, lineEnd, &file->vertices[vertex][i]);
+            }
+            if (pos == NULL) {
+                chunk->errorLine = lineNumber;
+            }
+            vertex++;
+        } else if (loadObj_isKey(pos, lineEnd, 'f')) {
+            //Indizes einlesen (.obj starten bei Index 1, negative Indizes zaehlen vom letzten Vertex zurueck)
+            GLint first = 0, previous = 0, entries = 0;
+            pos = loadObj_skipSpaces(pos + 1, lineEnd);
+            while (pos < lineEnd && *pos != '#' && chunk->errorLine == 0) {
+                GLint index;
+                pos = loadObj_parseIndex(pos, lineEnd, &index);
+                if (pos == NULL || index == 0) {
+                    chunk->errorLine = lineNumber;
+                    break;
+                }
+                index = index > 0 ? index - 1 : vertex + index;
+                if (index < 0 || index >= file->vertexCount) {
+                    chunk->errorLine = lineNumber;
+                    break;
+                }
+
+                //Flaeche als Faecher um den ersten Vertex zerlegen
+                if (entries == 0) {
+                    first = index;
+                } else if (entries >= 2) {
+                    //Nie ueber die im ersten Durchlauf reservierten Dreiecke hinaus schreiben
+                    if (face >= chunk->firstFace + chunk->faceCount) {
+                        chunk->errorLine = lineNumber;
+                        break;
+                    }
+                    file->indices[face].index1 = first;
+                    file->indices[face].index2 = previous;
+                    file->indices[face].index3 = index;
+                    face++;
+                }
+                previous = index;
+                entries++;
+                pos = loadObj_skipSpaces(pos, lineEnd);
+            }
+            if (entries < 3 && chunk->errorLine == 0) {
+                chunk->errorLine = lineNumber;
+            }
+        }
+        line = lineEnd + 1;
     }
-    vertices = calloc(result.vertexCount, sizeof(vec3));
 
-    //Anzahl der Dreiecke
-    if (fscanf(file, "# face count = %d\n", &result.faceCount) != 1) {
-        printf("Face Count Syntax-Error in .obj-File comment!\n");
+    //Beide Durchlaeufe muessen gleich viele Dreiecke ergeben, sonst bleiben Indizes uninitialisiert
+    if (chunk->errorLine == 0 && face - chunk->firstFace != chunk->faceCount) {
+        chunk->errorLine = lineNumber - 1;
     }
-    indices = calloc(result.faceCount, sizeof(faces));
+}
 
-    //Solange die Datei verarbeiten, bis EOF erreicht ist
-    while (1) {
+static const char *loadObj_parseFloat(const char *pos, const char *end, GLfloat *value) {
+    //Zehnerpotenzen, die als double exakt darstellbar sind
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    pos = loadObj_skipSpaces(pos, end);
+    GLboolean negative = GL_FALSE;
+    if (pos < end && (*pos == '-' || *pos == '+')) {
+        negative = *pos == '-';
+        pos++;
+    }
 
-        //Ersten char aus der Zeile auslesen -> Vertex oder Face
-        char lineHeader[64];
-        int res = fscanf(file, "%s", lineHeader);
-        if (res == EOF) {
-            break;
+    //Ziffern als ganze Zahl sammeln, Stellen jenseits der Genauigkeit verschieben nur den Exponenten
+    unsigned long long mantissa = 0;
+    GLint exponent = 0;
+    GLint digits = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos, ++digits) {
+        if (mantissa < 100000000000000000ull) {
+            mantissa = mantissa * 10 + (unsigned long long) (*pos - '0');
+        } else {
+            exponent++;
         }
-
-        if (strcmp(lineHeader, "v") == 0) {
-            //Koordinaten des Vertexes auslesen
-            if(fscanf(file, "%f %f %f\n", &vertices[vertexCount][0],
-                   &vertices[vertexCount][1],
-                   &vertices[vertexCount][2]) != 3){
-                printf("ERROR in File for a Vertex! \t%d\n", vertexCount);
-                exit(1);
+    }
+    if (pos < end && *pos == '.') {
+        for (pos++; pos < end && *pos >= '0' && *pos <= '9'; ++pos, ++digits) {
+            if (mantissa < 100000000000000000ull) {
+                mantissa = mantissa * 10 + (unsigned long long) (*pos - '0');
+                exponent--;
             }
-            vertexCount++;
-        } else if (strcmp(lineHeader, "f") == 0) {
-            //Indizes einlesen (.obj starten bei Index 1!)
-            if(fscanf(file, "%d %d %d\n", &indices[faceCount].index1,
-                   &indices[faceCount].index2,
-                   &indices[faceCount].index3) != 3){
-                printf("ERROR in File for a Face!\t%d\n", faceCount);
-                exit(1);
+        }
+    }
+    if (digits == 0) {
+        return NULL;
+    }
+
+    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+        const char *expPos = pos + 1;
+        GLboolean expNegative = GL_FALSE;
+        if (expPos < end && (*expPos == '-' || *expPos == '+')) {
+            expNegative = *expPos == '-';
+            expPos++;
+        }
+        if (expPos < end && *expPos >= '0' && *expPos <= '9') {
+            GLint expValue = 0;
+            for (; expPos < end && *expPos >= '0' && *expPos <= '9'; ++expPos) {
+                if (expValue < 10000) {
+                    expValue = expValue * 10 + (*expPos - '0');
+                }
             }
+            exponent += expNegative ? -expValue : expValue;
+            pos = expPos;
+        }
+    }
+    //Die Zahl muss hier enden
+    if (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '#') {
+        return NULL;
+    }
 
-            indices[faceCount].index1--;
-            indices[faceCount].index2--;
-            indices[faceCount].index3--;
-            faceCount++;
+    //Bis 2^53 und 10^22 ist eine Multiplikation oder Division exakt gerundet
+    double result = (double) mantissa;
+    if (exponent < 0) {
+        result = -exponent <= 22 ? result / powers[-exponent] : result * pow(10.0, exponent);
+    } else if (exponent > 0) {
+        result = exponent <= 22 ? result * powers[exponent] : result * pow(10.0, exponent);
+    }
+    *value = (GLfloat) (negative ? -result : result);
+    return pos;
+}
+
+static const char *loadObj_parseIndex(const char *pos, const char *end, GLint *value) {
+    pos = loadObj_skipSpaces(pos, end);
+    GLboolean negative = GL_FALSE;
+    if (pos < end && *pos == '-') {
+        negative = GL_TRUE;
+        pos++;
+    }
+    if (pos >= end || *pos < '0' || *pos > '9') {
+        return NULL;
+    }
+    long result = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos) {
+        if (result < 0x7fffffffL) {
+            result = result * 10 + (*pos - '0');
+        }
+    }
+    //Textur- und Normalenindex ueberspringen
+    if (pos < end && *pos == '/') {
+        while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '#') {
+            pos++;
         }
     }
+    if (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '#') {
+        return NULL;
+    }
+    result = result < 0x7fffffffL ? result : 0x7fffffffL;
+    *value = (GLint) (negative ? -result : result);
+    return pos;
+}
+
+static GLboolean loadObj_parseFile(const char *fileName, const char *path, object *result, vec3 **vertices,
+                                   faces **indices) {
+    size_t size = 0;
+    const char *data = (const char *) utils_mapFile(path, &size);
+    if (data == NULL) {
+        printf("Couldn't open file!\n");
+        return GL_FALSE;
+    }
 
-    //Objekt aus den ausgelesenen Datene erstellen
-    loadObj_createObjectFromFile(vertices, &result, indices, translation, rotation, scale);
-    
-    if(result.vertexCount <= 0){
-        printf("Error loading obj File!\n");
+    //Datei an Zeilengrenzen in Abschnitte zerlegen
+    GLint chunkCount = multiThreading_cpuCount() * LOAD_OBJ_CHUNKS_PER_CPU;
+    if ((size_t) chunkCount > size / LOAD_OBJ_MIN_CHUNK) {
+        chunkCount = (GLint) (size / LOAD_OBJ_MIN_CHUNK);
+    }
+    chunkCount = chunkCount > 0 ? chunkCount : 1;
+    loadObjFile file;
+    file.chunks = (loadObjChunk *) calloc(chunkCount, sizeof(loadObjChunk));
+    if (file.chunks == NULL) {
+        printf("Error allocating obj chunks!\n");
         exit(1);
     }
-    
+    const char *fileEnd = data + size;
+    const char *chunkBegin = data;
+    GLint usedChunks = 0;
+    for (int i = 0; i < chunkCount && chunkBegin < fileEnd; ++i) {
+        const char *chunkEnd = fileEnd;
+        if (i < chunkCount - 1 && (size_t) (fileEnd - chunkBegin) > size / chunkCount) {
+            const char *newline = (const char *) memchr(chunkBegin + size / chunkCount, '\n',
+                                                       fileEnd - chunkBegin - size / chunkCount);
+            chunkEnd = newline != NULL ? newline + 1 : fileEnd;
+        }
+        file.chunks[usedChunks].begin = chunkBegin;
+        file.chunks[usedChunks].end = chunkEnd;
+        usedChunks++;
+        chunkBegin = chunkEnd;
+    }
+
+    //Erster Durchlauf: Groessen der Arrays und Startindizes der Abschnitte bestimmen
+    multiThreading_runJobs(usedChunks, multiThreading_cpuCount(), loadObj_countChunk, &file);
+    GLint vertexCount = 0;
+    GLint faceCount = 0;
+    GLint lineCount = 1;
+    for (int i = 0; i < usedChunks; ++i) {
+        file.chunks[i].firstVertex = vertexCount;
+        file.chunks[i].firstFace = faceCount;
+        file.chunks[i].firstLine = lineCount;
+        vertexCount += file.chunks[i].vertexCount;
+        faceCount += file.chunks[i].faceCount;
+        lineCount += file.chunks[i].lineCount;
+    }
+
+    //Zweiter Durchlauf: Zahlen direkt an ihre Stelle lesen
+    file.vertexCount = vertexCount;
+    file.vertices = (vec3 *) malloc((vertexCount > 0 ? vertexCount : 1) * sizeof(vec3));
+    file.indices = (faces *) malloc((faceCount > 0 ? faceCount : 1) * sizeof(faces));
+    if (file.vertices == NULL || file.indices == NULL) {
+        printf("Error allocating obj data!\n");
+        exit(1);
+    }
+    multiThreading_runJobs(usedChunks, multiThreading_cpuCount(), loadObj_parseChunk, &file);
+    utils_unmapFile((void *) data, size);
+    *vertices = file.vertices;
+    *indices = file.indices;
+
+    //Ersten Fehler der Datei melden, das Modell bleibt dann leer
+    GLint errorLine = 0;
+    for (int i = 0; i < usedChunks && errorLine == 0; ++i) {
+        errorLine = file.chunks[i].errorLine;
+    }
+    free(file.chunks);
+    if (errorLine == 0 && (vertexCount <= 0 || faceCount <= 0)) {
+        printf("%s: No vertices or faces in obj File!\n", fileName);
+        return GL_FALSE;
+    } else if (errorLine != 0) {
+        printf("%s: Syntax-Error in line %d of obj File!\n", fileName, errorLine);
+        return GL_FALSE;
+    }
+    result->vertexCount = vertexCount;
+    result->faceCount = faceCount;
+    return GL_TRUE;
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+void loadObj_createObjectFromFile(vec3 *vertices, object *currObj, faces *indices, GLboolean compressedOnly) {
+    //Gelesene Arrays ohne Kopie uebernehmen, die Vertizes bleiben im Objektraum (Transformation der Instanzen)
+    //und die Indizes werden fuer die komprimierte BVH behalten
+    currObj->vertices = vertices;
+    currObj->indices = indices;
+
+    //BVH ueber die Dreiecke aufbauen, berechnet auch Kanten und Normalen der Dreiecke vor
+    //-> Schnitttests muessen nicht mehr gegen jedes Dreieck laufen
+    bvh_buildObject(currObj, compressedOnly);
+
+    //AABB und OBB fuer den Test vor den Dreiecken
+    boundingBox_calculateBounds(currObj);
+}
+
+object loadObj_readCached(const char *fileName, loadObjParseFunc parse, GLboolean compressedOnly) {
+    object result = sceneObjects_initDefaultModel();
+    double startTime = multiThreading_seconds();
+
+    //Aus dem Dateinamen und dem Pfad die Datei laden
+    char *path = utils_concatStrings(FILE_PATH, fileName);
+
+    //Fertig aufgebautes Mesh aus der Mesh-Datei, wenn sie zur Modelldatei passt
+    if (meshCache_load(path, &result, compressedOnly)) {
+        GLfloat cacheTime = (GLfloat) ((multiThreading_seconds() - startTime) * 1000.0);
+        printf("%s: \t%d Tris, Mesh cache %.1f ms, %sBVH %d Nodes, Depth %d, SAH %.2f\n", fileName,
+               result.faceCount, cacheTime, result.bvh.compressedOnly ? "Compressed " : "",
+               result.bvh.compressedOnly ? result.bvh.nodeCountQ : result.bvh.nodeCount, result.bvh.stats.depth,
+               result.bvh.stats.sahCost);
+        free(path);
+        return result;
+    }
+
+    vec3 *vertices = NULL;
+    faces *indices = NULL;
+    if (parse(fileName, path, &result, &vertices, &indices)) {
+        GLfloat parseTime = (GLfloat) ((multiThreading_seconds() - startTime) * 1000.0);
+        //Objekt aus den ausgelesenen Daten erstellen, das Objekt uebernimmt die Arrays
+        loadObj_createObjectFromFile(vertices, &result, indices, compressedOnly);
+        vertices = NULL;
+        indices = NULL;
+        printf("%s: \t%d Tris, Parse %.1f ms, %sBVH %d Nodes, Depth %d, SAH %.2f, %d ms\n", fileName,
+               result.faceCount, parseTime, result.bvh.compressedOnly ? "Compressed " : "",
+               result.bvh.compressedOnly ? result.bvh.nodeCountQ : result.bvh.nodeCount, result.bvh.stats.depth,
+               result.bvh.stats.sahCost, result.bvh.stats.buildTime);
+        //Beim naechsten Start entfallen Lesen und Aufbau
+        meshCache_write(path, &result);
+    }
+
     free(path);
-    fclose(file);
+    free(vertices);
+    free(indices);
     return result;
-}
\ No newline at end of file
+}
+
+object loadObj_readFile(const char *fileName, GLboolean compressedOnly) {
+    return loadObj_readCached(fileName, loadObj_parseFile, compressedOnly);
+}
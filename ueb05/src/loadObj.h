@@ -5,14 +5,47 @@
 #ifndef UEB05_LOADOBJ_H
 #define UEB05_LOADOBJ_H
 #include "utils.h"
+
 /**
- * Laedt eine .Obj Datei und erstellt ein Objekt, welches in der Szene gerendert werden kann
- * Erstellt aus Vertizes und Indizes ein Objekt und platziert es in der Szene
+ * Liest Vertizes und Dreiecke einer Modelldatei, Fehler meldet die Funktion selbst
+ * @param fileName Dateiname fuer Meldungen
+ * @param path Pfad der Datei
+ * @param result Ausgabe, vertexCount und faceCount werden nur bei Erfolg gesetzt
+ * @param vertices Ausgabe, mit malloc angelegte Vertizes (auch bei einem Fehler freizugeben)
+ * @param indices Ausgabe, mit malloc angelegte Vertexindizes der Dreiecke (auch bei einem Fehler freizugeben)
+ * @return GL_TRUE, wenn die Datei vollstaendig gelesen wurde
+ */
+typedef GLboolean (*loadObjParseFunc)(const char *fileName, const char *path, object *result, vec3 **vertices,
+                                      faces **indices);
+
+/**
+ * Laedt eine .Obj Datei und erstellt ein Mesh im Objektraum, das ueber Instanzen in der Szene platziert wird
+ * Erstellt aus Vertizes und Indizes ein Objekt und baut dessen BVH auf
  * @param fileName Dateiname der obj Datei
- * @param translation Ort des Objektes in der Szene
- * @param rotation Rotation des Objektes
- * @param scale Skalierung des Objektes
+ * @param compressedOnly GL_TRUE, wenn nur die komprimierte BVH aufgebaut werden soll (siehe bvh_buildObject)
  * @return object, geladenenes object, default Object, wenn was schief gegangen ist
  */
-object loadObj_readFile(const char* fileName, vec3 translation, vec3 rotation, GLfloat scale);
+object loadObj_readFile(const char* fileName, GLboolean compressedOnly);
+
+/**
+ * Erstellt aus Vertizes und Indizes ein Mesh im Objektraum: baut BVH (mit den vorberechneten Kanten und
+ * Normalen der Dreiecke) und Bounding Volumes auf. Wird auch von den anderen Dateiformaten verwendet.
+ * @param vertices mit malloc angelegte Vertizes, gehen in den Besitz des Objektes ueber
+ * @param currObj Ausgabe, vertexCount und faceCount muessen gesetzt sein
+ * @param indices mit malloc angelegte Vertexindizes der Dreiecke, gehen in den Besitz des Objektes ueber
+ * @param compressedOnly GL_TRUE, wenn nur die komprimierte BVH aufgebaut werden soll (siehe bvh_buildObject)
+ */
+void loadObj_createObjectFromFile(vec3 *vertices, object *currObj, faces *indices, GLboolean compressedOnly);
+
+/**
+ * Laedt ein Mesh aus der Mesh-Datei neben der Modelldatei. Passt sie nicht, wird die Modelldatei mit parse
+ * gelesen, das Mesh aufgebaut und fuer den naechsten Start als Mesh-Datei abgelegt. Wird von allen
+ * Dateiformaten verwendet.
+ * @param fileName Dateiname im Modellordner
+ * @param parse Funktion, die Vertizes und Dreiecke des Dateiformats liest
+ * @param compressedOnly GL_TRUE, wenn nur die komprimierte BVH aufgebaut werden soll, eine Mesh-Datei
+ *                       mit allen Layouts wird dann neu aufgebaut (und umgekehrt)
+ * @return geladenes Mesh, default Object, wenn was schief gegangen ist
+ */
+object loadObj_readCached(const char *fileName, loadObjParseFunc parse, GLboolean compressedOnly);
 #endif //UEB05_LOADOBJ_H
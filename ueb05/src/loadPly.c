@@ -0,0 +1,604 @@
+/**
+ * @file
+ * Schnittstelle, um binaere .ply Dateien zu laden und Meshes daraus zu erstellen.
+ * Die Datei wird einmal in den Speicher gemappt, nur der Kopf wird als Text gelesen. Aus ihm ergeben sich
+ * Lage und Aufbau der Vertizes und Flaechen in den Binaerdaten. Die Koordinaten werden dann ohne Zwischenschritt
+ * in das Vertex-Array umgewandelt (Byte-Reihenfolge nur bei Bedarf getauscht), ebenso die Indizes. Die Arrays
+ * gehen ohne Kopie an das Mesh ueber. Bestehen alle Flaechen aus
+ * Dreiecken, haben sie feste Groesse und werden wie die Vertizes in parallelen Jobs gelesen, sonst werden sie
+ * der Reihe nach in Faecher zerlegt.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "loadPly.h"
+#include "loadObj.h"
+#include "multiThreading.h"
+
+/** Maximale Anzahl der Elemente und der Properties je Element im Kopf */
+#define LOAD_PLY_MAX_ELEMENTS (16)
+#define LOAD_PLY_MAX_PROPERTIES (32)
+/** Maximale Laenge einer Zeile und eines Namens im Kopf */
+#define LOAD_PLY_MAX_LINE (256)
+#define LOAD_PLY_MAX_NAME (32)
+/** Vertizes bzw. Dreiecke, die ein Job umwandelt */
+#define LOAD_PLY_JOB_SIZE (1 << 16)
+
+/**---------------------------------------------- LOCAL TYPES ---------------------------------------------------*/
+
+/** Skalare Typen der Properties */
+typedef enum loadPlyType {
+    plyNone,
+    plyInt8,
+    plyUint8,
+    plyInt16,
+    plyUint16,
+    plyInt32,
+    plyUint32,
+    plyFloat32,
+    plyFloat64
+} loadPlyType;
+
+/** Property eines Elements aus dem Kopf */
+typedef struct loadPlyProperty {
+    char name[LOAD_PLY_MAX_NAME];
+    /** Typ des Wertes bzw. der Listeneintraege */
+    loadPlyType type;
+    /** Typ der Anzahl bei Listen, plyNone bei einzelnen Werten */
+    loadPlyType countType;
+} loadPlyProperty;
+
+/** Element aus dem Kopf, die Elemente liegen in der Reihenfolge des Kopfes in den Binaerdaten */
+typedef struct loadPlyElement {
+    char name[LOAD_PLY_MAX_NAME];
+    GLint count;
+    loadPlyProperty properties[LOAD_PLY_MAX_PROPERTIES];
+    GLint propertyCount;
+} loadPlyElement;
+
+/** Gemeinsamer Zustand der Jobs beim Umwandeln einer Datei */
+typedef struct loadPlyFile {
+    /** GL_TRUE, wenn die Byte-Reihenfolge der Datei nicht der des Rechners entspricht */
+    GLboolean swap;
+    /** Erster Vertex, Abstand der Vertizes, Offset und Typ von x, y, z */
+    const unsigned char *vertexData;
+    GLint vertexStride;
+    GLint coordOffset[3];
+    loadPlyType coordType[3];
+    /** Erste Flaeche und Abstand der Flaechen (nur wenn alle Flaechen Dreiecke sind) */
+    const unsigned char *faceData;
+    GLint faceStride;
+    /** Offset der Indizes in einer Flaeche, Typ der Indizes */
+    GLint indexOffset;
+    loadPlyType indexType;
+    /** Ziel der Vertizes und Indizes */
+    vec3 *vertices;
+    faces *indices;
+    GLint vertexCount;
+    GLint faceCount;
+    /** Wird gesetzt, wenn eine Flaeche auf einen Vertex ausserhalb der Datei verweist */
+    long invalidIndex;
+} loadPlyFile;
+
+/**------------------------------------------ LOCAL FUNCTION DECLARATION ----------------------------------------*/
+
+/**
+ * Bestimmt den Typ zu einem Typnamen des Kopfes ("float", "float32", "uchar", ...)
+ * @param name Typname
+ * @return Typ, plyNone bei unbekannten Namen
+ */
+static loadPlyType loadPly_typeFromName(const char *name);
+
+/**
+ * Groesse eines Typs in Bytes
+ * @param type Typ
+ * @return Groesse, 0 bei plyNone
+ */
+static GLint loadPly_typeSize(loadPlyType type);
+
+/**
+ * Liest einen Wert aus den Binaerdaten (auch an nicht ausgerichteten Adressen)
+ * @param pos Position des Wertes
+ * @param type Typ des Wertes
+ * @param swap GL_TRUE, wenn die Byte-Reihenfolge getauscht werden muss
+ * @return Wert
+ */
+static GLdouble loadPly_readValue(const unsigned char *pos, loadPlyType type, GLboolean swap);
+
+/**
+ * Liest einen Vertexindex einer Flaeche. 32 Bit Indizes in der Byte-Reihenfolge des Rechners
+ * (haeufigster Fall) werden nur kopiert, alle anderen ueber loadPly_readValue umgewandelt.
+ * @param pos Position des Index
+ * @param type Typ des Index (hoechstens 4 Byte)
+ * @param swap GL_TRUE, wenn die Byte-Reihenfolge getauscht werden muss
+ * @param vertexCount Anzahl der Vertizes der Datei
+ * @return Index, -1 wenn er auf keinen Vertex der Datei verweist
+ */
+static GLint loadPly_readIndex(const unsigned char *pos, loadPlyType type, GLboolean swap, GLint vertexCount);
+
+/**
+ * Liest den Kopf der Datei
+ * @param data Anfang der Datei
+ * @param size Groesse der Datei
+ * @param elements Ausgabe, Elemente (LOAD_PLY_MAX_ELEMENTS)
+ * @param elementCount Ausgabe, Anzahl der Elemente
+ * @param swap Ausgabe, GL_TRUE, wenn die Byte-Reihenfolge getauscht werden muss
+ * @return Groesse des Kopfes in Bytes, 0 wenn der Kopf nicht gelesen werden konnte
+ */
+static size_t loadPly_parseHeader(const char *data, size_t size, loadPlyElement *elements, GLint *elementCount,
+                                  GLboolean *swap);
+
+/**
+ * Bestimmt das Ende der Daten eines Elements. Elemente ohne Listen haben feste Groesse,
+ * sonst werden die Listen einzeln uebersprungen.
+ * @param element Element
+ * @param pos Anfang der Daten des Elements
+ * @param end Ende der Datei
+ * @param swap GL_TRUE, wenn die Byte-Reihenfolge getauscht werden muss
+ * @return Ende der Daten, NULL wenn die Daten ueber das Ende der Datei hinausgehen
+ */
+static const unsigned char *loadPly_skipElement(const loadPlyElement *element, const unsigned char *pos,
+                                                const unsigned char *end, GLboolean swap);
+
+/**
+ * Wandelt einen Bereich von Vertizes um, Job von multiThreading_runJobs
+ * @param idx Index des Bereichs (LOAD_PLY_JOB_SIZE Vertizes)
+ * @param ctx loadPlyFile
+ */
+static void loadPly_convertVertices(GLint idx, void *ctx);
+
+/**
+ * Liest einen Bereich von Dreiecken fester Groesse, Job von multiThreading_runJobs
+ * @param idx Index des Bereichs (LOAD_PLY_JOB_SIZE Dreiecke)
+ * @param ctx loadPlyFile
+ */
+static void loadPly_convertTriangles(GLint idx, void *ctx);
+
+/**
+ * Liest Vertizes und Dreiecke einer binaeren .ply Datei, Parser von loadObj_readCached
+ * @param fileName Dateiname fuer Meldungen
+ * @param path Pfad der Datei
+ * @param result Ausgabe, vertexCount und faceCount
+ * @param vertices Ausgabe, umgewandelte Vertizes
+ * @param indices Ausgabe, Vertexindizes der Dreiecke
+ * @return GL_FALSE, wenn der Kopf oder die Daten ungueltig sind
+ */
+static GLboolean loadPly_parseFile(const char *fileName, const char *path, object *result, vec3 **vertices,
+                                   faces **indices);
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION ---------------------------------------*/
+
+static loadPlyType loadPly_typeFromName(const char *name) {
+    if (strcmp(name, "char") == 0 || strcmp(name, "int8") == 0) {
+        return plyInt8;
+    } else if (strcmp(name, "uchar") == 0 || strcmp(name, "uint8") == 0) {
+        return plyUint8;
+    } else if (strcmp(name, "short") == 0 || strcmp(name, "int16") == 0) {
+        return plyInt16;
+    } else if (strcmp(name, "ushort") == 0 || strcmp(name, "uint16") == 0) {
+        return plyUint16;
+    } else if (strcmp(name, "int") == 0 || strcmp(name, "int32") == 0) {
+        return plyInt32;
+    } else if (strcmp(name, "uint") == 0 || strcmp(name, "uint32") == 0) {
+        return plyUint32;
+    } else if (strcmp(name, "float") == 0 || strcmp(name, "float32") == 0) {
+        return plyFloat32;
+    } else if (strcmp(name, "double") == 0 || strcmp(name, "float64") == 0) {
+        return plyFloat64;
+    }
+    return plyNone;
+}
+
+static GLint loadPly_typeSize(loadPlyType type) {
+    switch (type) {
+        case plyInt8:
+        case plyUint8:
+            return 1;
+        case plyInt16:
+        case plyUint16:
+            return 2;
+        case plyInt32:
+        case plyUint32:
+        case plyFloat32:
+            return 4;
+        case plyFloat64:
+            return 8;
+        case plyNone:
+        default:
+            return 0;
+    }
+}
+
+static GLdouble loadPly_readValue(const unsigned char *pos, loadPlyType type, GLboolean swap) {
+    unsigned char bytes[8];
+    GLint size = loadPly_typeSize(type);
+    for (int i = 0; i < size; ++i) {
+        bytes[i] = swap ? pos[size - 1 - i] : pos[i];
+    }
+    switch (type) {
+        case plyInt8: {
+            GLbyte value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyUint8:
+            return bytes[0];
+        case plyInt16: {
+            GLshort value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyUint16: {
+            GLushort value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyInt32: {
+            GLint value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyUint32: {
+            GLuint value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyFloat32: {
+            GLfloat value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyFloat64: {
+            GLdouble value;
+            memcpy(&value, bytes, sizeof(value));
+            return value;
+        }
+        case plyNone:
+        default:
+            return 0.0;
+    }
+}
+
+static GLint loadPly_readIndex(const unsigned char *pos, loadPlyType type, GLboolean swap, GLint vertexCount) {
+    if (!swap && (type == plyInt32 || type == plyUint32)) {
+        //Negative int32 Werte werden als unsigned zu gross und damit ebenfalls abgelehnt
+        GLuint value;
+        memcpy(&value, pos, sizeof(value));
+        return value < (GLuint) vertexCount ? (GLint) value : -1;
+    }
+    GLdouble value = loadPly_readValue(pos, type, swap);
+    return value >= 0.0 && value < (GLdouble) vertexCount ? (GLint) value : -1;
+}
+
+static size_t loadPly_parseHeader(const char *data, size_t size, loadPlyElement *elements, GLint *elementCount,
+                                  GLboolean *swap) {
+    const GLuint probe = 1;
+    GLboolean hostLittleEndian = *(const unsigned char *) &probe == 1;
+    GLboolean hasFormat = GL_FALSE;
+    *elementCount = 0;
+
+    const char *end = data + size;
+    for (const char *line = data; line < end;) {
+        const char *lineEnd = (const char *) memchr(line, '\n', end - line);
+        if (lineEnd == NULL) {
+            return 0;
+        }
+
+        //Zeile kopieren, damit sscanf am Zeilenende aufhoert
+        char text[LOAD_PLY_MAX_LINE];
+        size_t length = (size_t) (lineEnd - line) < sizeof(text) - 1 ? (size_t) (lineEnd - line) : sizeof(text) - 1;
+        memcpy(text, line, length);
+        text[length] = '\0';
+        if (length > 0 && text[length - 1] == '\r') {
+            text[length - 1] = '\0';
+        }
+
+        char word[3][LOAD_PLY_MAX_NAME];
+        GLint count;
+        if (line == data) {
+            if (strcmp(text, "ply") != 0) {
+                return 0;
+            }
+        } else if (strcmp(text, "end_header") == 0) {
+            return hasFormat ? (size_t) (lineEnd + 1 - data) : 0;
+        } else if (sscanf(text, "format %31s %31s", word[0], word[1]) == 2) {
+            //Text-Dateien werden nicht unterstuetzt
+            if (strcmp(word[0], "binary_little_endian") == 0) {
+                *swap = !hostLittleEndian;
+            } else if (strcmp(word[0], "binary_big_endian") == 0) {
+                *swap = hostLittleEndian;
+            } else {
+                return 0;
+            }
+            hasFormat = GL_TRUE;
+        } else if (sscanf(text, "element %31s %d", word[0], &count) == 2) {
+            if (*elementCount == LOAD_PLY_MAX_ELEMENTS || count < 0) {
+                return 0;
+            }
+            loadPlyElement *element = &elements[(*elementCount)++];
+            strcpy(element->name, word[0]);
+            element->count = count;
+            element->propertyCount = 0;
+        } else if (sscanf(text, "property list %31s %31s %31s", word[0], word[1], word[2]) == 3 ||
+                   sscanf(text, "property %31s %31s", word[1], word[2]) == 2) {
+            GLboolean list = strncmp(text, "property list ", 14) == 0;
+            if (*elementCount == 0 || elements[*elementCount - 1].propertyCount == LOAD_PLY_MAX_PROPERTIES) {
+                return 0;
+            }
+            loadPlyElement *element = &elements[*elementCount - 1];
+            loadPlyProperty *property = &element->properties[element->propertyCount++];
+            strcpy(property->name, word[2]);
+            property->type = loadPly_typeFromName(word[1]);
+            property->countType = list ? loadPly_typeFromName(word[0]) : plyNone;
+            if (property->type == plyNone || (list && property->countType == plyNone)) {
+                return 0;
+            }
+        } else if (strncmp(text, "comment", 7) != 0 && strncmp(text, "obj_info", 8) != 0 && text[0] != '\0') {
+            return 0;
+        }
+        line = lineEnd + 1;
+    }
+    return 0;
+}
+
+static const unsigned char *loadPly_skipElement(const loadPlyElement *element, const unsigned char *pos,
+                                                const unsigned char *end, GLboolean swap) {
+    //Ohne Listen haben alle Eintraege dieselbe Groesse
+    size_t stride = 0;
+    GLboolean hasList = GL_FALSE;
+    for (int i = 0; i < element->propertyCount; ++i) {
+        stride += loadPly_typeSize(element->properties[i].type);
+        hasList = hasList || element->properties[i].countType != plyNone;
+    }
+    if (!hasList) {
+        if (stride > 0 && (size_t) (end - pos) / stride < (size_t) element->count) {
+            return NULL;
+        }
+        return pos + stride * element->count;
+    }
+
+    for (int i = 0; i < element->count; ++i) {
+        for (int j = 0; j < element->propertyCount; ++j) {
+            const loadPlyProperty *property = &element->properties[j];
+            size_t bytes = loadPly_typeSize(property->type);
+            if (property->countType != plyNone) {
+                GLint countSize = loadPly_typeSize(property->countType);
+                if (end - pos < countSize) {
+                    return NULL;
+                }
+                GLdouble entries = loadPly_readValue(pos, property->countType, swap);
+                if (entries < 0.0 || entries > (GLdouble) (end - pos)) {
+                    return NULL;
+                }
+                pos += countSize;
+                bytes *= (size_t) entries;
+            }
+            if ((size_t) (end - pos) < bytes) {
+                return NULL;
+            }
+            pos += bytes;
+        }
+    }
+    return pos;
+}
+
+static void loadPly_convertVertices(GLint idx, void *ctx) {
+    loadPlyFile *file = (loadPlyFile *) ctx;
+    GLint first = idx * LOAD_PLY_JOB_SIZE;
+    GLint last = first + LOAD_PLY_JOB_SIZE < file->vertexCount ? first + LOAD_PLY_JOB_SIZE : file->vertexCount;
+    GLboolean direct = !file->swap && file->coordType[0] == plyFloat32 && file->coordType[1] == plyFloat32 &&
+                       file->coordType[2] == plyFloat32;
+
+    for (int i = first; i < last; ++i) {
+        const unsigned char *vertex = file->vertexData + (size_t) i * file->vertexStride;
+        for (int axis = 0; axis < 3; ++axis) {
+            //Haeufigster Fall: float in der Byte-Reihenfolge des Rechners wird nur kopiert
+            if (direct) {
+                memcpy(&file->vertices[i][axis], vertex + file->coordOffset[axis], sizeof(GLfloat));
+            } else {
+                file->vertices[i][axis] = (GLfloat) loadPly_readValue(vertex + file->coordOffset[axis],
+                                                                      file->coordType[axis], file->swap);
+            }
+        }
+    }
+}
+
+static void loadPly_convertTriangles(GLint idx, void *ctx) {
+    loadPlyFile *file = (loadPlyFile *) ctx;
+    GLint first = idx * LOAD_PLY_JOB_SIZE;
+    GLint last = first + LOAD_PLY_JOB_SIZE < file->faceCount ? first + LOAD_PLY_JOB_SIZE : file->faceCount;
+    GLint indexSize = loadPly_typeSize(file->indexType);
+
+    for (int i = first; i < last; ++i) {
+        const unsigned char *face = file->faceData + (size_t) i * file->faceStride + file->indexOffset;
+        GLint index[3];
+        for (int j = 0; j < 3; ++j) {
+            index[j] = loadPly_readIndex(face + j * indexSize, file->indexType, file->swap, file->vertexCount);
+            if (index[j] < 0) {
+                MULTI_THREAD_ATOMIC_STORE(&file->invalidIndex, 1);
+                index[j] = 0;
+            }
+        }
+        file->indices[i].index1 = index[0];
+        file->indices[i].index2 = index[1];
+        file->indices[i].index3 = index[2];
+    }
+}
+
+static GLboolean loadPly_parseFile(const char *fileName, const char *path, object *result, vec3 **vertices,
+                                   faces **indices) {
+    size_t size = 0;
+    const char *data = (const char *) utils_mapFile(path, &size);
+    if (data == NULL) {
+        printf("Couldn't open file!\n");
+        return GL_FALSE;
+    }
+
+    loadPlyElement elements[LOAD_PLY_MAX_ELEMENTS];
+    GLint elementCount = 0;
+    loadPlyFile file;
+    memset(&file, 0, sizeof(file));
+    size_t headerSize = loadPly_parseHeader(data, size, elements, &elementCount, &file.swap);
+    if (headerSize == 0) {
+        printf("%s: Invalid header, only binary ply Files are supported!\n", fileName);
+        utils_unmapFile((void *) data, size);
+        return GL_FALSE;
+    }
+
+    //Lage der Vertizes und Flaechen in den Binaerdaten bestimmen, andere Elemente ueberspringen
+    const unsigned char *end = (const unsigned char *) data + size;
+    const unsigned char *pos = (const unsigned char *) data + headerSize;
+    const loadPlyElement *faceElement = NULL;
+    GLint listIndex = -1;
+    GLboolean valid = GL_TRUE;
+    GLboolean hasVertices = GL_FALSE;
+    GLint faceCount = 0;
+    GLboolean onlyTriangles = GL_TRUE;
+    for (int e = 0; e < elementCount && valid; ++e) {
+        const loadPlyElement *element = &elements[e];
+        if (strcmp(element->name, "vertex") == 0) {
+            GLint found = 0;
+            file.vertexData = pos;
+            file.vertexCount = element->count;
+            for (int i = 0; i < element->propertyCount; ++i) {
+                const loadPlyProperty *property = &element->properties[i];
+                GLint axis = property->name[1] == '\0' ? property->name[0] - 'x' : -1;
+                if (axis >= 0 && axis < 3 && property->countType == plyNone) {
+                    file.coordOffset[axis] = file.vertexStride;
+                    file.coordType[axis] = property->type;
+                    found |= 1 << axis;
+                }
+                valid = valid && property->countType == plyNone;
+                file.vertexStride += loadPly_typeSize(property->type);
+            }
+            valid = valid && found == 7;
+            hasVertices = valid;
+        } else if (strcmp(element->name, "face") == 0) {
+            faceElement = element;
+            file.faceData = pos;
+            file.faceCount = element->count;
+            for (int i = 0; i < element->propertyCount; ++i) {
+                const loadPlyProperty *property = &element->properties[i];
+                if (property->countType != plyNone && (strcmp(property->name, "vertex_indices") == 0 ||
+                                                       strcmp(property->name, "vertex_index") == 0)) {
+                    listIndex = i;
+                } else if (property->countType != plyNone) {
+                    valid = GL_FALSE;
+                } else if (listIndex < 0) {
+                    file.indexOffset += loadPly_typeSize(property->type);
+                }
+            }
+            valid = valid && listIndex >= 0 && loadPly_typeSize(element->properties[listIndex].type) <= 4;
+        }
+        if (!valid) {
+            break;
+        }
+
+        //Ende der Daten, bei den Flaechen zusaetzlich die Anzahl der Dreiecke
+        if (element == faceElement) {
+            const loadPlyProperty *list = &element->properties[listIndex];
+            file.indexType = list->type;
+            GLint countSize = loadPly_typeSize(list->countType);
+            GLint indexSize = loadPly_typeSize(list->type);
+            GLint otherSize = 0;
+            for (int i = 0; i < element->propertyCount; ++i) {
+                otherSize += i != listIndex ? loadPly_typeSize(element->properties[i].type) : 0;
+            }
+            for (int i = 0; i < element->count && valid; ++i) {
+                const unsigned char *countPos = pos + file.indexOffset;
+                if (end - pos < file.indexOffset + countSize) {
+                    valid = GL_FALSE;
+                    break;
+                }
+                GLdouble entries = loadPly_readValue(countPos, list->countType, file.swap);
+                if (entries < 3.0 || entries > (GLdouble) (end - pos)) {
+                    valid = GL_FALSE;
+                    break;
+                }
+                size_t faceSize = (size_t) otherSize + countSize + (size_t) entries * indexSize;
+                if ((size_t) (end - pos) < faceSize) {
+                    valid = GL_FALSE;
+                    break;
+                }
+                onlyTriangles = onlyTriangles && entries == 3.0;
+                faceCount += (GLint) entries - 2;
+                pos += faceSize;
+            }
+            file.indexOffset += countSize;
+            file.faceStride = otherSize + countSize + 3 * indexSize;
+        } else {
+            pos = loadPly_skipElement(element, pos, end, file.swap);
+            valid = pos != NULL;
+        }
+    }
+
+    if (!valid || !hasVertices || faceElement == NULL || file.vertexCount <= 0 || faceCount <= 0) {
+        printf("%s: No vertices or faces in ply File or data does not match header!\n", fileName);
+        utils_unmapFile((void *) data, size);
+        return GL_FALSE;
+    }
+
+    //Vertizes und Dreiecke direkt aus den Binaerdaten in die Arrays des Meshes umwandeln
+    file.vertices = (vec3 *) malloc(file.vertexCount * sizeof(vec3));
+    file.indices = (faces *) malloc(faceCount * sizeof(faces));
+    if (file.vertices == NULL || file.indices == NULL) {
+        printf("Error allocating ply data!\n");
+        exit(1);
+    }
+    multiThreading_runJobs((file.vertexCount + LOAD_PLY_JOB_SIZE - 1) / LOAD_PLY_JOB_SIZE,
+                           multiThreading_cpuCount(), loadPly_convertVertices, &file);
+    if (onlyTriangles) {
+        multiThreading_runJobs((file.faceCount + LOAD_PLY_JOB_SIZE - 1) / LOAD_PLY_JOB_SIZE,
+                               multiThreading_cpuCount(), loadPly_convertTriangles, &file);
+    } else {
+        //Unterschiedlich grosse Flaechen der Reihe nach als Faecher um den ersten Vertex zerlegen
+        const loadPlyProperty *list = &faceElement->properties[listIndex];
+        GLint countSize = loadPly_typeSize(list->countType);
+        GLint indexSize = loadPly_typeSize(list->type);
+        GLint face = 0;
+        pos = file.faceData;
+        for (int i = 0; i < file.faceCount; ++i) {
+            GLint entries = (GLint) loadPly_readValue(pos + file.indexOffset - countSize, list->countType, file.swap);
+            const unsigned char *index = pos + file.indexOffset;
+            GLint first = 0;
+            GLint previous = 0;
+            for (int j = 0; j < entries; ++j) {
+                GLint value = loadPly_readIndex(index + j * indexSize, list->type, file.swap, file.vertexCount);
+                if (value < 0) {
+                    file.invalidIndex = 1;
+                    value = 0;
+                }
+                if (j == 0) {
+                    first = value;
+                } else if (j >= 2) {
+                    file.indices[face].index1 = first;
+                    file.indices[face].index2 = previous;
+                    file.indices[face].index3 = value;
+                    face++;
+                }
+                previous = value;
+            }
+            pos += file.faceStride + (size_t) (entries - 3) * indexSize;
+        }
+    }
+    utils_unmapFile((void *) data, size);
+    *vertices = file.vertices;
+    *indices = file.indices;
+
+    if (file.invalidIndex) {
+        printf("%s: Face references a vertex outside of ply File!\n", fileName);
+        return GL_FALSE;
+    }
+    result->vertexCount = file.vertexCount;
+    result->faceCount = faceCount;
+    return GL_TRUE;
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+object loadPly_readFile(const char *fileName, GLboolean compressedOnly) {
+    return loadObj_readCached(fileName, loadPly_parseFile, compressedOnly);
+}
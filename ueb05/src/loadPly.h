@@ -0,0 +1,16 @@
+#ifndef RAYTRACER_LOADPLY_H
+#define RAYTRACER_LOADPLY_H
+#include "types.h"
+
+/**
+ * Laedt eine binaere .ply Datei (little oder big endian) und erstellt ein Mesh im Objektraum.
+ * Gelesen werden die Koordinaten x, y, z des Elements "vertex" und die Liste "vertex_indices"
+ * (oder "vertex_index") des Elements "face", alle anderen Elemente und Properties werden uebersprungen.
+ * Flaechen mit mehr als drei Vertizes werden als Faecher in Dreiecke zerlegt.
+ * @param fileName Dateiname der ply Datei im Modellordner
+ * @param compressedOnly GL_TRUE, wenn nur die komprimierte BVH aufgebaut werden soll (siehe bvh_buildObject)
+ * @return geladenes Mesh, default Object, wenn was schief gegangen ist
+ */
+object loadPly_readFile(const char *fileName, GLboolean compressedOnly);
+
+#endif //RAYTRACER_LOADPLY_H
@@ -17,6 +17,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <float.h>
 #include <GL/glut.h>
 #include <pthread.h>
@@ -24,36 +25,351 @@
 /* ---- Eigene Header einbinden ---- */
 #include "logic.h"
 #include "sceneObjects.h"
+#include "resources.h"
 #include "multiThreading.h"
 #include "io.h"
 #include "trumboreMoeller.h"
+#include "bvh.h"
+#include "bvhPacket.h"
+#include "bvhTopLevel.h"
+#include "accelerator.h"
+#include "distributed.h"
+#include "progress.h"
+
+/**---------------------------------------------- LOCAL TYPES ---------------------------------------------------*/
+
+/** Kontext der Render-Jobs eines Durchgangs im Pool */
+typedef struct logicRenderJob {
+    const renderFrame *frame;
+    multiThreadRunner *tiles;
+    /** Pixelabstand des Durchgangs */
+    GLint step;
+    /** Erster Durchgang des Frames, sonst werden die Pixel frueherer Durchgaenge uebersprungen */
+    GLboolean first;
+    /** Fertige Tiles an den Fortschritt melden (nicht fuer Baender, die als Ganzes gemeldet werden) */
+    GLboolean reportTiles;
+    /** Im Wavefront-Modus erstes Tile jedes Stapels, ein Eintrag mehr als Stapel (sonst NULL) */
+    GLint *groups;
+} logicRenderJob;
+
+/**
+ * Queues eines Threads im Wavefront-Modus. Die Strahlen einer Stufe liegen als Structure of Arrays vor,
+ * jeder Strahl traegt mit seinem Gewicht zur Farbe eines Primaerstrahls (pixel) bei.
+ */
+typedef struct wavefrontQueues {
+    /** Strahlen der aktuellen Stufe */
+    Ray *rays;
+    GLint *pixels;
+    GLfloat *weights;
+    GLint count;
+    /** Sekundaerstrahlen fuer die naechste Stufe */
+    Ray *nextRays;
+    GLint *nextPixels;
+    GLfloat *nextWeights;
+    GLint nextCount;
+    /** Schnittpunkte und Verdeckung je Punktlicht der aktuellen Strahlen */
+    Hit *hits;
+    GLboolean *shadowed;
+    /** Platz fuer Strahlen in allen obigen Arrays */
+    GLint capacity;
+    /** Aufsummierte Farbe und Pixelposition je Primaerstrahl */
+    Color *colors;
+    GLint *originX;
+    GLint *originY;
+    GLint pixelCapacity;
+    /** Erster Primaerstrahl jedes Pakets, ein Eintrag mehr als Pakete */
+    GLint *packetStarts;
+    GLint packetCount;
+    GLint packetCapacity;
+} wavefrontQueues;
 
 /**---------------------------------------------- GLOBAL VARIABLES ----------------------------------------------*/
 
 /** Szene die dargestellt wird */
 static scene g_scene;
 
+/** Wavefront-Queues je Thread des Render-Pools, bleiben ueber alle Tiles und Frames erhalten */
+static wavefrontQueues *g_wavefrontQueues;
+static GLint g_wavefrontQueueCount;
+
 /**----------------------------------------- LOCAL FUNCTION DECLARATION -----------------------------------------*/
 /**
- * Rendert die Szene mit multiplen Threads
- * @param args Argument Struct, mit allen Infos ueber den bereich den der Thread rendern soll
- * @return NULL, keine Rueckgabe, da direkt in g_data geschrieben wird
+ * Erstellt den unveraenderlichen Zustand fuer den naechsten Frame aus der Szene
+ * @param frame Ausgabe, Zustand des Frames
+ */
+static void logic_snapshotFrame(renderFrame *frame);
+
+/**
+ * Prueft, ob der laufende Frame abgebrochen werden soll
+ * @return GL_TRUE, wenn eine neue Eingabe den Frame abgebrochen hat
+ */
+static GLboolean logic_frameCancelled(void);
+
+/**
+ * Laedt die Szene mit den Standardeinstellungen, startet den Render-Pool und reserviert die Framebuffer
+ */
+static void logic_initScene(void);
+
+/**
+ * Uebernimmt die Einstellungen eines Frames, die ein Render-Prozess zum Nachbauen der Szene braucht
+ * @param frame Frame des Koordinators
+ * @param settings Ausgabe, Einstellungen fuer die Render-Prozesse
+ */
+static void logic_frameSettings(const renderFrame *frame, distributedSettings *settings);
+
+/**
+ * Gleicht die Szene eines Render-Prozesses an die Einstellungen des Koordinators an.
+ * Nur geaenderte Einstellungen werden uebernommen, ein Wechsel der Ansicht laedt die Modelle neu.
+ * @param settings Einstellungen des Koordinators
+ */
+static void logic_applySettings(const distributedSettings *settings);
+
+/**
+ * Rendert die Zeilen [row, row + height) eines Frames ueber den Render-Pool
+ * @param frame Frame, der gerendert wird
+ * @param row erste Zeile
+ * @param height Anzahl der Zeilen
+ */
+static void logic_renderBand(const renderFrame *frame, GLint row, GLint height);
+
+/**
+ * Anzahl der Threads, die lokal rendern und ihre Arbeitszeit an den Fortschritt melden
+ * @return Threads des Render-Pools, 1 ohne Multithreading
+ */
+static GLint logic_renderThreadCount(void);
+
+/**
+ * Rendert ein Band im Koordinator, wenn kein Render-Prozess mehr erreichbar ist
+ * @param row erste Zeile
+ * @param height Anzahl der Zeilen
+ * @param ctx Frame, der gerendert wird
+ */
+static void logic_renderLocalBand(GLint row, GLint height, void *ctx);
+
+/**
+ * Rendert in einem Render-Prozess ein Band mit den Einstellungen des Koordinators
+ * @param settings Einstellungen des Koordinators
+ * @param row erste Zeile
+ * @param height Anzahl der Zeilen
+ * @param fb Ziel der Pixelfarben
+ * @param ctx unbenutzt
+ */
+static void logic_serveBand(const distributedSettings *settings, GLint row, GLint height, Color *fb, void *ctx);
+
+/**
+ * Rendert einen Frame in dessen Framebuffer, wird im Render-Thread aufgerufen.
+ * Progressive Frames werden grob nach fein gerendert und nach jedem Durchgang angezeigt.
+ * @param frame Zustand des Frames
+ * @return GL_FALSE, wenn der Frame abgebrochen wurde
+ */
+static GLboolean logic_render(const renderFrame *frame);
+
+/**
+ * Verfolgt einen Durchgang des Frames, jeder step-te Pixel in x- und y-Richtung
+ * @param frame Zustand des Frames
+ * @param step Pixelabstand des Durchgangs
+ * @param first erster Durchgang, sonst werden die Pixel des vorherigen (doppelten) Abstands wiederverwendet
+ */
+static void logic_renderPass(const renderFrame *frame, GLint step, GLboolean first);
+
+/**
+ * Zeigt das Zwischenergebnis eines Durchgangs an, indem der Backbuffer in den Frontbuffer kopiert wird
+ * @param frame Frame, dessen Framebuffer angezeigt werden soll
+ */
+static void logic_publishPass(const renderFrame *frame);
+
+/**
+ * Arbeitsschleife des Render-Threads: wartet auf angeforderte Frames, rendert sie in den
+ * Backbuffer und tauscht diesen nach Abschluss mit dem angezeigten Framebuffer
+ * @param args unbenutzt
+ * @return NULL
+ */
+static void *logic_renderWorker(void *args);
+
+/**
+ * Startet den Render-Thread, falls er noch nicht laeuft
+ */
+static void logic_startRenderThread(void);
+
+/**
+ * Bricht den laufenden Frame ab und wartet, bis der Render-Thread die Szene nicht mehr liest.
+ * Muss vor jeder Aenderung an der Szene aufgerufen werden, kehrt nach hoechstens einer Paketzeile pro Thread zurueck.
+ */
+static void logic_stopFrame(void);
+
+/**
+ * Wartet, bis alle angeforderten Frames gerendert wurden
+ */
+static void logic_waitForFrame(void);
+
+/**
+ * Rendert Tiles ueber den Render-Pool. Im Wavefront-Modus werden aufeinanderfolgende Tiles zu Stapeln
+ * von etwa WAVEFRONT_BATCH_RAYS Primaerstrahlen zusammengefasst, die ein Thread gemeinsam verfolgt.
+ * @param job Kontext der Jobs, groups wird hier gesetzt
+ * @param tileCount Anzahl der Tiles
+ */
+static void logic_runTiles(logicRenderJob *job, GLint tileCount);
+
+/**
+ * Fasst aufeinanderfolgende Tiles zu Stapeln von etwa WAVEFRONT_BATCH_RAYS Primaerstrahlen zusammen.
+ * Bei wenigen Strahlen (grobe Durchgaenge) werden die Stapel kleiner, damit jeder Thread mehrere bekommt.
+ * @param tiles Tiles
+ * @param tileCount Anzahl der Tiles
+ * @param step Pixelabstand des Durchgangs
+ * @param groups Ausgabe, erstes Tile jedes Stapels und tileCount als letzter Eintrag (tileCount + 1 Eintraege)
+ * @return Anzahl der Stapel
+ */
+static GLint logic_groupWavefrontTiles(const multiThreadRunner *tiles, GLint tileCount, GLint step, GLint *groups);
+
+/**
+ * Rendert einen Stapel von Tiles im Wavefront-Modus mit den Queues des Threads,
+ * wird von den Threads des Render-Pools aufgerufen
+ * @param idx Index des Stapels
+ * @param thread Index des Pool-Threads
+ * @param ctx logicRenderJob mit dem Frame, allen Tiles und den Stapeln
  */
-void *logic_renderImageMultiThreaded(void *args);
+static void logic_renderWavefrontTiles(GLint idx, GLint thread, void *ctx);
+
+/**
+ * Rendert ein Tile der Szene, wird von den Threads des Render-Pools aufgerufen
+ * @param idx Index des Tiles
+ * @param thread Index des Pool-Threads
+ * @param ctx logicRenderJob mit dem Frame und allen Tiles
+ */
+static void logic_renderTile(GLint idx, GLint thread, void *ctx);
 
 /**
  * Rendert die Szene und speichert die Farbe jedes Pixels
- * im g_data Array
+ * im Framebuffer des Frames
+ * @param frame Frame, der gerendert wird
+ * @param step Pixelabstand des Durchgangs
+ * @param first erster Durchgang des Frames
+ */
+static void logic_renderImage(const renderFrame *frame, GLint step, GLboolean first);
+
+/**
+ * Rendert einen rechteckigen Bereich des Bildes in Paketen der eingestellten Groesse
+ * @param frame Frame, der gerendert wird
+ * @param thread Index des Threads im Render-Pool (0 ohne Pool), unter dem die Arbeitszeit gemeldet wird
+ * @param col Start Pixel der Spalte (Vielfaches von step)
+ * @param row Start Pixel der Reihe (Vielfaches von step)
+ * @param width Breite des Bereichs
+ * @param height Hoehe des Bereichs
+ * @param step Pixelabstand des Durchgangs
+ * @param first erster Durchgang des Frames
+ */
+static void logic_renderArea(const renderFrame *frame, GLint thread, GLint col, GLint row, GLint width,
+                             GLint height, GLint step, GLboolean first);
+
+/**
+ * Verfolgt die Primaerstrahlen eines Pixelpakets gemeinsam und schreibt die Farben in den Framebuffer.
+ * Das Paket besteht aus jedem step-ten Pixel des Bereichs, jede Farbe fuellt ihren step x step Block.
+ * @param ctx Zustand des Threads
+ * @param col Start Pixel der Spalte
+ * @param row Start Pixel der Reihe
+ * @param width Breite des Bereichs
+ * @param height Hoehe des Bereichs
+ * @param step Pixelabstand des Durchgangs
+ * @param first erster Durchgang, sonst werden die Pixel des doppelten Abstands uebersprungen
+ */
+static void logic_tracePacket(traceContext *ctx, GLint col, GLint row, GLint width, GLint height, GLint step,
+                              GLboolean first);
+
+/**
+ * Rendert einen rechteckigen Bereich des Bildes im Wavefront-Modus ohne Render-Pool. Die Paketzeilen werden
+ * zu Stapeln von etwa WAVEFRONT_BATCH_RAYS Primaerstrahlen zusammengefasst, jeder Stapel durchlaeuft die
+ * Stufen gemeinsam. Parameter wie logic_renderArea.
+ */
+static void logic_renderAreaWavefront(const renderFrame *frame, GLint thread, GLint col, GLint row, GLint width,
+                                      GLint height, GLint step, GLboolean first);
+
+/**
+ * Erzeugt die Primaerstrahlen eines Bereichs paketweise und haengt sie an die Queue an,
+ * die Pakete bleiben fuer den gemeinsamen Schnitt erhalten
+ * @param frame Frame, der gerendert wird
+ * @param queues Queues des Threads, werden bei Bedarf vergroessert
+ * @param col Start Pixel der Spalte
+ * @param row Start Pixel der Reihe
+ * @param width Breite des Bereichs
+ * @param height Hoehe des Bereichs
+ * @param step Pixelabstand des Durchgangs
+ * @param first erster Durchgang, sonst werden die Pixel des doppelten Abstands uebersprungen
+ */
+static void logic_queueWavefront(const renderFrame *frame, wavefrontQueues *queues, GLint col, GLint row,
+                                 GLint width, GLint height, GLint step, GLboolean first);
+
+/**
+ * Verfolgt alle gesammelten Primaerstrahlen stufenweise statt rekursiv: alle Strahlen einer Tiefe werden
+ * geschnitten, dann alle Schattenstrahlen verfolgt, dann alle Treffer schattiert. Die Beitraege werden
+ * gewichtet je Primaerstrahl aufsummiert, Transmissions- und Reflektionsstrahlen bilden die Queue der
+ * naechsten Tiefe. Ergibt dieselben Farben wie logic_trace (bis auf die Reihenfolge der Summation).
+ * Danach ist die Queue wieder leer.
+ * @param ctx Zustand des Threads
+ * @param queues Queues des Threads mit den Primaerstrahlen aus logic_queueWavefront
+ * @param step Pixelabstand des Durchgangs
+ */
+static void logic_traceWavefront(traceContext *ctx, wavefrontQueues *queues, GLint step);
+
+/**
+ * Haengt einen Sekundaerstrahl an die Queue der naechsten Tiefe. Wird die maximale Rekursionstiefe
+ * ueberschritten, traegt der Strahl wie in logic_trace die Hintergrundfarbe bei.
+ * @param ctx Zustand des Threads mit der Tiefe des erzeugenden Strahls
+ * @param queues Queues des Threads, die naechste Queue muss Platz haben
+ * @param ray Sekundaerstrahl
+ * @param pixel Index des Primaerstrahls
+ * @param weight Gewicht des Beitrags
+ */
+static void logic_emitWavefrontRay(const traceContext *ctx, wavefrontQueues *queues, Ray ray, GLint pixel,
+                                   GLfloat weight);
+
+/**
+ * Vergroessert die Queues, sodass die angegebene Anzahl an Strahlen, Primaerstrahlen und Paketen Platz hat.
+ * Vorhandene Eintraege bleiben erhalten.
+ * @param queues Queues
+ * @param rayCount benoetigter Platz fuer Strahlen einer Stufe
+ * @param pixelCount benoetigter Platz fuer Primaerstrahlen
+ * @param packetCount benoetigter Platz fuer Pakete
+ */
+static void logic_reserveWavefront(wavefrontQueues *queues, GLint rayCount, GLint pixelCount, GLint packetCount);
+
+/**
+ * Gibt die Queues eines Threads frei
+ * @param queues Queues
+ */
+static void logic_freeWavefront(wavefrontQueues *queues);
+
+/**
+ * Legt leere Wavefront-Queues fuer jeden Thread des Render-Pools an (vorherige werden freigegeben)
+ */
+static void logic_initWavefrontQueues(void);
+
+/**
+ * Gibt die Wavefront-Queues aller Threads frei
  */
-static void logic_renderImage(void);
+static void logic_freeWavefrontQueues(void);
+
+/**
+ * Reserviert die Queues eines Threads fuer einen vollen Stapel und beschreibt sie einmal, damit
+ * die Seiten im lokalen Speicher des Threads liegen, Job von multiThreading_poolRunOnEach
+ * @param idx Index des Threads
+ * @param thread Index des Threads
+ * @param ctx nicht verwendet
+ */
+static void logic_touchWavefrontQueues(GLint idx, GLint thread, void *ctx);
+
+/**
+ * Legt die Wavefront-Queues neu an und laesst jeden Render-Thread seine eigenen zuerst beschreiben
+ */
+static void logic_prepareWavefrontQueues(void);
 
 /**
  * Erstellt einen normalisierten Strahl, abhaengig von einem Punkt auf der Projektionsebene
+ * @param frame Frame mit der Projektionsebene
  * @param GLint vertikaler Index
  * @param GLint horizontaler Index
  * @return Primaerstrahl von der Kamera durch das angegebene Pixel
  */
-static Ray logic_createPrimaryRay(GLint i, GLint j);
+static Ray logic_createPrimaryRay(const renderFrame *frame, GLint i, GLint j);
 
 /**
  * Erstellt einen Transmissions-Strahl, der die Richtung des original Strahls beibehaelt
@@ -74,16 +390,26 @@ static Ray logic_createReflectionRay(Ray originRay, Hit hitPoint);
 
 /**
  * Verfolgt einen Strahl und liefert die Frabe des Pixels
+ * @param ctx Zustand des Threads, ctx->depth ist die Tiefe des Strahls
  * @param Ray - Primaerstrahl
  *            - rekursiver Reflektionsstrahl
  *            - rekursiver Refraktionsstrahl
- * @param Ray depth aktuelle Tiefe der Rekursion
  * @return resultierende Farbe
  */
-static Color logic_trace(Ray *, GLint);
+static Color logic_trace(traceContext *ctx, Ray *);
+
+/**
+ * Berechnet die Farbe eines bereits bestimmten Schnittpunktes inklusive der rekursiven Strahlen
+ * @param ctx Zustand des Threads, ctx->depth ist die Tiefe des Strahls
+ * @param ray Strahl, der den Punkt getroffen hat
+ * @param hitPoint getroffener Punkt (Default Hit, wenn nichts getroffen wurde)
+ * @return resultierende Farbe
+ */
+static Color logic_shade(traceContext *ctx, Ray *ray, Hit hitPoint);
 
 /**
  * Prueft, ob der Ray ein Objekt in der Szene trifft
+ * @param ctx Zustand des Threads
  * @param Ray Strahl er ein Objekt treffen soll
  * @return wenn kein Objekt getroffen wurde (Default Werte)
  *         wenn ein Objekt getroffen wurde (Infos ueber nahesten Punkt) ->
@@ -92,31 +418,75 @@ static Color logic_trace(Ray *, GLint);
  *          Position des getroffenen Punktes,
  *          Normal des getroffenen Punktes)
  */
-static Hit logic_hit(Ray);
+static Hit logic_hit(const traceContext *ctx, Ray);
+
+/**
+ * Prueft fuer ein Paket von Primaerstrahlen, welche Objekte in der Szene getroffen werden.
+ * Die Dreiecksobjekte werden fuer koharente Pakete gemeinsam traversiert,
+ * sonst wird jeder Strahl einzeln ueber logic_hit verfolgt.
+ * @param ctx Zustand des Threads
+ * @param rays Strahlen des Pakets
+ * @param rayCount Anzahl der Strahlen
+ * @param hits Ausgabe, Ergebnis wie bei logic_hit je Strahl
+ */
+static void logic_hitPacket(const traceContext *ctx, Ray *rays, GLint rayCount, Hit *hits);
+
+/**
+ * Bestimmt die Modelle, die ein Strahl in der BVH der Instanzen ueberspringt:
+ * Primaerstrahlen die Wand, von der aus geschaut wird, rekursive Strahlen sehen alle Waende
+ * @param ctx Zustand des Threads mit der Tiefe des Strahls
+ * @return Bitmaske fuer accelerator_intersectClosest
+ */
+static GLuint logic_skipMask(const traceContext *ctx);
 
 /**
- * Berechnet die Farbe (Phong) an dem getroffenen Punkt und schaut, ob dieser im Schatten liegt
+ * Prueft den Schnitt mit der Kugel und ersetzt das bisherige Ergebnis, wenn die Kugel dichter ist
+ * @param frame Frame mit der Kugel
+ * @param ray Strahl
+ * @param result bisher naehester Treffer
+ */
+static void logic_hitSphere(const renderFrame *frame, Ray ray, Hit *result);
+
+/**
+ * Prueft den Schnitt mit der angezeigten Bounding Box des Hasen. Aussortiert wird ueber die
+ * Bounding Volumes aller Objekte in der BVH der Instanzen, die Box dient hier nur der Anzeige.
+ * @param frame Frame mit den Instanzen
+ * @param ray Strahl
+ * @param result bisher naehester Treffer, wird ersetzt wenn die Box angezeigt wird und dichter ist
+ */
+static void logic_hitBoundingBox(const renderFrame *frame, Ray ray, Hit *result);
+
+/**
+ * Verfolgt die Schattenstrahlen eines getroffenen Punktes zu allen aktiven Punktlichtern
+ * @param ctx Zustand des Threads mit dem Frame, zaehlt die Schattenstrahlen
+ * @param hitPoint getroffener Punkt
+ * @param shadowed Ausgabe, je Punktlicht ob der Punkt im Schatten liegt (AMOUNT_LIGHTS Eintraege)
+ */
+static void logic_traceShadows(traceContext *ctx, Hit hitPoint, GLboolean *shadowed);
+
+/**
+ * Berechnet die Farbe (Phong) an dem getroffenen Punkt
+ * @param frame Frame mit den Punktlichtern
  * @param Ray Strahl, der auf das Objekt getroffen ist
  * @param Hit getroffener Punkt
+ * @param shadowed je Punktlicht, ob der Punkt im Schatten liegt (logic_traceShadows)
  * @return Farbe an dem getroffenen Punkt
  */
-static Color logic_calcPhong(Ray, Hit);
+static Color logic_calcPhong(const renderFrame *frame, Ray, Hit, const GLboolean *shadowed);
 
 /**
  * Prueft ob der uebergeben HitPoint im Schatten, des Punktlichtes an index i liegt
+ * @param frame Frame mit den Punktlichtern und der Beschleunigungsstruktur
  * @param Hit Getroffener Punkt in der Szene
  * @param GLint index des Punktlichtes
  * @return im Schatten oder nicht
  */
-static GLboolean logic_shadowTrace(Hit, GLint);
-
-/**
- * Reserviert den Speicher, der fuer die Szene benoetigt wird
- */
-static void logic_initObjectData(void);
+static GLboolean logic_shadowTrace(const renderFrame *frame, Hit, GLint);
 
 /**
- * Reserviert den Speicher fuer den Framebuffer abhaengig von der Aufloesung
+ * Reserviert den Speicher fuer Front- und Backbuffer abhaengig von der Aufloesung.
+ * Das Multithreading muss bereits aufgesetzt sein, die Render-Threads beschreiben die Buffer zuerst.
+ * Bestehende Buffer werden ersetzt, das angezeigte Bild bleibt dabei erhalten.
  */
 static void logic_initFramebuffer(void);
 
@@ -132,6 +502,15 @@ static void logic_initFramebuffer(void);
  */
 static Hit logic_raySphereIntersection(Ray, sphere);
 
+/**
+ * Verdeckungstest eines Schattenstrahls mit der Kugel, ohne Hit und Trefferposition
+ * @param ray Schattenstrahl
+ * @param sp Kugel
+ * @param maxDist Abstand zur Lichtquelle
+ * @return GL_TRUE, wenn die Kugel mit EPSILON < Distanz < maxDist getroffen wird
+ */
+static GLboolean logic_raySphereOccludes(const Ray *ray, const sphere *sp, GLfloat maxDist);
+
 /**
  * Adds a weighted color to another color
  * @param oldColor old Color, combined with the new Color
@@ -152,48 +531,472 @@ static Hit logic_copyHitPoint(GLfloat dist, objectModels idxObject, vec3 positio
 
 /**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION ---------------------------------------*/
 
-void *logic_renderImageMultiThreaded(void *args) {
-    multiThreadRunner *runner = (multiThreadRunner *) args;
-    //Ueber alle Pixel iterieren
-    for (int j = runner->tileRow; j < runner->tileRow + runner->tileHeight; ++j) {
-        for (int i = runner->tileCol; i < runner->tileCol + runner->tileWidth; ++i) {
-            Ray ray = logic_createPrimaryRay(i, j);
-            g_scene.fb[OFFSET2D(DEFAULT_WINDOW_HEIGHT, i, j)] = logic_trace(&ray, 1);
+static void logic_snapshotFrame(renderFrame *frame) {
+    frame->fb = g_scene.fb;
+    frame->topLevel = &g_scene.topLevel;
+    frame->accel = &g_scene.accel;
+    frame->sphere = g_scene.sphere;
+    frame->projPlane = g_scene.projPlane;
+    for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
+        frame->pointLights[i] = g_scene.pointLights[i];
+    }
+    frame->showBB = g_scene.showBB;
+    frame->bvhOpts = g_scene.bvhOpts;
+    frame->packetSize = g_scene.packetSize;
+    frame->progressive = g_scene.progressive;
+    frame->wavefront = g_scene.wavefront;
+    //Die Wandseite von der wir aus schauen, soll im nicht rekursiven Durchgang nicht gerendert werden
+    frame->primarySkipMask = g_scene.projPlane.viewMode != ALL ? BVH_TOP_LEVEL_SKIP(g_scene.projPlane.viewMode) : 0;
+    frame->progress = &g_scene.progress;
+}
+
+static void logic_runTiles(logicRenderJob *job, GLint tileCount) {
+    multiThreadPool *pool = &g_scene.multiThreadOpts.pool;
+    if (!job->frame->wavefront) {
+        job->groups = NULL;
+        multiThreading_poolRun(pool, tileCount, logic_renderTile, job);
+        return;
+    }
+
+    job->groups = (GLint *) malloc((tileCount + 1) * sizeof(GLint));
+    if (job->groups == NULL) {
+        printf("Error allocating wavefront batches!\n");
+        exit(1);
+    }
+    GLint groupCount = logic_groupWavefrontTiles(job->tiles, tileCount, job->step, job->groups);
+    multiThreading_poolRun(pool, groupCount, logic_renderWavefrontTiles, job);
+    free(job->groups);
+    job->groups = NULL;
+}
+
+static GLint logic_groupWavefrontTiles(const multiThreadRunner *tiles, GLint tileCount, GLint step, GLint *groups) {
+    GLint totalRays = 0;
+    for (int t = 0; t < tileCount; ++t) {
+        totalRays += ((tiles[t].tileWidth + step - 1) / step) * ((tiles[t].tileHeight + step - 1) / step);
+    }
+    //Jeder Thread soll mindestens zwei Stapel bekommen, damit noch gestohlen werden kann
+    GLint batchRays = totalRays / (2 * g_wavefrontQueueCount);
+    batchRays = batchRays < WAVEFRONT_BATCH_RAYS ? batchRays : WAVEFRONT_BATCH_RAYS;
+
+    GLint groupCount = 0;
+    GLint rays = 0;
+    for (int t = 0; t < tileCount; ++t) {
+        if (rays == 0) {
+            groups[groupCount++] = t;
+        }
+        rays += ((tiles[t].tileWidth + step - 1) / step) * ((tiles[t].tileHeight + step - 1) / step);
+        if (rays >= batchRays) {
+            rays = 0;
         }
     }
-    return NULL;
+    groups[groupCount] = tileCount;
+    return groupCount;
+}
+
+static void logic_renderWavefrontTiles(GLint idx, GLint thread, void *ctx) {
+    logicRenderJob *job = (logicRenderJob *) ctx;
+    const renderFrame *frame = job->frame;
+    GLint firstTile = job->groups[idx];
+    GLint lastTile = job->groups[idx + 1];
+    //Abgebrochene Frames nicht weiter verfolgen, die Tiles bleiben ungueltig
+    if (logic_frameCancelled()) {
+        return;
+    }
+
+    //Alle Tiles des Stapels in die Queues des Threads, dann gemeinsam durch die Stufen
+    traceContext trace = {frame, 1, 0, thread};
+    wavefrontQueues *queues = &g_wavefrontQueues[thread];
+    double start = multiThreading_seconds();
+    GLint area = 0;
+    for (int t = firstTile; t < lastTile; ++t) {
+        const multiThreadRunner *tile = &job->tiles[t];
+        logic_queueWavefront(frame, queues, tile->tileCol, tile->tileRow, tile->tileWidth, tile->tileHeight,
+                             job->step, job->first);
+        area += tile->tileWidth * tile->tileHeight;
+    }
+    logic_traceWavefront(&trace, queues, job->step);
+    double seconds = multiThreading_seconds() - start;
+    progress_addRays(frame->progress, trace.rays);
+    progress_addBusy(frame->progress, thread, seconds);
+
+    //Renderzeit des Stapels nach der Flaeche auf die Tiles verteilen, fuer die Aufteilung des naechsten Frames
+    for (int t = firstTile; t < lastTile; ++t) {
+        multiThreadRunner *tile = &job->tiles[t];
+        tile->cost = (GLfloat) (seconds * tile->tileWidth * tile->tileHeight / area);
+        if (job->reportTiles) {
+            progress_finishTile(frame->progress, tile->tileCol, tile->tileRow, tile->tileWidth, tile->tileHeight);
+        }
+    }
+}
+
+static void logic_renderTile(GLint idx, GLint thread, void *ctx) {
+    logicRenderJob *job = (logicRenderJob *) ctx;
+    multiThreadRunner *runner = &job->tiles[idx];
+    double start = multiThreading_seconds();
+    logic_renderArea(job->frame, thread, runner->tileCol, runner->tileRow, runner->tileWidth, runner->tileHeight, job->step,
+                     job->first);
+    //Renderzeit fuer die Aufteilung des naechsten Frames merken
+    runner->cost = (GLfloat) (multiThreading_seconds() - start);
+    if (job->reportTiles) {
+        progress_finishTile(job->frame->progress, runner->tileCol, runner->tileRow, runner->tileWidth,
+                            runner->tileHeight);
+    }
+}
+
+static void logic_renderImage(const renderFrame *frame, GLint step, GLboolean first) {
+    logic_renderArea(frame, 0, 0, 0, xRes, yRes, step, first);
+}
+
+static void logic_renderArea(const renderFrame *frame, GLint thread, GLint col, GLint row, GLint width,
+                             GLint height, GLint step, GLboolean first) {
+    if (frame->wavefront) {
+        logic_renderAreaWavefront(frame, thread, col, row, width, height, step, first);
+        return;
+    }
+
+    //Eigener Zustand fuer diesen Aufruf, damit mehrere Threads (und Frames) unabhaengig verfolgen koennen
+    traceContext ctx = {frame, 1, 0, thread};
+    double rowStart = multiThreading_seconds();
+    //Ein Paket ueberdeckt packetSize x packetSize Strahlen im Abstand step
+    GLint size = frame->packetSize * step;
+    //Ueber alle Pakete iterieren, am Rand werden die Pakete kleiner
+    for (int j = row; j < row + height; j += size) {
+        //Abgebrochene Frames nicht weiter verfolgen, der Rest des Bereichs bleibt ungueltig
+        if (logic_frameCancelled()) {
+            return;
+        }
+        GLint packetHeight = (row + height - j < size) ? row + height - j : size;
+        for (int i = col; i < col + width; i += size) {
+            GLint packetWidth = (col + width - i < size) ? col + width - i : size;
+            logic_tracePacket(&ctx, i, j, packetWidth, packetHeight, step, first);
+        }
+        //Strahlen und Arbeitszeit nur einmal pro Paketzeile melden, damit sich die Threads keine Cache-Zeile teilen
+        double rowEnd = multiThreading_seconds();
+        progress_addRays(frame->progress, ctx.rays);
+        progress_addBusy(frame->progress, thread, rowEnd - rowStart);
+        ctx.rays = 0;
+        rowStart = rowEnd;
+    }
 }
 
-static void logic_renderImage(void) {
-    //Ueber alle Pixel iterieren
-    for (int j = 0; j < yRes; ++j) {
-        for (int i = 0; i < xRes; ++i) {
-            Ray ray = logic_createPrimaryRay(i, j);
-            g_scene.fb[OFFSET2D(DEFAULT_WINDOW_HEIGHT, i, j)] = logic_trace(&ray, 1);
+static void logic_tracePacket(traceContext *ctx, GLint col, GLint row, GLint width, GLint height, GLint step,
+                              GLboolean first) {
+    Ray rays[BVH_PACKET_MAX_RAYS];
+    Hit hits[BVH_PACKET_MAX_RAYS];
+    GLint pixels[BVH_PACKET_MAX_RAYS][2];
+
+    GLint rayCount = 0;
+    for (int j = row; j < row + height; j += step) {
+        for (int i = col; i < col + width; i += step) {
+            //Pixel des vorherigen Durchgangs sind schon verfolgt
+            if (!first && i % (2 * step) == 0 && j % (2 * step) == 0) {
+                continue;
+            }
+            pixels[rayCount][0] = i;
+            pixels[rayCount][1] = j;
+            rays[rayCount++] = logic_createPrimaryRay(ctx->frame, i, j);
+        }
+    }
+
+    //Schnittpunkte des ganzen Pakets bestimmen, danach einzeln schattieren
+    logic_hitPacket(ctx, rays, rayCount, hits);
+    ctx->rays += rayCount;
+
+    for (int r = 0; r < rayCount; ++r) {
+        Color color = logic_shade(ctx, &rays[r], hits[r]);
+
+        //Den Block bis zum naechsten Pixel des Durchgangs mit der Farbe fuellen (bei step 1 nur der Pixel selbst)
+        GLint endX = pixels[r][0] + step < DEFAULT_WINDOW_WIDTH ? pixels[r][0] + step : DEFAULT_WINDOW_WIDTH;
+        GLint endY = pixels[r][1] + step < DEFAULT_WINDOW_HEIGHT ? pixels[r][1] + step : DEFAULT_WINDOW_HEIGHT;
+        for (int j = pixels[r][1]; j < endY; ++j) {
+            for (int i = pixels[r][0]; i < endX; ++i) {
+                ctx->frame->fb[OFFSET2D(DEFAULT_WINDOW_HEIGHT, i, j)] = color;
+            }
         }
     }
 }
 
+static void logic_renderAreaWavefront(const renderFrame *frame, GLint thread, GLint col, GLint row, GLint width,
+                                      GLint height, GLint step, GLboolean first) {
+    traceContext ctx = {frame, 1, 0, thread};
+    wavefrontQueues *queues = &g_wavefrontQueues[thread];
+    double batchStart = multiThreading_seconds();
+
+    //Paketzeilen sammeln, bis etwa WAVEFRONT_BATCH_RAYS Primaerstrahlen zusammenkommen
+    GLint size = frame->packetSize * step;
+    for (int j = row; j < row + height; j += size) {
+        //Abgebrochene Frames nicht weiter verfolgen, der Rest des Bereichs bleibt ungueltig
+        if (logic_frameCancelled()) {
+            queues->count = 0;
+            queues->packetCount = 0;
+            return;
+        }
+        GLint packetRows = (row + height - j < size) ? row + height - j : size;
+        logic_queueWavefront(frame, queues, col, j, width, packetRows, step, first);
+        if (queues->count < WAVEFRONT_BATCH_RAYS && j + size < row + height) {
+            continue;
+        }
+
+        logic_traceWavefront(&ctx, queues, step);
+        double batchEnd = multiThreading_seconds();
+        progress_addRays(frame->progress, ctx.rays);
+        progress_addBusy(frame->progress, thread, batchEnd - batchStart);
+        ctx.rays = 0;
+        batchStart = batchEnd;
+    }
+}
+
+static void logic_queueWavefront(const renderFrame *frame, wavefrontQueues *queues, GLint col, GLint row,
+                                 GLint width, GLint height, GLint step, GLboolean first) {
+    GLint size = frame->packetSize * step;
+    GLint columns = (width + size - 1) / size;
+    GLint rows = (height + size - 1) / size;
+    GLint maxRays = queues->count + ((width + step - 1) / step) * ((height + step - 1) / step);
+    logic_reserveWavefront(queues, maxRays, maxRays, queues->packetCount + columns * rows + 1);
+
+    for (int pj = row; pj < row + height; pj += size) {
+        GLint packetEndY = (pj + size < row + height) ? pj + size : row + height;
+        for (int pi = col; pi < col + width; pi += size) {
+            GLint packetEndX = (pi + size < col + width) ? pi + size : col + width;
+            queues->packetStarts[queues->packetCount++] = queues->count;
+            for (int j = pj; j < packetEndY; j += step) {
+                for (int i = pi; i < packetEndX; i += step) {
+                    //Pixel des vorherigen Durchgangs sind schon verfolgt
+                    if (!first && i % (2 * step) == 0 && j % (2 * step) == 0) {
+                        continue;
+                    }
+                    GLint r = queues->count++;
+                    queues->rays[r] = logic_createPrimaryRay(frame, i, j);
+                    queues->pixels[r] = r;
+                    queues->weights[r] = 1.0f;
+                    queues->colors[r] = BACKGROUND_COLOR;
+                    queues->originX[r] = i;
+                    queues->originY[r] = j;
+                }
+            }
+        }
+    }
+    queues->packetStarts[queues->packetCount] = queues->count;
+}
+
+static void logic_traceWavefront(traceContext *ctx, wavefrontQueues *queues, GLint step) {
+    const renderFrame *frame = ctx->frame;
+    GLint packetCount = queues->packetCount;
+    GLint pixelCount = queues->count;
+
+    for (ctx->depth = 1; queues->count > 0; ctx->depth++) {
+        GLint count = queues->count;
+
+        //Stufe 2: Schnittpunkte aller Strahlen der Tiefe, Primaerstrahlen gemeinsam als Pakete
+        if (ctx->depth == 1) {
+            for (int p = 0; p < packetCount; ++p) {
+                GLint start = queues->packetStarts[p];
+                logic_hitPacket(ctx, &queues->rays[start], queues->packetStarts[p + 1] - start, &queues->hits[start]);
+            }
+        } else {
+            for (int r = 0; r < count; ++r) {
+                queues->hits[r] = logic_hit(ctx, queues->rays[r]);
+            }
+        }
+        ctx->rays += count;
+
+        //Stufe 3: Schattenstrahlen aller Treffer
+        for (int r = 0; r < count; ++r) {
+            if (!queues->hits[r].defaultHit) {
+                sceneObjects_setHitObjectMaterial(&queues->hits[r]);
+                logic_traceShadows(ctx, queues->hits[r], &queues->shadowed[r * AMOUNT_LIGHTS]);
+            }
+        }
+
+        //Stufe 4: schattieren, jeder Treffer erzeugt hoechstens zwei Strahlen fuer die naechste Tiefe
+        logic_reserveWavefront(queues, 2 * count, pixelCount, packetCount + 1);
+        queues->nextCount = 0;
+        for (int r = 0; r < count; ++r) {
+            Ray *ray = &queues->rays[r];
+            Hit *hitPoint = &queues->hits[r];
+            GLint pixel = queues->pixels[r];
+            GLfloat weight = queues->weights[r];
+            if (hitPoint->defaultHit) {
+                logic_addWeightedColor(&queues->colors[pixel], BACKGROUND_COLOR, weight);
+                continue;
+            }
+
+            //Lokale Farbe wie in logic_shade, abgeschwaecht ueber die Strecke des Strahls
+            Color color = logic_calcPhong(frame, *ray, *hitPoint, &queues->shadowed[r * AMOUNT_LIGHTS]);
+            ray->distance += glm_vec3_distance(hitPoint->position, ray->start);
+            utils_attenuationFunction(*ray, &color);
+            logic_addWeightedColor(&queues->colors[pixel], color, weight);
+
+            //Rekursion abbrechen, wenn Intensitaet des Lichtes zu klein wird
+            if (utils_colorIntensity(color) > MINIMUM_INTENSITIY) {
+                if (hitPoint->material.kRefr > 0.0f) {
+                    logic_emitWavefrontRay(ctx, queues, logic_createTransmissionRay(*ray, *hitPoint), pixel,
+                                           weight * hitPoint->material.kRefr);
+                }
+                if (hitPoint->material.kRefl > 0.0f) {
+                    logic_emitWavefrontRay(ctx, queues, logic_createReflectionRay(*ray, *hitPoint), pixel,
+                                           weight * hitPoint->material.kRefl);
+                }
+            }
+        }
+
+        //Naechste Queue wird zur aktuellen
+        Ray *rays = queues->rays;
+        GLint *pixels = queues->pixels;
+        GLfloat *weights = queues->weights;
+        queues->rays = queues->nextRays;
+        queues->pixels = queues->nextPixels;
+        queues->weights = queues->nextWeights;
+        queues->nextRays = rays;
+        queues->nextPixels = pixels;
+        queues->nextWeights = weights;
+        queues->count = queues->nextCount;
+    }
+    ctx->depth = 1;
+    queues->packetCount = 0;
+
+    //Den Block bis zum naechsten Pixel des Durchgangs mit der Farbe fuellen (bei step 1 nur der Pixel selbst)
+    for (int p = 0; p < pixelCount; ++p) {
+        GLint endX = queues->originX[p] + step < DEFAULT_WINDOW_WIDTH ? queues->originX[p] + step
+                                                                      : DEFAULT_WINDOW_WIDTH;
+        GLint endY = queues->originY[p] + step < DEFAULT_WINDOW_HEIGHT ? queues->originY[p] + step
+                                                                       : DEFAULT_WINDOW_HEIGHT;
+        for (int j = queues->originY[p]; j < endY; ++j) {
+            for (int i = queues->originX[p]; i < endX; ++i) {
+                frame->fb[OFFSET2D(DEFAULT_WINDOW_HEIGHT, i, j)] = queues->colors[p];
+            }
+        }
+    }
+}
+
+static void logic_emitWavefrontRay(const traceContext *ctx, wavefrontQueues *queues, Ray ray, GLint pixel,
+                                   GLfloat weight) {
+    if (ctx->depth + 1 > RECURSION_DEPTH) {
+        //Maximal Rekursionstiefe erreicht
+        logic_addWeightedColor(&queues->colors[pixel], BACKGROUND_COLOR, weight);
+        return;
+    }
+    GLint r = queues->nextCount++;
+    queues->nextRays[r] = ray;
+    queues->nextPixels[r] = pixel;
+    queues->nextWeights[r] = weight;
+}
+
+static void logic_reserveWavefront(wavefrontQueues *queues, GLint rayCount, GLint pixelCount, GLint packetCount) {
+    if (rayCount > queues->capacity) {
+        queues->capacity = rayCount;
+        queues->rays = (Ray *) realloc(queues->rays, rayCount * sizeof(Ray));
+        queues->pixels = (GLint *) realloc(queues->pixels, rayCount * sizeof(GLint));
+        queues->weights = (GLfloat *) realloc(queues->weights, rayCount * sizeof(GLfloat));
+        queues->nextRays = (Ray *) realloc(queues->nextRays, rayCount * sizeof(Ray));
+        queues->nextPixels = (GLint *) realloc(queues->nextPixels, rayCount * sizeof(GLint));
+        queues->nextWeights = (GLfloat *) realloc(queues->nextWeights, rayCount * sizeof(GLfloat));
+        queues->hits = (Hit *) realloc(queues->hits, rayCount * sizeof(Hit));
+        queues->shadowed = (GLboolean *) realloc(queues->shadowed, rayCount * AMOUNT_LIGHTS * sizeof(GLboolean));
+    }
+    if (pixelCount > queues->pixelCapacity) {
+        queues->pixelCapacity = pixelCount;
+        queues->colors = (Color *) realloc(queues->colors, pixelCount * sizeof(Color));
+        queues->originX = (GLint *) realloc(queues->originX, pixelCount * sizeof(GLint));
+        queues->originY = (GLint *) realloc(queues->originY, pixelCount * sizeof(GLint));
+    }
+    if (packetCount > queues->packetCapacity) {
+        queues->packetCapacity = packetCount;
+        queues->packetStarts = (GLint *) realloc(queues->packetStarts, packetCount * sizeof(GLint));
+    }
+    if (queues->rays == NULL || queues->pixels == NULL || queues->weights == NULL || queues->nextRays == NULL ||
+        queues->nextPixels == NULL || queues->nextWeights == NULL || queues->hits == NULL ||
+        queues->shadowed == NULL || queues->colors == NULL || queues->originX == NULL || queues->originY == NULL ||
+        queues->packetStarts == NULL) {
+        printf("Error allocating wavefront queues!\n");
+        exit(1);
+    }
+}
+
+static void logic_freeWavefront(wavefrontQueues *queues) {
+    free(queues->rays);
+    free(queues->pixels);
+    free(queues->weights);
+    free(queues->nextRays);
+    free(queues->nextPixels);
+    free(queues->nextWeights);
+    free(queues->hits);
+    free(queues->shadowed);
+    free(queues->colors);
+    free(queues->originX);
+    free(queues->originY);
+    free(queues->packetStarts);
+    memset(queues, 0, sizeof(*queues));
+}
+
+static void logic_initWavefrontQueues(void) {
+    logic_freeWavefrontQueues();
+    //Ohne gestartete Pool-Threads rendert der aufrufende Thread unter Index 0
+    g_wavefrontQueueCount = logic_renderThreadCount() > 0 ? logic_renderThreadCount() : 1;
+    g_wavefrontQueues = (wavefrontQueues *) calloc(g_wavefrontQueueCount, sizeof(wavefrontQueues));
+    if (g_wavefrontQueues == NULL) {
+        printf("Error allocating wavefront queues!\n");
+        exit(1);
+    }
+}
+
+static void logic_freeWavefrontQueues(void) {
+    for (int i = 0; i < g_wavefrontQueueCount; ++i) {
+        logic_freeWavefront(&g_wavefrontQueues[i]);
+    }
+    free(g_wavefrontQueues);
+    g_wavefrontQueues = NULL;
+    g_wavefrontQueueCount = 0;
+}
+
+static void logic_touchWavefrontQueues(GLint idx, GLint thread, void *ctx) {
+    (void) idx;
+    (void) ctx;
+    wavefrontQueues *queues = &g_wavefrontQueues[thread];
+    //Ein Stapel plus ein angefangenes Tile, jeweils mit einer Generation Folgestrahlen
+    GLint count = 2 * (WAVEFRONT_BATCH_RAYS + MULTI_THREAD_TILE_SIZE * MULTI_THREAD_TILE_SIZE);
+    logic_reserveWavefront(queues, count, count, count);
+    memset(queues->rays, 0, count * sizeof(Ray));
+    memset(queues->pixels, 0, count * sizeof(GLint));
+    memset(queues->weights, 0, count * sizeof(GLfloat));
+    memset(queues->nextRays, 0, count * sizeof(Ray));
+    memset(queues->nextPixels, 0, count * sizeof(GLint));
+    memset(queues->nextWeights, 0, count * sizeof(GLfloat));
+    memset(queues->hits, 0, count * sizeof(Hit));
+    memset(queues->shadowed, 0, count * AMOUNT_LIGHTS * sizeof(GLboolean));
+    memset(queues->colors, 0, count * sizeof(Color));
+    memset(queues->originX, 0, count * sizeof(GLint));
+    memset(queues->originY, 0, count * sizeof(GLint));
+    memset(queues->packetStarts, 0, count * sizeof(GLint));
+}
+
+static void logic_prepareWavefrontQueues(void) {
+    logic_initWavefrontQueues();
+    if (g_scene.multiThreadOpts.useMultiThreading) {
+        multiThreading_poolRunOnEach(&g_scene.multiThreadOpts.pool, logic_touchWavefrontQueues, NULL);
+    } else {
+        logic_touchWavefrontQueues(0, 0, NULL);
+    }
+}
+
 static void logic_addWeightedColor(Color *oldColor, Color toAdd, GLfloat weight) {
     oldColor->r += toAdd.r * weight;
     oldColor->g += toAdd.g * weight;
     oldColor->b += toAdd.b * weight;
 }
 
-static Ray logic_createPrimaryRay(GLint i, GLint j) {
+static Ray logic_createPrimaryRay(const renderFrame *frame, GLint i, GLint j) {
+    const projectionPlane *plane = &frame->projPlane;
     Ray ray;
     //Projektionspunkt auf der Projektionsebene
-    ray.start[0] = g_scene.projPlane.s[0] + ((float) i + 0.5f) * g_scene.projPlane.u[0] +
-                   ((float) j + 0.5f) * g_scene.projPlane.v[0];
+    ray.start[0] = plane->s[0] + ((float) i + 0.5f) * plane->u[0] + ((float) j + 0.5f) * plane->v[0];
 
-    ray.start[1] = g_scene.projPlane.s[1] + ((float) i + 0.5f) * g_scene.projPlane.u[1] +
-                   ((float) j + 0.5f) * g_scene.projPlane.v[1];
+    ray.start[1] = plane->s[1] + ((float) i + 0.5f) * plane->u[1] + ((float) j + 0.5f) * plane->v[1];
 
-    ray.start[2] = g_scene.projPlane.s[2] + ((float) i + 0.5f) * g_scene.projPlane.u[2] +
-                   ((float) j + 0.5f) * g_scene.projPlane.v[2];
+    ray.start[2] = plane->s[2] + ((float) i + 0.5f) * plane->u[2] + ((float) j + 0.5f) * plane->v[2];
 
     //Startpunkt des Rays -> Kamera
-    glm_vec3_sub(ray.start, g_scene.projPlane.cameraPos, ray.dir);
+    glm_vec3_sub(ray.start, (float *) plane->cameraPos, ray.dir);
     ray.distance = 0.0f;
     glm_vec3_normalize(ray.dir);
     return ray;
@@ -220,20 +1023,21 @@ static Ray logic_createReflectionRay(Ray originRay, Hit hitPoint) {
     return reflectionRay;
 }
 
-static Color logic_trace(Ray *ray, GLint depth) {
-    if (depth > RECURSION_DEPTH) {
+static Color logic_trace(traceContext *ctx, Ray *ray) {
+    if (ctx->depth > RECURSION_DEPTH) {
         ray->distance += 0.0f;
         //Maximal Rekursionstiefe erreicht
         return BACKGROUND_COLOR;
     }
-
-    //Sobald wir in rekursive Aufrufe gehen, sollen alle Waende geraendert werden
-    if (depth > 1) {
-        g_scene.projPlane.viewMode = ALL;
-    }
+    ctx->rays++;
 
     //Index vom dichtesten Objekt und das Dreieck was gerade getroffen wurde
-    Hit hitPoint = logic_hit(*ray);
+    //(in rekursiven Aufrufen werden ueber logic_skipMask alle Waende geraendert)
+    Hit hitPoint = logic_hit(ctx, *ray);
+    return logic_shade(ctx, ray, hitPoint);
+}
+
+static Color logic_shade(traceContext *ctx, Ray *ray, Hit hitPoint) {
     if (hitPoint.defaultHit) {
         ray->distance += 0.0f;
         //Kein Objekt getroffen, Hintergrundfarbe zurueckgeben
@@ -241,10 +1045,12 @@ static Color logic_trace(Ray *ray, GLint depth) {
     }
 
     //Material, vom gesetzten Objekt treffen
-    sceneObjects_setHitObjectMaterial(g_scene, &hitPoint);
+    sceneObjects_setHitObjectMaterial(&hitPoint);
 
     //lokale Farbberechnung
-    Color color = logic_calcPhong(*ray, hitPoint);
+    GLboolean shadowed[AMOUNT_LIGHTS];
+    logic_traceShadows(ctx, hitPoint, shadowed);
+    Color color = logic_calcPhong(ctx->frame, *ray, hitPoint, shadowed);
 
     //Insgesamte zurueckgelegte Strecke des Strahls anpassen
     ray->distance += glm_vec3_distance(hitPoint.position, ray->start);
@@ -260,7 +1066,9 @@ static Color logic_trace(Ray *ray, GLint depth) {
             Ray transmitRay = logic_createTransmissionRay(*ray, hitPoint);
 
             //Rekursiver Aufruf
-            Color transmittedColor = logic_trace(&transmitRay, depth + 1);
+            ctx->depth++;
+            Color transmittedColor = logic_trace(ctx, &transmitRay);
+            ctx->depth--;
 
             //Farbe aus dem rekursiven Aufruf gewichten
             logic_addWeightedColor(&color, transmittedColor, hitPoint.material.kRefr);
@@ -275,7 +1083,9 @@ static Color logic_trace(Ray *ray, GLint depth) {
             Ray reflectRay = logic_createReflectionRay(*ray, hitPoint);
 
             //Rekursiver Aufruf
-            Color reflectedColor = logic_trace(&reflectRay, depth + 1);
+            ctx->depth++;
+            Color reflectedColor = logic_trace(ctx, &reflectRay);
+            ctx->depth--;
 
             //Farbe aus dem rekursiven Aufruf gewichten
             logic_addWeightedColor(&color, reflectedColor, hitPoint.material.kRefl);
@@ -300,88 +1110,130 @@ static Hit logic_copyHitPoint(GLfloat dist, objectModels idxObject, vec3 positio
     return result;
 }
 
-static Hit logic_hit(Ray ray) {
+static void logic_hitSphere(const renderFrame *frame, Ray ray, Hit *result) {
+    //Pruefen, ob die Kugel getroffen wird
+    //Andere Berechnung fuer die Intersection
+    Hit temp = logic_raySphereIntersection(ray, frame->sphere);
+    if (!temp.defaultHit && temp.dist < result->dist) {
+        //Normale der Kugel an dem Punkt bestimmen
+        vec3 normal;
+        glm_vec3_sub(temp.position, (float *) frame->sphere.center, normal);
+        glm_vec3_normalize(normal);
+
+        *result = logic_copyHitPoint(temp.dist, SPHERE, temp.position, normal);
+    }
+}
+
+static void logic_hitBoundingBox(const renderFrame *frame, Ray ray, Hit *result) {
+    //Ein und ausblenden der Bounding Box
+    if (!frame->showBB) {
+        return;
+    }
+
+    //Naeheste Seite der eingestellten Box
+    GLfloat bbDist = result->dist;
+    vec3 normal;
+    if (bvhTopLevel_intersectBounds(frame->topLevel, frame->bvhOpts, BUNNY, ray, &bbDist, normal) >= 0) {
+        vec3 position;
+        glm_vec3_scale(ray.dir, bbDist, position);
+        glm_vec3_add(ray.start, position, position);
+        *result = logic_copyHitPoint(bbDist, BOUNDING_BOX, position, normal);
+    }
+}
+
+static GLuint logic_skipMask(const traceContext *ctx) {
+    //Die Wandseite von der wir aus schauen, soll im nicht rekursiven Durchgang nicht gerendert werden
+    return ctx->depth > 1 ? 0 : ctx->frame->primarySkipMask;
+}
+
+static Hit logic_hit(const traceContext *ctx, Ray ray) {
+    const renderFrame *frame = ctx->frame;
     //Default Hit
     Hit result = utils_createDefaultHit();
     //Initial auf FLT_MAX fuers vergleichen setzen
     result.dist = FLT_MAX;
 
-    //Bunny muss nicht geprueft werden, wenn die Bounding Box des
-    //Bunnys nicht getroffen wurde
-    GLboolean hitBB = GL_FALSE;
-
-    //Ueber alle Objekte iterieren und SchnittPunkte berechnen
-    for (int idxObj = 0; idxObj < AMOUNT_MODELS; ++idxObj) {
-        if (idxObj == SPHERE) {
-            //Pruefen, ob die Kugel getroffen wird
-            //Andere Berechnung fuer die Intersection
-            Hit temp = logic_raySphereIntersection(ray, g_scene.sphere);
-            if (!temp.defaultHit) {
-                //Normale der Kugel an dem Punkt bestimmen
-                vec3 normal;
-                glm_vec3_sub(temp.position, g_scene.sphere.center, normal);
-                glm_vec3_normalize(normal);
-
-                result = logic_copyHitPoint(temp.dist, SPHERE, temp.position, normal);
-            }
-        } else if (idxObj == BOUNDING_BOX) {
-            if (g_scene.bbState != none) {
-                //Pruefen ob die BoundingBox getroffen wird, wenn ja Schleife abbrechen
-                for (int amountTris = 0;
-                     amountTris < g_scene.allObjects[BOUNDING_BOX].faceCount && !hitBB; ++amountTris) {
-                    //SchnittPunkt berechnen (Weber-Baldwin oder Trumbore-Moeller
-                    Hit temp = trumboreMoeller_rayTriangleIntersection(ray,
-                                                                       g_scene.allObjects[idxObj].facesTM[amountTris]);
-
-                    if (!temp.defaultHit) {
-                        //Ein und ausblenden der Bounding Box
-                        if (g_scene.showBB) {
-                            result = logic_copyHitPoint(temp.dist, BOUNDING_BOX,
-                                                        temp.position,
-                                                        g_scene.allObjects[idxObj].facesTM[amountTris].normal);
-                        }
-                        hitBB = GL_TRUE;
-                    }
-                }
-            } else {
-                //Wenn keine BoundingBox genutzt werden soll,
-                //wird so getan, als wuerde sie getroffen werden, um dein Hasen normal abzufragen
-                hitBB = GL_TRUE;
-            }
-        } else {
-            //Ueber alle Dreiecke der Objekte iterieren, ausser Kugel
-            for (int amountTris = 0; amountTris < g_scene.allObjects[idxObj].faceCount; ++amountTris) {
-                //BoundingBox nicht getroffen, wenn der Hase gerendert werden soll
-                //Hase muss garnicht erst getestet werden
-                if (!hitBB && (idxObj == BUNNY) && (g_scene.bbState != none)) {
-                    break;
-                }
+    //Angezeigte Bounding Box des Hasen
+    logic_hitBoundingBox(frame, ray, &result);
+
+    //Naehesten Schnittpunkt ueber die eingestellte Beschleunigungsstruktur suchen (in der BVH wird jede Instanz
+    //vorher ueber ihr Bounding Volume aussortiert), nur Treffer dichter als der bisher naeheste werden beachtet
+    GLfloat dist = result.dist;
+    GLint idxTri = -1;
+    GLint idxInst = accelerator_intersectClosest(frame->accel, frame->bvhOpts, logic_skipMask(ctx), ray, &dist,
+                                                 &idxTri);
+    if (idxInst >= 0) {
+        vec3 position, normal;
+        glm_vec3_scale(ray.dir, dist, position);
+        glm_vec3_add(ray.start, position, position);
+        bvhTopLevel_hitNormal(frame->topLevel, idxInst, idxTri, normal);
+        result = logic_copyHitPoint(dist, frame->topLevel->instances[idxInst].model, position, normal);
+    }
 
-                //Die Wandseite von der wir aus schauen, soll im nicht rekursiven Durchgang nicht gerendert werden
-                if (idxObj == g_scene.projPlane.viewMode) {
-                    break;
-                }
+    //Kugel ist kein Dreiecksobjekt und wird extra abgefragt
+    logic_hitSphere(frame, ray, &result);
 
-                //SchnittPunkt berechnen (Weber-Baldwin oder Trumbore-Moeller
-                Hit temp = trumboreMoeller_rayTriangleIntersection(ray, g_scene.allObjects[idxObj].facesTM[amountTris]);
+    return result;
+}
 
-                //Wenn getroffen und berechnete Distanz kleiner als bisherige Distanz
-                if (!temp.defaultHit && (temp.dist < result.dist)) {
-                    result = logic_copyHitPoint(temp.dist, idxObj, temp.position,
-                                                g_scene.allObjects[idxObj].facesTM[amountTris].normal);
-                }
-            }
+static void logic_hitPacket(const traceContext *ctx, Ray *rays, GLint rayCount, Hit *hits) {
+    const renderFrame *frame = ctx->frame;
+    //Einzelne oder divergierende Strahlen werden nicht gemeinsam traversiert,
+    //ebenso wenn die Beschleunigungsstruktur keine Pakete unterstuetzt
+    bvhRayPacket packet;
+    if (rayCount <= 1 || !accelerator_supportsPackets(frame->accel) ||
+        !bvhPacket_init(rays, rayCount, frame->bvhOpts.triLayout, &packet)) {
+        for (int r = 0; r < rayCount; ++r) {
+            hits[r] = logic_hit(ctx, rays[r]);
         }
+        return;
     }
 
-    return result;
+    GLuint skipMasks[BVH_PACKET_MAX_RAYS];
+    GLfloat dists[BVH_PACKET_MAX_RAYS];
+    GLint instances[BVH_PACKET_MAX_RAYS];
+    GLint tris[BVH_PACKET_MAX_RAYS];
+
+    //Gleiche Reihenfolge und Sonderfaelle wie in logic_hit
+    for (int r = 0; r < rayCount; ++r) {
+        hits[r] = utils_createDefaultHit();
+        hits[r].dist = FLT_MAX;
+        logic_hitBoundingBox(frame, rays[r], &hits[r]);
+        skipMasks[r] = logic_skipMask(ctx);
+        dists[r] = hits[r].dist;
+    }
+
+    accelerator_intersectPacket(frame->accel, frame->bvhOpts, &packet, skipMasks, dists, instances, tris);
+
+    for (int r = 0; r < rayCount; ++r) {
+        if (instances[r] >= 0) {
+            vec3 position, normal;
+            glm_vec3_scale(rays[r].dir, dists[r], position);
+            glm_vec3_add(rays[r].start, position, position);
+            bvhTopLevel_hitNormal(frame->topLevel, instances[r], tris[r], normal);
+            hits[r] = logic_copyHitPoint(dists[r], frame->topLevel->instances[instances[r]].model, position, normal);
+        }
+        logic_hitSphere(frame, rays[r], &hits[r]);
+    }
+}
+
+static void logic_traceShadows(traceContext *ctx, Hit hitPoint, GLboolean *shadowed) {
+    for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
+        shadowed[i] = GL_FALSE;
+        //Nur wenn das Punktlicht aktiv ist beachten
+        if (ctx->frame->pointLights[i].active) {
+            ctx->rays++;
+            shadowed[i] = logic_shadowTrace(ctx->frame, hitPoint, i);
+        }
+    }
 }
 
-static Color logic_calcPhong(Ray ray, Hit hitPoint) {
+static Color logic_calcPhong(const renderFrame *frame, Ray ray, Hit hitPoint, const GLboolean *shadowed) {
+    const pointLight *lights = frame->pointLights;
     //Grundwert ist der Ambiente Anteil des Objektes
     Color col = {hitPoint.material.ka.r, hitPoint.material.ka.g, hitPoint.material.ka.b};
     //Wnn keine Lichtquelle aktiv ist, soll nichts zu sehen sein
-    if (!g_scene.pointLights[0].active && !g_scene.pointLights[1].active) {
+    if (!lights[0].active && !lights[1].active) {
         col.r = 0.0f;
         col.g = 0.0f;
         col.b = 0.0f;
@@ -389,13 +1241,13 @@ static Color logic_calcPhong(Ray ray, Hit hitPoint) {
 
     for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
         //Nur wenn das Punktlicht aktiv ist beachten
-        if (g_scene.pointLights[i].active) {
+        if (lights[i].active) {
             //Liegt die Position im Schatten, keinen Farbwert berechnen
             //Spiegel soll keinen Schatten werden
-            if (!logic_shadowTrace(hitPoint, i)) {
+            if (!shadowed[i]) {
                 //Richtungsvektor zum Licht, ausgehend vom getroffenen Punkt
                 vec3 lightDir;
-                glm_vec3_sub(g_scene.pointLights[i].pos, hitPoint.position, lightDir);
+                glm_vec3_sub((float *) lights[i].pos, hitPoint.position, lightDir);
                 glm_vec3_normalize(lightDir);
 
                 /*-------------------- DIFFUSER ANTEIL --------------------*/
@@ -403,12 +1255,12 @@ static Color logic_calcPhong(Ray ray, Hit hitPoint) {
                 //Farbe ergibt sich, aus der diffusen Farbe des Objekts, des diffusen Anteils, der Lichtfarbe
                 //und der Lichtintensitaet
                 Color diffuse = {
-                        hitPoint.material.kd.r * val * g_scene.pointLights[i].color.r *
-                        g_scene.pointLights[i].intensity,
-                        hitPoint.material.kd.g * val * g_scene.pointLights[i].color.g *
-                        g_scene.pointLights[i].intensity,
-                        hitPoint.material.kd.b * val * g_scene.pointLights[i].color.b *
-                        g_scene.pointLights[i].intensity};
+                        hitPoint.material.kd.r * val * lights[i].color.r *
+                        lights[i].intensity,
+                        hitPoint.material.kd.g * val * lights[i].color.g *
+                        lights[i].intensity,
+                        hitPoint.material.kd.b * val * lights[i].color.b *
+                        lights[i].intensity};
 
                 /*-------------------- SPEKULARER ANTEIL --------------------*/
                 vec3 negLightDir;
@@ -426,10 +1278,10 @@ static Color logic_calcPhong(Ray ray, Hit hitPoint) {
 
                 /*-------------------- ABSCHWAECHUNG DES PUNKTLICHTES --------------------*/
                 //Abschwachung des Punktlichtes, abhangig von der Distanz zum getroffenen Punkt
-                GLfloat distance = glm_vec3_distance(g_scene.pointLights[i].pos, hitPoint.position);
+                GLfloat distance = glm_vec3_distance((float *) lights[i].pos, hitPoint.position);
                 GLfloat attenuation =
-                        1.0 / (g_scene.pointLights[i].constant + g_scene.pointLights[i].linear * distance +
-                               g_scene.pointLights[i].quadratic * (distance * distance));
+                        1.0 / (lights[i].constant + lights[i].linear * distance +
+                               lights[i].quadratic * (distance * distance));
 
                 //Diffusen und Spekularen Anteil nochmal gewichten
                 col.r += 0.8f * diffuse.r + 0.3f * specular.r;
@@ -446,7 +1298,7 @@ static Color logic_calcPhong(Ray ray, Hit hitPoint) {
     return col;
 }
 
-static GLboolean logic_shadowTrace(Hit hitPoint, GLint i) {
+static GLboolean logic_shadowTrace(const renderFrame *frame, Hit hitPoint, GLint i) {
     //Spiegel soll keinen Schatten werfen
     if (hitPoint.idxObject == MIRROR) {
         return GL_FALSE;
@@ -457,7 +1309,7 @@ static GLboolean logic_shadowTrace(Hit hitPoint, GLint i) {
 
     glm_vec3_copy(hitPoint.position, shadowRay.start);
 
-    glm_vec3_sub(g_scene.pointLights[i].pos, shadowRay.start, shadowRay.dir);
+    glm_vec3_sub((float *) frame->pointLights[i].pos, shadowRay.start, shadowRay.dir);
     glm_vec3_normalize(shadowRay.dir);
 
     //Startposition des Schattenstrahls minimal entlang der Schattenstrahlrichtung verschieben,
@@ -466,61 +1318,44 @@ static GLboolean logic_shadowTrace(Hit hitPoint, GLint i) {
                  shadowRay.start);
 
     //Abstand des getroffenen Punktes zum Licht
-    GLfloat distToLight = glm_vec3_distance(g_scene.pointLights[i].pos, shadowRay.start);
-
-    //Ueber alle Objekte iterieren und SchnittPunkte berechnen
-    //Waende koennen nicht zwischen Lichtquelle und anderen Objekten in der Szene liegen
-    //Kuerzeste Intersection wird nicht benoetigt
-    for (int idxObj = CUBE; idxObj < AMOUNT_MODELS; ++idxObj) {
-        //Kugel wieder extra abfragen
-        if (idxObj == SPHERE) {
-            Hit shadowHit = logic_raySphereIntersection(shadowRay, g_scene.sphere);
-            GLboolean inShadow = !shadowHit.defaultHit;
-
-            if (inShadow && (shadowHit.dist > EPSILON) && (shadowHit.dist < distToLight)) {
-                return GL_TRUE;
-            }
-        } else {
-            //Ueber alle Dreiecke der Objekte iterieren
-            for (int amountTris = 0; amountTris < g_scene.allObjects[idxObj].faceCount; ++amountTris) {
-                //SchnittPunkt berechnen (Weber-Baldwin oder Trumbore-Moeller
-                Hit shadowHit = trumboreMoeller_rayTriangleIntersection(shadowRay,
-                                                                        g_scene.allObjects[idxObj].facesTM[amountTris]);
-                GLboolean inShadow = !shadowHit.defaultHit;
-
-                //Schattennstrahl trifft ein Objekt, und ist dichter dran als die Lichtquelle
-                if ((inShadow && (shadowHit.dist > EPSILON) && (shadowHit.dist < distToLight))) {
-
-                    //Getroffenes Objekt ist eine Bounding Box, waehrend keine Bounding Box verwendet werden soll
-                    //Schattenstrahl ignoriert die Bounding Box
-                    if (idxObj == BOUNDING_BOX) {
-                        //Ist nicht im Schatten
-                        break;
-                    }
+    GLfloat distToLight = glm_vec3_distance((float *) frame->pointLights[i].pos, shadowRay.start);
 
-                    //Ist im Schatten
-                    return GL_TRUE;
-                }
-            }
-        }
+    //Kugel wieder extra abfragen
+    if (logic_raySphereOccludes(&shadowRay, &frame->sphere, distToLight)) {
+        return GL_TRUE;
     }
-    return GL_FALSE;
-}
 
-static void logic_initObjectData(void) {
-    g_scene.allObjects = (object *) calloc(AMOUNT_MODELS, sizeof(struct object));
-    if (g_scene.allObjects == NULL) {
-        printf("Error initializing object Array!\n");
-        exit(1);
+    //Schattennstrahl trifft eine Instanz, und ist dichter dran als die Lichtquelle
+    //Waende werfen keinen Schatten, die Bounding Box liegt nicht in der BVH der Instanzen
+    //Kuerzester Treffer wird nicht benoetigt, die Beschleunigungsstruktur bricht beim ersten Treffer ab
+    if (accelerator_intersectAny(frame->accel, frame->bvhOpts, shadowRay, distToLight)) {
+        return GL_TRUE;
     }
+    return GL_FALSE;
 }
 
 static void logic_initFramebuffer(void) {
-    g_scene.fb = (Color *) calloc(DEFAULT_WINDOW_HEIGHT * DEFAULT_WINDOW_WIDTH, sizeof(*g_scene.fb));
-    if (g_scene.fb == NULL) {
+    //Kein calloc, die Seiten sollen erst von den Render-Threads angelegt werden
+    Color *fb = (Color *) malloc(DEFAULT_WINDOW_HEIGHT * DEFAULT_WINDOW_WIDTH * sizeof(*fb));
+    Color *backFb = (Color *) malloc(DEFAULT_WINDOW_HEIGHT * DEFAULT_WINDOW_WIDTH * sizeof(*backFb));
+    if (fb == NULL || backFb == NULL) {
         printf("Error initializing data Array!\n");
         exit(1);
     }
+    multiThreading_firstTouch(&g_scene, fb);
+    multiThreading_firstTouch(&g_scene, backFb);
+
+    //Beim Neubinden der Threads das angezeigte Bild uebernehmen, bis der naechste Frame fertig ist
+    Color *oldFb = logic_getFramebuffer();
+    Color *oldBackFb = g_scene.backFb;
+    if (oldFb != NULL) {
+        memcpy(fb, oldFb, DEFAULT_WINDOW_HEIGHT * DEFAULT_WINDOW_WIDTH * sizeof(*fb));
+    }
+    g_scene.fb = fb;
+    g_scene.backFb = backFb;
+    logic_releaseFramebuffer();
+    free(oldFb);
+    free(oldBackFb);
 }
 
 static Hit logic_raySphereIntersection(Ray ray, sphere sp) {
@@ -553,89 +1388,372 @@ static Hit logic_raySphereIntersection(Ray ray, sphere sp) {
     return result;
 }
 
+static GLboolean logic_raySphereOccludes(const Ray *ray, const sphere *sp, GLfloat maxDist) {
+    vec3 rayStartToSphereCenter;
+    glm_vec3_sub((float *) ray->start, (float *) sp->center, rayStartToSphereCenter);
+
+    GLfloat b = glm_vec3_dot(rayStartToSphereCenter, (float *) ray->dir);
+    GLfloat c = glm_vec3_norm2(rayStartToSphereCenter) - sp->radius * sp->radius;
+
+    //Gleiche Abbruchbedingungen wie logic_raySphereIntersection
+    if ((fabsf(c) < EPSILON) && (fabsf(b) < EPSILON)) return GL_FALSE;
+
+    GLfloat discriminant = b * b - c;
+    if (discriminant < 0.0f) return GL_FALSE;
+
+    GLfloat dist = -b - sqrt(discriminant);
+    return (dist > EPSILON) && (dist < maxDist);
+}
+
 /**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION ---------------------------------------*/
 
-static void logic_render(void) {
-    printf("Started Render!\n");
+static GLboolean logic_frameCancelled(void) {
+    //Wird pro Paketzeile abgefragt, daher ohne Sperre
+    return MULTI_THREAD_ATOMIC_LOAD(&g_scene.renderQueue.cancelled) != 0;
+}
+
+static void logic_renderPass(const renderFrame *frame, GLint step, GLboolean first) {
     if (g_scene.multiThreadOpts.useMultiThreading) {
-        GLint amountThreads = g_scene.multiThreadOpts.verticalThreads *
-                              g_scene.multiThreadOpts.horizontalThreads;
-
-        //IDs der Threads erstellen
-        g_scene.multiThreadOpts.threadIds = (pthread_t *) calloc(amountThreads, sizeof(pthread_t));
-        for (int i = 0; i < amountThreads; ++i) {
-            //Multithreading laufen lassen
-            pthread_create(&g_scene.multiThreadOpts.threadIds[i], NULL,
-                           logic_renderImageMultiThreaded, &g_scene.multiThreadOpts.threadArgs[i]);
+        //Schlafende Threads des Pools wecken und warten, bis alle Tiles fertig sind
+        progress_beginPass(frame->progress, g_scene.multiThreadOpts.tileCount);
+        logicRenderJob job = {frame, g_scene.multiThreadOpts.tiles, step, first, GL_TRUE, NULL};
+        logic_runTiles(&job, g_scene.multiThreadOpts.tileCount);
+    } else {
+        //Szene ohne Multithreading rendern, das ganze Bild zaehlt als ein Tile
+        progress_beginPass(frame->progress, 1);
+        logic_renderImage(frame, step, first);
+        if (!logic_frameCancelled()) {
+            progress_finishTile(frame->progress, 0, 0, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
         }
+    }
+    progress_finishPass(frame->progress);
+}
 
-        /* Seit dem Programmstart vergangene Zeit in Millisekunden */
-        int thisCallTime = glutGet(GLUT_ELAPSED_TIME);
+static void logic_publishPass(const renderFrame *frame) {
+    renderQueue *queue = &g_scene.renderQueue;
 
-        for (int i = 0; i < amountThreads; ++i) {
-            //Warten bis alle Threads fertig sind
-            pthread_join(g_scene.multiThreadOpts.threadIds[i], NULL);
+    pthread_mutex_lock(&queue->fbLock);
+    memcpy(g_scene.fb, frame->fb, DEFAULT_WINDOW_WIDTH * DEFAULT_WINDOW_HEIGHT * sizeof(Color));
+    pthread_mutex_unlock(&queue->fbLock);
 
-        }
+    pthread_mutex_lock(&queue->lock);
+    queue->frameReady = GL_TRUE;
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void logic_frameSettings(const renderFrame *frame, distributedSettings *settings) {
+    settings->viewMode = frame->projPlane.viewMode;
+    for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
+        settings->lightsActive[i] = frame->pointLights[i].active;
+    }
+    settings->showBB = frame->showBB;
+    settings->bvhOpts = frame->bvhOpts;
+    settings->accelType = frame->accel->type;
+    settings->packetSize = frame->packetSize;
+    settings->wavefront = frame->wavefront;
+}
 
-        int lastCallTime = glutGet(GLUT_ELAPSED_TIME);
-        /* Seit dem letzten Funktionsaufruf vergangene Zeit in Sekunden */
-        g_scene.renderTime = (double) (lastCallTime - thisCallTime) / 1000.0f;
+static void logic_applySettings(const distributedSettings *settings) {
+    if (settings->viewMode != g_scene.projPlane.viewMode) {
+        sceneObjects_setViewDir(&g_scene, settings->viewMode);
+        multiThreading_resetTileCosts(&g_scene);
+        sceneObjects_freeInstances(&g_scene);
+        sceneObjects_initModels(&g_scene);
+    }
+    if (settings->accelType != g_scene.accel.type) {
+        accelerator_setType(&g_scene.accel, settings->accelType);
+    }
+    for (int i = 0; i < AMOUNT_LIGHTS; ++i) {
+        g_scene.pointLights[i].active = settings->lightsActive[i];
+    }
+    g_scene.showBB = settings->showBB;
+    g_scene.bvhOpts = settings->bvhOpts;
+    g_scene.packetSize = settings->packetSize;
+    g_scene.wavefront = settings->wavefront;
+}
+
+static GLint logic_renderThreadCount(void) {
+    return g_scene.multiThreadOpts.useMultiThreading ? g_scene.multiThreadOpts.pool.threadCount : 1;
+}
+
+static void logic_renderBand(const renderFrame *frame, GLint row, GLint height) {
+    if (g_scene.multiThreadOpts.useMultiThreading) {
+        //Das Band in Tiles der ueblichen Breite zerlegen, damit alle Threads des Pools mitrechnen
+        multiThreadRunner tiles[(DEFAULT_WINDOW_WIDTH + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE];
+        GLint tileCount = 0;
+        for (int col = 0; col < DEFAULT_WINDOW_WIDTH; col += MULTI_THREAD_TILE_SIZE) {
+            multiThreadRunner *tile = &tiles[tileCount++];
+            tile->tileCol = col;
+            tile->tileWidth = col + MULTI_THREAD_TILE_SIZE < DEFAULT_WINDOW_WIDTH ? MULTI_THREAD_TILE_SIZE
+                                                                                  : DEFAULT_WINDOW_WIDTH - col;
+            tile->tileRow = row;
+            tile->tileHeight = height;
+            tile->cost = 0.0f;
+        }
+        //Die Baender meldet der Koordinator selbst, die Tiles hier nicht
+        logicRenderJob job = {frame, tiles, 1, GL_TRUE, GL_FALSE, NULL};
+        logic_runTiles(&job, tileCount);
     } else {
-        /* Seit dem Programmstart vergangene Zeit in Millisekunden */
-        int thisCallTime = glutGet(GLUT_ELAPSED_TIME);
-        //Szene ohne Multithreading rendern
-        logic_renderImage();
-        int lastCallTime = glutGet(GLUT_ELAPSED_TIME);
-        /* Seit dem letzten Funktionsaufruf vergangene Zeit in Sekunden */
-        g_scene.renderTime = (double) (lastCallTime - thisCallTime) / 1000.0f;
+        logic_renderArea(frame, 0, 0, row, DEFAULT_WINDOW_WIDTH, height, 1, GL_TRUE);
     }
+}
+
+static void logic_renderLocalBand(GLint row, GLint height, void *ctx) {
+    logic_renderBand((const renderFrame *) ctx, row, height);
+}
 
-    printf("Thread Amount: \t%d\n", g_scene.multiThreadOpts.threadingOpts);
+static void logic_serveBand(const distributedSettings *settings, GLint row, GLint height, Color *fb, void *ctx) {
+    (void) ctx;
+    logic_applySettings(settings);
+
+    renderFrame frame;
+    logic_snapshotFrame(&frame);
+    frame.fb = fb;
+    logic_renderBand(&frame, row, height);
+}
+
+static GLboolean logic_render(const renderFrame *frame) {
+    printf("Started Render!\n");
+    double startTime = multiThreading_seconds();
+
+    //Baender auf die Render-Prozesse verteilen, die Vorschau entfaellt, da jedes Band nur einmal uebertragen wird
+    GLboolean remote = g_scene.distribute && distributed_workerCount(&g_scene.cluster) > 0;
+    if (remote) {
+        progress_beginFrame(frame->progress, 1, logic_renderThreadCount());
+        distributedSettings settings;
+        logic_frameSettings(frame, &settings);
+        GLboolean completed = distributed_renderFrame(&g_scene.cluster, &settings, frame->fb, frame->progress,
+                                                      logic_renderLocalBand, logic_frameCancelled, (void *) frame);
+        progress_finishPass(frame->progress);
+        progress_endFrame(frame->progress);
+        if (!completed) {
+            printf("Render cancelled!\n\n");
+            return GL_FALSE;
+        }
+        g_scene.renderTime = (GLfloat) (multiThreading_seconds() - startTime);
+        printf("Render Workers: %d\n", distributed_workerCount(&g_scene.cluster));
+        printf("Accelerator: \t%s\n", accelerator_name(frame->accel->type));
+        printf("Packet Size: \t%dx%d\n", frame->packetSize, frame->packetSize);
+        printf("Wavefront: \t%s\n", frame->wavefront ? "On" : "Off");
+        printf("Rendertime: \t%.3f Sekunden\n\n", g_scene.renderTime);
+        return GL_TRUE;
+    }
+
+    //Tiles anhand der Renderzeiten des letzten Frames festlegen, alle Durchgaenge verwenden dieselben
+    if (g_scene.multiThreadOpts.useMultiThreading) {
+        multiThreading_planTiles(&g_scene);
+    }
+
+    //Grob nach fein, jeder Durchgang verfolgt nur die Pixel, die der vorherige nicht hatte
+    GLint firstStep = frame->progressive ? PROGRESSIVE_START_STEP : 1;
+    GLint passCount = 0;
+    for (GLint step = firstStep; step >= 1; step /= 2) {
+        passCount++;
+    }
+    progress_beginFrame(frame->progress, passCount, logic_renderThreadCount());
+    for (GLint step = firstStep; step >= 1; step /= 2) {
+        logic_renderPass(frame, step, step == firstStep);
+        if (logic_frameCancelled()) {
+            break;
+        }
+
+        if (step > 1) {
+            logic_publishPass(frame);
+            printf("Preview %dx%d: \t%.3f Sekunden\n", step, step, multiThreading_seconds() - startTime);
+        }
+    }
+
+    progress_endFrame(frame->progress);
+    if (logic_frameCancelled()) {
+        printf("Render cancelled!\n\n");
+        return GL_FALSE;
+    }
+
+    /* Vergangene Zeit in Sekunden */
+    g_scene.renderTime = (GLfloat) (multiThreading_seconds() - startTime);
+    if (g_scene.multiThreadOpts.useMultiThreading) {
+        multiThreading_recordTileCosts(&g_scene);
+    }
+
+    printf("Thread Amount: \t%d\n", g_scene.multiThreadOpts.threadCount);
+    if (g_scene.multiThreadOpts.useMultiThreading) {
+        printf("Tiles: \t\t%d\n", g_scene.multiThreadOpts.tileCount);
+        printf("Pinned Threads: %s\n", g_scene.multiThreadOpts.pool.pinned ? "On" : "Off");
+
+        //Auslastung der Threads, grosse Unterschiede deuten auf eine schlechte Aufteilung hin
+        GLfloat minBusy, maxBusy;
+        progress_busySeconds(frame->progress, &minBusy, &maxBusy);
+        printf("Thread Busy: \t%.3f - %.3f Sekunden\n", minBusy, maxBusy);
+    }
+    printf("Rays: \t\t%.2f Mio. (%.2f Mio./s)\n", progress_rays(frame->progress) * 1e-6,
+           progress_rays(frame->progress) * 1e-6 / g_scene.renderTime);
+    printf("BVH Layout: \t%s / %s\n", bvh_layoutName(frame->bvhOpts.layout),
+           bvh_triangleLayoutName(frame->bvhOpts.triLayout));
+    printf("Accelerator: \t%s\n", accelerator_name(frame->accel->type));
+    printf("Packet Size: \t%dx%d\n", frame->packetSize, frame->packetSize);
+    printf("Progressive: \t%s\n", frame->progressive ? "On" : "Off");
+    printf("Wavefront: \t%s\n", frame->wavefront ? "On" : "Off");
     printf("Rendertime: \t%.3f Sekunden\n\n", g_scene.renderTime);
+    return GL_TRUE;
 }
 
-void logic_initLogic(void) {
-    if (io_startRender()) {
-        //Farbarray abhaengig von der Aufloesung initialisieren
-        logic_initFramebuffer();
+static void *logic_renderWorker(void *args) {
+    (void) args;
+    renderQueue *queue = &g_scene.renderQueue;
 
-        //ViewPort Dimensionen festlegen (Quadratisch
-        g_scene.projPlane.viewPortHeight = 2.0f;
-        g_scene.projPlane.viewPortWidth = g_scene.projPlane.viewPortHeight;
+    pthread_mutex_lock(&queue->lock);
+    while (1) {
+        while (!queue->pending && !queue->shutdown) {
+            pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        if (queue->shutdown) {
+            break;
+        }
 
-        //Projektionsebene aufstellen
-        sceneObjects_setViewDir(&g_scene, FRONT);
+        renderFrame frame = queue->next;
+        frame.fb = g_scene.backFb;
+        queue->pending = GL_FALSE;
+        MULTI_THREAD_ATOMIC_STORE(&queue->cancelled, GL_FALSE);
+        queue->busy = GL_TRUE;
+        pthread_mutex_unlock(&queue->lock);
+
+        GLboolean completed = logic_render(&frame);
+
+        pthread_mutex_lock(&queue->lock);
+        if (completed && !MULTI_THREAD_ATOMIC_LOAD(&queue->cancelled)) {
+            //Fertigen Frame anzeigen, der bisher angezeigte wird zum neuen Backbuffer
+            pthread_mutex_lock(&queue->fbLock);
+            g_scene.backFb = g_scene.fb;
+            g_scene.fb = frame.fb;
+            pthread_mutex_unlock(&queue->fbLock);
+            queue->frameReady = GL_TRUE;
+        }
+        queue->busy = GL_FALSE;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
 
-        //Standard BoundigBox Status fuer den Hasen setzen
-        g_scene.bbState = aabb;
-        g_scene.lastUsedBB = g_scene.bbState;
-        //Bounding Box anzeigen
-        g_scene.showBB = GL_TRUE;
+static void logic_startRenderThread(void) {
+    renderQueue *queue = &g_scene.renderQueue;
+    if (queue->started) {
+        return;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_mutex_init(&queue->fbLock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    queue->pending = GL_FALSE;
+    queue->busy = GL_FALSE;
+    MULTI_THREAD_ATOMIC_STORE(&queue->cancelled, GL_FALSE);
+    queue->frameReady = GL_FALSE;
+    queue->shutdown = GL_FALSE;
+    pthread_create(&queue->thread, NULL, logic_renderWorker, NULL);
+    queue->started = GL_TRUE;
+}
 
-        //MultiThreading Einstellungen festlegen
-        multiThreading_setupThreading(&g_scene);
+static void logic_stopFrame(void) {
+    renderQueue *queue = &g_scene.renderQueue;
+    if (!queue->started) {
+        return;
+    }
+    pthread_mutex_lock(&queue->lock);
+    queue->pending = GL_FALSE;
+    if (queue->busy) {
+        MULTI_THREAD_ATOMIC_STORE(&queue->cancelled, GL_TRUE);
+    }
+    while (queue->busy) {
+        pthread_cond_wait(&queue->changed, &queue->lock);
+    }
+    pthread_mutex_unlock(&queue->lock);
+}
 
-        //Objektarray initialisieren
-        logic_initObjectData();
-        //Modelle der Szene laden
-        sceneObjects_initModels(&g_scene);
-        //Punktlichter initialisieren
-        sceneObjects_initPointLights(&g_scene);
+static void logic_waitForFrame(void) {
+    renderQueue *queue = &g_scene.renderQueue;
+    pthread_mutex_lock(&queue->lock);
+    while (queue->pending || queue->busy) {
+        pthread_mutex_unlock(&queue->lock);
+
+        //Fortschritt nur lesen, die Render-Threads werden dabei nicht aufgehalten
+        if (progress_running(&g_scene.progress)) {
+            GLint tileCount;
+            GLint tilesDone = progress_tilesDone(&g_scene.progress, &tileCount);
+            GLfloat minBusy, maxBusy;
+            progress_busySeconds(&g_scene.progress, &minBusy, &maxBusy);
+            printf("Progress: \t%5.1f%% (Tiles %d/%d, %.2f Mio. Rays, %.3f Sekunden, Busy %.3f - %.3f)\n",
+                   progress_fraction(&g_scene.progress) * 100.0f, tilesDone, tileCount,
+                   progress_rays(&g_scene.progress) * 1e-6, progress_seconds(&g_scene.progress), minBusy, maxBusy);
+        }
+        multiThreading_sleep(PROGRESS_REPORT_MILLIS);
 
-        //Szene rendern
-        logic_render();
+        pthread_mutex_lock(&queue->lock);
     }
+    pthread_mutex_unlock(&queue->lock);
 }
 
 /**
- * Rendert die Szene erneut
+ * Fordert einen neuen Frame der aktuellen Szene beim Render-Thread an, ohne darauf zu warten.
+ * Ein noch laufender Frame wird abgebrochen.
  */
 void logic_reDrawFrame(void) {
-    if (g_scene.fb != NULL)
-        free(g_scene.fb);
+    renderQueue *queue = &g_scene.renderQueue;
+    pthread_mutex_lock(&queue->lock);
+    logic_snapshotFrame(&queue->next);
+    if (queue->busy) {
+        MULTI_THREAD_ATOMIC_STORE(&queue->cancelled, GL_TRUE);
+    }
+    queue->pending = GL_TRUE;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+static void logic_initScene(void) {
+    //ViewPort Dimensionen festlegen (Quadratisch
+    g_scene.projPlane.viewPortHeight = 2.0f;
+    g_scene.projPlane.viewPortWidth = g_scene.projPlane.viewPortHeight;
+
+    //Projektionsebene aufstellen
+    sceneObjects_setViewDir(&g_scene, FRONT);
+
+    //Standard Bounding Volume fuer alle Objekte setzen
+    g_scene.bvhOpts.bounds = aabb;
+    g_scene.lastUsedBB = g_scene.bvhOpts.bounds;
+    //Bounding Box anzeigen
+    g_scene.showBB = GL_TRUE;
+
+    //Primaerstrahlen in 8x8 Paketen verfolgen
+    g_scene.packetSize = packets8x8;
+
+    //Erst eine grobe Vorschau anzeigen
+    g_scene.progressive = GL_TRUE;
+
+    //Strahlen rekursiv pro Pixel verfolgen
+    g_scene.wavefront = GL_FALSE;
+
+    //Fortschritt zuruecksetzen, bevor der erste Frame gerendert wird
+    progress_init(&g_scene.progress);
+
+    //MultiThreading Einstellungen festlegen
+    multiThreading_setupThreading(&g_scene);
+    logic_prepareWavefrontQueues();
+
+    //Farbarrays abhaengig von der Aufloesung initialisieren, nach dem Start der Render-Threads
     logic_initFramebuffer();
-    logic_render();
+
+    //Modelle der Szene laden
+    sceneObjects_initModels(&g_scene);
+    //Punktlichter initialisieren
+    sceneObjects_initPointLights(&g_scene);
+}
+
+void logic_initLogic(void) {
+    if (io_startRender()) {
+        logic_initScene();
+
+        //Szene im Hintergrund rendern
+        logic_startRenderThread();
+        logic_reDrawFrame();
+    }
 }
 
 /**
@@ -643,11 +1761,12 @@ void logic_reDrawFrame(void) {
  * @param mode
  */
 void logic_updateViewDir(viewMode mode) {
+    logic_stopFrame();
     sceneObjects_setViewDir(&g_scene, mode);
-    //Von hinten soll der Spiegel nicht gerendert werden
-    if (g_scene.allObjects != NULL)
-        free(g_scene.allObjects);
-    logic_initObjectData();
+    //Die Renderzeiten der alten Ansicht sagen nichts ueber die neue aus
+    multiThreading_resetTileCosts(&g_scene);
+    //Von hinten soll der Spiegel nicht gerendert werden, die Meshes bleiben geladen
+    sceneObjects_freeInstances(&g_scene);
     sceneObjects_initModels(&g_scene);
     logic_reDrawFrame();
 }
@@ -656,22 +1775,99 @@ void logic_updateViewDir(viewMode mode) {
  * Gibt den reservierten Speicher wieder frei
  */
 void logic_freeData(void) {
-    if (g_scene.fb != NULL) {
-        free(g_scene.fb);
-    }
-    if (g_scene.allObjects != NULL) {
-        free(g_scene.allObjects);
-    }
+    logic_stopFrame();
+    free(g_scene.fb);
+    free(g_scene.backFb);
+    g_scene.fb = NULL;
+    g_scene.backFb = NULL;
+    sceneObjects_freeModels(&g_scene);
+    resources_free(&g_scene.resources);
+    logic_freeWavefrontQueues();
     if (g_scene.pointLights != NULL) {
         free(g_scene.pointLights);
     }
 }
 
+void logic_freeThreads(void) {
+    renderQueue *queue = &g_scene.renderQueue;
+    if (queue->started) {
+        pthread_mutex_lock(&queue->lock);
+        queue->shutdown = GL_TRUE;
+        MULTI_THREAD_ATOMIC_STORE(&queue->cancelled, GL_TRUE);
+        pthread_cond_broadcast(&queue->changed);
+        pthread_mutex_unlock(&queue->lock);
+        pthread_join(queue->thread, NULL);
+        queue->started = GL_FALSE;
+    }
+    multiThreading_freeThreading(&g_scene);
+    distributed_disconnect(&g_scene.cluster);
+}
+
+void logic_useCompressedMeshes(void) {
+    //Die Meshes besitzen dann nur dieses Layout
+    g_scene.resources.compressedOnly = GL_TRUE;
+    g_scene.bvhOpts.layout = bvhQuantized;
+}
+
+void logic_connectWorkers(const char *addresses) {
+    g_scene.distribute = distributed_connect(&g_scene.cluster, addresses) > 0;
+}
+
+void logic_toggleDistributed(void) {
+    logic_stopFrame();
+    if (distributed_workerCount(&g_scene.cluster) == 0) {
+        printf("No render workers connected (start with --workers)\n");
+        g_scene.distribute = GL_FALSE;
+    } else {
+        g_scene.distribute = !g_scene.distribute;
+        if (g_scene.distribute)
+            printf("Distributing frames to %d render workers\n", distributed_workerCount(&g_scene.cluster));
+        else
+            printf("Rendering frames locally\n");
+    }
+    logic_reDrawFrame();
+}
+
+int logic_serveFrames(const char *address) {
+    //Die Szene einmal laden, danach gleichen die Auftraege des Koordinators nur noch Einstellungen an
+    logic_initScene();
+    int result = distributed_serve(address, logic_serveBand, g_scene.fb, NULL);
+    logic_freeData();
+    logic_freeThreads();
+    return result;
+}
+
 Color *logic_getFramebuffer(void) {
+    if (g_scene.renderQueue.started) {
+        pthread_mutex_lock(&g_scene.renderQueue.fbLock);
+    }
     return g_scene.fb;
 }
 
+void logic_releaseFramebuffer(void) {
+    if (g_scene.renderQueue.started) {
+        pthread_mutex_unlock(&g_scene.renderQueue.fbLock);
+    }
+}
+
+const renderProgress *logic_getProgress(void) {
+    return &g_scene.progress;
+}
+
+GLboolean logic_takeFinishedFrame(void) {
+    renderQueue *queue = &g_scene.renderQueue;
+    if (!queue->started) {
+        return GL_FALSE;
+    }
+    pthread_mutex_lock(&queue->lock);
+    GLboolean result = queue->frameReady;
+    queue->frameReady = GL_FALSE;
+    pthread_mutex_unlock(&queue->lock);
+    return result;
+}
+
 void logic_togglePointLight1(void) {
+    logic_stopFrame();
     g_scene.pointLights[0].active = !g_scene.pointLights[0].active;
     if (g_scene.pointLights[1].active)
         printf("Enabled PointLight 1\n");
@@ -681,6 +1877,7 @@ void logic_togglePointLight1(void) {
 }
 
 void logic_togglePointLight2(void) {
+    logic_stopFrame();
     g_scene.pointLights[1].active = !g_scene.pointLights[1].active;
     if (g_scene.pointLights[1].active)
         printf("Enabled PointLight 2\n");
@@ -690,23 +1887,19 @@ void logic_togglePointLight2(void) {
 }
 
 void logic_toggleBoundingBoxes(void) {
-    g_scene.bbState++;
-    if (g_scene.bbState > none) {
-        g_scene.bbState = 0;
-        g_scene.allObjects[BOUNDING_BOX] = sceneObjects_initDefaultModel();
-    }
-    g_scene.allObjects[BOUNDING_BOX] = g_scene.bbState == aabb ? g_scene.boundingBoxes[0] : g_scene.boundingBoxes[1];
+    logic_stopFrame();
+    g_scene.bvhOpts.bounds = (g_scene.bvhOpts.bounds + 1) % (none + 1);
 
-    switch (g_scene.bbState) {
+    switch (g_scene.bvhOpts.bounds) {
         case none:
-            printf("Switched to no Bounding Box for the Bunny\n");
+            printf("Switched to no Bounding Boxes\n");
             break;
         case aabb:
-            printf("Switched to AABB for the Bunny\n");
+            printf("Switched to AABBs\n");
             g_scene.lastUsedBB = aabb;
             break;
         case oobb:
-            printf("Switched to OOBB for the Bunny\n");
+            printf("Switched to OOBBs where tighter than the AABB\n");
             g_scene.lastUsedBB = oobb;
             break;
     }
@@ -714,6 +1907,7 @@ void logic_toggleBoundingBoxes(void) {
 }
 
 void logic_toggleShowBB(void) {
+    logic_stopFrame();
     g_scene.showBB = !g_scene.showBB;
     if (g_scene.showBB)
         printf("Displaying the Bounding Box for the Bunny\n");
@@ -722,6 +1916,156 @@ void logic_toggleShowBB(void) {
     logic_reDrawFrame();
 }
 
+void logic_toggleBvhLayout(void) {
+    logic_stopFrame();
+    if (g_scene.resources.compressedOnly) {
+        printf("Meshes only have the compressed BVH (--compressed), staying with %s (Bunny: %.1f Bytes/Triangle)\n",
+               bvh_layoutName(g_scene.bvhOpts.layout), bvh_bytesPerTriangle(g_scene.meshes[BUNNY_MESH]));
+        logic_reDrawFrame();
+        return;
+    }
+    g_scene.bvhOpts.layout = (g_scene.bvhOpts.layout + 1) % (bvhQuantized + 1);
+
+    //Speicherbedarf des Hasen im gewaehlten Layout ausgeben
+    const bvh *bunnyBvh = &g_scene.meshes[BUNNY_MESH]->bvh;
+    size_t nodeBytes;
+    switch (g_scene.bvhOpts.layout) {
+        case bvh4:
+            nodeBytes = bunnyBvh->nodeCount4 * sizeof(bvh4Node);
+            break;
+        case bvh8:
+            nodeBytes = bunnyBvh->nodeCount8 * sizeof(bvh8Node);
+            break;
+        case bvhQuantized:
+            nodeBytes = bunnyBvh->nodeCountQ * sizeof(bvhQuantNode);
+            break;
+        case bvh2:
+        default:
+            nodeBytes = bunnyBvh->nodeCount * sizeof(bvhNode);
+            break;
+    }
+    printf("Switched to %s (Bunny nodes: %zu KB, resident %.1f Bytes/Triangle)\n",
+           bvh_layoutName(g_scene.bvhOpts.layout), nodeBytes / 1024,
+           bvh_bytesPerTriangle(g_scene.meshes[BUNNY_MESH]));
+    //Die quantisierte BVH wird nur mit einzelnen Strahlen traversiert
+    if (g_scene.bvhOpts.layout == bvhQuantized && g_scene.packetSize != packetsOff) {
+        printf("Ray packets are traced as single rays in this layout\n");
+    }
+    logic_reDrawFrame();
+}
+
+void logic_toggleTriangleLayout(void) {
+    logic_stopFrame();
+    if (g_scene.resources.compressedOnly) {
+        printf("Meshes only have indexed triangles (--compressed), no triangle layouts to switch\n");
+        logic_reDrawFrame();
+        return;
+    }
+    g_scene.bvhOpts.triLayout = (g_scene.bvhOpts.triLayout + 1) % (trisSoA8 + 1);
+    printf("Switched to %s triangle leaves (Bunny: resident %.1f Bytes/Triangle)\n",
+           bvh_triangleLayoutName(g_scene.bvhOpts.triLayout), bvh_bytesPerTriangle(g_scene.meshes[BUNNY_MESH]));
+    logic_reDrawFrame();
+}
+
+void logic_togglePacketSize(void) {
+    logic_stopFrame();
+    switch (g_scene.packetSize) {
+        case packetsOff:
+            g_scene.packetSize = packets2x2;
+            break;
+        case packets2x2:
+            g_scene.packetSize = packets4x4;
+            break;
+        case packets4x4:
+            g_scene.packetSize = packets8x8;
+            break;
+        case packets8x8:
+        default:
+            g_scene.packetSize = packetsOff;
+            break;
+    }
+    if (g_scene.packetSize == packetsOff)
+        printf("Switched to single primary rays\n");
+    else
+        printf("Switched to %dx%d ray packets\n", g_scene.packetSize, g_scene.packetSize);
+    logic_reDrawFrame();
+}
+
+void logic_toggleProgressive(void) {
+    logic_stopFrame();
+    g_scene.progressive = !g_scene.progressive;
+    if (g_scene.progressive)
+        printf("Enabled progressive preview\n");
+    else
+        printf("Disabled progressive preview\n");
+    logic_reDrawFrame();
+}
+
+void logic_toggleWavefront(void) {
+    logic_stopFrame();
+    g_scene.wavefront = !g_scene.wavefront;
+    if (g_scene.wavefront)
+        printf("Enabled wavefront ray tracing\n");
+    else
+        printf("Disabled wavefront ray tracing\n");
+    logic_reDrawFrame();
+}
+
+void logic_toggleAccelerator(void) {
+    logic_stopFrame();
+    accelerator_setType(&g_scene.accel, (g_scene.accel.type + 1) % (accelGrid + 1));
+    printf("Switched to %s (%zu KB, built in %d ms)\n", accelerator_name(g_scene.accel.type),
+           accelerator_memoryFootprint(&g_scene.accel) / 1024, accelerator_buildTime(&g_scene.accel));
+    logic_reDrawFrame();
+}
+
+void logic_benchmarkAccelerators(void) {
+    logic_stopFrame();
+    GLfloat renderTimes[accelGrid + 1];
+    size_t memory[accelGrid + 1];
+    GLint buildTimes[accelGrid + 1];
+
+    //Das eingestellte Backend zuletzt rendern, damit es danach wieder aktiv ist
+    acceleratorType current = g_scene.accel.type;
+    for (int i = 1; i <= accelGrid + 1; ++i) {
+        acceleratorType type = (current + i) % (accelGrid + 1);
+        accelerator_setType(&g_scene.accel, type);
+        logic_reDrawFrame();
+        logic_waitForFrame();
+        logic_stopFrame();
+        renderTimes[type] = g_scene.renderTime;
+        memory[type] = accelerator_memoryFootprint(&g_scene.accel);
+        buildTimes[type] = accelerator_buildTime(&g_scene.accel);
+    }
+
+    printf("Accelerator \tBuild (ms) \tMemory (KB) \tRender (s)\n");
+    for (int type = 0; type <= accelGrid; ++type) {
+        printf("%-11s \t%10d \t%11zu \t%10.3f\n", accelerator_name(type), buildTimes[type], memory[type] / 1024,
+               renderTimes[type]);
+    }
+    printf("\n");
+}
+
 void logic_setThreadingOptions(multiThreadOptions opt) {
     g_scene.multiThreadOpts.threadingOpts = opt;
 }
+
+void logic_toggleThreadPinning(void) {
+    //Laufender Frame darf nicht mehr auf die Buffer zugreifen, die gleich ersetzt werden
+    logic_stopFrame();
+
+    g_scene.multiThreadOpts.pinThreads = !g_scene.multiThreadOpts.pinThreads;
+    if (g_scene.multiThreadOpts.pinThreads)
+        printf("Pinning render threads to cpu cores\n");
+    else
+        printf("Render threads are no longer pinned\n");
+
+    //Bestehende Threads neu binden, Szene und Aufteilung der Tiles bleiben erhalten.
+    //Nur der Speicher pro Thread wird aus den neu gebundenen Threads heraus neu angelegt.
+    if (g_scene.multiThreadOpts.useMultiThreading && g_scene.fb != NULL) {
+        multiThreading_poolSetPinned(&g_scene.multiThreadOpts.pool, g_scene.multiThreadOpts.pinThreads);
+        logic_initFramebuffer();
+        logic_prepareWavefrontQueues();
+        logic_reDrawFrame();
+    }
+}
@@ -31,16 +31,39 @@ void logic_initLogic(void);
 void logic_updateViewDir(viewMode mode);
 
 /**
- * Liefert die Farbwerte des Ergebnisbildes
- * @return
+ * Liefert die Farbwerte des zuletzt fertig gerenderten Bildes und sperrt sie gegen das Tauschen
+ * durch den Render-Thread, bis logic_releaseFramebuffer aufgerufen wird
+ * @return Frontbuffer
  */
 Color *logic_getFramebuffer(void);
 
+/**
+ * Gibt den ueber logic_getFramebuffer gesperrten Frontbuffer wieder frei
+ */
+void logic_releaseFramebuffer(void);
+
+/**
+ * Liefert den Fortschritt des laufenden Frames, kann jederzeit ohne Sperre gelesen werden (progress.h)
+ * @return Fortschritt
+ */
+const renderProgress *logic_getProgress(void);
+
+/**
+ * Prueft, ob seit dem letzten Aufruf ein neuer Frame fertig geworden ist
+ * @return GL_TRUE, wenn das Bild neu gezeichnet werden muss
+ */
+GLboolean logic_takeFinishedFrame(void);
+
 /**
  * Gibt den reservierten Speicher wieder frei
  */
 void logic_freeData(void);
 
+/**
+ * Beendet die Render-Threads, nur beim Beenden des Programms
+ */
+void logic_freeThreads(void);
+
 /**
  * (De-)aktiviert das 1. Punktlicht und rendert die Szene neu
  */
@@ -61,9 +84,80 @@ void logic_toggleBoundingBoxes(void);
  */
 void logic_toggleShowBB(void);
 
+/**
+ * Wechselt zwischen dem binaeren, 4-fach, 8-fach und quantisierten Knotenlayout der BVHs und rendert die Szene neu.
+ * Pakete traversieren die binaere und die weiten BVHs gemeinsam, die quantisierte BVH mit einzelnen Strahlen.
+ * Mit logic_useCompressedMeshes gibt es nur das quantisierte Layout.
+ */
+void logic_toggleBvhLayout(void);
+
+/**
+ * Wechselt zwischen einzelnen Dreiecken und SoA Bloecken zu 4 bzw. 8 Dreiecken
+ * in den Blaettern der BVHs und rendert die Szene neu (nicht mit logic_useCompressedMeshes)
+ */
+void logic_toggleTriangleLayout(void);
+
+/**
+ * Wechselt die Paketgroesse der Primaerstrahlen (einzeln, 2x2, 4x4, 8x8) und rendert die Szene neu
+ */
+void logic_togglePacketSize(void);
+
+/**
+ * (De-)aktiviert die progressive Vorschau (grob nach fein) und rendert die Szene neu
+ */
+void logic_toggleProgressive(void);
+
+/**
+ * Wechselt zwischen rekursiver Strahlverfolgung pro Pixel und dem Wavefront-Modus, in dem alle Strahlen
+ * einer Tiefe stufenweise (schneiden, Schatten, schattieren) ueber Queues verfolgt werden
+ */
+void logic_toggleWavefront(void);
+
+/**
+ * Wechselt zwischen der BVH und dem gleichmaessigen Gitter als Beschleunigungsstruktur und rendert die Szene neu
+ */
+void logic_toggleAccelerator(void);
+
+/**
+ * Rendert die aktuelle Ansicht mit jeder Beschleunigungsstruktur und gibt Aufbauzeit,
+ * Speicherbedarf und Renderzeit gegenueber
+ */
+void logic_benchmarkAccelerators(void);
+
 /**
  * Waehlt den Threading Modus aus
  * @param opt Threading Modus
  */
 void logic_setThreadingOptions(multiThreadOptions opt);
+
+/**
+ * (De-)aktiviert das Binden der Render-Threads an CPU Kerne. Laufende Threads werden direkt
+ * neu gebunden, Framebuffer und Speicher pro Thread danach von ihnen neu angelegt.
+ */
+void logic_toggleThreadPinning(void);
+
+/**
+ * Baut von allen Meshes nur die komprimierte BVH auf (triangleTM Records, SoA Bloecke und weite Baeume entfallen)
+ * und traversiert quantisiert. Muss vor dem Laden der Szene aufgerufen werden.
+ */
+void logic_useCompressedMeshes(void);
+
+/**
+ * Verbindet sich mit Render-Prozessen, auf die die Frames ab jetzt verteilt werden
+ * @param addresses durch Kommas getrennte Adressen ("unix:/pfad" oder "host:port")
+ */
+void logic_connectWorkers(const char *addresses);
+
+/**
+ * Wechselt zwischen lokalem Rendern und dem Verteilen auf die verbundenen Render-Prozesse
+ */
+void logic_toggleDistributed(void);
+
+/**
+ * Laeuft als Render-Prozess ohne Fenster: laedt die Szene einmal und rendert die Baender,
+ * die ein Koordinator ueber die Adresse anfordert
+ * @param address "unix:/pfad" oder "[host]:port", auf der gelauscht wird
+ * @return Rueckgabewert des Programms, ungleich 0 wenn nicht gelauscht werden konnte
+ */
+int logic_serveFrames(const char *address);
 #endif
\ No newline at end of file
@@ -9,13 +9,18 @@
 
 /* ---- System Header einbinden ---- */
 #include <stdio.h>
+#include <string.h>
 
 /* ---- Eigene Header einbinden ---- */
 #include "io.h"
+#include "logic.h"
 
 /**
  * Hauptprogramm.
  * Initialisierung und Starten der Ereignisbehandlung.
+ * Mit "--worker <adresse>" laeuft das Programm ohne Fenster als Render-Prozess,
+ * mit "--workers <adresse>[,<adresse>...]" verteilt es die Frames auf solche Prozesse.
+ * Ein vorangestelltes "--compressed" baut von den Meshes nur die komprimierte BVH auf.
  * @param argc Anzahl der Kommandozeilenparameter (In).
  * @param argv Kommandozeilenparameter (In).
  * @return Rueckgabewert im Fehlerfall ungleich Null.
@@ -23,8 +28,27 @@
 int
 main (int argc, char **argv)
 {
-	(void)argc;
-	(void)argv;
+  int arg = 1;
+  if (arg < argc && strcmp (argv[arg], "--compressed") == 0)
+    {
+      logic_useCompressedMeshes ();
+      arg++;
+    }
+  if (argc - arg == 2 && strcmp (argv[arg], "--worker") == 0)
+    {
+      return logic_serveFrames (argv[arg + 1]);
+    }
+  if (argc - arg == 2 && strcmp (argv[arg], "--workers") == 0)
+    {
+      logic_connectWorkers (argv[arg + 1]);
+    }
+  else if (argc > arg)
+    {
+      fprintf (stderr, "Usage: %s [--compressed] [--worker <address> | --workers <address>[,<address>...]]\n",
+               argv[0]);
+      return 1;
+    }
+
   /* Initialisierung des I/O-Sytems
      (inkl. Erzeugung des Fensters und Starten der Ereignisbehandlung). */
   if (!initAndStartIO
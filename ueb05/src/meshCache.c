@@ -0,0 +1,471 @@
+/**
+ * @file
+ * Binaere Mesh-Dateien, die neben den .obj und .ply Dateien abgelegt werden. Eine Mesh-Datei enthaelt die Vertizes,
+ * die Indizes, die vorberechneten Dreiecke, alle aufgebauten Layouts der BVH und die Bounding Volumes eines Meshes
+ * in dem Aufbau, in dem sie auch im Speicher liegen (bei bvh.compressedOnly nur die komprimierte BVH ohne Dreiecke).
+ * Beim Laden wird die Datei nur gemappt und die Zeiger des Objektes in die Abschnitte gesetzt, es wird weder gelesen
+ * noch kopiert noch aufgebaut.
+ * Die Abschnitte sind an Cache-Zeilen ausgerichtet. Im Kopf stehen Groessen der gespeicherten Typen, die Parameter
+ * des BVH Aufbaus und Groesse/Aenderungszeitpunkt der Quelldatei, passt etwas davon nicht, wird die Quelldatei
+ * neu gelesen. Nach dem Mappen wird jeder Index der Baeume geprueft, bevor die Datei verwendet wird.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "meshCache.h"
+#include "utils.h"
+
+/** Anzahl der Abschnitte einer Mesh-Datei (Arrays eines Objektes) */
+#define MESH_CACHE_SECTIONS (11)
+/** Anzahl der Typen, deren Groesse im Kopf geprueft wird */
+#define MESH_CACHE_TYPES (12)
+/** Wird in der Byte-Reihenfolge des schreibenden Rechners abgelegt */
+#define MESH_CACHE_BYTE_ORDER (0x01020304u)
+
+/**---------------------------------------------- LOCAL TYPES ---------------------------------------------------*/
+
+/** Kopf einer Mesh-Datei, steht am Anfang der Datei */
+typedef struct meshCacheHeader {
+    GLuint magic;
+    GLuint version;
+    GLuint byteOrder;
+    /** BVH_QUANT_BITS beim Schreiben, bestimmt den Aufbau der quantisierten Knoten */
+    GLuint quantBits;
+    /** BVH_MAX_LEAF_SIZE und BVH_MAX_DEPTH beim Schreiben, bestimmen Form und Tiefe der Baeume */
+    GLuint maxLeafSize;
+    GLuint maxDepth;
+    /** 1, wenn nur die komprimierte BVH gespeichert ist (bvh.compressedOnly) */
+    GLuint compressedOnly;
+    /** Groessen der gespeicherten Typen, unterscheiden sich je nach Compiler und Build-Optionen */
+    GLuint typeSizes[MESH_CACHE_TYPES];
+    /** Groesse und Aenderungszeitpunkt der .obj Datei, aus der die Mesh-Datei erzeugt wurde */
+    long long objSize;
+    long long objModified;
+    /** Groessen der Arrays des Objektes */
+    GLint vertexCount;
+    GLint faceCount;
+    GLint nodeCount;
+    GLint nodeCount4;
+    GLint nodeCount8;
+    GLint blockCount4;
+    GLint blockCount8;
+    GLint nodeCountQ;
+    bvhStats stats;
+    boundingVolume bounds;
+    /** Anfang der Abschnitte ab dem Dateianfang, 0 wenn das Array nicht existiert */
+    unsigned long long offsets[MESH_CACHE_SECTIONS];
+} meshCacheHeader;
+
+/** Array eines Objektes, das als Abschnitt gespeichert wird */
+typedef struct meshCacheSection {
+    /** Zeiger des Objektes auf das Array */
+    void **data;
+    /** Groesse des Arrays in Bytes laut den Zaehlern des Objektes */
+    size_t size;
+} meshCacheSection;
+
+/**------------------------------------------ LOCAL FUNCTION DECLARATION ----------------------------------------*/
+
+/**
+ * Bestimmt den Pfad der Mesh-Datei, die Endung .obj wird durch MESH_CACHE_EXTENSION ersetzt,
+ * an andere Quelldateien (z.B. .ply) wird sie angehaengt, damit gleichnamige Quellen sich nicht stoeren
+ * @param objPath Pfad der Quelldatei
+ * @return Pfad der Mesh-Datei (mit free freigeben)
+ */
+static char *meshCache_path(const char *objPath);
+
+/**
+ * Fuellt die Felder des Kopfes, die nur vom Programm und nicht vom Mesh abhaengen
+ * @param header Kopf, alle anderen Felder werden auf 0 gesetzt
+ */
+static void meshCache_initHeader(meshCacheHeader *header);
+
+/**
+ * Beschreibt die Arrays eines Objektes als Abschnitte, die Groessen ergeben sich aus seinen Zaehlern
+ * @param obj Objekt
+ * @param sections Ausgabe, MESH_CACHE_SECTIONS Abschnitte
+ */
+static void meshCache_sections(object *obj, meshCacheSection *sections);
+
+/**
+ * Rundet einen Offset auf die Ausrichtung der Abschnitte auf
+ * @param offset Offset in Bytes
+ * @return naechstes Vielfaches von MESH_CACHE_ALIGNMENT
+ */
+static unsigned long long meshCache_align(unsigned long long offset);
+
+/**
+ * Bestimmt den temporaeren Pfad, unter dem eine Mesh-Datei geschrieben wird. Die Prozess-ID im Namen
+ * verhindert, dass mehrere Prozesse (z.B. Render-Prozesse auf einem gemeinsamen Laufwerk) dieselbe Datei schreiben.
+ * @param path Pfad der Mesh-Datei
+ * @return temporaerer Pfad (mit free freigeben)
+ */
+static char *meshCache_tempPath(const char *path);
+
+/**
+ * Prueft ein Kind eines Knotens: Blaetter muessen einen Bereich der Dreiecke referenzieren, innere Knoten
+ * muessen hinter ihrem Elternknoten liegen (dadurch gibt es keine Zyklen) und duerfen nicht tiefer als
+ * BVH_MAX_DEPTH liegen, sonst laufen die Traversierungsstacks ueber.
+ * @param parent Index des Elternknotens
+ * @param child Index des Kindknotens bzw. erstes Dreieck
+ * @param count Anzahl der Dreiecke bei Blaettern, sonst 0
+ * @param nodeCount Anzahl der Knoten des Baums
+ * @param faceCount Anzahl der Dreiecke
+ * @param depths Tiefe je Knoten, die Tiefe des Kindes wird eingetragen
+ * @return GL_TRUE, wenn das Kind gueltig ist
+ */
+static GLboolean meshCache_validChild(GLint parent, GLint child, GLint count, GLint nodeCount, GLint faceCount,
+                                      GLint *depths);
+
+/**
+ * Prueft alle Indizes eines gemappten Objektes (Dreiecke, Knoten aller Layouts und Dreiecksbloecke),
+ * damit eine beschaedigte oder fremde Mesh-Datei beim Traversieren nicht ausserhalb der Arrays liest
+ * @param obj Objekt, dessen Arrays in die Mesh-Datei zeigen
+ * @return GL_TRUE, wenn alle Indizes gueltig sind
+ */
+static GLboolean meshCache_validate(const object *obj);
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION ---------------------------------------*/
+
+static char *meshCache_path(const char *objPath) {
+    size_t length = strlen(objPath);
+    char *base = malloc(length + 1);
+    if (base == NULL) {
+        printf("Couldn't create mesh cache path\n");
+        exit(1);
+    }
+    strcpy(base, objPath);
+    if (length >= 4 && strcmp(base + length - 4, ".obj") == 0) {
+        base[length - 4] = '\0';
+    }
+    char *result = utils_concatStrings(base, MESH_CACHE_EXTENSION);
+    free(base);
+    return result;
+}
+
+static void meshCache_initHeader(meshCacheHeader *header) {
+    //Auch die Fuellbytes, damit die Datei bei gleichem Mesh gleich bleibt
+    memset(header, 0, sizeof(*header));
+    header->magic = MESH_CACHE_MAGIC;
+    header->version = MESH_CACHE_VERSION;
+    header->byteOrder = MESH_CACHE_BYTE_ORDER;
+    header->quantBits = BVH_QUANT_BITS;
+    header->maxLeafSize = BVH_MAX_LEAF_SIZE;
+    header->maxDepth = BVH_MAX_DEPTH;
+    header->typeSizes[0] = sizeof(vec3);
+    header->typeSizes[1] = sizeof(triangleTM);
+    header->typeSizes[2] = sizeof(faces);
+    header->typeSizes[3] = sizeof(bvhNode);
+    header->typeSizes[4] = sizeof(bvh4Node);
+    header->typeSizes[5] = sizeof(bvh8Node);
+    header->typeSizes[6] = sizeof(triangleBlock4);
+    header->typeSizes[7] = sizeof(triangleBlock8);
+    header->typeSizes[8] = sizeof(bvhQuantNode);
+    header->typeSizes[9] = sizeof(bvhStats);
+    header->typeSizes[10] = sizeof(boundingVolume);
+    header->typeSizes[11] = sizeof(meshCacheHeader);
+}
+
+static void meshCache_sections(object *obj, meshCacheSection *sections) {
+    sections[0].data = (void **) &obj->vertices;
+    sections[0].size = obj->vertexCount * sizeof(vec3);
+    //Nur mit allen Layouts gibt es triangleTM Records
+    sections[1].data = (void **) &obj->facesTM;
+    sections[1].size = obj->bvh.compressedOnly ? 0 : obj->faceCount * sizeof(triangleTM);
+    sections[2].data = (void **) &obj->indices;
+    sections[2].size = obj->faceCount * sizeof(faces);
+    sections[3].data = (void **) &obj->bvh.nodes;
+    sections[3].size = obj->bvh.nodeCount * sizeof(bvhNode);
+    sections[4].data = (void **) &obj->bvh.nodes4;
+    sections[4].size = obj->bvh.nodeCount4 * sizeof(bvh4Node);
+    sections[5].data = (void **) &obj->bvh.nodes8;
+    sections[5].size = obj->bvh.nodeCount8 * sizeof(bvh8Node);
+    sections[6].data = (void **) &obj->bvh.blocks4;
+    sections[6].size = obj->bvh.blockCount4 * sizeof(triangleBlock4);
+    //Erster Block je Blatt, indiziert ueber das erste Dreieck (nur mit Bloecken)
+    sections[7].data = (void **) &obj->bvh.leafBlock4;
+    sections[7].size = obj->bvh.blockCount4 > 0 ? obj->faceCount * sizeof(GLint) : 0;
+    sections[8].data = (void **) &obj->bvh.blocks8;
+    sections[8].size = obj->bvh.blockCount8 * sizeof(triangleBlock8);
+    sections[9].data = (void **) &obj->bvh.leafBlock8;
+    sections[9].size = obj->bvh.blockCount8 > 0 ? obj->faceCount * sizeof(GLint) : 0;
+    sections[10].data = (void **) &obj->bvh.nodesQ;
+    sections[10].size = obj->bvh.nodeCountQ * sizeof(bvhQuantNode);
+}
+
+static unsigned long long meshCache_align(unsigned long long offset) {
+    return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+static char *meshCache_tempPath(const char *path) {
+    char suffix[32];
+#ifdef WIN32
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", _getpid());
+#else
+    snprintf(suffix, sizeof(suffix), ".%ld.tmp", (long) getpid());
+#endif
+    return utils_concatStrings(path, suffix);
+}
+
+static GLboolean meshCache_validChild(GLint parent, GLint child, GLint count, GLint nodeCount, GLint faceCount,
+                                      GLint *depths) {
+    if (count > 0) {
+        return child >= 0 && child < faceCount && count <= faceCount - child;
+    }
+    if (count < 0 || child <= parent || child >= nodeCount || depths[parent] >= BVH_MAX_DEPTH) {
+        return GL_FALSE;
+    }
+    //Ein Knoten mit mehreren Eltern zaehlt mit seiner groessten Tiefe
+    if (depths[parent] + 1 > depths[child]) {
+        depths[child] = depths[parent] + 1;
+    }
+    return GL_TRUE;
+}
+
+static GLboolean meshCache_validate(const object *obj) {
+    const bvh *tree = &obj->bvh;
+    GLint faceCount = obj->faceCount;
+
+    if (obj->indices != NULL) {
+        for (int i = 0; i < faceCount; ++i) {
+            const faces *tri = &obj->indices[i];
+            if (tri->index1 < 0 || tri->index1 >= obj->vertexCount || tri->index2 < 0 ||
+                tri->index2 >= obj->vertexCount || tri->index3 < 0 || tri->index3 >= obj->vertexCount) {
+                return GL_FALSE;
+            }
+        }
+    }
+
+    //Groesster Baum bestimmt den Speicher fuer die Tiefen, die Kinder liegen immer hinter den Eltern
+    GLint maxNodes = tree->nodeCount;
+    maxNodes = tree->nodeCount4 > maxNodes ? tree->nodeCount4 : maxNodes;
+    maxNodes = tree->nodeCount8 > maxNodes ? tree->nodeCount8 : maxNodes;
+    maxNodes = tree->nodeCountQ > maxNodes ? tree->nodeCountQ : maxNodes;
+    GLint *depths = (GLint *) malloc(maxNodes * sizeof(GLint));
+    if (depths == NULL) {
+        printf("Couldn't validate mesh cache\n");
+        exit(1);
+    }
+    GLboolean valid = GL_TRUE;
+
+    //Nur die komprimierte BVH: die Wurzel liefert nur ihre Box, ist sie kein Blatt, muss es quantisierte Knoten geben
+    if (tree->compressedOnly) {
+        valid = obj->indices != NULL && tree->nodeCount == 1 && (tree->nodes[0].count > 0 || tree->nodeCountQ > 0);
+    }
+
+    //Binaerer Baum, Blaetter werden direkt am Knoten geprueft (auch die Wurzel kann ein Blatt sein)
+    memset(depths, 0, tree->nodeCount * sizeof(GLint));
+    for (int n = 0; n < tree->nodeCount && valid; ++n) {
+        const bvhNode *node = &tree->nodes[n];
+        if (node->count == 0 && tree->compressedOnly) {
+            continue;
+        } else if (node->count == 0) {
+            valid = meshCache_validChild(n, node->leftFirst, 0, tree->nodeCount, faceCount, depths) &&
+                    meshCache_validChild(n, node->leftFirst + 1, 0, tree->nodeCount, faceCount, depths);
+        } else {
+            valid = meshCache_validChild(n, node->leftFirst, node->count, tree->nodeCount, faceCount, depths);
+        }
+    }
+
+    //Weite Baeume, leere Kinder haben den Index -1 und NaN Bounds
+    for (int width = 4; width <= 8 && valid; width += 4) {
+        GLint nodeCount = width == 4 ? tree->nodeCount4 : tree->nodeCount8;
+        memset(depths, 0, nodeCount * sizeof(GLint));
+        for (int n = 0; n < nodeCount && valid; ++n) {
+            const GLfloat *bounds = width == 4 ? &tree->nodes4[n].bounds[0][0] : &tree->nodes8[n].bounds[0][0];
+            const GLint *child = width == 4 ? tree->nodes4[n].child : tree->nodes8[n].child;
+            const GLint *count = width == 4 ? tree->nodes4[n].count : tree->nodes8[n].count;
+            for (int i = 0; i < width && valid; ++i) {
+                if (child[i] < 0) {
+                    valid = count[i] == 0;
+                    for (int row = 0; row < 6 && valid; ++row) {
+                        valid = bounds[row * width + i] != bounds[row * width + i];
+                    }
+                } else {
+                    valid = meshCache_validChild(n, child[i], count[i], nodeCount, faceCount, depths);
+                }
+            }
+        }
+    }
+
+    //Quantisierter Baum, referenziert indizierte Dreiecke
+    memset(depths, 0, tree->nodeCountQ * sizeof(GLint));
+    for (int n = 0; n < tree->nodeCountQ && valid; ++n) {
+        for (int c = 0; c < 2 && valid; ++c) {
+            valid = obj->indices != NULL && meshCache_validChild(n, tree->nodesQ[n].child[c], tree->nodesQ[n].count[c],
+                                                                 tree->nodeCountQ, faceCount, depths);
+        }
+    }
+    free(depths);
+
+    //Dreiecksbloecke: jedes Blatt braucht seine Bloecke, jede Spur ein gueltiges Dreieck oder -1 (leer)
+    for (int width = 4; width <= 8 && valid; width += 4) {
+        const GLint *leafBlock = width == 4 ? tree->leafBlock4 : tree->leafBlock8;
+        GLint blockCount = width == 4 ? tree->blockCount4 : tree->blockCount8;
+        if (leafBlock == NULL) {
+            continue;
+        }
+        for (int n = 0; n < tree->nodeCount && valid; ++n) {
+            const bvhNode *node = &tree->nodes[n];
+            if (node->count > 0) {
+                GLint first = leafBlock[node->leftFirst];
+                valid = first >= 0 && first < blockCount && (node->count + width - 1) / width <= blockCount - first;
+            }
+        }
+        for (int b = 0; b < blockCount && valid; ++b) {
+            const GLint *idx = width == 4 ? tree->blocks4[b].idx : tree->blocks8[b].idx;
+            for (int lane = 0; lane < width && valid; ++lane) {
+                valid = idx[lane] >= -1 && idx[lane] < faceCount;
+            }
+        }
+    }
+    return valid;
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+GLboolean meshCache_load(const char *objPath, object *result, GLboolean compressedOnly) {
+    char *path = meshCache_path(objPath);
+    size_t size = 0;
+    char *data = (char *) utils_mapFile(path, &size);
+    free(path);
+    if (data == NULL) {
+        return GL_FALSE;
+    }
+
+    //Kopf gegen dieses Programm und die aktuelle .obj Datei pruefen
+    meshCacheHeader expected;
+    meshCache_initHeader(&expected);
+    const meshCacheHeader *header = (const meshCacheHeader *) data;
+    long long objSize = 0;
+    long long objModified = 0;
+    GLboolean valid = size >= sizeof(meshCacheHeader) && header->magic == expected.magic &&
+                      header->version == expected.version && header->byteOrder == expected.byteOrder &&
+                      header->quantBits == expected.quantBits && header->maxLeafSize == expected.maxLeafSize &&
+                      header->maxDepth == expected.maxDepth && header->compressedOnly == (compressedOnly ? 1u : 0u) &&
+                      memcmp(header->typeSizes, expected.typeSizes, sizeof(expected.typeSizes)) == 0;
+    //Ohne .obj Datei wird die Mesh-Datei allein verwendet
+    if (valid && utils_fileStamp(objPath, &objSize, &objModified)) {
+        valid = header->objSize == objSize && header->objModified == objModified;
+    }
+    valid = valid && header->vertexCount > 0 && header->faceCount > 0 && header->nodeCount > 0 &&
+            header->nodeCount4 >= 0 && header->nodeCount8 >= 0 && header->blockCount4 >= 0 &&
+            header->blockCount8 >= 0 && header->nodeCountQ >= 0;
+    if (!valid) {
+        utils_unmapFile(data, size);
+        return GL_FALSE;
+    }
+
+    object obj = *result;
+    obj.vertexCount = header->vertexCount;
+    obj.faceCount = header->faceCount;
+    obj.bvh.nodeCount = header->nodeCount;
+    obj.bvh.nodeCount4 = header->nodeCount4;
+    obj.bvh.nodeCount8 = header->nodeCount8;
+    obj.bvh.blockCount4 = header->blockCount4;
+    obj.bvh.blockCount8 = header->blockCount8;
+    obj.bvh.nodeCountQ = header->nodeCountQ;
+    obj.bvh.compressedOnly = compressedOnly;
+    obj.bvh.stats = header->stats;
+    obj.bounds = header->bounds;
+
+    //Zeiger direkt in die Abschnitte setzen, jeder Abschnitt muss ganz in der Datei liegen
+    meshCacheSection sections[MESH_CACHE_SECTIONS];
+    meshCache_sections(&obj, sections);
+    for (int i = 0; i < MESH_CACHE_SECTIONS && valid; ++i) {
+        unsigned long long offset = header->offsets[i];
+        if (offset == 0) {
+            *sections[i].data = NULL;
+        } else if (offset % MESH_CACHE_ALIGNMENT != 0 || offset > size || sections[i].size > size - offset) {
+            valid = GL_FALSE;
+        } else {
+            *sections[i].data = data + offset;
+        }
+        //Zaehler ohne zugehoerigen Abschnitt
+        if (valid && *sections[i].data == NULL && sections[i].size > 0) {
+            valid = GL_FALSE;
+        }
+    }
+    //Ohne diese Arrays kann das Mesh nicht traversiert werden, die Indizes werden zuletzt geprueft
+    valid = valid && obj.vertices != NULL && (obj.facesTM != NULL || compressedOnly) && obj.bvh.nodes != NULL &&
+            meshCache_validate(&obj);
+    if (!valid) {
+        utils_unmapFile(data, size);
+        return GL_FALSE;
+    }
+
+    obj.mapping = data;
+    obj.mappingSize = size;
+    *result = obj;
+    return GL_TRUE;
+}
+
+void meshCache_write(const char *objPath, const object *obj) {
+    static const char padding[MESH_CACHE_ALIGNMENT] = {0};
+
+    meshCacheHeader header;
+    meshCache_initHeader(&header);
+    if (!utils_fileStamp(objPath, &header.objSize, &header.objModified)) {
+        return;
+    }
+    header.vertexCount = obj->vertexCount;
+    header.faceCount = obj->faceCount;
+    header.nodeCount = obj->bvh.nodeCount;
+    header.nodeCount4 = obj->bvh.nodeCount4;
+    header.nodeCount8 = obj->bvh.nodeCount8;
+    header.blockCount4 = obj->bvh.blockCount4;
+    header.blockCount8 = obj->bvh.blockCount8;
+    header.nodeCountQ = obj->bvh.nodeCountQ;
+    header.compressedOnly = obj->bvh.compressedOnly ? 1u : 0u;
+    header.stats = obj->bvh.stats;
+    header.bounds = obj->bounds;
+
+    //Abschnitte hintereinander und ausgerichtet hinter dem Kopf anordnen
+    object copy = *obj;
+    meshCacheSection sections[MESH_CACHE_SECTIONS];
+    meshCache_sections(&copy, sections);
+    unsigned long long offset = meshCache_align(sizeof(header));
+    for (int i = 0; i < MESH_CACHE_SECTIONS; ++i) {
+        if (*sections[i].data != NULL && sections[i].size > 0) {
+            header.offsets[i] = offset;
+            offset = meshCache_align(offset + sections[i].size);
+        }
+    }
+
+    char *path = meshCache_path(objPath);
+    char *tempPath = meshCache_tempPath(path);
+    FILE *file = fopen(tempPath, "wb");
+    GLboolean written = file != NULL && fwrite(&header, sizeof(header), 1, file) == 1;
+    unsigned long long position = sizeof(header);
+    for (int i = 0; i < MESH_CACHE_SECTIONS && written; ++i) {
+        if (header.offsets[i] == 0) {
+            continue;
+        }
+        written = fwrite(padding, 1, header.offsets[i] - position, file) == header.offsets[i] - position &&
+                  fwrite(*sections[i].data, sections[i].size, 1, file) == 1;
+        position = header.offsets[i] + sections[i].size;
+    }
+    if (file != NULL && fclose(file) != 0) {
+        written = GL_FALSE;
+    }
+#ifdef WIN32
+    //rename ersetzt unter Windows keine vorhandene Datei
+    if (written) {
+        remove(path);
+    }
+#endif
+    if (!written || rename(tempPath, path) != 0) {
+        printf("Couldn't write mesh cache %s\n", path);
+        remove(tempPath);
+    }
+    free(tempPath);
+    free(path);
+}
@@ -0,0 +1,26 @@
+#ifndef RAYTRACER_MESHCACHE_H
+#define RAYTRACER_MESHCACHE_H
+#include "types.h"
+
+/**
+ * Laedt ein Mesh aus der Mesh-Datei neben einer .obj oder .ply Datei. Die Datei wird nur verwendet, wenn sie
+ * zur aktuellen Quelldatei (Groesse und Aenderungszeitpunkt), zu den Typen und Parametern dieses Programms passt
+ * und alle Indizes der Baeume gueltig sind.
+ * Alle Arrays des Objektes zeigen danach direkt in die gemappte Datei (object.mapping).
+ * @param objPath Pfad der Quelldatei
+ * @param result Ausgabe, geladenes Mesh mit BVH und Bounding Volumes
+ * @param compressedOnly GL_TRUE, wenn die Mesh-Datei nur die komprimierte BVH enthalten muss, sonst alle Layouts
+ * @return GL_FALSE, wenn keine passende Mesh-Datei existiert, result bleibt dann unveraendert
+ */
+GLboolean meshCache_load(const char *objPath, object *result, GLboolean compressedOnly);
+
+/**
+ * Schreibt ein fertig aufgebautes Mesh als Mesh-Datei neben die Quelldatei. Die Datei wird erst
+ * unter einem temporaeren Namen (mit Prozess-ID) geschrieben und dann umbenannt, damit nie eine halbe Datei gelesen wird.
+ * Fehler werden gemeldet, das Mesh bleibt davon unberuehrt.
+ * @param objPath Pfad der Quelldatei
+ * @param obj Mesh mit BVH
+ */
+void meshCache_write(const char *objPath, const object *obj);
+
+#endif //RAYTRACER_MESHCACHE_H
@@ -1,13 +1,77 @@
 /**
  * @file
- * Implementiert Multithreading und teilt jedem Runner seinen Bereich der Szene
- * zu, die dieser rendern soll
+ * Implementiert Multithreading und zerlegt das Bild in kleine Tiles, die als Jobs
+ * gerendert werden. Zusaetzlich gibt es ein einfaches Job System mit dauerhaft laufenden Hilfsthreads,
+ * ueber das unabhaengige Aufgaben (z.B. Teilbaeume der BVH) parallel abgearbeitet werden. Auftraege
+ * duerfen aus Jobs heraus verschachtelt werden und teilen sich dieselben Threads.
+ * Gerendert wird ueber einen persistenten Pool, dessen Threads zwischen den Frames schlafen
+ * und sich die Tiles ueber Work Stealing gegenseitig abnehmen. Die gemessenen Renderzeiten
+ * eines Frames bestimmen Groesse und Reihenfolge der Tiles im naechsten Frame.
+ * Auf Systemen mit mehreren Sockeln koennen die Threads an Kerne gebunden werden, die Framebuffer
+ * werden von den Threads zuerst beschrieben, die ihre Tiles rendern.
  *
  * @author Christopher Ploog, Mario da Graca
  */
 
+#ifdef __linux__
+//Fuer pthread_setaffinity_np und die CPU_* Makros
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifndef WIN32
+#include <unistd.h>
+#include <time.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
 #include "multiThreading.h"
 
+/** Auftrag eines multiThreading_runJobs Aufrufs, liegt bis zu dessen Ende auf dem Stack des Aufrufers */
+typedef struct multiThreadBatch {
+    GLint nextJob;
+    GLint jobCount;
+    /** Anzahl der abgeschlossenen Jobs */
+    GLint finished;
+    /** Anzahl der gerade laufenden Jobs, hoechstens threadCount */
+    GLint running;
+    GLint threadCount;
+    multiThreadJob job;
+    void *ctx;
+    /** Naechst aelterer Auftrag */
+    struct multiThreadBatch *next;
+} multiThreadBatch;
+
+/** Gemeinsame Hilfsthreads aller (auch verschachtelter) multiThreading_runJobs Aufrufe */
+typedef struct multiThreadJobSystem {
+    /** Schuetzt alle Felder und die Zaehler der Auftraege */
+    pthread_mutex_t lock;
+    /** Signalisiert neue Auftraege und abgeschlossene Jobs */
+    pthread_cond_t changed;
+    pthread_t *threads;
+    GLint threadCount;
+    GLboolean started;
+    GLboolean shutdown;
+    /** Offene Auftraege, der neueste zuerst */
+    multiThreadBatch *batches;
+} multiThreadJobSystem;
+
+/** Hilfsthreads fuer multiThreading_runJobs, werden beim ersten Aufruf gestartet */
+static multiThreadJobSystem g_jobSystem = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0,
+                                           GL_FALSE, GL_FALSE, NULL};
+
+/** Kontext der First Touch Jobs */
+typedef struct multiThreadTouch {
+    Color *buffer;
+    /** Anzahl Threads, auf die die gleichmaessigen Tiles verteilt werden */
+    GLint threads;
+} multiThreadTouch;
+
+
 /**
  * Erstellt einen Multithread Runner fuer ein Bereich der zu rendernden Szene
  * @param tileCol Start Pixel Reihe des Tiles
@@ -23,71 +87,777 @@ static multiThreadRunner multiThreading_initRunner(GLint tileCol, GLint tileWidt
 
     result.tileRow = tileRow;
     result.tileCol = tileCol;
+    result.cost = 0.0f;
+
+    return result;
+}
+
+/**
+ * Bestimmt den Thread, dem ein gleichmaessiges Tile gehoert: der Bereich, in den multiThreading_poolRun
+ * den Index verteilt. Auf diesen Thread wird der Framebuffer des Tiles zuerst geschrieben und die
+ * kostengesteuerte Aufteilung laesst das Tile moeglichst dort.
+ * @param tileIdx Index des gleichmaessigen Tiles
+ * @param tileCount Anzahl gleichmaessiger Tiles
+ * @param threads Anzahl Threads
+ * @return Index des Threads
+ */
+static GLint multiThreading_homeThread(GLint tileIdx, GLint tileCount, GLint threads) {
+    GLint result = 0;
+    while (result < threads - 1 && tileIdx >= (GLint) ((long) tileCount * (result + 1) / threads)) {
+        result++;
+    }
+    return result;
+}
 
+/**
+ * Erstellt ein Tile, das am Bildrand abgeschnitten wird
+ * @param col Start Pixel Reihe
+ * @param row Start Pixel Spalte
+ * @param size gewuenschte Kantenlaenge
+ * @return Tile
+ */
+static multiThreadRunner multiThreading_clippedTile(GLint col, GLint row, GLint size) {
+    GLint width = DEFAULT_WINDOW_WIDTH - col < size ? DEFAULT_WINDOW_WIDTH - col : size;
+    GLint height = DEFAULT_WINDOW_HEIGHT - row < size ? DEFAULT_WINDOW_HEIGHT - row : size;
+    return multiThreading_initRunner(col, width, row, height);
+}
+
+/**
+ * Summiert die Kosten aller Zellen, die ein Tile ueberdeckt
+ * @param cellCosts Kostenkarte
+ * @param tile Tile
+ * @return geschaetzte Kosten des Tiles
+ */
+static GLfloat multiThreading_tileCost(const GLfloat *cellCosts, const multiThreadRunner *tile) {
+    GLfloat result = 0.0f;
+    for (int y = tile->tileRow / MULTI_THREAD_COST_CELL;
+         y * MULTI_THREAD_COST_CELL < tile->tileRow + tile->tileHeight; ++y) {
+        for (int x = tile->tileCol / MULTI_THREAD_COST_CELL;
+             x * MULTI_THREAD_COST_CELL < tile->tileCol + tile->tileWidth; ++x) {
+            result += cellCosts[OFFSET2D(MULTI_THREAD_CELLS_X, x, y)];
+        }
+    }
     return result;
 }
 
 /**
- * Initialisiert die Argumente fuer einen Thread
+ * Vergleicht zwei Tiles absteigend nach ihren Kosten (fuer qsort)
+ */
+static int multiThreading_compareCost(const void *a, const void *b) {
+    GLfloat costA = ((const multiThreadRunner *) a)->cost;
+    GLfloat costB = ((const multiThreadRunner *) b)->cost;
+    return (costA < costB) - (costA > costB);
+}
+
+/**
+ * Zerlegt das Bild zeilenweise in gleich grosse Tiles der Groesse MULTI_THREAD_TILE_SIZE
+ * @param opts Multithreading Optionen
+ */
+static void multiThreading_uniformTiles(multiThreadOpts *opts) {
+    GLint tilesX = (DEFAULT_WINDOW_WIDTH + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE;
+    GLint tilesY = (DEFAULT_WINDOW_HEIGHT + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE;
+    opts->tileCount = tilesX * tilesY;
+
+    //Benachbarte Tiles liegen hintereinander, so bekommt jeder Thread zu Beginn einen zusammenhaengenden Streifen
+    for (int y = 0; y < tilesY; ++y) {
+        for (int x = 0; x < tilesX; ++x) {
+            opts->tiles[OFFSET2D(tilesX, x, y)] = multiThreading_clippedTile(x * MULTI_THREAD_TILE_SIZE,
+                                                                             y * MULTI_THREAD_TILE_SIZE,
+                                                                             MULTI_THREAD_TILE_SIZE);
+        }
+    }
+}
+
+/**
+ * Erstellt die Tiles anhand der Kostenkarte: teure Tiles werden in Zellen zerlegt und alle Tiles
+ * so auf die Bereiche der Threads (siehe multiThreading_poolRun) verteilt, dass jeder Thread
+ * aehnliche Kosten erhaelt und seine teuersten Tiles zuerst rendert. Solange es die Kosten erlauben,
+ * bleibt ein Tile beim Thread, dem es in der gleichmaessigen Aufteilung gehoert (dort liegt sein
+ * Framebuffer im lokalen Speicher), nur der Ueberhang wandert zu weniger belasteten Threads.
+ * @param opts Multithreading Optionen mit gueltiger Kostenkarte
+ */
+static void multiThreading_costGuidedTiles(multiThreadOpts *opts) {
+    GLint tilesX = (DEFAULT_WINDOW_WIDTH + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE;
+    GLint tilesY = (DEFAULT_WINDOW_HEIGHT + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE;
+    GLint cellsPerTile = MULTI_THREAD_TILE_SIZE / MULTI_THREAD_COST_CELL;
+
+    GLfloat total = 0.0f;
+    for (int i = 0; i < MULTI_THREAD_CELLS_X * MULTI_THREAD_CELLS_Y; ++i) {
+        total += opts->cellCosts[i];
+    }
+    GLfloat splitCost = MULTI_THREAD_SPLIT_FACTOR * total / (GLfloat) (tilesX * tilesY);
+
+    multiThreadRunner *candidates = (multiThreadRunner *) malloc(MULTI_THREAD_CELLS_X * MULTI_THREAD_CELLS_Y *
+                                                                 sizeof(multiThreadRunner));
+    if (candidates == NULL) {
+        printf("Error allocating tiles!\n");
+        exit(1);
+    }
+
+    //Teure Tiles in Zellen zerlegen, damit sie sich auf mehrere Threads verteilen lassen
+    GLint count = 0;
+    for (int y = 0; y < tilesY; ++y) {
+        for (int x = 0; x < tilesX; ++x) {
+            multiThreadRunner tile = multiThreading_clippedTile(x * MULTI_THREAD_TILE_SIZE, y * MULTI_THREAD_TILE_SIZE,
+                                                                MULTI_THREAD_TILE_SIZE);
+            tile.cost = multiThreading_tileCost(opts->cellCosts, &tile);
+            if (tile.cost <= splitCost) {
+                candidates[count++] = tile;
+                continue;
+            }
+            for (int cy = 0; cy < cellsPerTile; ++cy) {
+                for (int cx = 0; cx < cellsPerTile; ++cx) {
+                    GLint col = tile.tileCol + cx * MULTI_THREAD_COST_CELL;
+                    GLint row = tile.tileRow + cy * MULTI_THREAD_COST_CELL;
+                    if (col < DEFAULT_WINDOW_WIDTH && row < DEFAULT_WINDOW_HEIGHT) {
+                        candidates[count] = multiThreading_clippedTile(col, row, MULTI_THREAD_COST_CELL);
+                        candidates[count].cost = multiThreading_tileCost(opts->cellCosts, &candidates[count]);
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+    qsort(candidates, count, sizeof(multiThreadRunner), multiThreading_compareCost);
+
+    //Absteigend dem Heimat-Thread geben, solange er Platz hat und seinen Anteil nicht ueberschreitet,
+    //sonst dem Thread mit den geringsten bisherigen Kosten, der noch Platz hat.
+    //Die Bereiche entsprechen der Aufteilung in multiThreading_poolRun.
+    GLint threads = opts->pool.threadCount > 0 ? opts->pool.threadCount : 1;
+    GLfloat share = total / (GLfloat) threads;
+    GLfloat *load = (GLfloat *) calloc(threads, sizeof(GLfloat));
+    GLint *fill = (GLint *) calloc(threads, sizeof(GLint));
+    if (load == NULL || fill == NULL) {
+        printf("Error allocating tiles!\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; ++i) {
+        GLint home = multiThreading_homeThread(OFFSET2D(tilesX, candidates[i].tileCol / MULTI_THREAD_TILE_SIZE,
+                                                        candidates[i].tileRow / MULTI_THREAD_TILE_SIZE),
+                                               tilesX * tilesY, threads);
+        GLint homeSize = (GLint) ((long) count * (home + 1) / threads - (long) count * home / threads);
+        GLint best = -1;
+        if (fill[home] < homeSize && load[home] + candidates[i].cost <= share) {
+            best = home;
+        }
+        for (int t = 0; best != home && t < threads; ++t) {
+            GLint size = (GLint) ((long) count * (t + 1) / threads - (long) count * t / threads);
+            if (fill[t] < size && (best < 0 || load[t] < load[best])) {
+                best = t;
+            }
+        }
+        opts->tiles[(long) count * best / threads + fill[best]++] = candidates[i];
+        load[best] += candidates[i].cost;
+    }
+    opts->tileCount = count;
+
+    free(load);
+    free(fill);
+    free(candidates);
+}
+
+/**
+ * Reserviert die Tiles und die Kostenkarte und zerlegt das Bild gleichmaessig
  * @param scene Aktuelle Szene
- * @param horiThreads Anzahl der horizontalen Threads
- * @param vertThreads Anzahl der vertikalen Threads
  * */
-static void multiThreading_initThread(scene *scene, GLint horiThreads, GLint vertThreads) {
-    //Allgemeine Infos ueber das Szene und das zu rendernde Bild
-    scene->multiThreadOpts.useMultiThreading = GL_TRUE;
-    scene->multiThreadOpts.horizontalThreads = horiThreads;
-    scene->multiThreadOpts.tileWidth = DEFAULT_WINDOW_WIDTH / scene->multiThreadOpts.horizontalThreads;
-    scene->multiThreadOpts.verticalThreads = vertThreads;
-    scene->multiThreadOpts.tileHeight = DEFAULT_WINDOW_HEIGHT / scene->multiThreadOpts.verticalThreads;
+static void multiThreading_initTiles(scene *scene) {
+    multiThreadOpts *opts = &scene->multiThreadOpts;
+
+    //Speicher reservieren (Tiles einer vorherigen Einstellung verwerfen), hoechstens ein Tile pro Zelle
+    free(opts->tiles);
+    free(opts->cellCosts);
+    opts->tiles = (multiThreadRunner *) calloc(MULTI_THREAD_CELLS_X * MULTI_THREAD_CELLS_Y,
+                                               sizeof(multiThreadRunner));
+    opts->cellCosts = (GLfloat *) calloc(MULTI_THREAD_CELLS_X * MULTI_THREAD_CELLS_Y, sizeof(GLfloat));
+    if (opts->tiles == NULL || opts->cellCosts == NULL) {
+        printf("Error allocating tiles!\n");
+        exit(1);
+    }
+    opts->hasCosts = GL_FALSE;
+    multiThreading_uniformTiles(opts);
+}
+
+/**
+ * Sucht einen Auftrag mit einem freien Job, muss unter der Sperre des Job Systems aufgerufen werden
+ * @param first neuester Auftrag, ab dem gesucht wird
+ * @param last aeltester Auftrag, der noch betrachtet wird (NULL fuer alle)
+ * @return Auftrag, NULL wenn keiner einen Job frei hat
+ */
+static multiThreadBatch *multiThreading_findBatch(multiThreadBatch *first, const multiThreadBatch *last) {
+    for (multiThreadBatch *batch = first; batch != NULL; batch = batch->next) {
+        if (batch->nextJob < batch->jobCount && batch->running < batch->threadCount) {
+            return batch;
+        }
+        if (batch == last) {
+            break;
+        }
+    }
+    return NULL;
+}
 
-    //Speicher reservieren
-    scene->multiThreadOpts.threadArgs = (multiThreadRunner *) calloc(scene->multiThreadOpts.horizontalThreads *
-                                                                     scene->multiThreadOpts.verticalThreads,
-                                                                     sizeof(multiThreadRunner));
+/**
+ * Arbeitet den naechsten Job eines Auftrags ab. Wird unter der Sperre des Job Systems aufgerufen,
+ * die waehrend des Jobs freigegeben wird, und kehrt wieder mit der Sperre zurueck.
+ * @param batch Auftrag mit freiem Job
+ */
+static void multiThreading_runBatchJob(multiThreadBatch *batch) {
+    GLint idx = batch->nextJob++;
+    batch->running++;
+    pthread_mutex_unlock(&g_jobSystem.lock);
 
-    //Jedem Runner seinen Bereich der Szene zuordnen und im Array speichern
-    for (int y = 0; y < scene->multiThreadOpts.verticalThreads; ++y) {
-        for (int x = 0; x < scene->multiThreadOpts.horizontalThreads; ++x) {
-            scene->multiThreadOpts.threadArgs[OFFSET2D(scene->multiThreadOpts.horizontalThreads, x, y)] =
-                    multiThreading_initRunner(x * scene->multiThreadOpts.tileWidth, scene->multiThreadOpts.tileWidth,
-                                              y * scene->multiThreadOpts.tileHeight, scene->multiThreadOpts.tileHeight);
+    batch->job(idx, batch->ctx);
+
+    pthread_mutex_lock(&g_jobSystem.lock);
+    batch->running--;
+    batch->finished++;
+    //Weckt den Aufrufer und Threads, die auf einen freien Platz im Auftrag warten
+    pthread_cond_broadcast(&g_jobSystem.changed);
+}
+
+/**
+ * Arbeitsschleife eines Hilfsthreads: arbeitet Jobs aller offenen Auftraege ab (die neuesten zuerst,
+ * damit verschachtelte Auftraege ihre aeusseren Jobs schnell freigeben) und schlaeft, wenn keiner offen ist.
+ * @param args nicht verwendet
+ * @return NULL
+ */
+static void *multiThreading_jobWorker(void *args) {
+    (void) args;
+    pthread_mutex_lock(&g_jobSystem.lock);
+    while (!g_jobSystem.shutdown) {
+        multiThreadBatch *batch = multiThreading_findBatch(g_jobSystem.batches, NULL);
+        if (batch != NULL) {
+            multiThreading_runBatchJob(batch);
+        } else {
+            pthread_cond_wait(&g_jobSystem.changed, &g_jobSystem.lock);
         }
     }
+    pthread_mutex_unlock(&g_jobSystem.lock);
+    return NULL;
 }
 
-void multiThreading_setupThreading(scene *scene) {
-    GLint horiThreads;
-    GLint vertThreads;
-    //Thread Anzahl in vertikale und horizontale Richtung aufteilen
-    switch (scene->multiThreadOpts.threadingOpts) {
-        case threads16:
-            horiThreads = 4;
-            vertThreads = 4;
-            break;
-        case threads8:
-            horiThreads = 4;
-            vertThreads = 2;
-            break;
-        case threads4:
-            horiThreads = 4;
-            vertThreads = 1;
-            break;
-        case threads2:
-            horiThreads = 2;
-            vertThreads = 1;
-            break;
-        case noMultiThreading:
-        default:
-            horiThreads = 0;
-            vertThreads = 0;
+/**
+ * Startet die Hilfsthreads des Job Systems (einen weniger als CPU Kerne, der Aufrufer arbeitet mit),
+ * muss unter der Sperre des Job Systems aufgerufen werden
+ */
+static void multiThreading_startJobSystem(void) {
+    GLint threadCount = multiThreading_cpuCount() - 1;
+    g_jobSystem.started = GL_TRUE;
+    g_jobSystem.shutdown = GL_FALSE;
+    g_jobSystem.threadCount = 0;
+    if (threadCount <= 0) {
+        return;
+    }
+
+    g_jobSystem.threads = (pthread_t *) calloc(threadCount, sizeof(pthread_t));
+    if (g_jobSystem.threads == NULL) {
+        printf("Error allocating threads!\n");
+        exit(1);
+    }
+    //Kann ein Thread nicht gestartet werden, arbeiten die Aufrufer dessen Jobs selbst ab
+    while (g_jobSystem.threadCount < threadCount &&
+           pthread_create(&g_jobSystem.threads[g_jobSystem.threadCount], NULL, multiThreading_jobWorker, NULL) == 0) {
+        g_jobSystem.threadCount++;
+    }
+    if (g_jobSystem.threadCount < threadCount) {
+        printf("Could only start %d of %d job threads!\n", g_jobSystem.threadCount, threadCount);
+    }
+}
+
+/**
+ * Beendet die Hilfsthreads des Job Systems, darf nur ohne offene Auftraege aufgerufen werden.
+ * Der naechste Aufruf von multiThreading_runJobs startet sie neu.
+ */
+static void multiThreading_stopJobSystem(void) {
+    pthread_mutex_lock(&g_jobSystem.lock);
+    if (!g_jobSystem.started) {
+        pthread_mutex_unlock(&g_jobSystem.lock);
+        return;
+    }
+    g_jobSystem.shutdown = GL_TRUE;
+    pthread_cond_broadcast(&g_jobSystem.changed);
+    pthread_mutex_unlock(&g_jobSystem.lock);
+
+    for (int i = 0; i < g_jobSystem.threadCount; ++i) {
+        pthread_join(g_jobSystem.threads[i], NULL);
+    }
+    free(g_jobSystem.threads);
+    g_jobSystem.threads = NULL;
+    g_jobSystem.threadCount = 0;
+    g_jobSystem.started = GL_FALSE;
+    g_jobSystem.shutdown = GL_FALSE;
+}
+
+/**
+ * Nimmt den naechsten Job vom Anfang der eigenen Deque
+ * @param deque eigene Deque
+ * @return Index des Jobs, -1 wenn die Deque leer ist
+ */
+static GLint multiThreading_popJob(multiThreadDeque *deque) {
+    GLint result = -1;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->top < deque->bottom) {
+        result = deque->top++;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return result;
+}
+
+/**
+ * Stiehlt die hintere Haelfte der Jobs eines anderen Threads und legt sie in die eigene Deque
+ * @param pool Pool
+ * @param id Index des stehlenden Threads
+ * @return GL_TRUE, wenn etwas gestohlen wurde
+ */
+static GLboolean multiThreading_stealJobs(multiThreadPool *pool, GLint id) {
+    //Beim rechten Nachbarn anfangen, damit sich die Diebe auf die Opfer verteilen
+    for (int i = 1; i < pool->threadCount; ++i) {
+        multiThreadDeque *victim = &pool->deques[(id + i) % pool->threadCount];
+
+        pthread_mutex_lock(&victim->lock);
+        GLint remaining = victim->bottom - victim->top;
+        GLint start = victim->bottom - (remaining + 1) / 2;
+        GLint end = victim->bottom;
+        if (remaining > 0) {
+            victim->bottom = start;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (remaining > 0) {
+            multiThreadDeque *own = &pool->deques[id];
+            pthread_mutex_lock(&own->lock);
+            own->top = start;
+            own->bottom = end;
+            pthread_mutex_unlock(&own->lock);
+            return GL_TRUE;
+        }
+    }
+    return GL_FALSE;
+}
+
+/**
+ * Bindet den aufrufenden Thread an einen einzelnen CPU Kern oder loest die Bindung wieder. Verwendet werden
+ * nur Kerne, auf denen der Prozess laufen darf; gibt es weniger Kerne als Threads, teilen sich Threads einen Kern.
+ * Ohne Unterstuetzung des Betriebssystems (z.B. macOS) bleibt der Thread ungebunden.
+ * @param id Index des Threads im Pool
+ * @param pinned GL_FALSE, wenn der Thread wieder auf allen Kernen des Prozesses laufen darf
+ */
+static void multiThreading_pinThread(GLint id, GLboolean pinned) {
+#if defined(__linux__)
+    //Kerne des Prozesses (Hauptthread), der aufrufende Thread kann bereits gebunden sein
+    cpu_set_t available;
+    if (sched_getaffinity(getpid(), sizeof(available), &available) != 0 || CPU_COUNT(&available) == 0) {
+        return;
+    }
+    if (!pinned) {
+        if (pthread_setaffinity_np(pthread_self(), sizeof(available), &available) != 0) {
+            printf("Could not unpin thread %d!\n", id);
+        }
+        return;
+    }
+
+    //Den (id % Anzahl)-ten erlaubten Kern suchen
+    GLint skip = id % CPU_COUNT(&available);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &available) && skip-- == 0) {
+            cpu_set_t single;
+            CPU_ZERO(&single);
+            CPU_SET(cpu, &single);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(single), &single) != 0) {
+                printf("Could not pin thread %d to cpu %d!\n", id, cpu);
+            }
+            return;
+        }
+    }
+#elif defined(WIN32)
+    DWORD_PTR processMask, systemMask;
+    if (!pinned) {
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) ||
+            SetThreadAffinityMask(GetCurrentThread(), processMask) == 0) {
+            printf("Could not unpin thread %d!\n", id);
+        }
+        return;
+    }
+    GLint cpu = id % multiThreading_cpuCount() % (GLint) (8 * sizeof(DWORD_PTR));
+    if (SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << cpu) == 0) {
+        printf("Could not pin thread %d to cpu %d!\n", id, cpu);
+    }
+#else
+    (void) id;
+    (void) pinned;
+#endif
+}
+
+/**
+ * Bindet einen Pool-Thread neu, Job von multiThreading_poolRunOnEach
+ * @param idx Index des Threads
+ * @param thread Index des Threads
+ * @param ctx GLboolean, GL_TRUE zum Binden
+ */
+static void multiThreading_pinJob(GLint idx, GLint thread, void *ctx) {
+    (void) idx;
+    multiThreading_pinThread(thread, *(const GLboolean *) ctx);
+}
+
+/**
+ * Leert die Pixel der gleichmaessigen Tiles, die einem Thread gehoeren (siehe multiThreading_homeThread),
+ * Job von multiThreading_poolRunOnEach.
+ * @param idx Index des Threads
+ * @param thread Index des Threads
+ * @param ctx multiThreadTouch
+ */
+static void multiThreading_touchTiles(GLint idx, GLint thread, void *ctx) {
+    (void) idx;
+    multiThreadTouch *touch = (multiThreadTouch *) ctx;
+    GLint tilesX = (DEFAULT_WINDOW_WIDTH + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE;
+    GLint tileCount = tilesX * ((DEFAULT_WINDOW_HEIGHT + MULTI_THREAD_TILE_SIZE - 1) / MULTI_THREAD_TILE_SIZE);
+    GLint first = (GLint) ((long) tileCount * thread / touch->threads);
+    GLint last = (GLint) ((long) tileCount * (thread + 1) / touch->threads);
+    Color *buffer = touch->buffer;
+    for (int t = first; t < last; ++t) {
+        multiThreadRunner tile = multiThreading_clippedTile((t % tilesX) * MULTI_THREAD_TILE_SIZE,
+                                                            (t / tilesX) * MULTI_THREAD_TILE_SIZE,
+                                                            MULTI_THREAD_TILE_SIZE);
+        for (int j = tile.tileRow; j < tile.tileRow + tile.tileHeight; ++j) {
+            memset(&buffer[OFFSET2D(DEFAULT_WINDOW_HEIGHT, tile.tileCol, j)], 0, tile.tileWidth * sizeof(Color));
+        }
+    }
+}
+
+/**
+ * Arbeitsschleife eines Pool-Threads: schlaeft bis zur naechsten Generation, arbeitet erst die
+ * eigenen Jobs ab, stiehlt dann bei den anderen und meldet sich zurueck, wenn nirgends mehr
+ * Jobs liegen. Laeuft, bis der Pool beendet wird.
+ * @param args multiThreadWorker
+ * @return NULL
+ */
+static void *multiThreading_poolWorker(void *args) {
+    multiThreadWorker *worker = (multiThreadWorker *) args;
+    multiThreadPool *pool = worker->pool;
+    GLuint seenGeneration = 0;
+
+    //Nicht mehr zwischen den Kernen wandern, damit Caches und lokaler Speicher beim Thread bleiben
+    if (pool->pinned) {
+        multiThreading_pinThread(worker->id, GL_TRUE);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->shutdown && pool->generation == seenGeneration) {
+            pthread_cond_wait(&pool->wakeUp, &pool->lock);
+        }
+        if (pool->shutdown) {
             break;
+        }
+        seenGeneration = pool->generation;
+        GLboolean each = pool->each;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (each) {
+            pool->job(worker->id, worker->id, pool->ctx);
+        } else {
+            do {
+                GLint idx;
+                while ((idx = multiThreading_popJob(&pool->deques[worker->id])) >= 0) {
+                    pool->job(idx, worker->id, pool->ctx);
+                }
+            } while (multiThreading_stealJobs(pool, worker->id));
+        }
+
+        //Der letzte fertige Thread weckt den Auftraggeber
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            pthread_cond_signal(&pool->done);
+        }
     }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+void multiThreading_setupThreading(scene *scene) {
+    GLint threadCount = scene->multiThreadOpts.threadingOpts == threadsAuto ? multiThreading_cpuCount()
+                                                                            : (GLint) scene->multiThreadOpts.threadingOpts;
+    scene->multiThreadOpts.threadCount = threadCount;
 
-    if(horiThreads >= 1 && vertThreads >= 1){
-        multiThreading_initThread(scene, horiThreads, vertThreads);
+    if (threadCount > 1) {
+        multiThreading_initTiles(scene);
         scene->multiThreadOpts.useMultiThreading = GL_TRUE;
+        //Pool nur neu starten, wenn sich die Anzahl der Threads geaendert hat, sonst hoechstens neu binden
+        multiThreading_poolStart(&scene->multiThreadOpts.pool, threadCount, scene->multiThreadOpts.pinThreads);
     } else {
         scene->multiThreadOpts.useMultiThreading = GL_FALSE;
     }
 }
+
+void multiThreading_runJobs(GLint jobCount, GLint threadCount, multiThreadJob job, void *ctx) {
+    if (threadCount > jobCount) {
+        threadCount = jobCount;
+    }
+
+    //Ohne Parallelitaet direkt abarbeiten
+    if (threadCount <= 1) {
+        for (int i = 0; i < jobCount; ++i) {
+            job(i, ctx);
+        }
+        return;
+    }
+
+    multiThreadBatch batch = {0, jobCount, 0, 0, threadCount, job, ctx, NULL};
+
+    pthread_mutex_lock(&g_jobSystem.lock);
+    if (!g_jobSystem.started) {
+        multiThreading_startJobSystem();
+    }
+    batch.next = g_jobSystem.batches;
+    g_jobSystem.batches = &batch;
+    pthread_cond_broadcast(&g_jobSystem.changed);
+
+    //Der aufrufende Thread arbeitet selbst mit. Sind alle eigenen Jobs vergeben, hilft er bei neueren
+    //(aus Jobs heraus gestarteten) Auftraegen, statt einen Kern mit Warten zu blockieren.
+    while (batch.finished < batch.jobCount) {
+        multiThreadBatch *next = multiThreading_findBatch(&batch, &batch);
+        if (next == NULL) {
+            next = multiThreading_findBatch(g_jobSystem.batches, &batch);
+        }
+        if (next != NULL) {
+            multiThreading_runBatchJob(next);
+        } else {
+            pthread_cond_wait(&g_jobSystem.changed, &g_jobSystem.lock);
+        }
+    }
+
+    //Auftrag aushaengen, er liegt nicht zwingend vorne, wenn parallele Aufrufe spaeter begonnen haben
+    multiThreadBatch **link = &g_jobSystem.batches;
+    while (*link != &batch) {
+        link = &(*link)->next;
+    }
+    *link = batch.next;
+    pthread_mutex_unlock(&g_jobSystem.lock);
+}
+
+void multiThreading_planTiles(scene *scene) {
+    if (scene->multiThreadOpts.hasCosts) {
+        multiThreading_costGuidedTiles(&scene->multiThreadOpts);
+    } else {
+        multiThreading_uniformTiles(&scene->multiThreadOpts);
+    }
+}
+
+void multiThreading_recordTileCosts(scene *scene) {
+    multiThreadOpts *opts = &scene->multiThreadOpts;
+
+    //Die Zeit eines Tiles gleichmaessig auf die ueberdeckten Zellen verteilen
+    for (int i = 0; i < opts->tileCount; ++i) {
+        const multiThreadRunner *tile = &opts->tiles[i];
+        GLint firstX = tile->tileCol / MULTI_THREAD_COST_CELL;
+        GLint firstY = tile->tileRow / MULTI_THREAD_COST_CELL;
+        GLint lastX = (tile->tileCol + tile->tileWidth - 1) / MULTI_THREAD_COST_CELL;
+        GLint lastY = (tile->tileRow + tile->tileHeight - 1) / MULTI_THREAD_COST_CELL;
+        GLfloat share = tile->cost / (GLfloat) ((lastX - firstX + 1) * (lastY - firstY + 1));
+
+        for (int y = firstY; y <= lastY; ++y) {
+            for (int x = firstX; x <= lastX; ++x) {
+                opts->cellCosts[OFFSET2D(MULTI_THREAD_CELLS_X, x, y)] = share;
+            }
+        }
+    }
+    opts->hasCosts = GL_TRUE;
+}
+
+void multiThreading_resetTileCosts(scene *scene) {
+    scene->multiThreadOpts.hasCosts = GL_FALSE;
+}
+
+double multiThreading_seconds(void) {
+#ifdef WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+#endif
+}
+
+void multiThreading_sleep(GLint millis) {
+#ifdef WIN32
+    Sleep(millis);
+#else
+    struct timespec duration = {millis / 1000, (millis % 1000) * 1000000L};
+    nanosleep(&duration, NULL);
+#endif
+}
+
+/**
+ * Weckt alle Threads des Pools fuer einen Auftrag und wartet, bis alle fertig sind
+ * @param pool gestarteter Pool mit mindestens einem Thread
+ * @param job auszufuehrende Funktion
+ * @param ctx Kontext der Funktion
+ * @param each GL_TRUE, wenn jeder Thread den Job einmal ausfuehrt, sonst werden die Deques abgearbeitet
+ */
+static void multiThreading_poolDispatch(multiThreadPool *pool, multiThreadPoolJob job, void *ctx, GLboolean each) {
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->ctx = ctx;
+    pool->each = each;
+    pool->running = pool->threadCount;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wakeUp);
+
+    while (pool->running > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void multiThreading_poolStart(multiThreadPool *pool, GLint threadCount, GLboolean pinned) {
+    if (pool->threads != NULL) {
+        if (pool->threadCount != threadCount) {
+            multiThreading_poolStop(pool);
+        } else {
+            //Gleiche Threads behalten, nur die Bindung anpassen
+            multiThreading_poolSetPinned(pool, pinned);
+            return;
+        }
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wakeUp, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->generation = 0;
+    pool->running = 0;
+    pool->job = NULL;
+    pool->ctx = NULL;
+    pool->each = GL_FALSE;
+    pool->shutdown = GL_FALSE;
+    pool->pinned = pinned;
+    pool->threadCount = threadCount;
+
+    pool->threads = (pthread_t *) calloc(threadCount, sizeof(pthread_t));
+    pool->workers = (multiThreadWorker *) calloc(threadCount, sizeof(multiThreadWorker));
+    pool->deques = (multiThreadDeque *) calloc(threadCount, sizeof(multiThreadDeque));
+    if (pool->threads == NULL || pool->workers == NULL || pool->deques == NULL) {
+        printf("Error allocating threads!\n");
+        exit(1);
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        pool->workers[i].pool = pool;
+        pool->workers[i].id = i;
+    }
+
+    //Kann ein Thread nicht gestartet werden, laeuft der Pool mit den bisher gestarteten weiter
+    GLint started = 0;
+    while (started < threadCount &&
+           pthread_create(&pool->threads[started], NULL, multiThreading_poolWorker, &pool->workers[started]) == 0) {
+        started++;
+    }
+    if (started < threadCount) {
+        printf("Could only start %d of %d render threads!\n", started, threadCount);
+        for (int i = started; i < threadCount; ++i) {
+            pthread_mutex_destroy(&pool->deques[i].lock);
+        }
+        pthread_mutex_lock(&pool->lock);
+        pool->threadCount = started;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void multiThreading_poolRun(multiThreadPool *pool, GLint jobCount, multiThreadPoolJob job, void *ctx) {
+    //Ohne gestartete Threads direkt abarbeiten
+    if (pool->threadCount == 0) {
+        for (int i = 0; i < jobCount; ++i) {
+            job(i, 0, ctx);
+        }
+        return;
+    }
+
+    //Jobs gleichmaessig als zusammenhaengende Bereiche auf die Deques verteilen,
+    //die Threads schlafen noch und sehen die Deques erst nach dem Wecken
+    for (int i = 0; i < pool->threadCount; ++i) {
+        pool->deques[i].top = (GLint) ((long) jobCount * i / pool->threadCount);
+        pool->deques[i].bottom = (GLint) ((long) jobCount * (i + 1) / pool->threadCount);
+    }
+    multiThreading_poolDispatch(pool, job, ctx, GL_FALSE);
+}
+
+void multiThreading_poolRunOnEach(multiThreadPool *pool, multiThreadPoolJob job, void *ctx) {
+    if (pool->threadCount == 0) {
+        job(0, 0, ctx);
+        return;
+    }
+    multiThreading_poolDispatch(pool, job, ctx, GL_TRUE);
+}
+
+void multiThreading_poolSetPinned(multiThreadPool *pool, GLboolean pinned) {
+    if (pool->pinned == pinned) {
+        return;
+    }
+    pool->pinned = pinned;
+    if (pool->threadCount > 0) {
+        multiThreading_poolRunOnEach(pool, multiThreading_pinJob, &pinned);
+    }
+}
+
+void multiThreading_poolStop(multiThreadPool *pool) {
+    if (pool->threads == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = GL_TRUE;
+    pthread_cond_broadcast(&pool->wakeUp);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->threadCount; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (int i = 0; i < pool->threadCount; ++i) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    free(pool->threads);
+    free(pool->workers);
+    free(pool->deques);
+    pool->threads = NULL;
+    pool->workers = NULL;
+    pool->deques = NULL;
+    pool->threadCount = 0;
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wakeUp);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+void multiThreading_firstTouch(scene *scene, Color *buffer) {
+    multiThreadOpts *opts = &scene->multiThreadOpts;
+    if (!opts->useMultiThreading) {
+        memset(buffer, 0, DEFAULT_WINDOW_WIDTH * DEFAULT_WINDOW_HEIGHT * sizeof(Color));
+        return;
+    }
+
+    //Jeder Thread beschreibt zuerst die Tiles, die ihm in der gleichmaessigen Aufteilung gehoeren.
+    //Die aktuelle Aufteilung bleibt unveraendert, die kostengesteuerte haelt Tiles moeglichst dort.
+    multiThreadTouch touch = {buffer, opts->pool.threadCount > 0 ? opts->pool.threadCount : 1};
+    multiThreading_poolRunOnEach(&opts->pool, multiThreading_touchTiles, &touch);
+}
+
+void multiThreading_freeThreading(scene *scene) {
+    multiThreading_poolStop(&scene->multiThreadOpts.pool);
+    multiThreading_stopJobSystem();
+    free(scene->multiThreadOpts.tiles);
+    free(scene->multiThreadOpts.cellCosts);
+    scene->multiThreadOpts.tiles = NULL;
+    scene->multiThreadOpts.cellCosts = NULL;
+}
+
+GLint multiThreading_cpuCount(void) {
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    GLint result = (GLint) info.dwNumberOfProcessors;
+#else
+    GLint result = (GLint) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return result > 0 ? result : 1;
+}
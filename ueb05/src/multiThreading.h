@@ -2,10 +2,136 @@
 #define RAYTRACER_MULTITHREADING_H
 #include "types.h"
 
+/*
+ * Atomare Zugriffe auf multiThreadCounter ohne Sperre. Erhoehen ist ungeordnet (nur der Zaehler selbst
+ * ist konsistent), Schreiben veroeffentlicht alle vorherigen Schreibzugriffe an Threads, die den Wert lesen.
+ */
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MULTI_THREAD_ATOMIC_ADD(counter, value) _InterlockedExchangeAdd((volatile long *) (counter), (long) (value))
+#define MULTI_THREAD_ATOMIC_LOAD(counter) _InterlockedCompareExchange((volatile long *) (counter), 0, 0)
+#define MULTI_THREAD_ATOMIC_STORE(counter, value) _InterlockedExchange((volatile long *) (counter), (long) (value))
+#else
+#define MULTI_THREAD_ATOMIC_ADD(counter, value) __atomic_fetch_add((counter), (long) (value), __ATOMIC_RELAXED)
+#define MULTI_THREAD_ATOMIC_LOAD(counter) __atomic_load_n((counter), __ATOMIC_ACQUIRE)
+#define MULTI_THREAD_ATOMIC_STORE(counter, value) __atomic_store_n((counter), (long) (value), __ATOMIC_RELEASE)
+#endif
+
 /**
- * Erstellt einen Thread anhand der eingestellten Multithreading Optionen
+ * Zerlegt das Bild in Tiles und startet den Render-Pool anhand der eingestellten Multithreading Optionen
+ * (threadsAuto: ein Thread pro online CPU Kern)
  * @param scene aktuelle Szene
  */
 void multiThreading_setupThreading(scene *scene);
 
+/**
+ * Arbeitet jobCount unabhaengige Jobs parallel ab. Die Jobs werden von gemeinsamen Hilfsthreads
+ * (einer weniger als CPU Kerne) und dem aufrufenden Thread abgearbeitet, die Hilfsthreads laufen
+ * dauerhaft bis multiThreading_freeThreading. Aufrufe aus einem Job heraus verwenden dieselben Threads,
+ * so laufen auch verschachtelt nie mehr Jobs gleichzeitig als Kerne vorhanden sind.
+ * Kehrt erst zurueck, wenn alle Jobs fertig sind.
+ * @param jobCount Anzahl der Jobs
+ * @param threadCount hoechstens so viele Jobs dieses Aufrufs laufen gleichzeitig
+ *                    (bei 1 wird direkt im aufrufenden Thread gearbeitet)
+ * @param job Funktion, die einen Job abarbeitet
+ * @param ctx Kontext, der an jeden Job uebergeben wird
+ */
+void multiThreading_runJobs(GLint jobCount, GLint threadCount, multiThreadJob job, void *ctx);
+
+/**
+ * Legt die Tiles fuer den naechsten Frame fest. Liegen Renderzeiten des letzten Frames vor, werden
+ * teure Tiles verkleinert und die Tiles so verteilt und sortiert, dass die teuersten zuerst starten.
+ * @param scene aktuelle Szene mit aufgesetztem Multithreading
+ */
+void multiThreading_planTiles(scene *scene);
+
+/**
+ * Uebernimmt die gemessenen Renderzeiten (cost) der Tiles in die Kostenkarte fuer den naechsten Frame
+ * @param scene aktuelle Szene nach dem Rendern
+ */
+void multiThreading_recordTileCosts(scene *scene);
+
+/**
+ * Verwirft die Kostenkarte, z.B. wenn sich die Blickrichtung geaendert hat
+ * @param scene aktuelle Szene
+ */
+void multiThreading_resetTileCosts(scene *scene);
+
+/**
+ * Liefert eine monotone Zeit zur Messung kurzer Abschnitte, auch aus Arbeitsthreads
+ * @return Zeit in Sekunden
+ */
+double multiThreading_seconds(void);
+
+/**
+ * Legt den aufrufenden Thread schlafen
+ * @param millis Dauer in Millisekunden
+ */
+void multiThreading_sleep(GLint millis);
+
+/**
+ * Startet die Arbeitsthreads eines Pools. Laeuft der Pool bereits mit derselben Anzahl
+ * Threads, bleiben diese erhalten, ansonsten wird er beendet und neu gestartet.
+ * @param pool Pool (zu Beginn mit 0 initialisiert)
+ * @param threadCount Anzahl der Arbeitsthreads
+ * @param pinned Thread i wird an den i-ten verfuegbaren CPU Kern gebunden
+ */
+void multiThreading_poolStart(multiThreadPool *pool, GLint threadCount, GLboolean pinned);
+
+/**
+ * Weckt die Threads des Pools und laesst sie jobCount Jobs abarbeiten. Jeder Thread beginnt mit
+ * einem zusammenhaengenden Bereich der Jobs und stiehlt anderen Threads Jobs, sobald er fertig ist.
+ * Kehrt erst zurueck, wenn alle Jobs fertig sind; die Threads schlafen danach wieder.
+ * @param pool gestarteter Pool
+ * @param jobCount Anzahl der Jobs
+ * @param job Funktion, die einen Job abarbeitet, erhaelt zusaetzlich den Index des Pool-Threads
+ * @param ctx Kontext, der an jeden Job uebergeben wird
+ */
+void multiThreading_poolRun(multiThreadPool *pool, GLint jobCount, multiThreadPoolJob job, void *ctx);
+
+/**
+ * Laesst jeden Thread des Pools den Job genau einmal ausfuehren, Job- und Thread-Index sind gleich.
+ * Dient fuer Arbeit, die auf einem bestimmten Thread laufen muss (Binden, First Touch).
+ * Ohne gestartete Threads laeuft der Job einmal im aufrufenden Thread.
+ * @param pool gestarteter Pool
+ * @param job Funktion, die pro Thread ausgefuehrt wird
+ * @param ctx Kontext, der an jeden Job uebergeben wird
+ */
+void multiThreading_poolRunOnEach(multiThreadPool *pool, multiThreadPoolJob job, void *ctx);
+
+/**
+ * Bindet die laufenden Threads des Pools an ihre CPU Kerne oder loest die Bindung, ohne sie neu zu starten
+ * @param pool Pool
+ * @param pinned GL_TRUE zum Binden
+ */
+void multiThreading_poolSetPinned(multiThreadPool *pool, GLboolean pinned);
+
+/**
+ * Beendet die Threads des Pools und gibt seinen Speicher frei
+ * @param pool Pool, darf auch nie gestartet worden sein
+ */
+void multiThreading_poolStop(multiThreadPool *pool);
+
+/**
+ * Beschreibt einen neuen Framebuffer zum ersten Mal aus den Threads, denen die jeweiligen Tiles
+ * gehoeren (First Touch). Das Betriebssystem legt die Seiten dadurch auf dem NUMA Knoten des
+ * Threads an, der sie spaeter beschreibt. Die aktuelle Aufteilung der Tiles bleibt erhalten.
+ * Ohne Multithreading wird der Buffer direkt geleert.
+ * @param scene Szene mit aufgesetztem Multithreading
+ * @param buffer noch nicht beschriebener Framebuffer (DEFAULT_WINDOW_WIDTH x DEFAULT_WINDOW_HEIGHT)
+ */
+void multiThreading_firstTouch(scene *scene, Color *buffer);
+
+/**
+ * Beendet den Render-Pool und die Hilfsthreads von multiThreading_runJobs und gibt die Tiles frei
+ * @param scene aktuelle Szene
+ */
+void multiThreading_freeThreading(scene *scene);
+
+/**
+ * Liefert die Anzahl der verfuegbaren CPU Kerne
+ * @return Anzahl der Kerne, mindestens 1
+ */
+GLint multiThreading_cpuCount(void);
+
 #endif //RAYTRACER_MULTITHREADING_H
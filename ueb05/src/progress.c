@@ -0,0 +1,137 @@
+/**
+ * @file
+ * Fortschritt des laufenden Frames ohne Sperren. Die Render-Threads melden fertige Tiles und
+ * verfolgte Strahlen ueber atomare Operationen, die Anzeige und die Konsole lesen die Zaehler
+ * zu beliebigen Zeitpunkten. Strahlen und Arbeitszeit werden in den Threads gesammelt und nur pro
+ * Paketzeile gemeldet, damit die innere Schleife keine gemeinsamen Cache-Zeilen beschreibt.
+ * Fertige Zellen werden mit der Nummer des Durchgangs markiert, so muss zu Beginn eines
+ * Durchgangs nichts zurueckgesetzt werden.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <string.h>
+#include "progress.h"
+#include "multiThreading.h"
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+void progress_init(renderProgress *progress) {
+    memset(progress, 0, sizeof(*progress));
+    progress->baseTime = multiThreading_seconds();
+}
+
+void progress_beginFrame(renderProgress *progress, GLint passCount, GLint threadCount) {
+    MULTI_THREAD_ATOMIC_STORE(&progress->rays, 0);
+    for (int i = 0; i < PROGRESS_MAX_THREADS; ++i) {
+        MULTI_THREAD_ATOMIC_STORE(&progress->busyMicros[i], 0);
+    }
+    MULTI_THREAD_ATOMIC_STORE(&progress->threadCount, threadCount < PROGRESS_MAX_THREADS ? threadCount
+                                                                                        : PROGRESS_MAX_THREADS);
+    MULTI_THREAD_ATOMIC_STORE(&progress->passesDone, 0);
+    MULTI_THREAD_ATOMIC_STORE(&progress->passCount, passCount);
+    MULTI_THREAD_ATOMIC_STORE(&progress->tilesDone, 0);
+    MULTI_THREAD_ATOMIC_STORE(&progress->tileCount, 0);
+    MULTI_THREAD_ATOMIC_STORE(&progress->startMillis, (multiThreading_seconds() - progress->baseTime) * 1000.0);
+    MULTI_THREAD_ATOMIC_STORE(&progress->running, 1);
+}
+
+void progress_beginPass(renderProgress *progress, GLint tileCount) {
+    MULTI_THREAD_ATOMIC_STORE(&progress->tilesDone, 0);
+    MULTI_THREAD_ATOMIC_STORE(&progress->tileCount, tileCount);
+    //Neue Nummer, die Markierungen des vorherigen Durchgangs gelten damit nicht mehr
+    MULTI_THREAD_ATOMIC_ADD(&progress->pass, 1);
+}
+
+void progress_finishTile(renderProgress *progress, GLint col, GLint row, GLint width, GLint height) {
+    long pass = MULTI_THREAD_ATOMIC_LOAD(&progress->pass);
+    GLint lastX = (col + width - 1) / MULTI_THREAD_COST_CELL;
+    GLint lastY = (row + height - 1) / MULTI_THREAD_COST_CELL;
+    for (int y = row / MULTI_THREAD_COST_CELL; y <= lastY; ++y) {
+        for (int x = col / MULTI_THREAD_COST_CELL; x <= lastX; ++x) {
+            MULTI_THREAD_ATOMIC_STORE(&progress->cells[OFFSET2D(MULTI_THREAD_CELLS_X, x, y)], pass);
+        }
+    }
+    MULTI_THREAD_ATOMIC_ADD(&progress->tilesDone, 1);
+}
+
+void progress_addRays(renderProgress *progress, GLint rays) {
+    MULTI_THREAD_ATOMIC_ADD(&progress->rays, rays);
+}
+
+void progress_addBusy(renderProgress *progress, GLint thread, double seconds) {
+    MULTI_THREAD_ATOMIC_ADD(&progress->busyMicros[thread % PROGRESS_MAX_THREADS], seconds * 1e6);
+}
+
+void progress_finishPass(renderProgress *progress) {
+    MULTI_THREAD_ATOMIC_ADD(&progress->passesDone, 1);
+}
+
+void progress_endFrame(renderProgress *progress) {
+    MULTI_THREAD_ATOMIC_STORE(&progress->running, 0);
+}
+
+GLboolean progress_running(const renderProgress *progress) {
+    return MULTI_THREAD_ATOMIC_LOAD(&progress->running) != 0;
+}
+
+GLfloat progress_fraction(const renderProgress *progress) {
+    long passCount = MULTI_THREAD_ATOMIC_LOAD(&progress->passCount);
+    long passesDone = MULTI_THREAD_ATOMIC_LOAD(&progress->passesDone);
+    long tileCount = MULTI_THREAD_ATOMIC_LOAD(&progress->tileCount);
+    long tilesDone = MULTI_THREAD_ATOMIC_LOAD(&progress->tilesDone);
+    if (passCount == 0) {
+        return 0.0f;
+    }
+
+    //Der Pixelabstand halbiert sich je Durchgang, jeder weitere Durchgang verfolgt also 3/4 seiner Pixel neu
+    GLfloat result = 0.0f;
+    GLfloat weight = 1.0f;
+    for (long pass = 1; pass < passCount; ++pass) {
+        weight *= 0.25f;
+    }
+    for (long pass = 0; pass < passCount && pass <= passesDone; ++pass) {
+        GLfloat passWeight = pass == 0 ? weight : weight * 3.0f;
+        if (pass < passesDone) {
+            result += passWeight;
+        } else if (tileCount > 0) {
+            result += passWeight * (GLfloat) tilesDone / (GLfloat) tileCount;
+        }
+        if (pass > 0) {
+            weight *= 4.0f;
+        }
+    }
+    return result < 1.0f ? result : 1.0f;
+}
+
+GLint progress_tilesDone(const renderProgress *progress, GLint *tileCount) {
+    *tileCount = (GLint) MULTI_THREAD_ATOMIC_LOAD(&progress->tileCount);
+    return (GLint) MULTI_THREAD_ATOMIC_LOAD(&progress->tilesDone);
+}
+
+long progress_rays(const renderProgress *progress) {
+    return MULTI_THREAD_ATOMIC_LOAD(&progress->rays);
+}
+
+void progress_busySeconds(const renderProgress *progress, GLfloat *minSeconds, GLfloat *maxSeconds) {
+    long threadCount = MULTI_THREAD_ATOMIC_LOAD(&progress->threadCount);
+    long minMicros = MULTI_THREAD_ATOMIC_LOAD(&progress->busyMicros[0]);
+    long maxMicros = minMicros;
+    for (long i = 1; i < threadCount; ++i) {
+        long micros = MULTI_THREAD_ATOMIC_LOAD(&progress->busyMicros[i]);
+        minMicros = micros < minMicros ? micros : minMicros;
+        maxMicros = micros > maxMicros ? micros : maxMicros;
+    }
+    *minSeconds = (GLfloat) minMicros * 1e-6f;
+    *maxSeconds = (GLfloat) maxMicros * 1e-6f;
+}
+
+GLfloat progress_seconds(const renderProgress *progress) {
+    double start = progress->baseTime + (double) MULTI_THREAD_ATOMIC_LOAD(&progress->startMillis) * 1e-3;
+    return (GLfloat) (multiThreading_seconds() - start);
+}
+
+GLboolean progress_cellDone(const renderProgress *progress, GLint x, GLint y) {
+    return MULTI_THREAD_ATOMIC_LOAD(&progress->cells[OFFSET2D(MULTI_THREAD_CELLS_X, x, y)]) ==
+           MULTI_THREAD_ATOMIC_LOAD(&progress->pass);
+}
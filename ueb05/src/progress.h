@@ -0,0 +1,118 @@
+#ifndef RAYTRACER_PROGRESS_H
+#define RAYTRACER_PROGRESS_H
+#include "types.h"
+
+/**
+ * Setzt den Fortschritt zurueck, bevor Threads darauf zugreifen
+ * @param progress Fortschritt
+ */
+void progress_init(renderProgress *progress);
+
+/**
+ * Beginnt einen neuen Frame, wird vom Render-Thread aufgerufen
+ * @param progress Fortschritt
+ * @param passCount Anzahl der Durchgaenge des Frames
+ * @param threadCount Anzahl der Threads, die den Frame rendern
+ */
+void progress_beginFrame(renderProgress *progress, GLint passCount, GLint threadCount);
+
+/**
+ * Beginnt einen Durchgang, alle Zellen gelten danach als offen
+ * @param progress Fortschritt
+ * @param tileCount Anzahl der Tiles des Durchgangs
+ */
+void progress_beginPass(renderProgress *progress, GLint tileCount);
+
+/**
+ * Meldet ein fertiges Tile, wird von den Render-Threads ohne Sperre aufgerufen
+ * @param progress Fortschritt
+ * @param col Start Pixel der Spalte (Vielfaches von MULTI_THREAD_COST_CELL)
+ * @param row Start Pixel der Reihe (Vielfaches von MULTI_THREAD_COST_CELL)
+ * @param width Breite des Tiles
+ * @param height Hoehe des Tiles
+ */
+void progress_finishTile(renderProgress *progress, GLint col, GLint row, GLint width, GLint height);
+
+/**
+ * Meldet verfolgte Strahlen, wird von den Render-Threads ohne Sperre aufgerufen
+ * @param progress Fortschritt
+ * @param rays Anzahl der Strahlen seit der letzten Meldung des Threads
+ */
+void progress_addRays(renderProgress *progress, GLint rays);
+
+/**
+ * Meldet Arbeitszeit eines Threads, wird wie progress_addRays pro Paketzeile ohne Sperre aufgerufen
+ * @param progress Fortschritt
+ * @param thread Index des Threads
+ * @param seconds Zeit seit der letzten Meldung des Threads
+ */
+void progress_addBusy(renderProgress *progress, GLint thread, double seconds);
+
+/**
+ * Schliesst einen Durchgang ab
+ * @param progress Fortschritt
+ */
+void progress_finishPass(renderProgress *progress);
+
+/**
+ * Beendet den Frame (fertig oder abgebrochen)
+ * @param progress Fortschritt
+ */
+void progress_endFrame(renderProgress *progress);
+
+/**
+ * Prueft, ob gerade ein Frame gerendert wird
+ * @param progress Fortschritt
+ * @return GL_TRUE zwischen progress_beginFrame und progress_endFrame
+ */
+GLboolean progress_running(const renderProgress *progress);
+
+/**
+ * Anteil der Pixel des Frames, die bereits gerendert wurden. Jeder Durchgang zaehlt nach den Pixeln,
+ * die er neu verfolgt.
+ * @param progress Fortschritt
+ * @return 0 bis 1
+ */
+GLfloat progress_fraction(const renderProgress *progress);
+
+/**
+ * Fertige Tiles des aktuellen Durchgangs
+ * @param progress Fortschritt
+ * @param tileCount Ausgabe, Anzahl der Tiles des Durchgangs
+ * @return Anzahl der fertigen Tiles
+ */
+GLint progress_tilesDone(const renderProgress *progress, GLint *tileCount);
+
+/**
+ * Verfolgte Strahlen des Frames
+ * @param progress Fortschritt
+ * @return Anzahl der Strahlen
+ */
+long progress_rays(const renderProgress *progress);
+
+/**
+ * Kleinste und groesste Arbeitszeit ueber alle Threads des Frames. Grosse Unterschiede deuten auf eine
+ * schlechte Aufteilung der Tiles hin.
+ * @param progress Fortschritt
+ * @param minSeconds Ausgabe, Arbeitszeit des am wenigsten ausgelasteten Threads
+ * @param maxSeconds Ausgabe, Arbeitszeit des am meisten ausgelasteten Threads
+ */
+void progress_busySeconds(const renderProgress *progress, GLfloat *minSeconds, GLfloat *maxSeconds);
+
+/**
+ * Zeit seit dem Beginn des Frames
+ * @param progress Fortschritt
+ * @return Sekunden
+ */
+GLfloat progress_seconds(const renderProgress *progress);
+
+/**
+ * Prueft, ob eine Zelle im aktuellen Durchgang fertig gerendert wurde
+ * @param progress Fortschritt
+ * @param x Spalte der Zelle (0 bis MULTI_THREAD_CELLS_X - 1)
+ * @param y Reihe der Zelle (0 bis MULTI_THREAD_CELLS_Y - 1)
+ * @return GL_TRUE, wenn die Zelle fertig ist
+ */
+GLboolean progress_cellDone(const renderProgress *progress, GLint x, GLint y);
+
+#endif //RAYTRACER_PROGRESS_H
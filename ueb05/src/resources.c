@@ -0,0 +1,198 @@
+/**
+ * @file
+ * Ressourcen-Cache fuer Meshes. Jede .obj Datei wird nur einmal geladen und von allen Nutzern
+ * ueber ihren Dateinamen gemeinsam verwendet. Die Eintraege zaehlen ihre Nutzer, das Mesh wird
+ * erst freigegeben, wenn der letzte Nutzer es zurueckgibt. Ein Wechsel der Ansicht baut so nur
+ * die Instanzen neu auf und laedt keine Datei erneut.
+ * Fehlende Meshes werden erst als Eintraege angelegt und dann als unabhaengige Jobs gleichzeitig geladen,
+ * jeder Job schreibt nur in seinen eigenen Eintrag. Der Cache selbst wird nur vom aufrufenden Thread veraendert.
+ *
+ * @author Christopher Ploog, Mario da Graca
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "resources.h"
+#include "loadObj.h"
+#include "loadPly.h"
+#include "bvh.h"
+#include "multiThreading.h"
+
+/**---------------------------------------------- LOCAL TYPES ---------------------------------------------------*/
+
+/** Eintraege, deren Meshes von den Jobs geladen werden */
+typedef struct resourceLoadJobs {
+    meshResource **entries;
+    /** Meshes nur mit der komprimierten BVH aufbauen */
+    GLboolean compressedOnly;
+} resourceLoadJobs;
+
+/**------------------------------------------ LOCAL FUNCTION DECLARATION ----------------------------------------*/
+
+/**
+ * Gibt den Speicher eines Meshes frei
+ * @param obj Mesh
+ */
+static void resources_freeMesh(object *obj);
+
+/**
+ * Sucht einen Eintrag ueber seinen Dateinamen
+ * @param cache Ressourcen-Cache
+ * @param fileName Dateiname
+ * @return Eintrag, NULL wenn die Datei nicht im Cache ist
+ */
+static meshResource *resources_findEntry(resourceCache *cache, const char *fileName);
+
+/**
+ * Legt einen Eintrag ohne Mesh und ohne Nutzer an
+ * @param cache Ressourcen-Cache
+ * @param fileName Dateiname
+ * @return neuer Eintrag
+ */
+static meshResource *resources_addEntry(resourceCache *cache, const char *fileName);
+
+/**
+ * Laedt das Mesh eines Eintrags, Job von multiThreading_runJobs
+ * @param idx Index des Eintrags
+ * @param ctx resourceLoadJobs
+ */
+static void resources_loadJob(GLint idx, void *ctx);
+
+/**
+ * Gibt einen Eintrag frei und entfernt ihn aus dem Cache
+ * @param cache Ressourcen-Cache
+ * @param idx Index des Eintrags
+ */
+static void resources_removeEntry(resourceCache *cache, GLint idx);
+
+/**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION ---------------------------------------*/
+
+static void resources_freeMesh(object *obj) {
+    if (obj->mapping != NULL) {
+        //Alle Arrays liegen in der gemappten Mesh-Datei
+        utils_unmapFile(obj->mapping, obj->mappingSize);
+        return;
+    }
+    if (obj->vertices != NULL) {
+        free(obj->vertices);
+    }
+    if (obj->facesTM != NULL) {
+        free(obj->facesTM);
+    }
+    if (obj->indices != NULL) {
+        free(obj->indices);
+    }
+    bvh_free(&obj->bvh);
+}
+
+static meshResource *resources_findEntry(resourceCache *cache, const char *fileName) {
+    for (int i = 0; i < cache->count; ++i) {
+        if (strcmp(cache->entries[i]->fileName, fileName) == 0) {
+            return cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static meshResource *resources_addEntry(resourceCache *cache, const char *fileName) {
+    if (cache->count == cache->capacity) {
+        GLint capacity = cache->capacity > 0 ? cache->capacity * 2 : AMOUNT_MESHES;
+        meshResource **entries = realloc(cache->entries, capacity * sizeof(meshResource *));
+        if (entries == NULL) {
+            printf("Error allocating resource cache!\n");
+            exit(1);
+        }
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    meshResource *entry = malloc(sizeof(meshResource));
+    if (entry == NULL) {
+        printf("Error allocating resource cache!\n");
+        exit(1);
+    }
+    entry->fileName = utils_concatStrings(fileName, "");
+    entry->refCount = 0;
+    cache->entries[cache->count++] = entry;
+    return entry;
+}
+
+static void resources_loadJob(GLint idx, void *ctx) {
+    resourceLoadJobs *jobs = (resourceLoadJobs *) ctx;
+    meshResource *entry = jobs->entries[idx];
+    //Das Dateiformat ergibt sich aus der Endung
+    const char *extension = strrchr(entry->fileName, '.');
+    if (extension != NULL && strcmp(extension, ".ply") == 0) {
+        entry->mesh = loadPly_readFile(entry->fileName, jobs->compressedOnly);
+    } else {
+        entry->mesh = loadObj_readFile(entry->fileName, jobs->compressedOnly);
+    }
+}
+
+static void resources_removeEntry(resourceCache *cache, GLint idx) {
+    meshResource *entry = cache->entries[idx];
+    resources_freeMesh(&entry->mesh);
+    free(entry->fileName);
+    free(entry);
+    //Reihenfolge spielt keine Rolle, die Nutzer halten Zeiger auf die Meshes und nicht auf die Plaetze
+    cache->entries[idx] = cache->entries[cache->count - 1];
+    cache->count--;
+}
+
+/**--------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
+
+const object *resources_acquireMesh(resourceCache *cache, const char *fileName) {
+    const object *result;
+    resources_acquireMeshes(cache, &fileName, 1, &result);
+    return result;
+}
+
+void resources_acquireMeshes(resourceCache *cache, const char **fileNames, GLint count, const object **meshes) {
+    resourceLoadJobs jobs;
+    jobs.entries = (meshResource **) malloc((count > 0 ? count : 1) * sizeof(meshResource *));
+    if (jobs.entries == NULL) {
+        printf("Error allocating resource cache!\n");
+        exit(1);
+    }
+    jobs.compressedOnly = cache->compressedOnly;
+
+    //Fehlende Dateien anlegen, doppelte Dateinamen finden dabei den neuen Eintrag
+    GLint jobCount = 0;
+    for (int i = 0; i < count; ++i) {
+        meshResource *entry = resources_findEntry(cache, fileNames[i]);
+        if (entry == NULL) {
+            entry = resources_addEntry(cache, fileNames[i]);
+            jobs.entries[jobCount++] = entry;
+        }
+        entry->refCount++;
+    }
+
+    //Jeder Job liest, baut und beschreibt nur seinen eigenen Eintrag
+    multiThreading_runJobs(jobCount, multiThreading_cpuCount(), resources_loadJob, &jobs);
+
+    //Erst wenn alle Meshes fertig sind, werden sie herausgegeben
+    for (int i = 0; i < count; ++i) {
+        meshes[i] = &resources_findEntry(cache, fileNames[i])->mesh;
+    }
+    free(jobs.entries);
+}
+
+void resources_releaseMesh(resourceCache *cache, const object *mesh) {
+    for (int i = 0; i < cache->count && mesh != NULL; ++i) {
+        if (&cache->entries[i]->mesh == mesh) {
+            if (--cache->entries[i]->refCount <= 0) {
+                resources_removeEntry(cache, i);
+            }
+            return;
+        }
+    }
+}
+
+void resources_free(resourceCache *cache) {
+    while (cache->count > 0) {
+        resources_removeEntry(cache, cache->count - 1);
+    }
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->capacity = 0;
+}
@@ -0,0 +1,40 @@
+#ifndef RAYTRACER_RESOURCES_H
+#define RAYTRACER_RESOURCES_H
+#include "types.h"
+
+/**
+ * Liefert das Mesh einer .obj oder .ply Datei und zaehlt einen Nutzer hinzu. Ist das Mesh noch nicht
+ * im Cache, wird es geladen (mit BVH und Bounding Volumes). Der Zeiger bleibt gueltig, bis
+ * der letzte Nutzer das Mesh zurueckgibt.
+ * @param cache Ressourcen-Cache (zu Beginn mit 0 initialisiert)
+ * @param fileName Dateiname im Modellordner
+ * @return Mesh im Objektraum, bei Fehlern beim Laden ein leeres Mesh
+ */
+const object *resources_acquireMesh(resourceCache *cache, const char *fileName);
+
+/**
+ * Liefert die Meshes mehrerer .obj oder .ply Dateien und zaehlt je Datei einen Nutzer hinzu. Alle Meshes, die noch
+ * nicht im Cache sind, werden als unabhaengige Jobs gleichzeitig geladen (Lesen, BVH und Bounding Volumes).
+ * Mit cache->compressedOnly wird von neuen Meshes nur die komprimierte BVH aufgebaut.
+ * Kehrt erst zurueck, wenn alle Meshes fertig sind.
+ * @param cache Ressourcen-Cache (zu Beginn mit 0 initialisiert)
+ * @param fileNames Dateinamen im Modellordner
+ * @param count Anzahl der Dateien
+ * @param meshes Ausgabe, Mesh je Datei in derselben Reihenfolge
+ */
+void resources_acquireMeshes(resourceCache *cache, const char **fileNames, GLint count, const object **meshes);
+
+/**
+ * Gibt ein Mesh zurueck, ohne Nutzer wird es freigegeben
+ * @param cache Ressourcen-Cache
+ * @param mesh Mesh aus resources_acquireMesh, NULL wird ignoriert
+ */
+void resources_releaseMesh(resourceCache *cache, const object *mesh);
+
+/**
+ * Gibt alle Meshes unabhaengig von ihren Nutzern und den Cache selbst frei
+ * @param cache Ressourcen-Cache
+ */
+void resources_free(resourceCache *cache);
+
+#endif //RAYTRACER_RESOURCES_H
@@ -29,12 +29,13 @@
 #include "debugGL.h"
 #include "logic.h"
 #include "io.h"
+#include "progress.h"
 
 /**
 * Gibt den Setuptext aus.
 */
 static void drawSetup() {
-    int size = 7;
+    int size = 9;
 
     Color color = {95 / 255.0f, 212 / 255.0f, 207 / 255.0f};
 
@@ -44,6 +45,8 @@ static void drawSetup() {
                     "F3     -    4 Threads",
                     "F4     -    2 Threads",
                     "F5     -    no Multithreading",
+                    "F6     -    1 Thread per CPU Core",
+                    "c/C    -    pin Threads to CPU Cores",
                     "t/T    -    print Help"};
 
     drawString(0.35f, 0.1f, color, help[0]);
@@ -53,6 +56,71 @@ static void drawSetup() {
     }
 }
 
+/**
+ * Zeichnet den Fortschritt des laufenden Frames ueber das zuletzt fertige Bild:
+ * Zellen, die im aktuellen Durchgang noch nicht gerendert wurden, werden abgedunkelt,
+ * am unteren Rand stehen ein Fortschrittsbalken und die Zaehler.
+ * @param progress Fortschritt, wird ohne Sperre gelesen
+ */
+static void drawProgress(const renderProgress *progress) {
+    GLint tileCount;
+    GLint tilesDone = progress_tilesDone(progress, &tileCount);
+    GLfloat fraction = progress_fraction(progress);
+
+    glPushAttrib(GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_ENABLE_BIT);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    //Pixelkoordinaten wie beim Framebuffer, Zeile 0 unten
+    gluOrtho2D(0.0, DEFAULT_WINDOW_WIDTH, 0.0, DEFAULT_WINDOW_HEIGHT);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glColor4f(0.0f, 0.0f, 0.0f, 0.5f);
+    glBegin(GL_QUADS);
+    for (GLint y = 0; y < MULTI_THREAD_CELLS_Y; ++y) {
+        for (GLint x = 0; x < MULTI_THREAD_CELLS_X; ++x) {
+            if (!progress_cellDone(progress, x, y)) {
+                GLfloat left = (GLfloat) (x * MULTI_THREAD_COST_CELL);
+                GLfloat bottom = (GLfloat) (y * MULTI_THREAD_COST_CELL);
+                glVertex2f(left, bottom);
+                glVertex2f(left + MULTI_THREAD_COST_CELL, bottom);
+                glVertex2f(left + MULTI_THREAD_COST_CELL, bottom + MULTI_THREAD_COST_CELL);
+                glVertex2f(left, bottom + MULTI_THREAD_COST_CELL);
+            }
+        }
+    }
+
+    //Fortschrittsbalken
+    GLfloat barWidth = DEFAULT_WINDOW_WIDTH - 20.0f;
+    glColor4f(0.0f, 0.0f, 0.0f, 0.7f);
+    glVertex2f(10.0f, 10.0f);
+    glVertex2f(10.0f + barWidth, 10.0f);
+    glVertex2f(10.0f + barWidth, 20.0f);
+    glVertex2f(10.0f, 20.0f);
+    glColor4f(95 / 255.0f, 212 / 255.0f, 207 / 255.0f, 1.0f);
+    glVertex2f(10.0f, 10.0f);
+    glVertex2f(10.0f + barWidth * fraction, 10.0f);
+    glVertex2f(10.0f + barWidth * fraction, 20.0f);
+    glVertex2f(10.0f, 20.0f);
+    glEnd();
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+
+    Color color = {95 / 255.0f, 212 / 255.0f, 207 / 255.0f};
+    drawString(0.02f, 0.94f, color, "%.0f%%  Tiles %d/%d  %.2f Mio. Rays  %.1f s", fraction * 100.0f, tilesDone,
+               tileCount, progress_rays(progress) * 1e-6, progress_seconds(progress));
+}
+
 /**
  * Zeichen-Funktion, stellt die Szene dar
  */
@@ -60,8 +128,14 @@ void drawScene(void) {
     if(!io_startRender()){
         drawSetup();
     } else {
-        //Szene einmal zeichnen, nachdem sie fertig gerendert wurde
+        //Zuletzt fertig gerenderten Frame zeichnen, der Render-Thread tauscht ihn solange nicht aus
         glDrawPixels(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, GL_RGB, GL_FLOAT, logic_getFramebuffer());
+        logic_releaseFramebuffer();
+
+        //Solange ein Frame gerendert wird, den Fortschritt darueber legen
+        if (progress_running(logic_getProgress())) {
+            drawProgress(logic_getProgress());
+        }
     }
 }
 
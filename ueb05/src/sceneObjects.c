@@ -5,49 +5,34 @@
  * @author Christopher Ploog, Mario da Graca
  */
 
+#include <string.h>
 #include "sceneObjects.h"
-#include "loadObj.h"
-#include "boundingBox.h"
+#include "resources.h"
+#include "accelerator.h"
 
 
 /**---------------------------------------- LOCAL FUNCTION IMPLEMENTATION --------------------------------------*/
 
 /**
- * Berechnet die AABB und die OBB von einem Objekt in der Szene
- * @param scene Aktuelle Szene
- * @param idx Index des Objektes, desses Bounding Boxes generiert werden soll
- */
-static void sceneObjects_initBoundingBoxes(scene *scene, GLint idx, vec3 bunnyTranslation) {
-    //Axis Aligned Bounding Box
-    corners aabbBox;
-    boundingBox aabb = boundingBox_calculateAABB(scene->allObjects[idx], &aabbBox);
-    scene->boundingBoxes[0] = boundingBox_createObjectFromBoundingBox(aabbBox);
-
-    //Object Oriented Bounding Box
-    corners oobbBox;
-    boundingBox_createOOBFromAABB(aabb, scene->allObjects[idx], &oobbBox, bunnyTranslation);
-    scene->boundingBoxes[1] = boundingBox_createObjectFromBoundingBox(oobbBox);
-
-}
-
-
-/**
- * Laedt ein Quadrat mit Seitenlaenge 1 um den Ursprung
+ * Platziert eine Instanz des Quadrats mit Seitenlaenge 1 um den Ursprung
  * @param model Seite der Box
  * @param translation Position der Seite
  * @param rotation Rotation der Seite
  * @param scale Skalierung der Seite
  */
 static void sceneObjects_renderPlane(scene* scene, objectModels model, vec3 translation, vec3 rotation, GLfloat scale) {
-    scene->allObjects[model] = loadObj_readFile("plane.obj", translation, rotation, scale);
+    //Waende koennen nicht zwischen Lichtquelle und anderen Objekten liegen und werfen daher keinen Schatten
+    bvhTopLevel_addInstance(&scene->topLevel, scene->meshes[PLANE_MESH], model, translation, rotation, scale,
+                            GL_FALSE);
 }
 
 /**
  * Fuegt eine Box der Szene hinzu, die alle anderen Objekte beinhaltet,
- * laesst die Seite aus, von der aus geguckt wird
+ * alle Waende teilen sich ein Mesh
  * @param scale Skalierung der Box
  */
-void sceneObjects_loadBox(scene scene) {
+void sceneObjects_loadBox(scene *scene) {
+
     //Box skalierung
     GLfloat scale = 2.0f;
     //Box translations
@@ -66,74 +51,106 @@ void sceneObjects_loadBox(scene scene) {
     vec3 upperRot = {180, 0, 0};
     vec3 frontRot = {-90, 0, 0};
 
-    //Alle Waende laden
-    sceneObjects_renderPlane(&scene, UPPER_WALL, upperTrans, upperRot, scale);
-    sceneObjects_renderPlane(&scene, LOWER_WALL, lowerTrans, lowerRot, scale);
-    sceneObjects_renderPlane(&scene, RIGHT_WALL, rightTrans, rightRot, scale);
-    sceneObjects_renderPlane(&scene, LEFT_WALL, leftTrans, leftRot, scale);
-    sceneObjects_renderPlane(&scene, FRONT_WALL, frontTrans, frontRot, scale);
-    sceneObjects_renderPlane(&scene, REAR_WALL, rearTrans, rearRot, scale);
+    //Alle Waende platzieren
+    sceneObjects_renderPlane(scene, UPPER_WALL, upperTrans, upperRot, scale);
+    sceneObjects_renderPlane(scene, LOWER_WALL, lowerTrans, lowerRot, scale);
+    sceneObjects_renderPlane(scene, RIGHT_WALL, rightTrans, rightRot, scale);
+    sceneObjects_renderPlane(scene, LEFT_WALL, leftTrans, leftRot, scale);
+    sceneObjects_renderPlane(scene, FRONT_WALL, frontTrans, frontRot, scale);
+    sceneObjects_renderPlane(scene, REAR_WALL, rearTrans, rearRot, scale);
 }
 
 /**
- * Laedt den teiltransparenten Wuerfel
+ * Platziert den teiltransparenten Wuerfel
  * @param scene aktuelle Szene
  */
 static void sceneObjects_loadCube(scene * scene){
     vec3 cubeTranslation = {-1.2f * CUBE_SCALE, -0.79999f, 1.2f * CUBE_SCALE};
     vec3 cubeRotation = {0.0f, -33.0f, 0.0f};
-    scene->allObjects[CUBE] = loadObj_readFile("cube.obj", cubeTranslation, cubeRotation, CUBE_SCALE);
+    bvhTopLevel_addInstance(&scene->topLevel, scene->meshes[CUBE_MESH], CUBE, cubeTranslation, cubeRotation,
+                            CUBE_SCALE, GL_TRUE);
 }
 
 /**
- * Laedt den Spiegel
+ * Platziert den Spiegel, von hinten wird er nicht platziert.
+ * Ein bereits geladenes Mesh bleibt dann fuer die naechste Ansicht erhalten.
  * @param scene aktuelle Szene
  */
 static void sceneObjects_loadMirror(scene *scene) {
     if (scene->projPlane.viewMode != BACK) {
-        scene->allObjects[MIRROR] = loadObj_readFile("mirror.obj", (vec3) {0, 0, 0}, (vec3) {0, 0, 0}, 1.0f);
-    } else {
-        scene->allObjects[MIRROR] = sceneObjects_initDefaultModel();
+        bvhTopLevel_addInstance(&scene->topLevel, scene->meshes[MIRROR_MESH], MIRROR, (vec3) {0, 0, 0},
+                                (vec3) {0, 0, 0}, 1.0f, GL_TRUE);
     }
 }
 
 /**
- * Laedt den Hasen
- * @param scene aktuelle Szene
+ * Liefert die Datei des Hasen
  * @param size Feinheit des Hasens
+ * @return Dateiname im Modellordner
  */
-static void sceneObjects_loadBunny(scene * scene, bunnySize size){
-    char *fileName;
-    vec3 bunnyTranslation = {0.55f, -0.999f, -0.075f};
-    vec3 bunnyRotation = {0.0f, 45.0f, 0.0f};
-    GLfloat scale = BUNNY_SCALE;
+static const char *sceneObjects_bunnyFile(bunnySize size) {
     switch (size) {
         case grob:
-            fileName = "bunny-grob.obj";
-            glm_vec3_copy((vec3){0.0f, -45.0f, 0.0f}, bunnyRotation);
-            break;
+            return "bunny-grob.obj";
         case mittel:
-            fileName = "bunny-med.obj";
-            break;
+            return "bunny-med.obj";
         case fein:
-            fileName = "bunny-fein.obj";
-            break;
+            return "bunny-fein.obj";
         case sehr_fein:
-            fileName = "bunny-sehrFein.obj";
-            break;
+            return "bunny-sehrFein.obj";
         case extrem_fein:
-            fileName = "bunny-extreme.obj";
-            break;
+            return "bunny-extreme.obj";
         default:
             printf("Unknown Bunny!\n");
             exit(1);
     }
+}
 
-    scene->allObjects[BUNNY] = loadObj_readFile(fileName, bunnyTranslation, bunnyRotation, scale);
+/**
+ * Platziert den Hasen
+ * @param scene aktuelle Szene
+ * @param size Feinheit des Hasens
+ */
+static void sceneObjects_loadBunny(scene * scene, bunnySize size){
+    vec3 bunnyTranslation = {0.55f, -0.999f, -0.075f};
+    vec3 bunnyRotation = {0.0f, 45.0f, 0.0f};
+    GLfloat scale = BUNNY_SCALE;
+    if (size == grob) {
+        glm_vec3_copy((vec3){0.0f, -45.0f, 0.0f}, bunnyRotation);
+    }
 
-    sceneObjects_initBoundingBoxes(scene, BUNNY, bunnyTranslation);
+    bvhTopLevel_addInstance(&scene->topLevel, scene->meshes[BUNNY_MESH], BUNNY, bunnyTranslation, bunnyRotation,
+                            scale, GL_TRUE);
+}
 
-    scene->allObjects[BOUNDING_BOX] = scene->boundingBoxes[scene->lastUsedBB];
+/**
+ * Holt alle Meshes, die die Szene noch nicht haelt, in einem Auftrag aus dem Ressourcen-Cache.
+ * Fehlende Dateien werden dort gleichzeitig geladen, die Szene sieht die Meshes erst, wenn alle fertig sind.
+ * @param scene aktuelle Szene
+ * @param size Feinheit des Hasens
+ */
+static void sceneObjects_acquireMeshes(scene *scene, bunnySize size) {
+    const char *fileNames[AMOUNT_MESHES];
+    fileNames[PLANE_MESH] = "plane.obj";
+    fileNames[CUBE_MESH] = "cube.obj";
+    fileNames[MIRROR_MESH] = "mirror.obj";
+    fileNames[BUNNY_MESH] = sceneObjects_bunnyFile(size);
+
+    const char *missingFiles[AMOUNT_MESHES];
+    meshModels missing[AMOUNT_MESHES];
+    const object *loaded[AMOUNT_MESHES];
+    GLint missingCount = 0;
+    for (int i = 0; i < AMOUNT_MESHES; ++i) {
+        //Von hinten wird der Spiegel nicht gebraucht
+        if (scene->meshes[i] == NULL && (i != MIRROR_MESH || scene->projPlane.viewMode != BACK)) {
+            missingFiles[missingCount] = fileNames[i];
+            missing[missingCount++] = (meshModels) i;
+        }
+    }
+    resources_acquireMeshes(&scene->resources, missingFiles, missingCount, loaded);
+    for (int i = 0; i < missingCount; ++i) {
+        scene->meshes[missing[i]] = loaded[i];
+    }
 }
 
 /**
@@ -143,7 +160,6 @@ static void sceneObjects_loadBunny(scene * scene, bunnySize size){
 static void sceneObjects_loadSphere(scene *scene){
     glm_vec3_copy((vec3) {0.0f, -0.799f, -0.65f}, scene->sphere.center);
     scene->sphere.radius = SPHERE_RADIUS;
-    scene->allObjects[SPHERE] = sceneObjects_initDefaultModel();
 }
 
 /**---------------------------------------- GLOBAL FUNCTION IMPLEMENTATION --------------------------------------*/
@@ -155,11 +171,33 @@ object sceneObjects_initDefaultModel(void) {
     result.faceCount = 0;
     result.vertices = NULL;
     result.facesTM = NULL;
+    result.indices = NULL;
+    result.bvh.nodes = NULL;
+    result.bvh.nodeCount = 0;
+    result.bvh.nodes4 = NULL;
+    result.bvh.nodeCount4 = 0;
+    result.bvh.nodes8 = NULL;
+    result.bvh.nodeCount8 = 0;
+    result.bvh.blocks4 = NULL;
+    result.bvh.blockCount4 = 0;
+    result.bvh.leafBlock4 = NULL;
+    result.bvh.blocks8 = NULL;
+    result.bvh.blockCount8 = 0;
+    result.bvh.leafBlock8 = NULL;
+    result.bvh.nodesQ = NULL;
+    result.bvh.nodeCountQ = 0;
+    result.bvh.compressedOnly = GL_FALSE;
+    memset(&result.bounds, 0, sizeof(result.bounds));
+    result.mapping = NULL;
+    result.mappingSize = 0;
 
     return result;
 }
 
 void sceneObjects_initModels(scene *scene) {
+    /*---------------------------- MESHES ----------------------------*/
+    sceneObjects_acquireMeshes(scene, grob);
+
     /*---------------------------- WUERFEL ----------------------------*/
     sceneObjects_loadCube(scene);
 
@@ -173,7 +211,26 @@ void sceneObjects_initModels(scene *scene) {
     sceneObjects_loadSphere(scene);
 
     /*---------------------------- BOX ----------------------------*/
-    sceneObjects_loadBox(*scene);
+    sceneObjects_loadBox(scene);
+
+    /*---------------------------- INSTANZEN ----------------------------*/
+    accelerator_build(&scene->accel, &scene->topLevel);
+    printf("Scene: \t%d Instances of %d Meshes, %s %zu KB (%d ms)\n", scene->topLevel.instanceCount,
+           AMOUNT_MESHES, accelerator_name(scene->accel.type), accelerator_memoryFootprint(&scene->accel) / 1024,
+           accelerator_buildTime(&scene->accel));
+}
+
+void sceneObjects_freeInstances(scene *scene) {
+    accelerator_free(&scene->accel);
+    bvhTopLevel_free(&scene->topLevel);
+}
+
+void sceneObjects_freeModels(scene *scene) {
+    sceneObjects_freeInstances(scene);
+    for (int i = 0; i < AMOUNT_MESHES; ++i) {
+        resources_releaseMesh(&scene->resources, scene->meshes[i]);
+        scene->meshes[i] = NULL;
+    }
 }
 
 void sceneObjects_setViewDir(scene * scene, viewMode mode) {
@@ -316,7 +373,7 @@ void sceneObjects_initPointLights(scene *scene) {
     scene->pointLights[1].active = GL_TRUE;
 }
 
-void sceneObjects_setHitObjectMaterial(scene scene, Hit *hitObject) {
+void sceneObjects_setHitObjectMaterial(Hit *hitObject) {
     switch (hitObject->idxObject) {
         case BUNNY:
             hitObject->material.ka = AMBIENT_GREEN;
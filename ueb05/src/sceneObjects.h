@@ -8,13 +8,27 @@
  */
 object sceneObjects_initDefaultModel();
 
-void sceneObjects_loadBox(scene scene);
+/**
+ * Platziert je Wand eine Instanz des Wand-Meshes (scene.meshes[PLANE_MESH]) in der Szene
+ */
+void sceneObjects_loadBox(scene *scene);
 
 /**
- * Laedt die Objekte und platziert sie am richtigen Ort in der Szene
+ * Holt noch nicht geladene Meshes aus dem Ressourcen-Cache, platziert ihre Instanzen
+ * am richtigen Ort in der Szene und baut die BVH ueber die Instanzen auf
  */
 void sceneObjects_initModels(scene *scene);
 
+/**
+ * Gibt die Instanzen und die Beschleunigungsstruktur frei, die Meshes bleiben geladen
+ */
+void sceneObjects_freeInstances(scene *scene);
+
+/**
+ * Gibt die Instanzen und die Bounding Boxes der Szene frei und die Meshes an den Ressourcen-Cache zurueck
+ */
+void sceneObjects_freeModels(scene *scene);
+
 /**
  * Baut die Projektionsebene abhaengig von der Blickrichtung auf die Szene aus
  * @param mode Blickrichtung
@@ -31,5 +45,5 @@ void sceneObjects_initPointLights(scene *scene);
  * abhaengig von dem getroffenen Objekt in der Szene
  * @param hitObject Hit Objekt
  */
-void sceneObjects_setHitObjectMaterial(scene scene, Hit *hitObject);
+void sceneObjects_setHitObjectMaterial(Hit *hitObject);
 #endif //RAYTRACER_SCENEOBJECTS_H
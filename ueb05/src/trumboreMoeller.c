@@ -49,4 +49,276 @@ Hit trumboreMoeller_rayTriangleIntersection(Ray ray, triangleTM currTri) {
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+GLboolean trumboreMoeller_rayTriangleOccludes(const Ray *ray, const triangleTM *currTri, GLfloat maxDist) {
+    vec3 tVec, pVec, qVec;
+
+    //Gleiche Rechenschritte wie beim vollen Test, aber ohne Hit und Trefferposition
+    glm_vec3_cross((float *) ray->dir, (float *) currTri->edge2, pVec);
+    GLfloat det = glm_vec3_dot((float *) currTri->edge1, pVec);
+    if (fabsf(det) < EPSILON) return GL_FALSE;
+
+    GLfloat invDet = 1.0f / det;
+    glm_vec3_sub((float *) ray->start, (float *) currTri->vertices.a, tVec);
+
+    GLfloat u = invDet * glm_vec3_dot(tVec, pVec);
+    if ((u < 0.0f) || (u > 1.0f)) return GL_FALSE;
+
+    glm_vec3_cross(tVec, (float *) currTri->edge1, qVec);
+    GLfloat v = invDet * glm_vec3_dot((float *) ray->dir, qVec);
+    if ((v < 0.0f) || (u + v > 1.0f)) return GL_FALSE;
+
+    GLfloat dist = invDet * glm_vec3_dot((float *) currTri->edge2, qVec);
+    return dist > EPSILON && dist < maxDist;
+}
+
+GLboolean trumboreMoeller_rayVertexIntersection(const Ray *ray, const vec3 a, const vec3 b, const vec3 c,
+                                                GLfloat maxDist, GLfloat *dist) {
+    vec3 edge1, edge2, tVec, pVec, qVec;
+
+    //Kanten wie utils_calcTwoEdgesTM, danach die gleichen Rechenschritte wie beim vollen Test
+    glm_vec3_sub((float *) b, (float *) a, edge1);
+    glm_vec3_sub((float *) c, (float *) a, edge2);
+
+    glm_vec3_cross((float *) ray->dir, edge2, pVec);
+    GLfloat det = glm_vec3_dot(edge1, pVec);
+    if (fabsf(det) < EPSILON) return GL_FALSE;
+
+    GLfloat invDet = 1.0f / det;
+    glm_vec3_sub((float *) ray->start, (float *) a, tVec);
+
+    GLfloat u = invDet * glm_vec3_dot(tVec, pVec);
+    if ((u < 0.0f) || (u > 1.0f)) return GL_FALSE;
+
+    glm_vec3_cross(tVec, edge1, qVec);
+    GLfloat v = invDet * glm_vec3_dot((float *) ray->dir, qVec);
+    if ((v < 0.0f) || (u + v > 1.0f)) return GL_FALSE;
+
+    GLfloat t = invDet * glm_vec3_dot(edge2, qVec);
+    if (t > EPSILON && t < maxDist) {
+        *dist = t;
+        return GL_TRUE;
+    }
+    return GL_FALSE;
+}
+
+/**
+ * Waehlt aus den Ergebnissen eines Blocktests den naehesten Treffer aus
+ * @param mask Bitmaske der getroffenen Plaetze
+ * @param count Anzahl der Plaetze
+ * @return naehester Platz, -1 wenn keiner dichter als dist liegt
+ */
+static GLint trumboreMoeller_nearestLane(GLint mask, GLint count, const GLfloat *t, const GLfloat *u,
+                                         const GLfloat *v, GLfloat *dist, GLfloat *uOut, GLfloat *vOut) {
+    GLint result = -1;
+    for (int i = 0; i < count; ++i) {
+        if ((mask & (1 << i)) && t[i] < *dist) {
+            *dist = t[i];
+            *uOut = u[i];
+            *vOut = v[i];
+            result = i;
+        }
+    }
+    return result;
+}
+
+/**
+ * Schnitttest fuer 4 Dreiecke eines SoA Blocks ab dem Platz lane (Reihenabstand stride)
+ * Rechenreihenfolge entspricht trumboreMoeller_rayTriangleIntersection.
+ * @param maxDist nur Treffer dichter als maxDist werden in die Maske aufgenommen
+ * @param t, u, v Ausgabe der Distanzen und baryzentrischen Koordinaten je Platz, NULL beim Schattentest
+ * @return Bitmaske der getroffenen Plaetze (EPSILON < Distanz < maxDist)
+ */
+static GLint trumboreMoeller_intersectLanes4(const triangleBlockRay *ray, const GLfloat *vertex, const GLfloat *edge1,
+                                             const GLfloat *edge2, GLint stride, GLfloat maxDist, GLfloat *t,
+                                             GLfloat *u, GLfloat *v) {
+#ifdef CGLM_SSE_FP
+    __m128 e1x = _mm_loadu_ps(edge1), e1y = _mm_loadu_ps(edge1 + stride), e1z = _mm_loadu_ps(edge1 + 2 * stride);
+    __m128 e2x = _mm_loadu_ps(edge2), e2y = _mm_loadu_ps(edge2 + stride), e2z = _mm_loadu_ps(edge2 + 2 * stride);
+
+    //pVec = dir x edge2, det = edge1 * pVec
+    __m128 px = _mm_sub_ps(_mm_mul_ps(ray->dir4[1], e2z), _mm_mul_ps(ray->dir4[2], e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(ray->dir4[2], e2x), _mm_mul_ps(ray->dir4[0], e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(ray->dir4[0], e2y), _mm_mul_ps(ray->dir4[1], e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    //tVec = start - vertex
+    __m128 tx = _mm_sub_ps(ray->start4[0], _mm_loadu_ps(vertex));
+    __m128 ty = _mm_sub_ps(ray->start4[1], _mm_loadu_ps(vertex + stride));
+    __m128 tz = _mm_sub_ps(ray->start4[2], _mm_loadu_ps(vertex + 2 * stride));
+
+    __m128 uu = _mm_mul_ps(invDet,
+                           _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)));
+
+    //qVec = tVec x edge1
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+    __m128 vv = _mm_mul_ps(invDet, _mm_add_ps(_mm_add_ps(_mm_mul_ps(ray->dir4[0], qx), _mm_mul_ps(ray->dir4[1], qy)),
+                                              _mm_mul_ps(ray->dir4[2], qz)));
+    __m128 tt = _mm_mul_ps(invDet, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)),
+                                              _mm_mul_ps(e2z, qz)));
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 mask = _mm_cmpge_ps(absDet, _mm_set1_ps(EPSILON));
+    mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(uu, zero), _mm_cmple_ps(uu, one)));
+    mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpge_ps(vv, zero), _mm_cmple_ps(_mm_add_ps(uu, vv), one)));
+    mask = _mm_and_ps(mask, _mm_and_ps(_mm_cmpgt_ps(tt, _mm_set1_ps(EPSILON)),
+                                       _mm_cmplt_ps(tt, _mm_set1_ps(maxDist))));
+
+    if (t != NULL) {
+        _mm_storeu_ps(t, tt);
+        _mm_storeu_ps(u, uu);
+        _mm_storeu_ps(v, vv);
+    }
+    return _mm_movemask_ps(mask);
+#else
+    GLint result = 0;
+    for (int i = 0; i < 4; ++i) {
+        vec3 e1 = {edge1[i], edge1[stride + i], edge1[2 * stride + i]};
+        vec3 e2 = {edge2[i], edge2[stride + i], edge2[2 * stride + i]};
+        vec3 a = {vertex[i], vertex[stride + i], vertex[2 * stride + i]};
+        vec3 pVec, tVec, qVec;
+
+        glm_vec3_cross((float *) ray->dir, e2, pVec);
+        GLfloat det = glm_vec3_dot(e1, pVec);
+        if (fabsf(det) < EPSILON) continue;
+        GLfloat invDet = 1.0f / det;
+
+        glm_vec3_sub((float *) ray->start, a, tVec);
+        GLfloat uu = invDet * glm_vec3_dot(tVec, pVec);
+        if ((uu < 0.0f) || (uu > 1.0f)) continue;
+
+        glm_vec3_cross(tVec, e1, qVec);
+        GLfloat vv = invDet * glm_vec3_dot((float *) ray->dir, qVec);
+        if ((vv < 0.0f) || (uu + vv > 1.0f)) continue;
+
+        GLfloat tt = invDet * glm_vec3_dot(e2, qVec);
+        if (tt > EPSILON && tt < maxDist) {
+            result |= 1 << i;
+            if (t != NULL) {
+                t[i] = tt;
+                u[i] = uu;
+                v[i] = vv;
+            }
+        }
+    }
+    return result;
+#endif
+}
+
+/**
+ * Schnitttest fuer alle 8 Dreiecke eines Blocks (AVX, ohne AVX zwei 4er Tests)
+ * @param maxDist nur Treffer dichter als maxDist werden in die Maske aufgenommen
+ * @param t, u, v Ausgabe der Distanzen und baryzentrischen Koordinaten je Platz, NULL beim Schattentest
+ * @return Bitmaske der getroffenen Plaetze (EPSILON < Distanz < maxDist)
+ */
+static GLint trumboreMoeller_intersectLanes8(const triangleBlockRay *ray, const triangleBlock8 *block,
+                                             GLfloat maxDist, GLfloat *t, GLfloat *u, GLfloat *v) {
+#ifdef CGLM_AVX_FP
+    const GLfloat *edge1 = &block->edge1[0][0];
+    const GLfloat *edge2 = &block->edge2[0][0];
+    const GLfloat *vertex = &block->vertex[0][0];
+    __m256 e1x = _mm256_loadu_ps(edge1), e1y = _mm256_loadu_ps(edge1 + 8), e1z = _mm256_loadu_ps(edge1 + 16);
+    __m256 e2x = _mm256_loadu_ps(edge2), e2y = _mm256_loadu_ps(edge2 + 8), e2z = _mm256_loadu_ps(edge2 + 16);
+
+    //pVec = dir x edge2, det = edge1 * pVec
+    __m256 px = _mm256_sub_ps(_mm256_mul_ps(ray->dir8[1], e2z), _mm256_mul_ps(ray->dir8[2], e2y));
+    __m256 py = _mm256_sub_ps(_mm256_mul_ps(ray->dir8[2], e2x), _mm256_mul_ps(ray->dir8[0], e2z));
+    __m256 pz = _mm256_sub_ps(_mm256_mul_ps(ray->dir8[0], e2y), _mm256_mul_ps(ray->dir8[1], e2x));
+    __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)),
+                               _mm256_mul_ps(e1z, pz));
+    __m256 absDet = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det);
+    __m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+
+    //tVec = start - vertex
+    __m256 tx = _mm256_sub_ps(ray->start8[0], _mm256_loadu_ps(vertex));
+    __m256 ty = _mm256_sub_ps(ray->start8[1], _mm256_loadu_ps(vertex + 8));
+    __m256 tz = _mm256_sub_ps(ray->start8[2], _mm256_loadu_ps(vertex + 16));
+
+    __m256 uu = _mm256_mul_ps(invDet, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(tx, px), _mm256_mul_ps(ty, py)),
+                                                    _mm256_mul_ps(tz, pz)));
+
+    //qVec = tVec x edge1
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(ty, e1z), _mm256_mul_ps(tz, e1y));
+    __m256 qy = _mm256_sub_ps(_mm256_mul_ps(tz, e1x), _mm256_mul_ps(tx, e1z));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(tx, e1y), _mm256_mul_ps(ty, e1x));
+    __m256 vv = _mm256_mul_ps(invDet, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ray->dir8[0], qx),
+                                                                  _mm256_mul_ps(ray->dir8[1], qy)),
+                                                    _mm256_mul_ps(ray->dir8[2], qz)));
+    __m256 tt = _mm256_mul_ps(invDet, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)),
+                                                    _mm256_mul_ps(e2z, qz)));
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 m = _mm256_cmp_ps(absDet, _mm256_set1_ps(EPSILON), _CMP_GE_OQ);
+    m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(uu, zero, _CMP_GE_OQ), _mm256_cmp_ps(uu, one, _CMP_LE_OQ)));
+    m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(vv, zero, _CMP_GE_OQ),
+                                       _mm256_cmp_ps(_mm256_add_ps(uu, vv), one, _CMP_LE_OQ)));
+    m = _mm256_and_ps(m, _mm256_and_ps(_mm256_cmp_ps(tt, _mm256_set1_ps(EPSILON), _CMP_GT_OQ),
+                                       _mm256_cmp_ps(tt, _mm256_set1_ps(maxDist), _CMP_LT_OQ)));
+
+    if (t != NULL) {
+        _mm256_storeu_ps(t, tt);
+        _mm256_storeu_ps(u, uu);
+        _mm256_storeu_ps(v, vv);
+    }
+    return _mm256_movemask_ps(m);
+#else
+    GLint mask = trumboreMoeller_intersectLanes4(ray, &block->vertex[0][0], &block->edge1[0][0],
+                                                 &block->edge2[0][0], 8, maxDist, t, u, v);
+    mask |= trumboreMoeller_intersectLanes4(ray, &block->vertex[0][4], &block->edge1[0][4], &block->edge2[0][4], 8,
+                                            maxDist, t != NULL ? t + 4 : NULL, t != NULL ? u + 4 : NULL,
+                                            t != NULL ? v + 4 : NULL) << 4;
+    return mask;
+#endif
+}
+
+void trumboreMoeller_initBlockRay(const Ray *ray, triangleBlockRay *result) {
+    for (int axis = 0; axis < 3; ++axis) {
+        result->start[axis] = ray->start[axis];
+        result->dir[axis] = ray->dir[axis];
+#ifdef CGLM_SSE_FP
+        result->start4[axis] = _mm_set1_ps(ray->start[axis]);
+        result->dir4[axis] = _mm_set1_ps(ray->dir[axis]);
+#endif
+#ifdef CGLM_AVX_FP
+        result->start8[axis] = _mm256_set1_ps(ray->start[axis]);
+        result->dir8[axis] = _mm256_set1_ps(ray->dir[axis]);
+#endif
+    }
+}
+
+GLint trumboreMoeller_intersectBlock4(const triangleBlockRay *ray, const triangleBlock4 *block, GLfloat *dist,
+                                      GLfloat *u, GLfloat *v) {
+    GLfloat tLanes[4], uLanes[4], vLanes[4];
+    GLint mask = trumboreMoeller_intersectLanes4(ray, &block->vertex[0][0], &block->edge1[0][0],
+                                                 &block->edge2[0][0], 4, *dist, tLanes, uLanes, vLanes);
+    if (mask == 0) {
+        return -1;
+    }
+    return trumboreMoeller_nearestLane(mask, 4, tLanes, uLanes, vLanes, dist, u, v);
+}
+
+GLint trumboreMoeller_intersectBlock8(const triangleBlockRay *ray, const triangleBlock8 *block, GLfloat *dist,
+                                      GLfloat *u, GLfloat *v) {
+    GLfloat tLanes[8], uLanes[8], vLanes[8];
+    GLint mask = trumboreMoeller_intersectLanes8(ray, block, *dist, tLanes, uLanes, vLanes);
+    if (mask == 0) {
+        return -1;
+    }
+    return trumboreMoeller_nearestLane(mask, 8, tLanes, uLanes, vLanes, dist, u, v);
+}
+
+GLboolean trumboreMoeller_occludesBlock4(const triangleBlockRay *ray, const triangleBlock4 *block, GLfloat maxDist) {
+    return trumboreMoeller_intersectLanes4(ray, &block->vertex[0][0], &block->edge1[0][0], &block->edge2[0][0], 4,
+                                           maxDist, NULL, NULL, NULL) != 0;
+}
+
+GLboolean trumboreMoeller_occludesBlock8(const triangleBlockRay *ray, const triangleBlock8 *block, GLfloat maxDist) {
+    return trumboreMoeller_intersectLanes8(ray, block, maxDist, NULL, NULL, NULL) != 0;
+}
@@ -2,6 +2,20 @@
 #define RAYTRACER_TRUMBOREMOELLER_H
 #include "types.h"
 
+/** Strahl, dessen Start und Richtung fuer die Blocktests in SIMD Register verteilt wurden */
+typedef struct triangleBlockRay {
+    vec3 start;
+    vec3 dir;
+#ifdef CGLM_SSE_FP
+    __m128 start4[3];
+    __m128 dir4[3];
+#endif
+#ifdef CGLM_AVX_FP
+    __m256 start8[3];
+    __m256 dir8[3];
+#endif
+} triangleBlockRay;
+
 /**
  * Prueft, ob ein Strahl ein Dreieck trifft
  * !!! Effiziente Implementierung SEHR WICHTIG !!!
@@ -14,4 +28,78 @@
  */
 Hit trumboreMoeller_rayTriangleIntersection(Ray, triangleTM);
 
+/**
+ * Prueft fuer Schattenstrahlen nur, ob ein Dreieck vor maxDist getroffen wird.
+ * Es wird weder ein Hit noch die Trefferposition berechnet.
+ * @param ray Strahl
+ * @param currTri Dreieck
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE, wenn das Dreieck mit EPSILON < Distanz < maxDist getroffen wird
+ */
+GLboolean trumboreMoeller_rayTriangleOccludes(const Ray *ray, const triangleTM *currTri, GLfloat maxDist);
+
+/**
+ * Schnitttest mit einem indizierten Dreieck, die Kanten werden erst beim Test aus den Vertizes berechnet.
+ * Wird von der komprimierten BVH verwendet, die ohne triangleTM Records auskommt.
+ * @param ray Strahl
+ * @param a erster Vertex
+ * @param b zweiter Vertex
+ * @param c dritter Vertex
+ * @param maxDist maximale Distanz
+ * @param dist Ausgabe, Distanz zum Schnittpunkt (nur wenn getroffen)
+ * @return GL_TRUE, wenn das Dreieck mit EPSILON < Distanz < maxDist getroffen wird
+ */
+GLboolean trumboreMoeller_rayVertexIntersection(const Ray *ray, const vec3 a, const vec3 b, const vec3 c,
+                                                GLfloat maxDist, GLfloat *dist);
+
+/**
+ * Bereitet einen Strahl fuer die Blocktests vor
+ * @param ray Strahl
+ * @param result vorbereiteter Strahl
+ */
+void trumboreMoeller_initBlockRay(const Ray *ray, triangleBlockRay *result);
+
+/**
+ * Testet einen Strahl gegen alle 4 Dreiecke eines Blocks (SSE)
+ * @param ray vorbereiteter Strahl
+ * @param block Dreiecksblock
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Treffer (nur wenn getroffen)
+ * @param u Aus: baryzentrische u-Koordinate des naehesten Treffers
+ * @param v Aus: baryzentrische v-Koordinate des naehesten Treffers
+ * @return Platz des naehesten getroffenen Dreiecks im Block, -1 wenn keins dichter als dist getroffen wurde
+ */
+GLint trumboreMoeller_intersectBlock4(const triangleBlockRay *ray, const triangleBlock4 *block, GLfloat *dist,
+                                      GLfloat *u, GLfloat *v);
+
+/**
+ * Testet einen Strahl gegen alle 8 Dreiecke eines Blocks (AVX, ohne AVX zwei SSE Tests)
+ * @param ray vorbereiteter Strahl
+ * @param block Dreiecksblock
+ * @param dist Ein: maximale Distanz, Aus: Distanz zum naehesten Treffer (nur wenn getroffen)
+ * @param u Aus: baryzentrische u-Koordinate des naehesten Treffers
+ * @param v Aus: baryzentrische v-Koordinate des naehesten Treffers
+ * @return Platz des naehesten getroffenen Dreiecks im Block, -1 wenn keins dichter als dist getroffen wurde
+ */
+GLint trumboreMoeller_intersectBlock8(const triangleBlockRay *ray, const triangleBlock8 *block, GLfloat *dist,
+                                      GLfloat *u, GLfloat *v);
+
+/**
+ * Prueft fuer Schattenstrahlen, ob irgendein Dreieck eines 4er Blocks vor maxDist getroffen wird.
+ * Es wird weder der naeheste Platz gesucht noch werden baryzentrische Koordinaten geschrieben.
+ * @param ray vorbereiteter Strahl
+ * @param block Dreiecksblock
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE bei einem Treffer
+ */
+GLboolean trumboreMoeller_occludesBlock4(const triangleBlockRay *ray, const triangleBlock4 *block, GLfloat maxDist);
+
+/**
+ * Prueft fuer Schattenstrahlen, ob irgendein Dreieck eines 8er Blocks vor maxDist getroffen wird
+ * @param ray vorbereiteter Strahl
+ * @param block Dreiecksblock
+ * @param maxDist maximale Distanz
+ * @return GL_TRUE bei einem Treffer
+ */
+GLboolean trumboreMoeller_occludesBlock8(const triangleBlockRay *ray, const triangleBlock8 *block, GLfloat maxDist);
+
 #endif //RAYTRACER_TRUMBOREMOELLER_H
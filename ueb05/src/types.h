@@ -24,6 +24,7 @@
 #endif
 
 #include <cglm/cglm.h>
+#include <pthread.h>
 
 /** ------------------------------------------------- Konstanten ------------------------------------------------- */
 
@@ -40,6 +41,23 @@
 #define AMOUNT_LIGHTS (2)
 /** Minimale Intensitaet die berechent werden muss, damit Rekursion fortgefuehrt wird */
 #define MINIMUM_INTENSITIY (0.05f)
+/** Pixelabstand des ersten Durchgangs der progressiven Vorschau (halbiert sich je Durchgang bis 1) */
+#define PROGRESSIVE_START_STEP (8)
+
+/** Abstand, in dem der Fortschritt ohne Fenster ausgegeben wird (Millisekunden) */
+#define PROGRESS_REPORT_MILLIS (500)
+/** Threads, deren Arbeitszeit der Fortschritt getrennt zaehlt, weitere teilen sich die Eintraege */
+#define PROGRESS_MAX_THREADS (256)
+/** Primaerstrahlen, die im Wavefront-Modus gemeinsam durch alle Stufen laufen (mindestens eine Paketzeile) */
+#define WAVEFRONT_BATCH_RAYS (4096)
+
+/** Kennung und Version der Mesh-Dateien, die Version muss bei jeder Aenderung am Dateiaufbau erhoeht werden */
+#define MESH_CACHE_MAGIC (0x48534d52u)
+#define MESH_CACHE_VERSION (3)
+/** Ausrichtung der Abschnitte einer Mesh-Datei in Bytes (Cache-Zeile) */
+#define MESH_CACHE_ALIGNMENT (64)
+/** Endung der Mesh-Dateien, die neben den .obj Dateien abgelegt werden */
+#define MESH_CACHE_EXTENSION ".mesh"
 
 /**Objekt Konstanten*/
 #define CUBE_SCALE (0.4f)
@@ -131,6 +149,29 @@ typedef struct triangleTM {
     vec3 edge2;
 } triangleTM;
 
+/**
+ * 4 Dreiecke als SoA Block (Reihen x, y, z je Attribut), damit ein Strahl mit einem
+ * SIMD Schnitttest gegen alle Dreiecke des Blocks geprueft werden kann.
+ * Leere Plaetze haben Kanten der Laenge 0 und werden dadurch nie getroffen.
+ */
+typedef struct triangleBlock4 {
+    /** Erster Vertex (a) der Dreiecke */
+    GLfloat vertex[3][4];
+    /** Kanten b - a und c - a */
+    GLfloat edge1[3][4];
+    GLfloat edge2[3][4];
+    /** Index des Dreiecks in facesTM, -1 fuer leere Plaetze */
+    GLint idx[4];
+} triangleBlock4;
+
+/** 8 Dreiecke als SoA Block, Aufbau wie triangleBlock4 */
+typedef struct triangleBlock8 {
+    GLfloat vertex[3][8];
+    GLfloat edge1[3][8];
+    GLfloat edge2[3][8];
+    GLint idx[8];
+} triangleBlock8;
+
 /**Struct, dass ein Punktlicht repraesentiert*/
 typedef struct pointLight {
     vec3 pos;
@@ -145,45 +186,284 @@ typedef struct pointLight {
 
 /** ---------------------------------------------------- Objekte ----------------------------------------------------*/
 
+/** Knoten einer Bounding Volume Hierarchy (32 Byte) */
+typedef struct bvhNode {
+    /** Minimale Ecke der AABB des Knotens */
+    vec3 min;
+    /** Innerer Knoten: Index des linken Kindes (rechtes Kind folgt direkt), Blatt: Index des ersten Dreiecks */
+    GLint leftFirst;
+    /** Maximale Ecke der AABB des Knotens */
+    vec3 max;
+    /** Anzahl der Dreiecke im Blatt, 0 bei inneren Knoten */
+    GLint count;
+} bvhNode;
+
+/**
+ * Knoten einer 4-fach BVH, die Bounds der Kinder liegen als SoA vor
+ * (Reihen: minX, minY, minZ, maxX, maxY, maxZ), damit ein SIMD Slab Test alle Kinder prueft.
+ * Leere Kinder haben NaN Bounds und werden dadurch nie getroffen.
+ */
+typedef struct bvh4Node {
+    GLfloat bounds[6][4];
+    /** Innerer Knoten: Index des Kindknotens, Blatt: Index des ersten Dreiecks */
+    GLint child[4];
+    /** Anzahl der Dreiecke, wenn das Kind ein Blatt ist, sonst 0 */
+    GLint count[4];
+} bvh4Node;
+
+/** Knoten einer 8-fach BVH, Aufbau wie bvh4Node */
+typedef struct bvh8Node {
+    GLfloat bounds[6][8];
+    GLint child[8];
+    GLint count[8];
+} bvh8Node;
+
+/** Maximale Anzahl an Dreiecken in einem Blatt */
+#define BVH_MAX_LEAF_SIZE (8)
+/** Maximale Tiefe der BVH, danach wird ein Blatt erzwungen */
+#define BVH_MAX_DEPTH (48)
+
+/** Bits je Koordinate der quantisierten Knoten (8 oder 16) */
+#ifndef BVH_QUANT_BITS
+#define BVH_QUANT_BITS (8)
+#endif
+
+#if BVH_QUANT_BITS == 16
+typedef GLushort bvhQuant;
+#else
+typedef GLubyte bvhQuant;
+#endif
+
+/**
+ * Innerer Knoten der komprimierten binaeren BVH. Die Bounds der beiden Kinder sind relativ
+ * zur (dekodierten) Box des Knotens quantisiert, nur die Wurzelbox liegt in voller Genauigkeit vor.
+ * Die Blaetter referenzieren indizierte Dreiecke (object.indices) statt triangleTM Records.
+ */
+typedef struct bvhQuantNode {
+    /** Quantisierte Ecken je Kind und Achse */
+    bvhQuant qMin[2][3];
+    bvhQuant qMax[2][3];
+    /** Innerer Knoten: Index des Kindknotens, Blatt: Index des ersten Dreiecks */
+    GLint child[2];
+    /** Anzahl der Dreiecke, wenn das Kind ein Blatt ist, sonst 0 */
+    GLubyte count[2];
+} bvhQuantNode;
+
+/** Speicherlayout der BVH Knoten, das beim Traversieren verwendet wird */
+typedef enum bvhLayout {
+    bvh2,
+    bvh4,
+    bvh8,
+    /** Quantisierte binaere Knoten mit indizierten Dreiecken, das Dreieckslayout wird ignoriert */
+    bvhQuantized
+} bvhLayout;
+
+/** Speicherlayout der Dreiecke in den Blaettern, das beim Traversieren verwendet wird */
+typedef enum triangleLayout {
+    /** Einzelne triangleTM Records */
+    trisAoS,
+    /** SoA Bloecke zu je 4 Dreiecken */
+    trisSoA4,
+    /** SoA Bloecke zu je 8 Dreiecken */
+    trisSoA8
+} triangleLayout;
+
+/** Kantenlaenge der Pixelpakete, in denen Primaerstrahlen gemeinsam verfolgt werden */
+typedef enum packetSize {
+    packetsOff = 1,
+    packets2x2 = 2,
+    packets4x4 = 4,
+    packets8x8 = 8
+} packetSize;
+
+/** Gibt an, welche Bounding Volumes der Objekte vor ihren Dreiecken getestet (und angezeigt) werden */
+typedef enum boundingBoxState {
+    /** Achsenparallele Box */
+    aabb,
+    /** Orientierte Box, falls sie enger als die AABB ist, sonst die AABB */
+    oobb,
+    /** Kein Test, nur die Knoten der BVH ueber die Instanzen */
+    none
+} boundingBoxState;
+
+/** Einstellungen, mit denen die BVHs traversiert werden */
+typedef struct bvhOptions {
+    bvhLayout layout;
+    triangleLayout triLayout;
+    /** Bounding Volume, mit dem die Objekte vor ihrer BVH aussortiert werden */
+    boundingBoxState bounds;
+} bvhOptions;
+
+/** Kennzahlen eines BVH Aufbaus */
+typedef struct bvhStats {
+    /** Aufbauzeit in Millisekunden */
+    GLint buildTime;
+    /** Tiefe des binaeren Baums (Wurzel hat Tiefe 1) */
+    GLint depth;
+    GLint leafCount;
+    /** SAH Kosten relativ zur Oberflaeche der Wurzel */
+    GLfloat sahCost;
+} bvhStats;
+
+/** Bounding Volume Hierarchy ueber die Dreiecke eines Objektes, Wurzel liegt jeweils an Index 0 */
+typedef struct bvh {
+    /** Binaerer Baum, aus dem die weiten Layouts erzeugt werden */
+    bvhNode *nodes;
+    GLint nodeCount;
+    /** Zusammengefasster 4-fach Baum */
+    bvh4Node *nodes4;
+    GLint nodeCount4;
+    /** Zusammengefasster 8-fach Baum */
+    bvh8Node *nodes8;
+    GLint nodeCount8;
+    /** Dreiecke der Blaetter als SoA Bloecke, jedes Blatt beginnt mit einem neuen Block */
+    triangleBlock4 *blocks4;
+    GLint blockCount4;
+    triangleBlock8 *blocks8;
+    GLint blockCount8;
+    /** Erster Block eines Blattes, indiziert ueber das erste Dreieck des Blattes */
+    GLint *leafBlock4;
+    GLint *leafBlock8;
+    /** Komprimierter binaerer Baum (nur innere Knoten, Wurzelbox aus nodes[0]) */
+    bvhQuantNode *nodesQ;
+    GLint nodeCountQ;
+    /**
+     * GL_TRUE, wenn nur die komprimierte BVH aufgebaut wurde: nodes enthaelt nur die Wurzel, es gibt keine
+     * weiten Baeume, keine SoA Bloecke und keine triangleTM Records, jedes Layout traversiert die komprimierte BVH
+     */
+    GLboolean compressedOnly;
+    /** Kennzahlen des Aufbaus */
+    bvhStats stats;
+} bvh;
+
+/**
+ * Vorberechnete Bounding Volumes eines Objektes: eine AABB und eine OBB
+ * (Mittelpunkt, normierte Achsen und halbe Kantenlaengen entlang der Achsen)
+ */
+typedef struct boundingVolume {
+    vec3 min;
+    vec3 max;
+    vec3 center;
+    vec3 axes[3];
+    vec3 halfSize;
+    /** GL_TRUE, wenn die OBB ein kleineres Volumen als die AABB hat */
+    GLboolean useObb;
+} boundingVolume;
+
 /**Struct fuer ein Objekt, welches mit Dreiecken dargestellt wird*/
 typedef struct object {
     GLint vertexCount;
     vec3 *vertices;
     GLint faceCount;
+    /** Vorberechnete Dreiecke, NULL wenn nur die komprimierte BVH aufgebaut wurde (bvh.compressedOnly) */
     triangleTM *facesTM;
+    /** Vertexindizes der Dreiecke, gleiche Reihenfolge wie facesTM */
+    faces *indices;
+    /** Beschleunigungsstruktur ueber facesTM (Dreiecke sind in BVH Reihenfolge sortiert) */
+    bvh bvh;
+    /** Bounding Volumes im Objektraum */
+    boundingVolume bounds;
+    /** Gemappte Mesh-Datei, in der alle Arrays liegen, NULL wenn die Arrays einzeln reserviert wurden */
+    void *mapping;
+    size_t mappingSize;
 } object;
 
-/** Struct, dass einen min und Max Wert speichert*/
-typedef struct minMax {
-    GLfloat min;
-    GLfloat max;
-} minMax;
-
-/**Struct, dass die 6 Min und Max Koordiantenwerte speichert, um einen Cube zu erzeugen*/
-typedef struct cube {
-    minMax cornerX;
-    minMax cornerY;
-    minMax cornerZ;
-} cube;
-
-typedef struct corners {
-    vec3 topFrontLeft;
-    vec3 topFrontRight;
-    vec3 bottomFrontLeft;
-    vec3 bottomFrontRight;
-    vec3 topBackLeft;
-    vec3 topBackRight;
-    vec3 bottomBackLeft;
-    vec3 bottomBackRight;
-} corners;
-
-/**Struct, dass eine Bounding Box repraesentiert*/
-typedef struct boundingBox {
-    GLfloat width;
-    GLfloat height;
-    GLfloat depth;
-    cube cube;
-} boundingBox;
+/** Meshes, die von den Instanzen der Szene gemeinsam genutzt werden */
+typedef enum meshModels {
+    PLANE_MESH,
+    CUBE_MESH,
+    MIRROR_MESH,
+    BUNNY_MESH,
+    AMOUNT_MESHES
+} meshModels;
+
+/**
+ * Instanz eines Meshes in der Szene. Die Dreiecke und die BVH liegen nur einmal im Objektraum vor,
+ * jede Instanz bringt ihre eigene Transformation mit (Matrizen spaltenweise wie bei cglm).
+ */
+typedef struct objectInstance {
+    /** Gemeinsam genutztes Mesh im Objektraum */
+    const object *mesh;
+    /** Modell der Instanz, bestimmt Material und Sonderfaelle beim Rendern */
+    objectModels model;
+    /** Objektraum -> Weltraum */
+    GLfloat toWorld[4][4];
+    /** Weltraum -> Objektraum */
+    GLfloat toObject[4][4];
+    /** Transformation der Normalen in den Weltraum (transponierte Inverse) */
+    GLfloat normalMatrix[3][3];
+    /** GL_TRUE, wenn toWorld die Einheitsmatrix ist, die Strahlen muessen dann nicht transformiert werden */
+    GLboolean identity;
+    /** Instanz wird von Schattenstrahlen getestet */
+    GLboolean castsShadow;
+    /** Bounding Volumes der Instanz im Weltraum, die AABB geht in die BVH ueber die Instanzen ein */
+    boundingVolume bounds;
+} objectInstance;
+
+/** Zweistufige Beschleunigungsstruktur: BVH ueber die Instanzen, jede Instanz verweist auf die BVH ihres Meshes */
+typedef struct topLevel {
+    objectInstance *instances;
+    GLint instanceCount;
+    GLint capacity;
+    /** BVH ueber die AABBs der Instanzen im Weltraum */
+    bvh bvh;
+    /** Index der Instanzen in der Reihenfolge der Blaetter */
+    GLint *order;
+    /** BVH nur ueber die schattenwerfenden Instanzen, fuer Schattenstrahlen */
+    bvh shadowBvh;
+    GLint *shadowOrder;
+} topLevel;
+
+/** Dreieck einer Instanz im Weltraum, wie es in den Zellen des Gitters liegt */
+typedef struct gridTriangle {
+    triangleTM tri;
+    /** Index der Instanz und des Dreiecks im Mesh der Instanz (fuer die Normale) */
+    GLint instance;
+    GLint idx;
+    /** Modell der Instanz fuer die skipMask */
+    objectModels model;
+    /** Instanz wird von Schattenstrahlen getestet */
+    GLboolean castsShadow;
+} gridTriangle;
+
+/**
+ * Gleichmaessiges Gitter ueber die Dreiecke aller Instanzen im Weltraum.
+ * Die Dreiecke jeder Zelle liegen zusammenhaengend in cellTris (cellStart[i] bis cellStart[i + 1]).
+ */
+typedef struct grid {
+    vec3 min;
+    vec3 max;
+    /** Anzahl der Zellen je Achse */
+    GLint res[3];
+    vec3 cellSize;
+    vec3 invCellSize;
+    /** Start der Dreiecksliste je Zelle, Anzahl Zellen + 1 Eintraege */
+    GLint *cellStart;
+    /** Indizes in tris, nach Zellen sortiert */
+    GLint *cellTris;
+    GLint refCount;
+    gridTriangle *tris;
+    GLint triCount;
+} grid;
+
+/** Beschleunigungsstruktur, ueber die die Dreiecksobjekte der Szene geschnitten werden */
+typedef enum acceleratorType {
+    /** Zweistufige BVH ueber die Instanzen und ihre Meshes */
+    accelBvh,
+    /** Gleichmaessiges Gitter mit 3D-DDA Traversierung */
+    accelGrid
+} acceleratorType;
+
+/** Austauschbare Beschleunigungsstruktur ueber die Instanzen der Szene */
+typedef struct accelerator {
+    acceleratorType type;
+    /** Instanzen, ueber die die Struktur aufgebaut wurde */
+    topLevel *tlas;
+    /** Daten des Gitters, nur bei accelGrid aufgebaut */
+    grid grid;
+    /** Aufbauzeit des Backends in Millisekunden */
+    GLint buildTime;
+} accelerator;
 
 /**Aufloesung des Bunny Models*/
 typedef enum bunnySize {
@@ -202,6 +482,20 @@ typedef struct sphere {
 
 /** ------------------------------------------------ MultiThreading Optionen --------------------------------------*/
 
+/** Kantenlaenge der Tiles, in die das Bild fuer die Threads zerlegt wird (Vielfaches der Paketgroessen) */
+#define MULTI_THREAD_TILE_SIZE (16)
+/** Kantenlaenge der Zellen der Kostenkarte, teure Tiles werden in diese Zellen zerlegt */
+#define MULTI_THREAD_COST_CELL (MULTI_THREAD_TILE_SIZE / 2)
+/** Tiles, die mehr als das Vielfache der mittleren Kosten benoetigt haben, werden zerlegt */
+#define MULTI_THREAD_SPLIT_FACTOR (2.0f)
+/** Anzahl der Zellen der Kostenkarte in x- und y-Richtung */
+#define MULTI_THREAD_CELLS_X ((DEFAULT_WINDOW_WIDTH + MULTI_THREAD_COST_CELL - 1) / MULTI_THREAD_COST_CELL)
+#define MULTI_THREAD_CELLS_Y ((DEFAULT_WINDOW_HEIGHT + MULTI_THREAD_COST_CELL - 1) / MULTI_THREAD_COST_CELL)
+
+/** Zaehler, der von mehreren Threads ohne Sperre ueber MULTI_THREAD_ATOMIC_* veraendert wird */
+typedef long multiThreadCounter;
+
+/** Bereich (Tile) der Szene, der als ein Job gerendert wird */
 typedef struct multiThreadRunner {
     /** Breite eines Tiles */
     GLint tileWidth;
@@ -211,10 +505,76 @@ typedef struct multiThreadRunner {
     GLint tileRow;
     /**Start Pixel Reihe des Tiles*/
     GLint tileCol;
+    /** Vor dem Rendern: geschaetzte Kosten aus dem letzten Frame, danach: gemessene Renderzeit in Sekunden */
+    GLfloat cost;
 } multiThreadRunner;
 
+/** Job, der ueber multiThreading_runJobs parallel abgearbeitet wird */
+typedef void (*multiThreadJob)(GLint idx, void *ctx);
+
+/** Job des Render-Pools, thread ist der Index des ausfuehrenden Pool-Threads */
+typedef void (*multiThreadPoolJob)(GLint idx, GLint thread, void *ctx);
+
+/**
+ * Deque eines Pool-Threads mit einem zusammenhaengenden Bereich von Jobs [top, bottom).
+ * Der Besitzer nimmt vorne, andere Threads stehlen die hintere Haelfte.
+ */
+typedef struct multiThreadDeque {
+    pthread_mutex_t lock;
+    /** Naechster Job des Besitzers */
+    GLint top;
+    /** Ende des Bereichs (exklusiv) */
+    GLint bottom;
+} multiThreadDeque;
+
+struct multiThreadPool;
+
+/** Argument eines Pool-Threads */
+typedef struct multiThreadWorker {
+    struct multiThreadPool *pool;
+    /** Index des Threads und seiner Deque */
+    GLint id;
+} multiThreadWorker;
+
+/**
+ * Persistenter Pool aus Arbeitsthreads. Die Threads werden einmal erzeugt, schlafen auf
+ * einer Bedingungsvariable und werden pro Frame ueber eine neue Generation geweckt.
+ * Die Jobs einer Generation werden auf die Deques der Threads verteilt, wer fertig ist, stiehlt.
+ */
+typedef struct multiThreadPool {
+    /** IDs der Arbeitsthreads, NULL solange der Pool nicht gestartet wurde */
+    pthread_t *threads;
+    /** Argumente der Arbeitsthreads */
+    multiThreadWorker *workers;
+    /** Eine Deque pro Arbeitsthread */
+    multiThreadDeque *deques;
+    /** Anzahl der Arbeitsthreads */
+    GLint threadCount;
+    /** Schuetzt generation, running und shutdown */
+    pthread_mutex_t lock;
+    /** Weckt die Arbeitsthreads fuer eine neue Generation oder zum Beenden */
+    pthread_cond_t wakeUp;
+    /** Signalisiert, dass alle Arbeitsthreads die aktuelle Generation abgeschlossen haben */
+    pthread_cond_t done;
+    /** Wird pro Auftrag erhoeht, damit jeder Thread jeden Auftrag genau einmal bearbeitet */
+    GLuint generation;
+    /** Threads, die die aktuelle Generation noch nicht abgeschlossen haben */
+    GLint running;
+    /** Funktion und Kontext des aktuellen Auftrags */
+    multiThreadPoolJob job;
+    void *ctx;
+    /** Jeder Thread fuehrt den Job des Auftrags genau einmal mit seinem Index aus, statt Deques abzuarbeiten */
+    GLboolean each;
+    /** Threads sollen sich beenden */
+    GLboolean shutdown;
+    /** Jeder Arbeitsthread ist fest an einen CPU Kern gebunden */
+    GLboolean pinned;
+} multiThreadPool;
+
 /**Anzahl der Threads mit denen gerendert werden soll*/
 typedef enum multiThreadOptions {
+    /** So viele Threads wie CPU Kerne online sind (Standard) */
+    threadsAuto = 0,
     threads16 = 16,
     threads8 = 8,
     threads4 = 4,
@@ -226,18 +586,20 @@ typedef enum multiThreadOptions {
 typedef struct multiThreadOpts {
     /** Multithreading benutzen */
     GLboolean useMultiThreading;
-    /** Anzahl vertikale Threads */
-    GLint verticalThreads;
-    /** Anzahl horizontale Threads */
-    GLint horizontalThreads;
-    /** Breite eines Tiles */
-    GLint tileWidth;
-    /** Hoehe eines Tiles */
-    GLint tileHeight;
-    /** Alle Threads mit ihren Informationen */
-    multiThreadRunner *threadArgs;
-    /** Alle Thread IDs */
-    pthread_t *threadIds;
+    /** Anzahl der Render-Threads */
+    GLint threadCount;
+    /** Anzahl der Tiles */
+    GLint tileCount;
+    /** Tiles des aktuellen Frames, in der Reihenfolge, in der sie auf die Threads verteilt werden */
+    multiThreadRunner *tiles;
+    /** Renderzeit pro Zelle (MULTI_THREAD_COST_CELL) aus dem letzten Frame, zeilenweise */
+    GLfloat *cellCosts;
+    /** cellCosts enthaelt Messwerte, die fuer die Aufteilung verwendet werden koennen */
+    GLboolean hasCosts;
+    /** Persistente Arbeitsthreads, die die Tiles rendern */
+    multiThreadPool pool;
+    /** Arbeitsthreads an CPU Kerne binden, statt sie vom Betriebssystem verschieben zu lassen */
+    GLboolean pinThreads;
     /** Multithreading Einstellungen */
     multiThreadOptions threadingOpts;
 }multiThreadOpts;
@@ -270,27 +632,186 @@ typedef struct projectionPlane {
     vec3 v;
 } projectionPlane;
 
-/**Gibt an, welche und ob eine Bounding Box um den Hasen gerendert werden soll*/
-typedef enum boundingBoxState {
-    aabb,
-    oobb,
-    none
-} boundingBoxState;
+/**
+ * Fortschritt des laufenden Frames. Die Render-Threads zaehlen ohne Sperren ueber atomare Operationen,
+ * Anzeige und Konsole lesen jederzeit ueber die Funktionen aus progress.h.
+ */
+typedef struct renderProgress {
+    /** Ein Frame wird gerade gerendert */
+    multiThreadCounter running;
+    /** Fortlaufende Nummer des aktuellen Durchgangs ueber alle Frames */
+    multiThreadCounter pass;
+    /** Abgeschlossene Durchgaenge und Durchgaenge des Frames */
+    multiThreadCounter passesDone;
+    multiThreadCounter passCount;
+    /** Fertige Tiles und Tiles des aktuellen Durchgangs */
+    multiThreadCounter tilesDone;
+    multiThreadCounter tileCount;
+    /** Verfolgte Strahlen des Frames (Primaer-, Sekundaer- und Schattenstrahlen) */
+    multiThreadCounter rays;
+    /** Threads, die den Frame rendern */
+    multiThreadCounter threadCount;
+    /** Arbeitszeit je Thread im Frame in Mikrosekunden, wird wie rays pro Paketzeile gemeldet */
+    multiThreadCounter busyMicros[PROGRESS_MAX_THREADS];
+    /** Bezugszeit (multiThreading_seconds) fuer startMillis, wird nur in progress_init gesetzt */
+    double baseTime;
+    /** Start des Frames in Millisekunden nach baseTime */
+    multiThreadCounter startMillis;
+    /** Durchgang, in dem eine Zelle (MULTI_THREAD_COST_CELL) zuletzt fertig wurde, zeilenweise */
+    multiThreadCounter cells[MULTI_THREAD_CELLS_X * MULTI_THREAD_CELLS_Y];
+} renderProgress;
+
+/**
+ * Unveraenderlicher Zustand eines Frames. Wird vor dem Rendern aus der Szene erstellt und von allen
+ * Threads nur gelesen, die Szene selbst wird waehrend der Strahlverfolgung nicht angefasst.
+ * Instanzen und Beschleunigungsstruktur werden referenziert und muessen bis zum Ende des Frames gueltig bleiben.
+ */
+typedef struct renderFrame {
+    /** Ziel der Pixelfarben */
+    Color *fb;
+    /** Instanzen der Meshes */
+    const topLevel *topLevel;
+    /** Beschleunigungsstruktur ueber die Instanzen */
+    const accelerator *accel;
+    /** Kugel der Szene */
+    sphere sphere;
+    /** Projektionsebene der Ansicht */
+    projectionPlane projPlane;
+    /** Punktlichter zum Zeitpunkt des Frames */
+    pointLight pointLights[AMOUNT_LIGHTS];
+    /** Bounding Box des Hasen anzeigen */
+    GLboolean showBB;
+    /** Knoten- und Dreieckslayout der BVHs */
+    bvhOptions bvhOpts;
+    /** Paketgroesse fuer die Primaerstrahlen */
+    packetSize packetSize;
+    /** Frame grob nach fein in mehreren Durchgaengen rendern und jeden Durchgang anzeigen */
+    GLboolean progressive;
+    /** Strahlen stufenweise ueber Queues statt rekursiv pro Pixel verfolgen */
+    GLboolean wavefront;
+    /** Modelle, die Primaerstrahlen ueberspringen (die Wand, von der aus geschaut wird) */
+    GLuint primarySkipMask;
+    /** Fortschritt, den die Threads waehrend des Frames melden */
+    renderProgress *progress;
+} renderFrame;
+
+/** Zustand eines Threads waehrend der Strahlverfolgung, jeder Thread hat seinen eigenen */
+typedef struct traceContext {
+    /** Frame, der gerendert wird */
+    const renderFrame *frame;
+    /** Aktuelle Tiefe der Rekursion (1 = Primaerstrahl) */
+    GLint depth;
+    /** Verfolgte Strahlen, die noch nicht an den Fortschritt gemeldet wurden */
+    GLint rays;
+    /** Index des Threads im Render-Pool (0 ohne Pool), unter dem die Arbeitszeit gemeldet wird */
+    GLint thread;
+} traceContext;
+
+/**
+ * Hintergrund-Renderer: ein eigener Thread rendert angeforderte Frames in den Backbuffer und tauscht
+ * ihn nach Abschluss mit dem angezeigten Framebuffer. Eine neue Anforderung bricht den laufenden Frame ab.
+ */
+typedef struct renderQueue {
+    /** Render-Thread, gueltig wenn started */
+    pthread_t thread;
+    GLboolean started;
+    /** Schuetzt alle folgenden Felder ausser fbLock */
+    pthread_mutex_t lock;
+    /** Signalisiert neue Anforderungen, abgeschlossene und abgebrochene Frames */
+    pthread_cond_t changed;
+    /** Ein neuer Frame wurde angefordert */
+    GLboolean pending;
+    /** Ein Frame wird gerade gerendert */
+    GLboolean busy;
+    /** Der laufende Frame soll abgebrochen werden (GL_TRUE/GL_FALSE), wird unter der Sperre geschrieben
+     *  und von den Render-Threads ohne Sperre gelesen, nur atomar zugreifen */
+    multiThreadCounter cancelled;
+    /** Ein fertiger Frame wurde in den Frontbuffer getauscht und noch nicht angezeigt */
+    GLboolean frameReady;
+    /** Der Render-Thread soll sich beenden */
+    GLboolean shutdown;
+    /** Zustand des angeforderten Frames */
+    renderFrame next;
+    /** Schuetzt den Frontbuffer waehrend er angezeigt oder getauscht wird */
+    pthread_mutex_t fbLock;
+} renderQueue;
+
+/** Zeilen eines Bandes, das einem entfernten Render-Prozess als ein Auftrag zugeteilt wird */
+#define DISTRIBUTED_BAND_HEIGHT (32)
+/** Auftraege, die ein Render-Prozess gleichzeitig haben darf, damit er waehrend der Uebertragung weiterrechnet */
+#define DISTRIBUTED_MAX_IN_FLIGHT (2)
+
+/**
+ * Einstellungen eines Frames, mit denen ein Render-Prozess seine eigene Szene an die des
+ * Koordinators angleicht. Es werden nur Einstellungen uebertragen, keine Geometrie.
+ */
+typedef struct distributedSettings {
+    viewMode viewMode;
+    GLboolean lightsActive[AMOUNT_LIGHTS];
+    GLboolean showBB;
+    bvhOptions bvhOpts;
+    acceleratorType accelType;
+    packetSize packetSize;
+    GLboolean wavefront;
+} distributedSettings;
+
+/** Verbindung des Koordinators zu einem Render-Prozess */
+typedef struct distributedWorker {
+    /** Socket der Verbindung, -1 wenn die Verbindung abgebrochen ist */
+    int socket;
+    /** Adresse fuer Ausgaben */
+    char address[128];
+    /** Zugeteilte Baender in der Reihenfolge, in der die Ergebnisse zurueckkommen */
+    GLint bands[DISTRIBUTED_MAX_IN_FLIGHT];
+    GLint inFlight;
+} distributedWorker;
+
+/** Render-Prozesse, auf die der Koordinator die Baender eines Frames verteilt */
+typedef struct distributedCluster {
+    distributedWorker *workers;
+    GLint workerCount;
+    /** Nummer des naechsten Frames, wird in jedem Auftrag mitgeschickt */
+    GLuint nextFrame;
+} distributedCluster;
+
+/** Geladenes Mesh im Ressourcen-Cache, liegt einzeln im Speicher, damit Zeiger auf das Mesh gueltig bleiben */
+typedef struct meshResource {
+    /** Dateiname, ueber den das Mesh gefunden wird */
+    char *fileName;
+    object mesh;
+    /** Anzahl der Nutzer, bei 0 wird das Mesh freigegeben */
+    GLint refCount;
+} meshResource;
+
+/** Geladene Meshes, die ueber ihren Dateinamen gemeinsam genutzt werden */
+typedef struct resourceCache {
+    meshResource **entries;
+    GLint count;
+    GLint capacity;
+    /** Meshes nur mit der komprimierten BVH laden, spart die triangleTM Records, Bloecke und weiten Baeume */
+    GLboolean compressedOnly;
+} resourceCache;
 
 typedef struct scene {
-    /** Pixelfarbinformationen fuer das gesamte Bild */
+    /** Pixelfarbinformationen fuer das gesamte Bild (angezeigter Frontbuffer) */
     Color *fb;
-    /** Globale Information ueber alle Objekte in der Szene */
-    object *allObjects;
+    /** Backbuffer, in den der Hintergrund-Renderer den naechsten Frame schreibt */
+    Color *backFb;
+    /** Hintergrund-Renderer */
+    renderQueue renderQueue;
+    /** Meshes der Szene im Objektraum aus dem Ressourcen-Cache, indiziert ueber meshModels, NULL wenn nicht geladen */
+    const object *meshes[AMOUNT_MESHES];
+    /** Geladene Meshes, bleiben beim Wechsel der Ansicht erhalten */
+    resourceCache resources;
+    /** Instanzen der Meshes mit ihrer Transformation und BVH ueber die Instanzen */
+    topLevel topLevel;
+    /** Beschleunigungsstruktur, ueber die die Instanzen geschnitten werden */
+    accelerator accel;
     /** Globales Sphaeren Objekt */
     sphere sphere;
     /** Globale Projektionsebene */
     projectionPlane projPlane;
-    /** Axis Aligned Bounding Box und Object Oriented Bounding Box des Hasens */
-    object boundingBoxes[2];
-    /** Status, welche und ob eine Bounding Box gerendert werden soll */
-    boundingBoxState bbState;
-    /** Status, welche und ob eine Bounding Box gerendert werden soll */
+    /** Status, welche Bounding Box zuletzt verwendet wurde (aktuelle in bvhOpts.bounds) */
     boundingBoxState lastUsedBB;
     /** Status, ob BoundingBoxes gerendert werden sollen */
     GLboolean showBB;
@@ -300,6 +821,20 @@ typedef struct scene {
     multiThreadOpts multiThreadOpts;
     /** Speicher die Renderzeit der Szene */
     GLfloat renderTime;
+    /** Knoten- und Dreieckslayout der BVHs, mit dem traversiert wird */
+    bvhOptions bvhOpts;
+    /** Paketgroesse fuer die Primaerstrahlen */
+    packetSize packetSize;
+    /** Progressive Vorschau (erst jeder 8., 4., 2. Pixel, dann alle) */
+    GLboolean progressive;
+    /** Strahlen im Wavefront-Modus (Queues je Stufe) statt rekursiv verfolgen */
+    GLboolean wavefront;
+    /** Verbundene Render-Prozesse */
+    distributedCluster cluster;
+    /** Frames auf die Render-Prozesse verteilen statt lokal zu rendern */
+    GLboolean distribute;
+    /** Fortschritt des laufenden Frames */
+    renderProgress progress;
 } scene;
 
 
@@ -5,7 +5,18 @@
  * @author Christopher Ploog, Mario da Graca
  */
 
+#ifndef WIN32
+//Fuer mmap und posix_madvise unter -std=c99
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <string.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "utils.h"
 
 Hit utils_createDefaultHit(void) {
@@ -71,4 +82,74 @@ char *utils_concatStrings(const char *s1, const char *s2){
     strcpy(result, s1);
     strcat(result, s2);
     return result;
-}
\ No newline at end of file
+}
+void *utils_mapFile(const char *path, size_t *size) {
+#ifdef WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    void *data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    *size = (size_t) fileSize.QuadPart;
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    //Die Datei wird meist ganz gelesen, die Seiten also moeglichst frueh anfordern
+    posix_madvise(data, (size_t) info.st_size, POSIX_MADV_WILLNEED);
+    *size = (size_t) info.st_size;
+    return data;
+#endif
+}
+
+void utils_unmapFile(void *data, size_t size) {
+#ifdef WIN32
+    (void) size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+GLboolean utils_fileStamp(const char *path, long long *size, long long *modified) {
+#ifdef WIN32
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &info)) {
+        return GL_FALSE;
+    }
+    *size = ((long long) info.nFileSizeHigh << 32) | (long long) info.nFileSizeLow;
+    *modified = ((long long) info.ftLastWriteTime.dwHighDateTime << 32) |
+                (long long) info.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return GL_FALSE;
+    }
+    *size = (long long) info.st_size;
+    *modified = (long long) info.st_mtime;
+#endif
+    return GL_TRUE;
+}
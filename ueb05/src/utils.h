@@ -61,4 +61,29 @@ GLfloat utils_colorIntensity(Color color);
  * @return
  */
 char *utils_concatStrings(const char *s1, const char *s2);
+
+/**
+ * Mappt eine Datei in den Speicher. Die Seiten werden erst beim ersten Zugriff gelesen,
+ * Schreibzugriffe landen nur in einer privaten Kopie der Seiten und nie in der Datei.
+ * @param path Pfad der Datei
+ * @param size Ausgabe, Groesse der Datei in Bytes
+ * @return Anfang der Datei im Speicher, NULL wenn die Datei nicht geoeffnet werden konnte oder leer ist
+ */
+void *utils_mapFile(const char *path, size_t *size);
+
+/**
+ * Gibt eine ueber utils_mapFile gemappte Datei wieder frei
+ * @param data Anfang der Datei
+ * @param size Groesse der Datei
+ */
+void utils_unmapFile(void *data, size_t size);
+
+/**
+ * Bestimmt Groesse und Zeitpunkt der letzten Aenderung einer Datei
+ * @param path Pfad der Datei
+ * @param size Ausgabe, Groesse in Bytes
+ * @param modified Ausgabe, Zeitpunkt der letzten Aenderung (nur zum Vergleichen)
+ * @return GL_FALSE, wenn die Datei nicht existiert
+ */
+GLboolean utils_fileStamp(const char *path, long long *size, long long *modified);
 #endif //RAYTRACER_UTILS_H